@@ -0,0 +1,20 @@
+#pragma once
+
+// Statement classification computed by the preprocessor for static SQL and passed
+// to the runtime (GIXSQLSetStatementFlags), so that it does not need to be
+// derived again from the statement text at each execution
+
+#define SQL_STMT_FLAG_NONE			(uint32_t)0x0
+#define SQL_STMT_FLAG_VALID			(uint32_t)0x1
+#define SQL_STMT_FLAG_SELECT		(uint32_t)0x2
+#define SQL_STMT_FLAG_INSERT		(uint32_t)0x4
+#define SQL_STMT_FLAG_UPDATE		(uint32_t)0x8
+#define SQL_STMT_FLAG_DELETE		(uint32_t)0x10
+#define SQL_STMT_FLAG_TX_END		(uint32_t)0x20
+#define SQL_STMT_FLAG_POSITIONED	(uint32_t)0x40
+#define SQL_STMT_FLAG_HAS_RESULTS	(uint32_t)0x80
+
+#define SQL_STMT_HAS_FLAGS(_F)				((_F) & SQL_STMT_FLAG_VALID)
+#define SQL_STMT_IS_UPDATE_OR_DELETE(_F)	((_F) & (SQL_STMT_FLAG_UPDATE | SQL_STMT_FLAG_DELETE))
+#define SQL_STMT_IS_TX_END(_F)				((_F) & SQL_STMT_FLAG_TX_END)
+#define SQL_STMT_IS_POSITIONED(_F)			((_F) & SQL_STMT_FLAG_POSITIONED)
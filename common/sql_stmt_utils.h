@@ -0,0 +1,26 @@
+#pragma once
+
+#include <string>
+#include <cctype>
+
+// Statement text helpers shared by the drivers (header-only: the drivers
+// do not link any common library)
+
+// Only the first keyword is needed, so we do not copy the whole statement
+inline bool is_ddl_statement(const std::string& query)
+{
+	size_t n = query.find_first_not_of(" \t\r\n");
+	if (n == std::string::npos)
+		return false;
+
+	std::string q = query.substr(n, 7);
+	for (auto& c : q)
+		c = (char)toupper((unsigned char)c);
+
+	return (
+		q.compare(0, 7, "CREATE ") == 0 ||
+		q.compare(0, 6, "ALTER ") == 0 ||
+		q.compare(0, 5, "DROP ") == 0 ||
+		q.compare(0, 7, "RENAME ") == 0
+		);
+}
@@ -21,6 +21,10 @@ USA.
 #include <map>
 #include <vector>
 #include <string>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <thread>
 
 #include "popl.hpp"
 
@@ -49,16 +53,14 @@ using namespace popl;
 
 bool is_alias(const std::string& f, std::string& ext);
 std::string get_basename(const std::string& f);
+bool read_batch_file(const std::string& batch_file, const std::string& outfile_alias, std::vector<std::pair<std::string, std::string>>& jobs);
+int run_batch(const std::vector<std::pair<std::string, std::string>>& jobs, int n_threads, bool verbose,
+	std::function<bool(std::string, std::string, ErrorData&)> preprocess);
 
 int main(int argc, char** argv)
 {
 	int rc = -1;
 
-	GixPreProcessor gp;
-
-	std::shared_ptr<TPESQLParser> esql_parser;
-	std::shared_ptr<TPESQLProcessor> esql_generator;
-
 	// Do processing here
 	const auto args = argv;
 
@@ -86,10 +88,16 @@ int main(int argc, char** argv)
 	auto opt_verbose_debug = options.add<Switch>("d", "verbose-debug", "verbose (debug)");
 	auto opt_parser_scanner_debug = options.add<Switch>("D", "parser-scanner-debug", "parser/scanner debug output");
 	auto opt_emit_map_file = options.add<Switch>("m", "map", "emit map file");
+	auto opt_map_format = options.add<Value<std::string>>("", "map-format", "map file format, implies -m (=text|binary|both)", "text");
 	auto opt_emit_cobol85 = options.add<Switch>("C", "cobol85", "emit COBOL85-compliant code");
 	auto opt_varying_ids = options.add<Value<std::string>>("Y", "varying", "length/data suffixes for varlen fields (=LEN,ARR)");
 	auto opt_picx_as_varchar = options.add<Value<std::string>>("P", "picx-as", "text field options (=char|charf|varchar)", "char");
 	auto opt_no_rec_code = options.add<Value<std::string>>("", "no-rec-code", "custom code for \"no record\" condition(=nnn)");
+	auto opt_emit_stmt_flags = options.add<Switch>("F", "esql-stmt-flags", "ESQL: emit compile-time statement classification flags");
+	auto opt_emit_manifest = options.add<Switch>("M", "esql-manifest", "ESQL: emit a manifest of the static statements, to prepare them when connecting");
+	auto opt_emit_stmt_ids = options.add<Switch>("T", "esql-stmt-ids", "ESQL: emit statement identifiers (used in runtime metrics)");
+	auto opt_batch = options.add<Value<std::string>>("b", "batch", "batch mode: file listing the input and output files (one pair per line)");
+	auto opt_jobs = options.add<Value<int>>("j", "jobs", "batch mode: number of files preprocessed in parallel (=0: number of CPUs)", 0);
 
 	options.parse(argc, argv);
 
@@ -120,12 +128,42 @@ int main(int argc, char** argv)
 				return 1;
 			}
 
-			if (!opt_infile->is_set() || !opt_outfile->is_set()) {
+			std::vector<std::pair<std::string, std::string>> jobs;
+			bool batch_mode = opt_batch->is_set() || opt_infile->count() > 1;
+
+			if (!opt_batch->is_set() && (!opt_infile->is_set() || !opt_outfile->is_set())) {
 				std::cout << options << std::endl;
 				fprintf(stderr, "ERROR: please enter at least the input and output file parameters\n");
 				return 1;
 			}
 
+			// In batch mode a single -o option can be an alias (e.g. @.cbsql) for all the input files
+			std::string outext;
+			bool outfile_alias = opt_outfile->count() == 1 && is_alias(opt_outfile->value(0), outext);
+
+			if (opt_outfile->count() < opt_infile->count() && !outfile_alias) {
+				std::cout << options << std::endl;
+				fprintf(stderr, "ERROR: please enter an output file for each input file\n");
+				return 1;
+			}
+
+			for (size_t i = 0; i < opt_infile->count(); i++) {
+				jobs.push_back({ opt_infile->value(i), opt_outfile->value(outfile_alias ? 0 : i) });
+			}
+
+			if (opt_batch->is_set() && !read_batch_file(opt_batch->value(), outfile_alias ? opt_outfile->value(0) : std::string(), jobs))
+				return 1;
+
+			if (jobs.empty()) {
+				fprintf(stderr, "ERROR: no input files\n");
+				return 1;
+			}
+
+			if (opt_map_format->is_set() && opt_map_format->value() != "text" && opt_map_format->value() != "binary" && opt_map_format->value() != "both") {
+				std::cout << options << std::endl;
+				fprintf(stderr, "ERROR: map-format argument must be \"text\", \"binary\" or \"both\"\n");
+				return 1;
+			}
 
 			if (opt_picx_as_varchar->is_set() && opt_picx_as_varchar->value() != "char" && opt_picx_as_varchar->value() != "charf" && opt_picx_as_varchar->value() != "varchar") {
 				std::cout << options << std::endl;
@@ -144,7 +182,8 @@ int main(int argc, char** argv)
 				}
 			}
 
-			CopyResolver copy_resolver(filename_get_dir(filename_absolute_path(opt_infile->value())));
+			// The COPY resolver (and its caches) is shared by all the files preprocessed in this run
+			CopyResolver copy_resolver(filename_get_dir(filename_absolute_path(jobs.at(0).first)));
 
 			copy_resolver.setVerbose(opt_verbose->is_set());
 
@@ -157,80 +196,209 @@ int main(int argc, char** argv)
 				}
 			}
 
-			gp.setCopyResolver(&copy_resolver);
+			if (opt_esql->is_set() && opt_esql_copy_exts->is_set())
+				copy_resolver.setExtensions(string_split(opt_esql_copy_exts->value(), ","));
+
+			int no_rec_code = 0;
+			if (opt_no_rec_code->is_set()) {
+				std::string c = opt_no_rec_code->value();
+				int i = atoi(c.c_str());
+				if (i != 0 && i >= -999999999 && i <= 999999999) {
+					no_rec_code = i;
+				}
+			}
+
+			// Each file gets its own preprocessor instance (and pipeline)
+			auto preprocess = [&](std::string infile, std::string outfile, ErrorData& err_data) -> bool {
+				GixPreProcessor gp;
+
+				gp.setCopyResolver(&copy_resolver);
+
+				if (opt_consolidate->is_set())
+					gp.addStep(std::make_shared<TPSourceConsolidation>(&gp));
+
+				if (opt_esql->is_set()) {
+					if (opt_varying_ids->is_set())
+						gp.setOpt("varlen_suffixes", opt_varying_ids->value());
+
+					gp.setOpt("emit_static_calls", opt_esql_static_calls->is_set());
+					gp.setOpt("params_style", opt_esql_param_style->value());
+					gp.setOpt("preprocess_copy_files", opt_esql_preprocess_copy->is_set());
+					gp.setOpt("consolidated_map", true);
+					gp.setOpt("emit_map_file", opt_emit_map_file->is_set() || opt_map_format->is_set());
+					gp.setOpt("map_format", opt_map_format->value());
+					gp.setOpt("emit_cobol85", opt_emit_cobol85->is_set());
+					gp.setOpt("picx_as_varchar", to_lower(opt_picx_as_varchar->value()) == "varchar");
+					gp.setOpt("emit_stmt_flags", opt_emit_stmt_flags->is_set());
+					gp.setOpt("emit_manifest", opt_emit_manifest->is_set());
+					gp.setOpt("emit_stmt_ids", opt_emit_stmt_ids->is_set());
+					gp.setOpt("debug_parser_scanner", opt_parser_scanner_debug->is_set());
+
+					if (no_rec_code)
+						gp.setOpt("no_rec_code", no_rec_code);
+
+					gp.addStep(std::make_shared<TPESQLParser>(&gp));
+					gp.addStep(std::make_shared<TPESQLProcessor>(&gp));
+				}
+
+				gp.setOpt("emit_debug_info", opt_debug_info->is_set());
+				gp.verbose = opt_verbose->is_set();
+				gp.verbose_debug = opt_verbose_debug->is_set();
 
-			if (opt_consolidate->is_set())
-				gp.addStep(std::make_shared<TPSourceConsolidation>(&gp));
+				std::string outext;
+				if (is_alias(outfile, outext)) {
+					outfile = get_basename(infile) + outext;	// outext includes the dot
+				}
 
+				if (infile == outfile) {
+					err_data.err_code = 1;
+					err_data.err_messages.push_back("ERROR: input and output file must be different");
+					return false;
+				}
 
-			if (opt_esql->is_set()) {
-				if (opt_varying_ids->is_set())
-					gp.setOpt("varlen_suffixes", opt_varying_ids->value());
+				gp.setInputFile(infile);
+				gp.setOutputFile(outfile);
 
-				gp.setOpt("emit_static_calls", opt_esql_static_calls->is_set());
-				gp.setOpt("params_style", opt_esql_param_style->value());
-				gp.setOpt("preprocess_copy_files", opt_esql_preprocess_copy->is_set());
-				gp.setOpt("consolidated_map", true);
-				gp.setOpt("emit_map_file", opt_emit_map_file->is_set());
-				gp.setOpt("emit_cobol85", opt_emit_cobol85->is_set());
-				gp.setOpt("picx_as_varchar", to_lower(opt_picx_as_varchar->value()) == "varchar");
-				gp.setOpt("debug_parser_scanner", opt_parser_scanner_debug->is_set());
+				bool b = gp.process();
+				err_data = gp.err_data;
+				return b;
+			};
 
-				if (opt_esql_copy_exts->is_set())
-					copy_resolver.setExtensions(string_split(opt_esql_copy_exts->value(), ","));
+			if (!batch_mode) {
+				ErrorData err_data;
+				err_data.err_code = 0;
 
-				if (opt_no_rec_code->is_set()) {
-					std::string c = opt_no_rec_code->value();
-					int i = atoi(c.c_str());
-					if (i != 0 && i >= -999999999 && i <= 999999999) {
-						gp.setOpt("no_rec_code", i);
-					}
+				bool b = preprocess(jobs.at(0).first, jobs.at(0).second, err_data);
+				if (!b) {
+					rc = err_data.err_code;
+					for (std::string m : err_data.err_messages)
+						fprintf(stderr, "%s\n", m.c_str());
 				}
 
-				gp.addStep(std::make_shared<TPESQLParser>(&gp));
+				for (std::string w : err_data.warnings)
+					fprintf(stderr, "%s\n", w.c_str());
 
-				esql_generator = std::make_shared<TPESQLProcessor>(&gp);
-				gp.addStep(esql_generator);
+				rc = err_data.err_code;
+			}
+			else {
+				rc = run_batch(jobs, opt_jobs->value(), opt_verbose->is_set(), preprocess);
 			}
 
-			gp.setOpt("emit_debug_info", opt_debug_info->is_set());
-			gp.verbose = opt_verbose->is_set();
-			gp.verbose_debug = opt_verbose_debug->is_set();
+		}
 
+		return rc;
+	}
 
-			std::string infile = opt_infile->value(0);
-			std::string outfile = opt_outfile->value(0);
-			std::string outext;
+}
 
-			if (is_alias(outfile, outext)) {
-				outfile = get_basename(infile) + "." + outext;
-			}
+bool read_batch_file(const std::string& batch_file, const std::string& outfile_alias, std::vector<std::pair<std::string, std::string>>& jobs)
+{
+	if (!file_exists(batch_file)) {
+		fprintf(stderr, "ERROR: cannot read batch file %s\n", batch_file.c_str());
+		return false;
+	}
 
-			if (infile == outfile) {
-				fprintf(stderr, "ERROR: input and output file must be different\n");
-				return 1;
+	// One file per line: the input file and the output file, separated by a tab or, if there are
+	// no tabs, by a space. The output file can be omitted if -o is an alias (e.g. @.cbsql).
+	std::vector<std::string> lines = file_read_all_lines(batch_file);
+	for (size_t i = 0; i < lines.size(); i++) {
+		std::string line = trim_copy(lines.at(i));
+		if (line.empty() || line.at(0) == '#')
+			continue;
+
+		std::string infile = line;
+		std::string outfile = outfile_alias;
+
+		size_t pos = line.find('\t');
+		if (pos == std::string::npos)
+			pos = line.find(' ');
+
+		if (pos != std::string::npos) {
+			infile = trim_copy(line.substr(0, pos));
+			outfile = trim_copy(line.substr(pos + 1));
+		}
+
+		if (outfile.empty()) {
+			fprintf(stderr, "ERROR: %s(%zu): no output file for %s\n", batch_file.c_str(), i + 1, infile.c_str());
+			return false;
+		}
+
+		jobs.push_back({ infile, outfile });
+	}
+
+	return true;
+}
+
+// The files are preprocessed in parallel: each worker thread takes the next file from the list as
+// soon as it is done with the previous one, so the load stays balanced even when the sizes of the
+// programs vary a lot. Errors and warnings are reported per file, the exit code is 0 only if all
+// the files have been preprocessed successfully.
+int run_batch(const std::vector<std::pair<std::string, std::string>>& jobs, int n_threads, bool verbose,
+	std::function<bool(std::string, std::string, ErrorData&)> preprocess)
+{
+	if (n_threads <= 0)
+		n_threads = std::thread::hardware_concurrency();
+
+	if (n_threads <= 0)
+		n_threads = 1;
+
+	if ((size_t)n_threads > jobs.size())
+		n_threads = (int)jobs.size();
+
+	std::atomic<size_t> next_job(0);
+	std::atomic<int> failed(0);
+	std::mutex output_mutex;
+
+	auto worker = [&]() {
+		size_t i;
+		while ((i = next_job.fetch_add(1)) < jobs.size()) {
+			const std::string& infile = jobs.at(i).first;
+
+			ErrorData err_data;
+			err_data.err_code = 0;
+
+			bool b;
+			try {
+				b = preprocess(infile, jobs.at(i).second, err_data);
 			}
+			catch (std::exception& ex) {
+				b = false;
+				err_data.err_messages.push_back(std::string("ERROR: ") + ex.what());
+			}
+
+			if (!b || err_data.err_code)
+				failed++;
 
-			gp.setInputFile(infile);
-			gp.setOutputFile(outfile);
+			std::lock_guard<std::mutex> lock(output_mutex);
 
-			bool b = gp.process();
-			if (!b) {
-				rc = gp.err_data.err_code;
-				for (std::string m : gp.err_data.err_messages)
+			if (!b || err_data.err_code) {
+				fprintf(stderr, "%s: failed (%d)\n", infile.c_str(), err_data.err_code);
+				for (std::string m : err_data.err_messages)
 					fprintf(stderr, "%s\n", m.c_str());
 			}
+			else {
+				if (verbose)
+					printf("%s: OK\n", infile.c_str());
+			}
 
-			for (std::string w : gp.err_data.warnings)
+			for (std::string w : err_data.warnings)
 				fprintf(stderr, "%s\n", w.c_str());
+		}
+	};
 
-			rc = gp.err_data.err_code;
+	std::vector<std::thread> threads;
+	for (int i = 0; i < n_threads; i++)
+		threads.emplace_back(worker);
 
-		}
+	for (auto& t : threads)
+		t.join();
 
-		return rc;
+	if (failed > 0) {
+		fprintf(stderr, "%d of %zu file(s) failed\n", failed.load(), jobs.size());
+		return 1;
 	}
 
+	return 0;
 }
 
 bool is_alias(const std::string& f, std::string& ext)
@@ -0,0 +1,205 @@
+/*
+This file is part of Gix-IDE, an IDE and platform for GnuCOBOL
+Copyright (C) 2021 Marco Ridoni
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+USA.
+*/
+
+/*
+	Round-trip test for the binary map file ("make check"): TBMAP01.cbl is preprocessed
+	with --map-format=both, then every entry of the text map file is looked up through
+	BinaryMapFileReader. The text map has no paragraphs: those are checked against the
+	source lines.
+
+	The environment provides GIXPP (the gixpp executable), TEST_SRCDIR (this directory)
+	and TEST_COPYDIR (the directory of SQLCA.cpy).
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <filesystem>
+
+#include "MapFileReader.h"
+#include "BinaryMapFile.h"
+#include "libcpputils.h"
+
+#define TEST_MODULE		"TBMAP01"
+#define TEST_WORK_DIR	"bmap-roundtrip.tmp"
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do { if (!(cond)) { fprintf(stderr, "FAIL: " __VA_ARGS__); fprintf(stderr, "\n"); failures++; } } while (0)
+
+// "line@file" (as written in the text map)
+static bool parse_location(const std::string& s, int* file_id, int* line)
+{
+	return sscanf(s.c_str(), "%d@%d", line, file_id) == 2;
+}
+
+// Checks that every "from:to" entry of a text map section is returned by the given binary lookup
+static void check_line_map(const MapFileReader& mr, const std::string& section, const BinaryMapFileReader& br,
+	bool (BinaryMapFileReader::*find)(int, int, int*, int*) const)
+{
+	std::vector<std::string> items;
+	CHECK(mr.getSectionData(section, items) && items.size() > 1, "no %s section in the text map", section.c_str());
+	if (items.size() < 2)
+		return;
+
+	CHECK(atoi(items.at(0).c_str()) == (int)items.size() - 1, "%s: wrong entry count", section.c_str());
+
+	for (size_t i = 1; i < items.size(); i++) {
+		size_t pos = items.at(i).find(':');
+		int from_file, from_line, to_file, to_line;
+		if (pos == std::string::npos || !parse_location(items.at(i).substr(0, pos), &from_file, &from_line) || !parse_location(items.at(i).substr(pos + 1), &to_file, &to_line)) {
+			CHECK(false, "%s: invalid entry %s", section.c_str(), items.at(i).c_str());
+			continue;
+		}
+
+		int b_file = 0, b_line = 0;
+		bool found = (br.*find)(from_file, from_line, &b_file, &b_line);
+		CHECK(found && b_file == to_file && b_line == to_line, "%s: %s -> found=%d, %d@%d", section.c_str(), items.at(i).c_str(), found, b_line, b_file);
+	}
+}
+
+// Returns the (1-based) line of the source file that starts the given paragraph
+static int find_source_line(const std::string& filename, const std::string& paragraph)
+{
+	std::vector<std::string> lines = file_read_all_lines(filename);
+	for (size_t i = 0; i < lines.size(); i++) {
+		if (trim_copy(lines.at(i)) == paragraph + ".")
+			return (int)i + 1;
+	}
+	return 0;
+}
+
+int main()
+{
+	const char* gixpp = getenv("GIXPP");
+	const char* src_dir = getenv("TEST_SRCDIR");
+	const char* copy_dir = getenv("TEST_COPYDIR");
+	if (!gixpp || !src_dir || !copy_dir) {
+		fprintf(stderr, "ERROR: GIXPP, TEST_SRCDIR and TEST_COPYDIR must be set\n");
+		return 1;
+	}
+
+	std::filesystem::path work_dir = std::filesystem::absolute(TEST_WORK_DIR);
+	std::filesystem::remove_all(work_dir);
+	std::filesystem::create_directories(work_dir);
+	for (std::string f : { TEST_MODULE ".cbl", "TBMAPCPY.cpy" })
+		std::filesystem::copy_file(std::filesystem::path(src_dir) / f, work_dir / f);
+
+	std::filesystem::current_path(work_dir);
+
+	std::string cmd = string_format("%s -e -S -I. -I%s --map-format=both -i %s.cbl -o %s.cbsql", gixpp, copy_dir, TEST_MODULE, TEST_MODULE);
+	if (system(cmd.c_str()) != 0) {
+		fprintf(stderr, "ERROR: preprocessing failed: %s\n", cmd.c_str());
+		return 1;
+	}
+
+	MapFileReader mr(TEST_MODULE ".cbsql.map");
+	if (!mr.read()) {
+		fprintf(stderr, "ERROR: cannot read the text map file\n");
+		return 1;
+	}
+
+	BinaryMapFileReader br(TEST_MODULE BMAP_FILE_EXT);
+	if (!br.open()) {
+		fprintf(stderr, "ERROR: cannot open the binary map file\n");
+		return 1;
+	}
+
+	// global data: version, flags, input file, output file, input file id, output file id
+	std::vector<std::string> items;
+	CHECK(mr.getSectionData("map", items) && items.size() == 6, "invalid map section in the text map");
+	if (items.size() == 6) {
+		CHECK(atoi(items.at(4).c_str()) != 0, "the input file is not in the file map");
+		CHECK(br.getInputFileId() == atoi(items.at(4).c_str()), "input file id: %d, expected %s", br.getInputFileId(), items.at(4).c_str());
+		CHECK(br.getOutputFileId() == atoi(items.at(5).c_str()), "output file id: %d, expected %s", br.getOutputFileId(), items.at(5).c_str());
+	}
+	CHECK(br.getModuleName() == TEST_MODULE, "module name: %s", br.getModuleName().c_str());
+
+	// file map: "#id:name"
+	items.clear();
+	CHECK(mr.getSectionData("filemap", items) && items.size() > 1, "no filemap section in the text map");
+	for (size_t i = 1; i < items.size(); i++) {
+		size_t pos = items.at(i).find(':');
+		int id = atoi(items.at(i).c_str() + 1);
+		std::string name = (pos != std::string::npos) ? items.at(i).substr(pos + 1) : std::string();
+		CHECK(id > 0, "invalid file id in %s", items.at(i).c_str());
+		CHECK(br.getFileName(id) == name, "file #%d: %s, expected %s", id, br.getFileName(id).c_str(), name.c_str());
+		CHECK(br.getFileId(name) == id, "file %s: id %d, expected %d", name.c_str(), br.getFileId(name), id);
+	}
+
+	check_line_map(mr, "in_to_out_map", br, &BinaryMapFileReader::findOutputLine);
+	check_line_map(mr, "out_to_in_map", br, &BinaryMapFileReader::findInputLine);
+
+	int f, l;
+	CHECK(!br.findOutputLine(br.getInputFileId(), 999999, &f, &l), "found a mapping for a line that does not exist");
+	CHECK(!br.findInputLine(br.getOutputFileId(), 999999, &f, &l), "found a mapping for a line that does not exist");
+
+	// field map: "name/path@file:line" (the path can contain ':')
+	items.clear();
+	CHECK(mr.getSectionData("field_map", items) && items.size() > 1, "no field_map section in the text map");
+	for (size_t i = 1; i < items.size(); i++) {
+		const std::string& e = items.at(i);
+		size_t slash = e.find('/');
+		size_t at = e.rfind('@');
+		size_t colon = e.rfind(':');
+		if (slash == std::string::npos || at == std::string::npos || colon == std::string::npos || !(slash < at && at < colon)) {
+			CHECK(false, "field_map: invalid entry %s", e.c_str());
+			continue;
+		}
+
+		std::string name = e.substr(0, slash);
+		std::string path;
+		int file_id = 0, line = 0;
+		bool found = br.findField(name, path, &file_id, &line);
+		CHECK(found, "field %s not found", name.c_str());
+		CHECK(path == e.substr(slash + 1, at - slash - 1), "field %s: path %s", name.c_str(), path.c_str());
+		CHECK(br.getFileName(file_id) == e.substr(at + 1, colon - at - 1), "field %s: file %s", name.c_str(), br.getFileName(file_id).c_str());
+		CHECK(line == atoi(e.c_str() + colon + 1), "field %s: line %d", name.c_str(), line);
+	}
+
+	std::string path;
+	CHECK(!br.findField("NO-SUCH-FIELD", path, &f, &l), "found a field that does not exist");
+
+	// paragraphs
+	for (std::string p : { "100-MAIN", "100-EXIT", "200-UPDATE" }) {
+		int file_id = 0, line = 0;
+		bool found = br.findParagraph(p, &file_id, &line);
+		CHECK(found, "paragraph %s not found", p.c_str());
+		std::error_code ec;
+		CHECK(std::filesystem::equivalent(br.getFileName(file_id), TEST_MODULE ".cbl", ec), "paragraph %s: file %s", p.c_str(), br.getFileName(file_id).c_str());
+		CHECK(line == find_source_line(TEST_MODULE ".cbl", p), "paragraph %s: line %d", p.c_str(), line);
+
+		std::string name;
+		CHECK(br.findParagraphAt(file_id, line + 1, name) && name == p, "line %d: paragraph %s, expected %s", line + 1, name.c_str(), p.c_str());
+	}
+
+	CHECK(!br.findParagraph("NO-SUCH-PARAGRAPH", &f, &l), "found a paragraph that does not exist");
+
+	br.close();
+
+	if (failures) {
+		fprintf(stderr, "%d check(s) failed\n", failures);
+		return 1;
+	}
+
+	printf("binary map round-trip: OK\n");
+	return 0;
+}
@@ -0,0 +1,165 @@
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using System.Text;
+using System.Text.Json;
+
+namespace gixsql_tests
+{
+    public class BenchmarkStatementResult
+    {
+        public string Op;
+        public string Statement;
+        public string Sql;
+        public long Calls;
+        public long Errors;
+        public long RowsFetched;
+        public long RowsAffected;
+
+        // per call, in microseconds (from the runtime metrics histograms)
+        public double DriverP50;
+        public double DriverP99;
+        public double ConversionP50;
+        public double ConversionP99;
+    }
+
+    public class BenchmarkResult
+    {
+        public string Name;
+        public string Description;
+        public string DbType;
+        public string Architecture;
+        public string CompilerType;
+
+        public double ElapsedSeconds;
+        public long Calls;
+        public long Rows;
+        public double RowsPerSecond;
+
+        public List<BenchmarkStatementResult> Statements = new List<BenchmarkStatementResult>();
+
+        // Reads the metrics written by the runtime library during the last run of the benchmark program
+        public static BenchmarkResult FromTestData(GixSqlTestData td)
+        {
+            if (String.IsNullOrWhiteSpace(td.MetricsFile) || !File.Exists(td.MetricsFile))
+                throw new Exception($"Runtime metrics not found for {td.FullName}: {td.MetricsFile}");
+
+            BenchmarkResult r = new BenchmarkResult();
+            r.Name = td.Name;
+            r.Description = td.Description;
+            r.DbType = td.DataSources.Count > 0 ? td.DataSources[0].type : "nodata";
+            r.Architecture = td.Architecture;
+            r.CompilerType = td.CompilerType;
+            r.ElapsedSeconds = td.LastRunElapsed.TotalSeconds;
+
+            using (JsonDocument doc = JsonDocument.Parse(File.ReadAllText(td.MetricsFile)))
+            {
+                foreach (JsonElement s in doc.RootElement.GetProperty("statements").EnumerateArray())
+                {
+                    BenchmarkStatementResult sr = new BenchmarkStatementResult();
+                    sr.Op = s.GetProperty("op").GetString();
+                    sr.Statement = s.GetProperty("statement").GetString();
+                    sr.Sql = s.GetProperty("sql").GetString();
+                    sr.Calls = s.GetProperty("calls").GetInt64();
+                    sr.Errors = s.GetProperty("errors").GetInt64();
+                    sr.RowsFetched = s.GetProperty("rows_fetched").GetInt64();
+                    sr.RowsAffected = s.GetProperty("rows_affected").GetInt64();
+
+                    JsonElement dt = s.GetProperty("driver_time_ns");
+                    sr.DriverP50 = dt.GetProperty("p50").GetDouble() / 1000.0;
+                    sr.DriverP99 = dt.GetProperty("p99").GetDouble() / 1000.0;
+
+                    JsonElement ct = s.GetProperty("conversion_time_ns");
+                    sr.ConversionP50 = ct.GetProperty("p50").GetDouble() / 1000.0;
+                    sr.ConversionP99 = ct.GetProperty("p99").GetDouble() / 1000.0;
+
+                    r.Statements.Add(sr);
+                }
+            }
+
+            r.Calls = r.Statements.Sum(a => a.Calls);
+            r.Rows = r.Statements.Sum(a => a.RowsFetched + a.RowsAffected);
+            r.RowsPerSecond = r.ElapsedSeconds > 0 ? r.Rows / r.ElapsedSeconds : 0;
+
+            return r;
+        }
+    }
+
+    public static class BenchmarkReport
+    {
+        public static void Print(List<BenchmarkResult> results)
+        {
+            foreach (var r in results)
+            {
+                Console.WriteLine();
+                Console.WriteLine($"{r.Name}/{r.Architecture}/{r.CompilerType}/{r.DbType} - {r.Description}");
+                Console.WriteLine($"  elapsed: {r.ElapsedSeconds:0.000} s, calls: {r.Calls}, rows: {r.Rows}, rows/s: {r.RowsPerSecond:0}");
+                Console.WriteLine("  {0,-24} {1,-8} {2,10} {3,10} {4,12} {5,12} {6,12} {7,12}", "statement", "op", "calls", "rows", "drv p50 us", "drv p99 us", "cnv p50 us", "cnv p99 us");
+                foreach (var s in r.Statements.OrderByDescending(a => a.Calls))
+                {
+                    Console.WriteLine("  {0,-24} {1,-8} {2,10} {3,10} {4,12:0.0} {5,12:0.0} {6,12:0.0} {7,12:0.0}",
+                        s.Statement.Length > 24 ? s.Statement.Substring(0, 24) : s.Statement, s.Op, s.Calls, s.RowsFetched + s.RowsAffected,
+                        s.DriverP50, s.DriverP99, s.ConversionP50, s.ConversionP99);
+                }
+            }
+
+            if (results.Count == 0)
+                return;
+
+            // one line per benchmark and driver, to compare them at a glance
+            Console.WriteLine();
+            Console.WriteLine("{0,-12} {1,-8} {2,12} {3,10} {4,12}", "benchmark", "db", "rows", "elapsed s", "rows/s");
+            foreach (var r in results.OrderBy(a => a.Name).ThenBy(a => a.DbType))
+            {
+                Console.WriteLine("{0,-12} {1,-8} {2,12} {3,10:0.000} {4,12:0}", r.Name, r.DbType, r.Rows, r.ElapsedSeconds, r.RowsPerSecond);
+            }
+        }
+
+        public static void WriteJson(string path, List<BenchmarkResult> results)
+        {
+            using (var fs = File.Create(path))
+            using (var w = new Utf8JsonWriter(fs, new JsonWriterOptions { Indented = true }))
+            {
+                w.WriteStartObject();
+                w.WriteString("date", DateTime.Now.ToString("s"));
+                w.WriteString("gixsql-install-base", TestDataProvider.TestGixSqlInstallBase);
+                w.WriteStartArray("benchmarks");
+                foreach (var r in results)
+                {
+                    w.WriteStartObject();
+                    w.WriteString("name", r.Name);
+                    w.WriteString("description", r.Description);
+                    w.WriteString("dbtype", r.DbType);
+                    w.WriteString("architecture", r.Architecture);
+                    w.WriteString("compiler-type", r.CompilerType);
+                    w.WriteNumber("elapsed_s", r.ElapsedSeconds);
+                    w.WriteNumber("calls", r.Calls);
+                    w.WriteNumber("rows", r.Rows);
+                    w.WriteNumber("rows_per_s", r.RowsPerSecond);
+                    w.WriteStartArray("statements");
+                    foreach (var s in r.Statements)
+                    {
+                        w.WriteStartObject();
+                        w.WriteString("statement", s.Statement);
+                        w.WriteString("op", s.Op);
+                        w.WriteString("sql", s.Sql);
+                        w.WriteNumber("calls", s.Calls);
+                        w.WriteNumber("errors", s.Errors);
+                        w.WriteNumber("rows_fetched", s.RowsFetched);
+                        w.WriteNumber("rows_affected", s.RowsAffected);
+                        w.WriteNumber("driver_p50_us", s.DriverP50);
+                        w.WriteNumber("driver_p99_us", s.DriverP99);
+                        w.WriteNumber("conversion_p50_us", s.ConversionP50);
+                        w.WriteNumber("conversion_p99_us", s.ConversionP99);
+                        w.WriteEndObject();
+                    }
+                    w.WriteEndArray();
+                    w.WriteEndObject();
+                }
+                w.WriteEndArray();
+                w.WriteEndObject();
+            }
+        }
+    }
+}
@@ -455,10 +455,21 @@ namespace gixsql_tests
                 if (File.Exists(log_path))
                     File.Delete(log_path);
 
-                env.Add("GIXSQL_LOG_LEVEL", "trace");
+                // trace logging would dominate the timings of a benchmark
+                env.Add("GIXSQL_LOG_LEVEL", td.Benchmark ? "error" : "trace");
                 env.Add("GIXSQL_LOG_FILE", log_path);
                 env.Add("GIXSQL_LOG_TRUNCATE", "on");
 
+                if (td.Benchmark)
+                {
+                    td.MetricsFile = Path.Combine(TestTempDir, $"metrics-{td.Name}-{td.Architecture}-{dbid}-{td.CompilerType}.json");
+                    if (File.Exists(td.MetricsFile))
+                        File.Delete(td.MetricsFile);
+
+                    env.Add("GIXSQL_METRICS_FILE", td.MetricsFile);
+                    env.Add("GIXSQL_METRICS_FORMAT", "json");
+                }
+
                 foreach (var kve in td.Environment)
                 {
                     env.Add(kve.Key, kve.Value);
@@ -501,7 +512,7 @@ namespace gixsql_tests
                     Console.WriteLine($"PATH: {env["PATH"]}");
                 }
 
-                if (!String.IsNullOrWhiteSpace(TestDataProvider.MemCheck))
+                if (!String.IsNullOrWhiteSpace(TestDataProvider.MemCheck) && !td.Benchmark)
                 {
                     string mc = TestDataProvider.MemCheck.Replace("${testid}", td.Name);
                     mc = mc.Replace("${dbtype}", dbid);
@@ -520,6 +531,8 @@ namespace gixsql_tests
                     }
                 }
 
+                Stopwatch sw = Stopwatch.StartNew();
+
                 var res = Task.Run(async () =>
                 {
                     return await Cli.Wrap(exe)
@@ -530,6 +543,10 @@ namespace gixsql_tests
 
                 });
 
+                res.Wait();
+                sw.Stop();
+                td.LastRunElapsed = sw.Elapsed;
+
                 if (TestDataProvider.TestVerbose)
                 {
                     Console.WriteLine(res.Result.StandardOutput);
@@ -599,6 +616,31 @@ namespace gixsql_tests
                     }
                 }
 
+                // the log is checked after the program has ended, so that this also covers what is written at exit
+                if (td.ExpectedLogContent.Count > 0)
+                {
+                    Assert.IsTrue(File.Exists(log_path), $"Log file not found: {log_path}");
+                    string log_content = File.ReadAllText(log_path);
+
+                    for (int i = 0; i < td.ExpectedLogContent.Count; i++)
+                    {
+                        string t = td.ExpectedLogContent[i];
+                        bool useregex = t.StartsWith("{{RX}}");
+                        if (useregex)
+                            t = t.Substring(6);
+
+                        if (useregex)
+                        {
+                            Regex rx = new Regex(t, RegexOptions.Multiline);
+                            Assert.IsTrue(rx.IsMatch(log_content), $"Log content mismatch (index: {i}, expected: {t}");
+                        }
+                        else
+                        {
+                            Assert.IsTrue(log_content.Contains(t), $"Log content mismatch (index: {i}, expected: {t}");
+                        }
+                    }
+                }
+
                 if (TestDataProvider.TestVerbose)
                 {
                     if (b1 || b2)
@@ -36,6 +36,7 @@ namespace gixsql_tests
 
         public List<string> ExpectedOutput = new List<string>();
         public List<string> ExpectedPreprocessedFileContent = new List<string>();
+        public List<string> ExpectedLogContent = new List<string>();
 
         public string LastPreprocessedFile;
         public string LastCompiledFile;
@@ -43,6 +44,11 @@ namespace gixsql_tests
         public string LastErrorText;
         public string LastOutputText;
 
+        // Benchmarks: runtime metrics are collected in MetricsFile and the run time is measured
+        public bool Benchmark = false;
+        public string MetricsFile;
+        public TimeSpan LastRunElapsed;
+
         public string BuildType = "exe";
         public string AdditionalPreProcessParams;
         public string AdditionalCompileParams;
@@ -16,6 +16,18 @@ namespace gixsql_tests_nunit
         static Dictionary<string, string> results = new Dictionary<string, string>();
         public static int Main(string[] args)
         {
+            bool bench = false;
+            string bench_output = null;
+
+            var opts = new OptionSet {
+                { "b|bench", "run the benchmark programs instead of the test suite", v => bench = v != null },
+                { "o|bench-output=", "write the benchmark results (JSON) to this file", v => bench_output = v },
+            };
+            opts.Parse(args);
+
+            if (bench)
+                return RunBenchmarks(bench_output);
+
             DateTime start_time = DateTime.Now;
 
             var tests = TestDataProvider.GetData();
@@ -81,5 +93,43 @@ namespace gixsql_tests_nunit
 
             return num_results_ko;
         }
+
+        private static int RunBenchmarks(string bench_output)
+        {
+            var tests = TestDataProvider.GetBenchmarkData();
+
+            GixSqlDynamicTestRunner.ResetCounter();
+
+            List<BenchmarkResult> bench_results = new List<BenchmarkResult>();
+            int num_failed = 0;
+
+            foreach (TestCaseData tcd in tests)
+            {
+                GixSqlTestData test = (GixSqlTestData)tcd.OriginalArguments[0];
+
+                try
+                {
+                    var tr = new GixSqlDynamicTestRunner();
+                    tr.Execute(test);
+                    bench_results.Add(BenchmarkResult.FromTestData(test));
+                }
+                catch (Exception ex)
+                {
+                    Console.WriteLine(ex.Message);
+                    Console.WriteLine("Benchmark failed: " + test.FullName);
+                    num_failed++;
+                }
+            }
+
+            BenchmarkReport.Print(bench_results);
+
+            if (!String.IsNullOrWhiteSpace(bench_output))
+            {
+                BenchmarkReport.WriteJson(bench_output, bench_results);
+                Console.WriteLine("\nBenchmark results written to " + bench_output);
+            }
+
+            return num_failed;
+        }
     }
 }
@@ -217,6 +217,17 @@ namespace gixsql_tests
 
 
         public static IEnumerable GetData()
+        {
+            return GetData("GIXTEST_TESTMATRIX_CONFIG", "gixsql_test_data.xml", false);
+        }
+
+        // The benchmark programs use the same matrix format as the test suite
+        public static IEnumerable GetBenchmarkData()
+        {
+            return GetData("GIXTEST_BENCHMATRIX_CONFIG", "gixsql_bench_data.xml", true);
+        }
+
+        private static IEnumerable GetData(string matrix_env_var, string embedded_matrix, bool is_benchmark)
         {
             try
             {
@@ -227,9 +238,9 @@ namespace gixsql_tests
                 XmlDocument doc = new XmlDocument();
 
                 // if not initialized, we use the embedded test matrix
-                string testmatrix_config = Environment.GetEnvironmentVariable("GIXTEST_TESTMATRIX_CONFIG");
+                string testmatrix_config = Environment.GetEnvironmentVariable(matrix_env_var);
                 if (!String.IsNullOrWhiteSpace(testmatrix_config) && !File.Exists(testmatrix_config))
-                    throw new Exception("Invalid value for GIXTEST_TESTMATRIX_CONFIG");
+                    throw new Exception("Invalid value for " + matrix_env_var);
 
                 if (!String.IsNullOrWhiteSpace(testmatrix_config))
                 {
@@ -238,7 +249,7 @@ namespace gixsql_tests
                 }
                 else
                 {
-                    doc.LoadXml(Utils.GetResource("gixsql_test_data.xml"));
+                    doc.LoadXml(Utils.GetResource(embedded_matrix));
                     Console.WriteLine("Using embedded test matrix");
                 }
 
@@ -266,6 +277,7 @@ namespace gixsql_tests
 
                                 GixSqlTestData td = new GixSqlTestData();
                                 td.Name = xe.Attributes["name"].Value;
+                                td.Benchmark = is_benchmark;
                                 td.Architecture = arch;
                                 td.CompilerType = ctype;
 
@@ -521,6 +533,18 @@ namespace gixsql_tests
                                     }
                                 }
 
+                                foreach (XmlElement xeo in xe.SelectNodes("expected-log-content/line"))
+                                {
+                                    if (xeo.HasAttribute("regex") && Boolean.Parse(xeo.Attributes["regex"].Value))
+                                    {
+                                        td.ExpectedLogContent.Add("{{RX}}" + xeo.InnerText);
+                                    }
+                                    else
+                                    {
+                                        td.ExpectedLogContent.Add(xeo.InnerText);
+                                    }
+                                }
+
 
                                 var tcd = new TestCaseData(td);
                                 tcd.SetName(td.FullName);
@@ -0,0 +1,18 @@
+﻿BEGIN
+    BEGIN
+        EXECUTE IMMEDIATE 'DROP TABLE bench_data';
+        EXECUTE IMMEDIATE 'DROP TABLE bench_ins';
+
+    EXCEPTION
+         WHEN OTHERS THEN
+                IF SQLCODE != -942 THEN
+                     RAISE;
+                END IF;
+    END;
+
+EXECUTE IMMEDIATE 'CREATE TABLE bench_data ( id integer not null, fld01 integer, fld02 numeric(11,2), fld03 varchar(32), primary key (id) )';
+EXECUTE IMMEDIATE 'CREATE TABLE bench_ins ( id integer not null, fld01 integer, fld02 numeric(11,2), fld03 varchar(32), primary key (id) )';
+
+EXECUTE IMMEDIATE 'INSERT INTO bench_data (id, fld01, fld02, fld03) SELECT LEVEL, MOD(LEVEL, 1000), LEVEL / 100, ''ROW '' || LEVEL FROM dual CONNECT BY LEVEL <= 1000000';
+
+END;
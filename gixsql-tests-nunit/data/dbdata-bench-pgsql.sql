@@ -0,0 +1,27 @@
+﻿DROP TABLE IF EXISTS bench_data;
+DROP TABLE IF EXISTS bench_ins;
+
+CREATE TABLE bench_data (
+    id integer not null,
+    fld01 integer,
+    fld02 numeric(11,2),
+    fld03 varchar(32),
+    primary key (id)
+);
+
+CREATE TABLE bench_ins (
+    id integer not null,
+    fld01 integer,
+    fld02 numeric(11,2),
+    fld03 varchar(32),
+    primary key (id)
+);
+
+--
+
+INSERT INTO bench_data (id, fld01, fld02, fld03)
+    SELECT n, n % 1000, n / 100.0, 'ROW ' || n FROM generate_series(1, 1000000) AS n;
+
+--
+
+ANALYZE bench_data;
@@ -0,0 +1,24 @@
+﻿DROP TABLE IF EXISTS bench_data;
+DROP TABLE IF EXISTS bench_ins;
+
+CREATE TABLE bench_data (
+    id integer not null,
+    fld01 integer,
+    fld02 numeric(11,2),
+    fld03 varchar(32),
+    primary key (id)
+);
+
+CREATE TABLE bench_ins (
+    id integer not null,
+    fld01 integer,
+    fld02 numeric(11,2),
+    fld03 varchar(32),
+    primary key (id)
+);
+
+--
+
+INSERT INTO bench_data (id, fld01, fld02, fld03)
+    WITH RECURSIVE seq(n) AS (SELECT 1 UNION ALL SELECT n + 1 FROM seq WHERE n < 1000000)
+    SELECT n, n % 1000, n / 100.0, 'ROW ' || n FROM seq;
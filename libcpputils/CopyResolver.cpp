@@ -22,6 +22,8 @@ USA.
 #include "libcpputils.h"
 
 #include <filesystem>
+#include <fstream>
+#include <sstream>
 
 
 CopyResolver::CopyResolver(const std::string& base_dir, const std::vector<std::string> &_copy_dirs)
@@ -38,7 +40,9 @@ CopyResolver::CopyResolver(const std::string& base_dir)
 
 void CopyResolver::resetCache()
 {
+	std::lock_guard<std::mutex> lock(cache_mutex);
 	resolve_cache.clear();
+	content_cache.clear();
 }
 
 void CopyResolver::setCopyDirs(const std::vector<std::string> &_copy_dirs)
@@ -99,9 +103,13 @@ bool CopyResolver::resolveCopyFile(const std::string copy_name, std::string &cop
 		return false;
 	}
 
-	if (map_contains<std::string>(resolve_cache, copy_name)) {
-		copy_file = resolve_cache[copy_name];
-		return true;
+	{
+		std::lock_guard<std::mutex> lock(cache_mutex);
+		auto it = resolve_cache.find(copy_name);
+		if (it != resolve_cache.end()) {
+			copy_file = it->second;
+			return true;
+		}
 	}
 
 	if (copy_dirs.empty())
@@ -143,7 +151,10 @@ bool CopyResolver::resolve_from_dir(const std::string& copy_dir, const std::stri
 
 		if (std::filesystem::exists(the_file)) {
 			copy_file = filename_absolute_path(the_file);
-			resolve_cache[copy_name] = copy_file;
+			{
+				std::lock_guard<std::mutex> lock(cache_mutex);
+				resolve_cache[copy_name] = copy_file;
+			}
 			if (verbose)
 				printf("OK\n");
 
@@ -155,3 +166,41 @@ bool CopyResolver::resolve_from_dir(const std::string& copy_dir, const std::stri
 	}
 	return false;
 }
+
+std::shared_ptr<const std::string> CopyResolver::getCopyFileContent(const std::string &copy_file)
+{
+	{
+		std::lock_guard<std::mutex> lock(cache_mutex);
+		auto it = content_cache.find(copy_file);
+		if (it != content_cache.end())
+			return it->second;
+	}
+
+	// Read outside the lock: if two threads read the same file, the first one to finish wins
+	std::ifstream ifs(copy_file);
+	if (!ifs.is_open())
+		return nullptr;
+
+	std::ostringstream oss;
+	oss << ifs.rdbuf();
+	auto content = std::make_shared<const std::string>(oss.str());
+
+	std::lock_guard<std::mutex> lock(cache_mutex);
+	return content_cache.emplace(copy_file, content).first->second;
+}
+
+bool CopyResolver::getCopyFileLines(const std::string &copy_file, std::vector<std::string> &lines)
+{
+	auto content = getCopyFileContent(copy_file);
+	if (!content)
+		return false;
+
+	// same as file_read_all_lines
+	std::istringstream iss(*content);
+	std::string line;
+	while (std::getline(iss, line)) {
+		lines.push_back(line);
+	}
+
+	return true;
+}
@@ -23,6 +23,8 @@ USA.
 #include <string>
 #include <vector>
 #include <map>
+#include <memory>
+#include <mutex>
 
 //#include "libgixutils_global.h"
 
@@ -44,6 +46,12 @@ public:
 	bool resolveCopyFile(const std::string copy_name, std::string &copy_file);
 	void setVerbose(bool b);
 
+	// Contents of a (resolved) copy file: each file is read only once and then shared by all
+	// the files preprocessed with this resolver. Resolution and content lookups are thread-safe,
+	// the configuration methods above are not and must be called before preprocessing starts.
+	std::shared_ptr<const std::string> getCopyFileContent(const std::string &copy_file);
+	bool getCopyFileLines(const std::string &copy_file, std::vector<std::string> &lines);
+
 private:
 	std::vector<std::string> copy_dirs;
 	std::vector<std::string> copy_exts;
@@ -52,7 +60,9 @@ private:
 
 	bool verbose = false;
 
+	std::mutex cache_mutex;
 	std::map<std::string, std::string> resolve_cache;
+	std::map<std::string, std::shared_ptr<const std::string>> content_cache;
 
 	bool resolve_from_dir(const std::string& copy_dir, const std::string& copy_name, std::string& copy_file);
 };
@@ -0,0 +1,461 @@
+/*
+This file is part of Gix-IDE, an IDE and platform for GnuCOBOL
+Copyright (C) 2021 Marco Ridoni
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+USA.
+*/
+
+#include "BinaryMapFile.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <tuple>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#define BMAP_ALIGN(n)	(((n) + 7) & ~((uint64_t)7))
+
+static bool line_entry_less(const BinaryMapLineEntry& a, const BinaryMapLineEntry& b)
+{
+	return std::tie(a.from_file, a.from_line) < std::tie(b.from_file, b.from_line);
+}
+
+BinaryMapFileWriter::BinaryMapFileWriter()
+{
+	module_name = 0;
+	input_file_id = 0;
+	output_file_id = 0;
+
+	// offset 0 is the empty string
+	strings.push_back('\0');
+	string_offsets[""] = 0;
+}
+
+uint32_t BinaryMapFileWriter::addString(const std::string& s)
+{
+	auto it = string_offsets.find(s);
+	if (it != string_offsets.end())
+		return it->second;
+
+	uint32_t offset = (uint32_t)strings.size();
+	strings.append(s);
+	strings.push_back('\0');
+	string_offsets[s] = offset;
+	return offset;
+}
+
+void BinaryMapFileWriter::setModuleName(const std::string& name)
+{
+	module_name = addString(name);
+}
+
+void BinaryMapFileWriter::setInputFileId(int id)
+{
+	input_file_id = id;
+}
+
+void BinaryMapFileWriter::setOutputFileId(int id)
+{
+	output_file_id = id;
+}
+
+void BinaryMapFileWriter::addFile(int id, const std::string& name)
+{
+	file_ids[name] = id;
+	files.push_back({ (uint32_t)id, addString(name) });
+}
+
+int BinaryMapFileWriter::getFileId(const std::string& name)
+{
+	auto it = file_ids.find(name);
+	if (it != file_ids.end())
+		return it->second;
+
+	int id = 1;
+	for (const auto& f : files) {
+		if ((int)f.id >= id)
+			id = f.id + 1;
+	}
+
+	addFile(id, name);
+	return id;
+}
+
+void BinaryMapFileWriter::addInToOutMapping(int in_file_id, int in_line, int out_file_id, int out_line)
+{
+	in_to_out.push_back({ (uint32_t)in_file_id, (uint32_t)in_line, (uint32_t)out_file_id, (uint32_t)out_line });
+}
+
+void BinaryMapFileWriter::addOutToInMapping(int out_file_id, int out_line, int in_file_id, int in_line)
+{
+	out_to_in.push_back({ (uint32_t)out_file_id, (uint32_t)out_line, (uint32_t)in_file_id, (uint32_t)in_line });
+}
+
+void BinaryMapFileWriter::addParagraph(const std::string& name, const std::string& file, int line, bool is_included)
+{
+	paragraphs.push_back({ addString(name), (uint32_t)getFileId(file), (uint32_t)line, is_included ? (uint32_t)BMAP_PARAGRAPH_FLAG_INCLUDED : 0 });
+}
+
+void BinaryMapFileWriter::addField(const std::string& name, const std::string& path, const std::string& file, int line)
+{
+	fields.push_back({ addString(name), addString(path), (uint32_t)getFileId(file), (uint32_t)line });
+}
+
+bool BinaryMapFileWriter::writeToFile(const std::string& filename)
+{
+	const char* s = strings.c_str();
+
+	std::sort(files.begin(), files.end(), [](const BinaryMapFileEntry& a, const BinaryMapFileEntry& b) { return a.id < b.id; });
+	std::sort(in_to_out.begin(), in_to_out.end(), line_entry_less);
+	std::sort(out_to_in.begin(), out_to_in.end(), line_entry_less);
+
+	std::vector<BinaryMapParagraphEntry> paragraphs_by_name = paragraphs;
+	std::sort(paragraphs_by_name.begin(), paragraphs_by_name.end(), [s](const BinaryMapParagraphEntry& a, const BinaryMapParagraphEntry& b) { return strcmp(s + a.name, s + b.name) < 0; });
+
+	std::vector<BinaryMapParagraphEntry> paragraphs_by_location = paragraphs;
+	std::sort(paragraphs_by_location.begin(), paragraphs_by_location.end(), [](const BinaryMapParagraphEntry& a, const BinaryMapParagraphEntry& b) {
+		return std::tie(a.file_id, a.line) < std::tie(b.file_id, b.line);
+	});
+
+	std::sort(fields.begin(), fields.end(), [s](const BinaryMapFieldEntry& a, const BinaryMapFieldEntry& b) { return strcmp(s + a.name, s + b.name) < 0; });
+
+	struct SectionData {
+		uint32_t type;
+		uint32_t count;
+		const void* data;
+		size_t size;
+	};
+
+	std::vector<SectionData> section_data = {
+		{ BMAP_SECTION_STRINGS, (uint32_t)strings.size(), strings.data(), strings.size() },
+		{ BMAP_SECTION_FILES, (uint32_t)files.size(), files.data(), files.size() * sizeof(BinaryMapFileEntry) },
+		{ BMAP_SECTION_IN_TO_OUT, (uint32_t)in_to_out.size(), in_to_out.data(), in_to_out.size() * sizeof(BinaryMapLineEntry) },
+		{ BMAP_SECTION_OUT_TO_IN, (uint32_t)out_to_in.size(), out_to_in.data(), out_to_in.size() * sizeof(BinaryMapLineEntry) },
+		{ BMAP_SECTION_PARAGRAPHS, (uint32_t)paragraphs_by_name.size(), paragraphs_by_name.data(), paragraphs_by_name.size() * sizeof(BinaryMapParagraphEntry) },
+		{ BMAP_SECTION_PARAGRAPH_LOCATIONS, (uint32_t)paragraphs_by_location.size(), paragraphs_by_location.data(), paragraphs_by_location.size() * sizeof(BinaryMapParagraphEntry) },
+		{ BMAP_SECTION_FIELDS, (uint32_t)fields.size(), fields.data(), fields.size() * sizeof(BinaryMapFieldEntry) }
+	};
+
+	BinaryMapHeader hdr;
+	memset(&hdr, 0, sizeof(BinaryMapHeader));
+	memcpy(hdr.magic, BMAP_MAGIC, 4);
+	hdr.version = BMAP_FMT_VER;
+	hdr.section_count = (uint32_t)section_data.size();
+	hdr.module_name = module_name;
+	hdr.input_file_id = input_file_id;
+	hdr.output_file_id = output_file_id;
+
+	std::vector<BinaryMapSection> sections;
+	uint64_t offset = BMAP_ALIGN(sizeof(BinaryMapHeader) + section_data.size() * sizeof(BinaryMapSection));
+	for (const auto& sd : section_data) {
+		sections.push_back({ sd.type, sd.count, offset });
+		offset = BMAP_ALIGN(offset + sd.size);
+	}
+
+	std::ofstream ofs(filename, std::ios::binary | std::ios::trunc);
+	if (!ofs.is_open())
+		return false;
+
+	const char padding[8] = { 0 };
+	uint64_t pos = 0;
+
+	ofs.write((const char*)&hdr, sizeof(BinaryMapHeader));
+	ofs.write((const char*)sections.data(), sections.size() * sizeof(BinaryMapSection));
+	pos = sizeof(BinaryMapHeader) + sections.size() * sizeof(BinaryMapSection);
+
+	for (size_t i = 0; i < section_data.size(); i++) {
+		ofs.write(padding, sections[i].offset - pos);
+		ofs.write((const char*)section_data[i].data, section_data[i].size);
+		pos = sections[i].offset + section_data[i].size;
+	}
+	ofs.write(padding, BMAP_ALIGN(pos) - pos);
+
+	ofs.close();
+	return !ofs.fail();
+}
+
+BinaryMapFileReader::BinaryMapFileReader(const std::string& _filename)
+{
+	filename = _filename;
+	data = nullptr;
+	data_size = 0;
+	header = nullptr;
+	strings = nullptr;
+	strings_size = 0;
+#if defined(_WIN32)
+	file_handle = INVALID_HANDLE_VALUE;
+	mapping_handle = NULL;
+#endif
+}
+
+BinaryMapFileReader::~BinaryMapFileReader()
+{
+	close();
+}
+
+bool BinaryMapFileReader::open()
+{
+	close();
+
+#if defined(_WIN32)
+	file_handle = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file_handle == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER sz;
+	if (!GetFileSizeEx(file_handle, &sz) || sz.QuadPart < (LONGLONG)sizeof(BinaryMapHeader)) {
+		close();
+		return false;
+	}
+
+	mapping_handle = CreateFileMappingA(file_handle, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (!mapping_handle) {
+		close();
+		return false;
+	}
+
+	data = (const char*)MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0);
+	if (!data) {
+		close();
+		return false;
+	}
+	data_size = (size_t)sz.QuadPart;
+#else
+	int fd = ::open(filename.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(BinaryMapHeader)) {
+		::close(fd);
+		return false;
+	}
+
+	void* p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (p == MAP_FAILED)
+		return false;
+
+	data = (const char*)p;
+	data_size = st.st_size;
+#endif
+
+	header = (const BinaryMapHeader*)data;
+	if (memcmp(header->magic, BMAP_MAGIC, 4) != 0 || header->version != BMAP_FMT_VER ||
+		sizeof(BinaryMapHeader) + (uint64_t)header->section_count * sizeof(BinaryMapSection) > data_size) {
+		close();
+		return false;
+	}
+
+	uint32_t n = 0;
+	strings = (const char*)getSection(BMAP_SECTION_STRINGS, &n, 1);
+	if (!strings || n == 0 || strings[n - 1] != '\0') {
+		close();
+		return false;
+	}
+	strings_size = n;
+
+	return true;
+}
+
+void BinaryMapFileReader::close()
+{
+#if defined(_WIN32)
+	if (data)
+		UnmapViewOfFile(data);
+
+	if (mapping_handle)
+		CloseHandle(mapping_handle);
+
+	if (file_handle != INVALID_HANDLE_VALUE)
+		CloseHandle(file_handle);
+
+	mapping_handle = NULL;
+	file_handle = INVALID_HANDLE_VALUE;
+#else
+	if (data)
+		munmap((void*)data, data_size);
+#endif
+
+	data = nullptr;
+	data_size = 0;
+	header = nullptr;
+	strings = nullptr;
+	strings_size = 0;
+}
+
+const char* BinaryMapFileReader::getString(uint32_t offset) const
+{
+	if (!strings || offset >= strings_size)
+		return "";
+
+	return strings + offset;
+}
+
+const void* BinaryMapFileReader::getSection(uint32_t type, uint32_t* count, size_t entry_size) const
+{
+	*count = 0;
+	if (!header)
+		return nullptr;
+
+	const BinaryMapSection* sections = (const BinaryMapSection*)(data + sizeof(BinaryMapHeader));
+	for (uint32_t i = 0; i < header->section_count; i++) {
+		const BinaryMapSection& s = sections[i];
+		if (s.type != type)
+			continue;
+
+		if (s.offset > data_size || (uint64_t)s.count * entry_size > data_size - s.offset)
+			return nullptr;
+
+		*count = s.count;
+		return data + s.offset;
+	}
+	return nullptr;
+}
+
+std::string BinaryMapFileReader::getModuleName() const
+{
+	return header ? getString(header->module_name) : "";
+}
+
+int BinaryMapFileReader::getInputFileId() const
+{
+	return header ? header->input_file_id : 0;
+}
+
+int BinaryMapFileReader::getOutputFileId() const
+{
+	return header ? header->output_file_id : 0;
+}
+
+std::string BinaryMapFileReader::getFileName(int id) const
+{
+	uint32_t n;
+	const BinaryMapFileEntry* files = (const BinaryMapFileEntry*)getSection(BMAP_SECTION_FILES, &n, sizeof(BinaryMapFileEntry));
+	if (!files)
+		return "";
+
+	auto it = std::lower_bound(files, files + n, (uint32_t)id, [](const BinaryMapFileEntry& e, uint32_t v) { return e.id < v; });
+	if (it == files + n || it->id != (uint32_t)id)
+		return "";
+
+	return getString(it->name);
+}
+
+int BinaryMapFileReader::getFileId(const std::string& name) const
+{
+	uint32_t n;
+	const BinaryMapFileEntry* files = (const BinaryMapFileEntry*)getSection(BMAP_SECTION_FILES, &n, sizeof(BinaryMapFileEntry));
+	if (!files)
+		return 0;
+
+	// the file table is small (the program and its copybooks)
+	for (uint32_t i = 0; i < n; i++) {
+		if (name == getString(files[i].name))
+			return files[i].id;
+	}
+	return 0;
+}
+
+bool BinaryMapFileReader::findLine(uint32_t section_type, int from_file_id, int from_line, int* to_file_id, int* to_line) const
+{
+	uint32_t n;
+	const BinaryMapLineEntry* entries = (const BinaryMapLineEntry*)getSection(section_type, &n, sizeof(BinaryMapLineEntry));
+	if (!entries)
+		return false;
+
+	BinaryMapLineEntry k = { (uint32_t)from_file_id, (uint32_t)from_line, 0, 0 };
+	auto it = std::lower_bound(entries, entries + n, k, line_entry_less);
+	if (it == entries + n || it->from_file != k.from_file || it->from_line != k.from_line)
+		return false;
+
+	*to_file_id = it->to_file;
+	*to_line = it->to_line;
+	return true;
+}
+
+bool BinaryMapFileReader::findOutputLine(int in_file_id, int in_line, int* out_file_id, int* out_line) const
+{
+	return findLine(BMAP_SECTION_IN_TO_OUT, in_file_id, in_line, out_file_id, out_line);
+}
+
+bool BinaryMapFileReader::findInputLine(int out_file_id, int out_line, int* in_file_id, int* in_line) const
+{
+	return findLine(BMAP_SECTION_OUT_TO_IN, out_file_id, out_line, in_file_id, in_line);
+}
+
+bool BinaryMapFileReader::findParagraph(const std::string& name, int* file_id, int* line) const
+{
+	uint32_t n;
+	const BinaryMapParagraphEntry* entries = (const BinaryMapParagraphEntry*)getSection(BMAP_SECTION_PARAGRAPHS, &n, sizeof(BinaryMapParagraphEntry));
+	if (!entries)
+		return false;
+
+	auto it = std::lower_bound(entries, entries + n, name, [this](const BinaryMapParagraphEntry& e, const std::string& v) { return strcmp(getString(e.name), v.c_str()) < 0; });
+	if (it == entries + n || name != getString(it->name))
+		return false;
+
+	*file_id = it->file_id;
+	*line = it->line;
+	return true;
+}
+
+bool BinaryMapFileReader::findParagraphAt(int file_id, int line, std::string& name) const
+{
+	uint32_t n;
+	const BinaryMapParagraphEntry* entries = (const BinaryMapParagraphEntry*)getSection(BMAP_SECTION_PARAGRAPH_LOCATIONS, &n, sizeof(BinaryMapParagraphEntry));
+	if (!entries)
+		return false;
+
+	// first paragraph after the line, then step back
+	auto it = std::upper_bound(entries, entries + n, std::make_tuple((uint32_t)file_id, (uint32_t)line), [](const std::tuple<uint32_t, uint32_t>& v, const BinaryMapParagraphEntry& e) {
+		return v < std::tie(e.file_id, e.line);
+	});
+	if (it == entries)
+		return false;
+
+	--it;
+	if (it->file_id != (uint32_t)file_id)
+		return false;
+
+	name = getString(it->name);
+	return true;
+}
+
+bool BinaryMapFileReader::findField(const std::string& name, std::string& path, int* file_id, int* line) const
+{
+	uint32_t n;
+	const BinaryMapFieldEntry* entries = (const BinaryMapFieldEntry*)getSection(BMAP_SECTION_FIELDS, &n, sizeof(BinaryMapFieldEntry));
+	if (!entries)
+		return false;
+
+	auto it = std::lower_bound(entries, entries + n, name, [this](const BinaryMapFieldEntry& e, const std::string& v) { return strcmp(getString(e.name), v.c_str()) < 0; });
+	if (it == entries + n || name != getString(it->name))
+		return false;
+
+	path = getString(it->path);
+	*file_id = it->file_id;
+	*line = it->line;
+	return true;
+}
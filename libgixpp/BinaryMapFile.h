@@ -0,0 +1,198 @@
+/*
+This file is part of Gix-IDE, an IDE and platform for GnuCOBOL
+Copyright (C) 2021 Marco Ridoni
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+USA.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <string>
+#include <map>
+
+/*
+	Binary map file (.cbsql.bmap): the same information as the text map file, in a form that
+	can be memory-mapped and searched without being parsed.
+
+	Layout (little-endian, all the sections are aligned to 8 bytes):
+
+		header			BinaryMapHeader
+		section table	BinaryMapSection[header.section_count]
+		sections		STRINGS: NUL-terminated strings, referenced by their offset in the section
+						(offset 0 is the empty string)
+						FILES: BinaryMapFileEntry[], sorted by id
+						IN_TO_OUT, OUT_TO_IN: BinaryMapLineEntry[], sorted by (from_file, from_line)
+						PARAGRAPHS: BinaryMapParagraphEntry[], sorted by name
+						PARAGRAPH_LOCATIONS: BinaryMapParagraphEntry[], sorted by (file_id, line)
+						FIELDS: BinaryMapFieldEntry[], sorted by name
+
+	Readers must ignore sections with an unknown type; a change of the layout of the
+	existing sections requires a new format version.
+*/
+
+#define BMAP_MAGIC					"GXBM"
+#define BMAP_FMT_VER				((uint16_t) 0x0001)
+#define BMAP_FILE_EXT				".cbsql.bmap"
+
+#define BMAP_SECTION_STRINGS				1
+#define BMAP_SECTION_FILES					2
+#define BMAP_SECTION_IN_TO_OUT				3
+#define BMAP_SECTION_OUT_TO_IN				4
+#define BMAP_SECTION_PARAGRAPHS				5
+#define BMAP_SECTION_PARAGRAPH_LOCATIONS	6
+#define BMAP_SECTION_FIELDS					7
+
+#define BMAP_PARAGRAPH_FLAG_INCLUDED		0x01
+
+#pragma pack(push, 1)
+
+struct BinaryMapHeader {
+	char magic[4];
+	uint16_t version;
+	uint16_t flags;
+	uint32_t section_count;
+	uint32_t module_name;		// string
+	uint32_t input_file_id;
+	uint32_t output_file_id;
+	uint32_t reserved[2];
+};
+
+struct BinaryMapSection {
+	uint32_t type;
+	uint32_t count;				// number of entries (bytes for STRINGS)
+	uint64_t offset;			// from the start of the file
+};
+
+struct BinaryMapFileEntry {
+	uint32_t id;
+	uint32_t name;				// string
+};
+
+struct BinaryMapLineEntry {
+	uint32_t from_file;
+	uint32_t from_line;
+	uint32_t to_file;
+	uint32_t to_line;
+};
+
+struct BinaryMapParagraphEntry {
+	uint32_t name;				// string
+	uint32_t file_id;
+	uint32_t line;
+	uint32_t flags;
+};
+
+struct BinaryMapFieldEntry {
+	uint32_t name;				// string
+	uint32_t path;				// string
+	uint32_t file_id;
+	uint32_t line;
+};
+
+#pragma pack(pop)
+
+class BinaryMapFileWriter
+{
+public:
+	BinaryMapFileWriter();
+
+	void setModuleName(const std::string& name);
+	void setInputFileId(int id);
+	void setOutputFileId(int id);
+
+	// Adds a file with the given id; files referenced by paragraphs and fields and not
+	// already in the file map are added with the first free id
+	void addFile(int id, const std::string& name);
+	int getFileId(const std::string& name);
+
+	// The two maps are not symmetric: several output lines can map to the same input line
+	void addInToOutMapping(int in_file_id, int in_line, int out_file_id, int out_line);
+	void addOutToInMapping(int out_file_id, int out_line, int in_file_id, int in_line);
+	void addParagraph(const std::string& name, const std::string& file, int line, bool is_included);
+	void addField(const std::string& name, const std::string& path, const std::string& file, int line);
+
+	bool writeToFile(const std::string& filename);
+
+private:
+	uint32_t addString(const std::string& s);
+
+	std::string strings;
+	std::map<std::string, uint32_t> string_offsets;
+
+	uint32_t module_name;
+	uint32_t input_file_id;
+	uint32_t output_file_id;
+
+	std::map<std::string, int> file_ids;
+	std::vector<BinaryMapFileEntry> files;
+	std::vector<BinaryMapLineEntry> in_to_out;
+	std::vector<BinaryMapLineEntry> out_to_in;
+	std::vector<BinaryMapParagraphEntry> paragraphs;
+	std::vector<BinaryMapFieldEntry> fields;
+};
+
+/*
+	Reads a binary map file through a read-only memory mapping: open() only validates the header
+	and the section table, lookups are binary searches on the mapped tables.
+*/
+class BinaryMapFileReader
+{
+public:
+	BinaryMapFileReader(const std::string& filename);
+	~BinaryMapFileReader();
+
+	bool open();
+	void close();
+
+	std::string getModuleName() const;
+	int getInputFileId() const;
+	int getOutputFileId() const;
+
+	std::string getFileName(int id) const;
+	int getFileId(const std::string& name) const;
+
+	bool findOutputLine(int in_file_id, int in_line, int* out_file_id, int* out_line) const;
+	bool findInputLine(int out_file_id, int out_line, int* in_file_id, int* in_line) const;
+
+	bool findParagraph(const std::string& name, int* file_id, int* line) const;
+
+	// The paragraph that contains the given line (the last one that starts at or before it in the same file)
+	bool findParagraphAt(int file_id, int line, std::string& name) const;
+
+	bool findField(const std::string& name, std::string& path, int* file_id, int* line) const;
+
+private:
+	const char* getString(uint32_t offset) const;
+	const void* getSection(uint32_t type, uint32_t* count, size_t entry_size) const;
+	bool findLine(uint32_t section_type, int from_file_id, int from_line, int* to_file_id, int* to_line) const;
+
+	std::string filename;
+
+	const char* data;
+	size_t data_size;
+
+#if defined(_WIN32)
+	void* file_handle;
+	void* mapping_handle;
+#endif
+
+	const BinaryMapHeader* header;
+	const char* strings;
+	uint32_t strings_size;
+};
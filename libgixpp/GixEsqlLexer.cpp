@@ -23,6 +23,8 @@ USA.
 #include "libcpputils.h"
 
 #include <istream>
+#include <fstream>
+#include <sstream>
 #include <filesystem>
 #include <regex>
 
@@ -149,8 +151,16 @@ void GixEsqlLexer::pushNewFile(const std::string file_name, gix_esql_driver *dri
 		}
 	}
 
-	std::istream *in_file = new std::ifstream(file_full_name);
-	yy_buffer_state *new_buffer = yy_create_buffer(in_file, YY_BUF_SIZE);
+	// Copy files are read through the resolver's cache, since they are usually shared by many programs
+	std::unique_ptr<std::istream> in_file;
+	std::shared_ptr<const std::string> content = resolve_as_copy ? driver->preprocessor()->getCopyResolver()->getCopyFileContent(file_full_name) : nullptr;
+	if (content)
+		in_file = std::make_unique<std::istringstream>(*content);
+	else
+		in_file = std::make_unique<std::ifstream>(file_full_name);
+
+	yy_buffer_state *new_buffer = yy_create_buffer(in_file.get(), YY_BUF_SIZE);
+	include_streams.push_back(std::move(in_file));
 
 	if (driver->preprocessor()->verbose_debug)
 		printf("Switching to file %s\n", file_full_name.c_str());
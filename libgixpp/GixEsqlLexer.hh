@@ -34,6 +34,9 @@ USA.
 #include <stack>
 #include <map>
 #include <string>
+#include <vector>
+#include <memory>
+#include <istream>
 
 #include "gix_esql_parser.hh"
 
@@ -88,6 +91,17 @@ private:
 
     std::vector<std::string> reserved_words_list;
 
+    // Scanner state: it belongs to the lexer instance, so that several
+    // files can be preprocessed at the same time in different threads
+    yy::location loc;   // the location of the current token
+    int subquery_level = 0;
+    std::vector<std::string> cur_token_list;
+
+    // Streams for the included files, released with the lexer
+    std::vector<std::unique_ptr<std::istream>> include_streams;
+
+    yy::gix_esql_parser::symbol_type __MAKE_TOKEN(char *s, yy::location loc);
+
     bool is_current_cmd_dml();
     bool is_current_cmd_select();
     bool is_current_cmd_passthru();
@@ -115,8 +115,13 @@ struct ESQLJobParams
 	bool opt_consolidated_map;
 	bool opt_no_output;
 	bool opt_emit_map_file;
+	bool opt_emit_text_map;
+	bool opt_emit_binary_map;
 	bool opt_emit_cobol85;
 	bool opt_picx_as_varchar;
+	bool opt_emit_stmt_flags;
+	bool opt_emit_manifest;
+	bool opt_emit_stmt_ids;
 	int opt_norec_sqlcode = 100;
 	std::string opt_varlen_suffix_len;
 	std::string opt_varlen_suffix_data;
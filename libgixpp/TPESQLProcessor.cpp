@@ -23,12 +23,14 @@ USA.
 #include "ESQLCall.h"
 #include "gix_esql_driver.hh"
 #include "MapFileWriter.h"
+#include "BinaryMapFile.h"
 #include "libcpputils.h"
 #include "limits.h"
 #include "linq/linq.hpp"
 
 #include "cobol_var_types.h"
 #include "varlen_defs.h"
+#include "sql_stmt_flags.h"
 
 #if defined(_WIN32) && defined(_DEBUG)
 #include <Windows.h>
@@ -55,6 +57,8 @@ USA.
 #define CBL_FIELD_FLAG_AUTOTRIM	(uint32_t)0x200
 
 #define MAP_FILE_FMT_VER ((uint16_t) 0x0100)
+
+#define STMT_SRC_FILE_MAX_LEN		24
 #define FLAG_M_BASE					0
 
 #define ERR_NOTDEF_CONVERSION -1
@@ -92,18 +96,6 @@ static std::map<std::string, ESQL_Command> ESQL_cmd_map{ { ESQL_CONNECT, ESQL_Co
 #define CALL_PREFIX	"GIXSQL"
 #define TAG_PREFIX	"GIXSQL"
 
-struct esql_whenever_clause_handler_t {
-	int action = WHENEVER_ACTION_CONTINUE;
-	std::string host_label;
-};
-
-static struct esql_whenever_handler_t
-{
-	esql_whenever_clause_handler_t not_found;
-	esql_whenever_clause_handler_t sqlwarning;
-	esql_whenever_clause_handler_t sqlerror;
-} esql_whenever_handler;
-
 inline std::string TPESQLProcessor::get_call_id(const std::string s)
 {
 	return CALL_PREFIX + s;
@@ -128,8 +120,16 @@ bool TPESQLProcessor::run(std::shared_ptr<ITransformationStep> prev_step)
 	parser_data->job_params()->opt_consolidated_map = std::get<bool>(owner->getOpt("consolidated_map", false));
 	parser_data->job_params()->opt_no_output = std::get<bool>(owner->getOpt("no_output", false));
 	parser_data->job_params()->opt_emit_map_file = std::get<bool>(owner->getOpt("emit_map_file", false));
+
+	// map_format: text (default), binary or both
+	auto map_format = to_lower(std::get<std::string>(owner->getOpt("map_format", std::string("text"))));
+	parser_data->job_params()->opt_emit_text_map = map_format != "binary";
+	parser_data->job_params()->opt_emit_binary_map = map_format == "binary" || map_format == "both";
 	parser_data->job_params()->opt_emit_cobol85 = std::get<bool>(owner->getOpt("emit_cobol85", false));
 	parser_data->job_params()->opt_picx_as_varchar = std::get<bool>(owner->getOpt("picx_as_varchar", false));
+	parser_data->job_params()->opt_emit_stmt_flags = std::get<bool>(owner->getOpt("emit_stmt_flags", false));
+	parser_data->job_params()->opt_emit_manifest = std::get<bool>(owner->getOpt("emit_manifest", false));
+	parser_data->job_params()->opt_emit_stmt_ids = std::get<bool>(owner->getOpt("emit_stmt_ids", false));
 
 	auto vsfxs = std::get<std::string>(owner->getOpt("varlen_suffixes", std::string()));
 	if (vsfxs.empty()) {
@@ -149,6 +149,11 @@ bool TPESQLProcessor::run(std::shared_ptr<ITransformationStep> prev_step)
 	working_end_line = 0;
 	current_input_line = 0;
 
+	map_enabled = parser_data->job_params()->opt_emit_map_file || parser_data->job_params()->opt_emit_debug_info || parser_data->job_params()->opt_no_output;
+	src_map_runs.clear();
+	map_cur_file.clear();
+	map_cur_file_id = 0;
+
 	if (parser_data->job_params()->opt_params_style == ESQL_ParameterStyle::Unknown) {
 		raise_error("Unsupported or invalid parameter style", ERR_PP_PARAM_ERROR);
 		return false;
@@ -198,17 +203,23 @@ int TPESQLProcessor::outputESQL()
 		return -1;
 	}
 
+	// The output file always has id 1 in the file map
+	filemap.clear();
+	if (map_enabled)
+		filemap[output_file] = 1;
+
 	input_file_stack.push(filename_clean_path(input_file));
 
 	if (!find_working_storage(&working_begin_line, &working_end_line))
 		return -1;
 
-	startup_items = cpplinq::from(*(parser_data->exec_list())).where([](cb_exec_sql_stmt_ptr p) { return p->startup_item != 0; }).to_vector();
 	process_sql_query_list();
 	if (!fixup_declared_vars()) {
 		return -1;
 	}
 
+	build_exec_sql_index();
+
 
 #if defined(_WIN32) && defined(_DEBUG)
 	std::vector<cb_exec_sql_stmt_ptr>* p = parser_data->exec_list();
@@ -239,8 +250,15 @@ int TPESQLProcessor::outputESQL()
 		b2 = true;
 	}
 	else {
-		if (parser_data->job_params()->opt_emit_map_file)
-			b2 = write_map_file(output_file);
+		if (parser_data->job_params()->opt_emit_map_file) {
+			build_map_data();
+			b2 = true;
+			if (parser_data->job_params()->opt_emit_text_map)
+				b2 = write_map_file(output_file);
+
+			if (parser_data->job_params()->opt_emit_binary_map)
+				b2 = write_binary_map_file(output_file) && b2;
+		}
 		else {
 			build_map_data();
 			b2 = true;
@@ -277,7 +295,11 @@ bool TPESQLProcessor::generate_consolidated_map()
 bool TPESQLProcessor::processNextFile()
 {
 	std::string the_file = input_file_stack.top();
-	std::vector<std::string> input_lines = file_read_all_lines(the_file);
+	std::vector<std::string> input_lines;
+	if (is_current_file_included())
+		owner->getCopyResolver()->getCopyFileLines(the_file, input_lines);
+	else
+		input_lines = file_read_all_lines(the_file);
 
 #if defined(_WIN32) && defined(_DEBUG) && defined(VERBOSE)
 	char bfr[512];
@@ -294,14 +316,17 @@ bool TPESQLProcessor::processNextFile()
 	}
 
 	std::string f1 = filename_absolute_path(the_file);
+	auto it_line_index = exec_sql_line_index.find(f1);
+	const std::vector<cb_exec_sql_stmt_ptr>* line_index = (it_line_index != exec_sql_line_index.end()) ? &it_line_index->second : nullptr;
+
 	for (int input_line = 1; input_line <= input_lines.size(); input_line++) {
 		current_input_line = input_line;
 
-		std::string cur_line = input_lines.at(input_line - 1);
+		const std::string& cur_line = input_lines.at(input_line - 1);
 
 		bool in_ws = (input_line >= working_begin_line) && (input_line <= working_end_line);
 
-		cb_exec_sql_stmt_ptr exec_sql_stmt = find_exec_sql_stmt(f1, input_line);
+		cb_exec_sql_stmt_ptr exec_sql_stmt = find_exec_sql_stmt(line_index, input_line);
 		if (!exec_sql_stmt) {
 			put_output_line(cur_line);
 			continue;
@@ -396,6 +421,146 @@ void TPESQLProcessor::put_end_exec_sql(bool with_period)
 	put_call(start_exec_sql_call, with_period);
 }
 
+// Static SQL is classified here, once, so that the runtime does not need to inspect the statement text
+void TPESQLProcessor::put_statement_flags(const ESQL_Command cmd, const cb_exec_sql_stmt_ptr stmt)
+{
+	if (!parser_data->job_params()->opt_emit_stmt_flags)
+		return;
+
+	uint32_t flags = SQL_STMT_FLAG_VALID;
+
+	switch (cmd) {
+		case ESQL_Command::Select:
+			flags |= SQL_STMT_FLAG_SELECT | SQL_STMT_FLAG_HAS_RESULTS;
+			break;
+
+		case ESQL_Command::Insert:
+			flags |= SQL_STMT_FLAG_INSERT;
+			break;
+
+		case ESQL_Command::Update:
+			flags |= SQL_STMT_FLAG_UPDATE;
+			break;
+
+		case ESQL_Command::Delete:
+			flags |= SQL_STMT_FLAG_DELETE;
+			break;
+
+		case ESQL_Command::Commit:
+		case ESQL_Command::Rollback:
+			flags |= SQL_STMT_FLAG_TX_END;
+			break;
+
+		default:
+			// Anything else is not classified, the runtime will fall back to inspecting the statement text
+			return;
+	}
+
+	if ((cmd == ESQL_Command::Update || cmd == ESQL_Command::Delete) && stmt->sql_query_list_id > 0) {
+		std::string sql = to_upper(this->ws_query_list.at(stmt->sql_query_list_id - 1));
+		sql = string_replace(sql, "\r", " ");
+		sql = string_replace(sql, "\n", " ");
+		sql = string_replace(sql, "\t", " ");
+		if (sql.find("WHERE CURRENT OF") != std::string::npos)
+			flags |= SQL_STMT_FLAG_POSITIONED;
+	}
+
+	ESQLCall flags_call(get_call_id("SetStatementFlags"), parser_data->job_params()->opt_emit_static_calls);
+	flags_call.addParameter((int)flags, BY_VALUE);
+	put_call(flags_call, false);
+}
+
+// Static statements are identified by module and query id (e.g. "PROG1:SQ0001"), so that the runtime
+// can report them (e.g. in its metrics) without using their text. The source file and line of the
+// statement (the same location recorded in the map file) are passed too, for the slow statement log
+void TPESQLProcessor::put_statement_id(const cb_exec_sql_stmt_ptr stmt)
+{
+	if (!parser_data->job_params()->opt_emit_stmt_ids || stmt->sql_query_list_id <= 0)
+		return;
+
+	std::string stmt_id = string_format("%s:SQ%04d", parser_data->program_id(), stmt->sql_query_list_id);
+
+	// Only the file name is passed, and it is truncated (from the left) if needed, so that the generated line fits in area B
+	std::string src_file = filename_get_name(stmt->src_file);
+	if (src_file.length() > STMT_SRC_FILE_MAX_LEN)
+		src_file = src_file.substr(src_file.length() - STMT_SRC_FILE_MAX_LEN);
+
+	ESQLCall id_call(get_call_id("SetStatementId"), parser_data->job_params()->opt_emit_static_calls);
+	id_call.addParameter("\"" + stmt_id + "\" & x\"00\"", BY_REFERENCE);
+	id_call.addParameter("\"" + src_file + "\" & x\"00\"", BY_REFERENCE);
+	id_call.addParameter(stmt->startLine, BY_VALUE);
+	put_call(id_call, false);
+}
+
+// The manifest lists the static statements with input parameters, with the types of their parameters:
+// it is registered with the runtime before the first CONNECT, so that the statements can be prepared
+// in advance on the new connection (if the driver supports it and the data source enables it)
+void TPESQLProcessor::add_manifest_param(const cb_exec_sql_stmt_ptr stmt, CobolVarType type, int flags)
+{
+	if (!parser_data->job_params()->opt_emit_manifest || stmt->sql_query_list_id <= 0)
+		return;
+
+	if (stmt->commandName != ESQL_SELECT && stmt->commandName != ESQL_INSERT && stmt->commandName != ESQL_UPDATE && stmt->commandName != ESQL_DELETE)
+		return;
+
+	if (manifest_params.find(stmt) == manifest_params.end())
+		manifest_stmts.push_back(stmt);
+
+	manifest_params[stmt].push_back(std::make_pair(type, flags));
+}
+
+void TPESQLProcessor::put_manifest_registration_check()
+{
+	if (!parser_data->job_params()->opt_emit_manifest)
+		return;
+
+	put_output_line(AREA_B_CPREFIX "IF GIXSQL-MF-F = ' '");
+	put_output_line(AREA_B_CPREFIX "    PERFORM GIXSQL-MF-P");
+	put_output_line(AREA_B_CPREFIX "    MOVE 'X' TO GIXSQL-MF-F");
+	put_output_line(AREA_B_CPREFIX "END-IF");
+}
+
+bool TPESQLProcessor::put_manifest()
+{
+	if (!parser_data->job_params()->opt_emit_manifest)
+		return true;
+
+	bool emit_static = parser_data->job_params()->opt_emit_static_calls;
+	std::set<int> registered_queries;
+
+	put_output_line(AREA_A_CPREFIX "GIXSQL-MF-P.");
+
+	for (cb_exec_sql_stmt_ptr stmt : manifest_stmts) {
+		// Cursors declared on a host variable are not static
+		std::string sql_content = this->ws_query_list.at(stmt->sql_query_list_id - 1);
+		if (starts_with(sql_content, "@:"))
+			continue;
+
+		if (registered_queries.find(stmt->sql_query_list_id) != registered_queries.end())
+			continue;
+
+		registered_queries.insert(stmt->sql_query_list_id);
+
+		for (auto p : manifest_params[stmt]) {
+			ESQLCall p_call(get_call_id("RegisterStatementParam"), emit_static);
+			p_call.addParameter(p.first, BY_VALUE);
+			p_call.addParameter(p.second, BY_VALUE);
+			if (!put_call(p_call, false))
+				return false;
+		}
+
+		ESQLCall r_call(get_call_id("RegisterStatement"), emit_static);
+		r_call.addParameter(string_format("SQ%04d", stmt->sql_query_list_id), BY_REFERENCE);
+		r_call.addParameter(stmt->cursorName.empty() ? 0 : 1, BY_VALUE);
+		if (!put_call(r_call, false))
+			return false;
+	}
+
+	put_output_line(AREA_B_CPREFIX "CONTINUE.");
+
+	return true;
+}
+
 std::string take_max(std::string& s, int n)
 {
 	std::string res;
@@ -529,8 +694,7 @@ bool TPESQLProcessor::put_cursor_declarations()
 	put_output_line(std::string(_areab) + "GO TO GIX-SKIP-CRSR-INIT.");
 
 	auto cursor_list = startup_items;
-	auto other_crsrs = cpplinq::from(*(parser_data->exec_list())).where([](cb_exec_sql_stmt_ptr p) { return p->startup_item == 0 && p->commandName == ESQL_SELECT && !p->cursorName.empty(); }).to_vector();
-	cursor_list.insert(cursor_list.end(), other_crsrs.begin(), other_crsrs.end());
+	cursor_list.insert(cursor_list.end(), other_cursors.begin(), other_cursors.end());
 
 	for (cb_exec_sql_stmt_ptr stmt : cursor_list) {
 		bool has_params = stmt->host_list->size() > 0;
@@ -614,6 +778,9 @@ bool TPESQLProcessor::put_cursor_declarations()
 		}
 	}
 
+	if (!put_manifest())
+		return false;
+
 	put_output_line(AREA_A_CPREFIX "GIX-SKIP-CRSR-INIT.");
 
 	put_output_line(code_tag + "*");
@@ -643,32 +810,63 @@ bool TPESQLProcessor::put_call(const ESQLCall& c, bool terminate_with_period, in
 	return true;
 }
 
-cb_exec_sql_stmt_ptr TPESQLProcessor::find_exec_sql_stmt(const std::string f1, int i)
+// The ESQL block list is scanned once here, instead of once for each input line. When blocks overlap
+// (e.g. the declaration of a host variable and the comment block that replaces its definition), the line
+// is assigned to the first one in the list, as the previous linear search did.
+void TPESQLProcessor::build_exec_sql_index()
 {
-	std::vector<cb_exec_sql_stmt_ptr>* p = parser_data->exec_list();
-	for (auto e : *p) {
-		std::string f2 = e->src_abs_path;
-		if (f1 == f2 && (e->startLine <= i && e->endLine >= i))
-			return e;
+	exec_sql_line_index.clear();
+	exec_sql_cmd_index.clear();
+	startup_cursor_names.clear();
+	other_cursors.clear();
+	startup_items.clear();
+
+	for (auto e : *(parser_data->exec_list())) {
+		exec_sql_cmd_index[e->commandName].push_back(e);
+
+		if (e->startup_item != 0) {
+			startup_items.push_back(e);
+			startup_cursor_names.insert(e->cursorName);
+		}
+		else {
+			if (e->commandName == ESQL_SELECT && !e->cursorName.empty())
+				other_cursors.push_back(e);
+		}
+
+		if (e->startLine <= 0 || e->endLine < e->startLine)
+			continue;
+
+		std::vector<cb_exec_sql_stmt_ptr>& line_index = exec_sql_line_index[e->src_abs_path];
+		if (line_index.size() <= e->endLine)
+			line_index.resize(e->endLine + 1, nullptr);
+
+		for (int i = e->startLine; i <= e->endLine; i++) {
+			if (!line_index[i])
+				line_index[i] = e;
+		}
 	}
+}
 
-	return NULL;
+cb_exec_sql_stmt_ptr TPESQLProcessor::find_exec_sql_stmt(const std::vector<cb_exec_sql_stmt_ptr>* line_index, int i)
+{
+	if (!line_index || i < 0 || i >= line_index->size())
+		return NULL;
+
+	return line_index->at(i);
 }
 
 cb_exec_sql_stmt_ptr TPESQLProcessor::find_esql_cmd(std::string cmd, int idx)
 {
-	int n = 0;
-	std::vector<cb_exec_sql_stmt_ptr>* p = parser_data->exec_list();
-	for (auto e : *p) {
-		if (e->commandName == cmd) {
-			if (n == idx)
-				return e;
-			else
-				n++;
-		}
-	}
+	auto it = exec_sql_cmd_index.find(cmd);
+	if (it == exec_sql_cmd_index.end() || idx < 0 || idx >= it->second.size())
+		return NULL;
+
+	return it->second.at(idx);
+}
 
-	return NULL;
+bool TPESQLProcessor::is_startup_cursor(const std::string& crsr_name)
+{
+	return startup_cursor_names.find(crsr_name) != startup_cursor_names.end();
 }
 
 void TPESQLProcessor::put_output_line(const std::string& line)
@@ -677,13 +875,58 @@ void TPESQLProcessor::put_output_line(const std::string& line)
 
 	output_lines.push_back(line);
 
-	std::string output_id = string_format("%d@%s", output_line, output_file);
-	std::string input_id = string_format("%d@%s", current_input_line, input_file_stack.top());
-#if defined(_WIN32) && defined(_DEBUG) && defined(_DEBUG_LOG_ON)
-	OutputDebugStringA((input_id + "-> " + output_id + "\n").toLocal8Bit().constData());
-#endif
-	out_to_in[output_id] = input_id;
-	in_to_out[input_id] = output_id;
+	if (!map_enabled)
+		return;
+
+	// The file id is cached, the input file only changes when entering or leaving a copybook
+	const std::string& in_file = input_file_stack.top();
+	if (map_cur_file_id == 0 || in_file != map_cur_file) {
+		map_cur_file = in_file;
+		map_cur_file_id = get_map_file_id(in_file);
+	}
+
+	map_add_line(output_line, map_cur_file_id, current_input_line);
+}
+
+int TPESQLProcessor::get_map_file_id(const std::string& filename)
+{
+	auto it = filemap.find(filename);
+	if (it != filemap.end())
+		return it->second;
+
+	int id = filemap.size() + 1;
+	filemap[filename] = id;
+	return id;
+}
+
+// Unlike get_map_file_id, this does not add the file to the map (0 means not found).
+// Files other than the output one are stored with their clean path.
+int TPESQLProcessor::find_map_file_id(const std::string& filename) const
+{
+	auto it = filemap.find(filename);
+	if (it == filemap.end() && file_exists(filename))
+		it = filemap.find(filename_clean_path(filename));
+
+	return (it != filemap.end()) ? it->second : 0;
+}
+
+void TPESQLProcessor::map_add_line(int out_line, int in_file_id, int in_line)
+{
+	if (!src_map_runs.empty()) {
+		SrcMapRun& r = src_map_runs.back();
+		if (out_line == r.out_start + r.count && in_file_id == r.in_file_id) {
+			// the second line of a run decides whether the input line stays the same or is incremented
+			if (r.count == 1 && (in_line == r.in_start || in_line == r.in_start + 1))
+				r.in_step = in_line - r.in_start;
+
+			if (in_line == r.in_start + r.count * r.in_step) {
+				r.count++;
+				return;
+			}
+		}
+	}
+
+	src_map_runs.push_back({ out_line, in_file_id, in_line, 1, 0 });
 }
 
 bool TPESQLProcessor::handle_esql_stmt(const ESQL_Command cmd, const cb_exec_sql_stmt_ptr stmt, bool in_ws)
@@ -713,6 +956,10 @@ bool TPESQLProcessor::handle_esql_stmt(const ESQL_Command cmd, const cb_exec_sql
 
 		// Cursor initialization flags (if requested)
 		put_smart_cursor_init_flags();
+
+		// Module manifest registration flag
+		if (parser_data->job_params()->opt_emit_manifest)
+			put_output_line(code_tag + " 01  GIXSQL-MF-F PIC X.");
 		break;
 
 	case ESQL_Command::Incfile:
@@ -760,6 +1007,8 @@ bool TPESQLProcessor::handle_esql_stmt(const ESQL_Command cmd, const cb_exec_sql
 
 	case ESQL_Command::Connect:
 	{
+		put_manifest_registration_check();
+
 		ESQLCall connect_call(get_call_id("Connect"), emit_static);
 		connect_call.addParameter("SQLCA", BY_REFERENCE);
 
@@ -816,6 +1065,8 @@ bool TPESQLProcessor::handle_esql_stmt(const ESQL_Command cmd, const cb_exec_sql
 			int res_params_count = 0;
 
 			put_start_exec_sql(false);
+			put_statement_flags(cmd, stmt);
+			put_statement_id(stmt);
 
 			if (!put_res_host_parameters(stmt, &res_params_count))
 				return false;
@@ -861,7 +1112,7 @@ bool TPESQLProcessor::handle_esql_stmt(const ESQL_Command cmd, const cb_exec_sql
 			put_whenever_handler(stmt->period);
 		}
 		else {
-			bool is_crsr_startup_item = cpplinq::from(startup_items).where([stmt](cb_exec_sql_stmt_ptr p) { return p->cursorName == stmt->cursorName; }).to_vector().size() > 0;
+			bool is_crsr_startup_item = is_startup_cursor(stmt->cursorName);
 			if (!is_crsr_startup_item) {
 				put_smart_cursor_init_check(stmt->cursorName, true);
 			}
@@ -871,7 +1122,7 @@ bool TPESQLProcessor::handle_esql_stmt(const ESQL_Command cmd, const cb_exec_sql
 
 	case ESQL_Command::Open:
 	{
-		bool is_crsr_startup_item = cpplinq::from(startup_items).where([stmt](cb_exec_sql_stmt_ptr p) { return p->cursorName == stmt->cursorName; }).to_vector().size() > 0;
+		bool is_crsr_startup_item = is_startup_cursor(stmt->cursorName);
 
 		// We need to add a check only if the cursor has been declared in the WORKING-STORAGE section
 		std::string crsr_init_var = "GIXSQL-CI-F-" + string_replace(stmt->cursorName, "_", "-");
@@ -1035,6 +1286,8 @@ bool TPESQLProcessor::handle_esql_stmt(const ESQL_Command cmd, const cb_exec_sql
 	{
 		// Note: RELEASE not supported, in case check the stmt->transaction_release flag
 		put_start_exec_sql(false);
+		put_statement_flags(cmd, stmt);
+		put_statement_id(stmt);
 		ESQLCall commit_call(get_call_id("Exec"), emit_static);
 		commit_call.addParameter("SQLCA", BY_REFERENCE);
 		commit_call.addParameter(parser_data.get(), stmt->connectionId);
@@ -1053,6 +1306,8 @@ bool TPESQLProcessor::handle_esql_stmt(const ESQL_Command cmd, const cb_exec_sql
 	{
 		// Note: RELEASE not supported, in case check the stmt->transaction_release flag
 		put_start_exec_sql(false);
+		put_statement_flags(cmd, stmt);
+		put_statement_id(stmt);
 		ESQLCall rollback_call(get_call_id("Exec"), emit_static);
 		rollback_call.addParameter("SQLCA", BY_REFERENCE);
 		rollback_call.addParameter(parser_data.get(), stmt->connectionId);
@@ -1073,6 +1328,8 @@ bool TPESQLProcessor::handle_esql_stmt(const ESQL_Command cmd, const cb_exec_sql
 	case ESQL_Command::Insert:
 	{
 		put_start_exec_sql(false);
+		put_statement_flags(cmd, stmt);
+		put_statement_id(stmt);
 
 		int sql_params_count = 0;
 
@@ -1140,6 +1397,8 @@ bool TPESQLProcessor::handle_esql_stmt(const ESQL_Command cmd, const cb_exec_sql
 					if (!put_call(pp_call, false))
 						return false;
 
+					add_manifest_param(stmt, pp_type, pp_flags);
+
 					sql_params_count++;
 
 					pp = pp->sister;
@@ -1171,6 +1430,8 @@ bool TPESQLProcessor::handle_esql_stmt(const ESQL_Command cmd, const cb_exec_sql
 				if (!put_call(p_call, false))
 					return false;
 
+				add_manifest_param(stmt, f_type, flags);
+
 				sql_params_count++;
 			}
 		}
@@ -1741,40 +2002,20 @@ std::map<uint64_t, uint64_t>& TPESQLProcessor::getBinarySrcLineMapReverse() cons
 
 bool TPESQLProcessor::build_map_data()
 {
-	map_collect_files(filemap);
-
-	std::string file;
-	int line_in, line_out;
-	//uint64_t k, v;
-
-	// in to out map
-	for (std::map<std::string, std::string>::const_iterator it = in_to_out.begin(); it != in_to_out.end(); ++it) {
-		splitLineEntry(it->first, file, &line_in);
-		int fin_id = filemap[file];
-
-		splitLineEntry(it->second, file, &line_out);
-		int fout_id = filemap[file];
-
-		uint64_t k = ((uint64_t)fin_id << 32) + line_in;
-		uint64_t v = ((uint64_t)fout_id << 32) + line_out;
-
-		b_in_to_out[k] = v;
-	}
-
-	// out to in map
-	for (std::map<std::string, std::string>::const_iterator it = out_to_in.begin(); it != out_to_in.end(); ++it) {
-
-		splitLineEntry(it->first, file, &line_out);
-		int fout_id = filemap[file];
-
-		splitLineEntry(it->second, file, &line_in);
-		int fin_id = filemap[file];
-
-		uint64_t k = ((uint64_t)fout_id << 32) + line_out;
-		uint64_t v = ((uint64_t)fin_id << 32) + line_in;
-
-		b_out_to_in[k] = v;
-
+	b_in_to_out.clear();
+	b_out_to_in.clear();
+
+	// Runs are replayed in output order, so when several output lines map to the same input line,
+	// the input line maps to the last one
+	const uint64_t fout_id = 1;
+	for (const SrcMapRun& r : src_map_runs) {
+		for (int i = 0; i < r.count; i++) {
+			uint64_t k = (fout_id << 32) + (r.out_start + i);
+			uint64_t v = ((uint64_t)r.in_file_id << 32) + (r.in_start + i * r.in_step);
+
+			b_out_to_in[k] = v;
+			b_in_to_out[v] = k;
+		}
 	}
 
 	// Variable declaraton source location info
@@ -1803,10 +2044,26 @@ bool TPESQLProcessor::build_map_data()
 	return true;
 }
 
-bool TPESQLProcessor::write_map_file(const std::string& preprocd_file)
+// Declaration path of a field, e.g. "WS:REC:SUB:FLD"
+static std::string get_field_path(cb_field_ptr fld)
 {
-	map_collect_files(filemap);
+	std::string path;
 
+	cb_field_ptr p = fld;
+	do {
+		path = p->sname + ":" + path;
+		p = p->parent;
+	} while (p);
+
+	if (path.length() > 0)
+		path = path.substr(0, path.length() - 1);
+
+	return "WS:" + path;
+}
+
+// The map data must have already been built (build_map_data)
+bool TPESQLProcessor::write_map_file(const std::string& preprocd_file)
+{
 	if (parser_data->job_params()->opt_no_output)
 		return true;
 
@@ -1821,8 +2078,8 @@ bool TPESQLProcessor::write_map_file(const std::string& preprocd_file)
 	mw.appendToSectionContents("map", nflags);
 	mw.appendToSectionContents("map", input_file);
 	mw.appendToSectionContents("map", output_file);
-	mw.appendToSectionContents("map", filemap[input_file]);
-	mw.appendToSectionContents("map", filemap[output_file]);
+	mw.appendToSectionContents("map", find_map_file_id(input_file));
+	mw.appendToSectionContents("map", find_map_file_id(output_file));
 
 	// file map
 	mw.addSection("filemap");
@@ -1831,36 +2088,22 @@ bool TPESQLProcessor::write_map_file(const std::string& preprocd_file)
 		mw.appendToSectionContents("filemap", string_format("#%d:%s", it->second, it->first));
 	}
 
-	std::string file;
-	int line_in, line_out;
-
 	// in to out map
 	mw.addSection("in_to_out_map");
-	mw.appendToSectionContents("in_to_out_map", in_to_out.size());
-
-	for (std::map<std::string, std::string>::const_iterator it = in_to_out.begin(); it != in_to_out.end(); ++it) {
-		splitLineEntry(it->first, file, &line_in);
-		int fin_id = filemap[file];
-
-		splitLineEntry(it->second, file, &line_out);
-		int fout_id = filemap[file];
+	mw.appendToSectionContents("in_to_out_map", b_in_to_out.size());
 
-		mw.appendToSectionContents("in_to_out_map", string_format("%d@%d:%d@%d", line_in, fin_id, line_out, fout_id));
+	for (auto it = b_in_to_out.begin(); it != b_in_to_out.end(); ++it) {
+		mw.appendToSectionContents("in_to_out_map", string_format("%d@%d:%d@%d", (int)(it->first & 0xffffffff), (int)(it->first >> 32),
+			(int)(it->second & 0xffffffff), (int)(it->second >> 32)));
 	}
 
 	// out to in map
 	mw.addSection("out_to_in_map");
-	mw.appendToSectionContents("out_to_in_map", out_to_in.size());
-
-	for (std::map<std::string, std::string>::const_iterator it = out_to_in.begin(); it != out_to_in.end(); ++it) {
-
-		splitLineEntry(it->first, file, &line_out);
-		int fout_id = filemap[file];
-
-		splitLineEntry(it->second, file, &line_in);
-		int fin_id = filemap[file];
+	mw.appendToSectionContents("out_to_in_map", b_out_to_in.size());
 
-		mw.appendToSectionContents("out_to_in_map", string_format("%d@%d:%d@%d", line_out, fout_id, line_in, fin_id));
+	for (auto it = b_out_to_in.begin(); it != b_out_to_in.end(); ++it) {
+		mw.appendToSectionContents("out_to_in_map", string_format("%d@%d:%d@%d", (int)(it->first & 0xffffffff), (int)(it->first >> 32),
+			(int)(it->second & 0xffffffff), (int)(it->second >> 32)));
 	}
 
 	// Variable declaraton source location info
@@ -1869,25 +2112,50 @@ bool TPESQLProcessor::write_map_file(const std::string& preprocd_file)
 	auto const fmap = parser_data->get_field_map();
 	mw.appendToSectionContents("field_map", fmap.size());
 	for (std::map<std::string, cb_field_ptr>::const_iterator it = fmap.begin(); it != fmap.end(); ++it) {
-		std::string path;
-		std::string var = it->first;
 		cb_field_ptr fld = it->second;
+		mw.appendToSectionContents("field_map", string_format("%s/%s@%s:%d", fld->sname, get_field_path(fld), fld->defined_at_source_file, fld->defined_at_source_line));
+	}
 
-		cb_field_ptr p = fld;
-		do {
-			path = p->sname + ":" + path;
-			p = p->parent;
-		} while (p);
+	return mw.writeToFile(outfile);
+}
 
-		if (path.length() > 0)
-			path = path.substr(0, path.length() - 1);
+// Same contents as the text map file, in the binary format defined in BinaryMapFile.h.
+// The map data must have already been built (build_map_data)
+bool TPESQLProcessor::write_binary_map_file(const std::string& preprocd_file)
+{
+	if (parser_data->job_params()->opt_no_output)
+		return true;
 
-		path = "WS:" + path;
+	BinaryMapFileWriter bw;
+	std::string outfile = filename_change_ext(preprocd_file, BMAP_FILE_EXT);
 
-		mw.appendToSectionContents("field_map", string_format("%s/%s@%s:%d", fld->sname, path, fld->defined_at_source_file, fld->defined_at_source_line));
+	bw.setModuleName(parser_data->program_id());
+	for (auto it = filemap.begin(); it != filemap.end(); ++it) {
+		bw.addFile(it->second, it->first);
 	}
+	bw.setInputFileId(find_map_file_id(input_file));
+	bw.setOutputFileId(find_map_file_id(output_file));
 
-	return mw.writeToFile(outfile);
+	for (auto it = b_in_to_out.begin(); it != b_in_to_out.end(); ++it) {
+		bw.addInToOutMapping((int)(it->first >> 32), (int)(it->first & 0xffffffff), (int)(it->second >> 32), (int)(it->second & 0xffffffff));
+	}
+
+	for (auto it = b_out_to_in.begin(); it != b_out_to_in.end(); ++it) {
+		bw.addOutToInMapping((int)(it->first >> 32), (int)(it->first & 0xffffffff), (int)(it->second >> 32), (int)(it->second & 0xffffffff));
+	}
+
+	const auto& paragraphs = parser_data->paragraphs();
+	for (auto it = paragraphs.begin(); it != paragraphs.end(); ++it) {
+		bw.addParagraph(it->first, it->second.filename, it->second.line, it->second.is_included);
+	}
+
+	const auto& fmap = parser_data->get_field_map();
+	for (auto it = fmap.begin(); it != fmap.end(); ++it) {
+		cb_field_ptr fld = it->second;
+		bw.addField(fld->sname, get_field_path(fld), fld->defined_at_source_file, fld->defined_at_source_line);
+	}
+
+	return bw.writeToFile(outfile);
 }
 
 void TPESQLProcessor::add_dependency(const std::string& parent, const std::string& dep_path)
@@ -1935,8 +2203,7 @@ void TPESQLProcessor::put_smart_cursor_init_flags()
 		put_output_line(code_tag + string_format(" 01  GIXSQL-CI-F-%s PIC X.", cname));
 	}
 	// Then the other cursors
-	auto other_crsrs = cpplinq::from(*(parser_data->exec_list())).where([](cb_exec_sql_stmt_ptr p) { return p->startup_item == 0 && p->commandName == ESQL_SELECT && !p->cursorName.empty(); }).to_vector();
-	for (cb_exec_sql_stmt_ptr stmt : other_crsrs) {
+	for (cb_exec_sql_stmt_ptr stmt : other_cursors) {
 		std::string cname = string_replace(stmt->cursorName, "_", "-");
 		put_output_line(code_tag + string_format(" 01  GIXSQL-CI-F-%s PIC X.", cname));
 	}
@@ -2103,12 +2370,20 @@ bool TPESQLProcessor::put_host_parameters(const cb_exec_sql_stmt_ptr stmt)
 
 		if (!put_call(p_call, false))
 			return false;
+
+		add_manifest_param(stmt, f_type, flags);
 	}
 	return true;
 }
 
 void TPESQLProcessor::add_preprocessed_blocks()
 {
+	if (!map_enabled)
+		return;
+
+	if (b_in_to_out.empty())
+		build_map_data();
+
 	std::vector<cb_exec_sql_stmt_ptr>* p = parser_data->exec_list();
 	for (auto e : *p) {
 		PreprocessedBlockInfo* bi = new PreprocessedBlockInfo();
@@ -2119,25 +2394,30 @@ void TPESQLProcessor::add_preprocessed_blocks()
 		bi->orig_start_line = e->startLine;
 		bi->orig_end_line = e->endLine;
 
-		auto in_out_start_key = std::to_string(bi->orig_start_line) + "@" + bi->orig_source_file;
-		auto in_out_end_key = std::to_string(bi->orig_end_line) + "@" + bi->orig_source_file;
-		if (in_to_out.find(in_out_start_key) == in_to_out.end() || in_to_out.find(in_out_end_key) == in_to_out.end()) {
+		auto it_file = filemap.find(bi->orig_source_file);
+		if (it_file == filemap.end()) {
 			delete bi;
 			continue;
 		}
 
-		if (generated_blocks.find(e) == generated_blocks.end()) {
+		uint64_t fin_id = (uint64_t)it_file->second;
+		auto it_start = b_in_to_out.find((fin_id << 32) + bi->orig_start_line);
+		auto it_end = b_in_to_out.find((fin_id << 32) + bi->orig_end_line);
+		if (it_start == b_in_to_out.end() || it_end == b_in_to_out.end()) {
 			delete bi;
 			continue;
 		}
 
-		auto in_out_start_val = in_to_out[in_out_start_key];
-		auto in_out_end_val = in_to_out[in_out_end_key];
+		if (generated_blocks.find(e) == generated_blocks.end()) {
+			delete bi;
+			continue;
+		}
 
-		bi->pp_source_file = in_out_start_val.substr(in_out_start_val.find("@") + 1);
-		bi->pp_start_line = atoi(in_out_start_val.substr(0, in_out_start_val.find("@")).c_str());
+		// all the output lines are in the output file
+		bi->pp_source_file = output_file;
+		bi->pp_start_line = (int)(it_start->second & 0xffffffff);
 
-		bi->pp_end_line = atoi(in_out_end_val.substr(0, in_out_end_val.find("@")).c_str());
+		bi->pp_end_line = (int)(it_end->second & 0xffffffff);
 
 		bi->module_name = parser_data->program_id();
 
@@ -2230,50 +2510,34 @@ std::string TPESQLProcessor::getModuleName()
 	return parser_data->program_id();
 }
 
-void TPESQLProcessor::splitLineEntry(const std::string& k, std::string& s, int* i)
-{
-	int p = k.find("@");
-	s = k.substr(p + 1);
-	*i = std::stoi(k.substr(0, p));
-}
-
-void TPESQLProcessor::map_collect_files(std::map<std::string, int>& filemap)
+// The string maps ("line@file") are only built if requested through getSrcLineMap/getSrcLineMapReverse
+void TPESQLProcessor::build_src_line_maps()
 {
-	int l;
-	int n = 1;
-	std::string f;
-
-	if (!in_to_out.size())
+	if (!in_to_out.empty() || src_map_runs.empty())
 		return;
 
-	//std::string s = in_to_out[in_to_out.keys().at(0)];
-	std::string s = in_to_out.begin()->second;
-
-	splitLineEntry(s, f, &l);
-	filemap[f] = n++;
-
-	std::map<std::string, std::string>::const_iterator it = in_to_out.begin();
-	auto end = in_to_out.end();
-	while (it != end) {
-		splitLineEntry(it->first, f, &l);
-		if (!map_contains<std::string, int>(filemap, f))
-			filemap[f] = n++;
+	if (b_in_to_out.empty())
+		build_map_data();
 
-		splitLineEntry(it->second, f, &l);
-		if (!map_contains<std::string, int>(filemap, f))
-			filemap[f] = n++;
+	std::map<int, std::string> rfm = getReverseFileMap();
+	for (auto it = b_in_to_out.begin(); it != b_in_to_out.end(); ++it) {
+		in_to_out[std::to_string(it->first & 0xffffffff) + "@" + rfm[(int)(it->first >> 32)]] = std::to_string(it->second & 0xffffffff) + "@" + rfm[(int)(it->second >> 32)];
+	}
 
-		++it;
+	for (auto it = b_out_to_in.begin(); it != b_out_to_in.end(); ++it) {
+		out_to_in[std::to_string(it->first & 0xffffffff) + "@" + rfm[(int)(it->first >> 32)]] = std::to_string(it->second & 0xffffffff) + "@" + rfm[(int)(it->second >> 32)];
 	}
 }
 
 std::map<std::string, std::string>& TPESQLProcessor::getSrcLineMap() const
 {
+	const_cast<TPESQLProcessor*>(this)->build_src_line_maps();
 	return const_cast<std::map<std::string, std::string>&>(in_to_out);
 }
 
 std::map<std::string, std::string>& TPESQLProcessor::getSrcLineMapReverse() const
 {
+	const_cast<TPESQLProcessor*>(this)->build_src_line_maps();
 	return const_cast<std::map<std::string, std::string>&>(out_to_in);
 }
 
@@ -24,6 +24,7 @@ USA.
 #include <vector>
 #include <map>
 #include <stack>
+#include <set>
 #include <memory>
 
 #include "ITransformationStep.h"
@@ -32,7 +33,18 @@ USA.
 #include "ESQLCall.h"
 
 class gix_esql_driver;
-struct esql_whenever_clause_handler_t;
+
+struct esql_whenever_clause_handler_t {
+	int action = WHENEVER_ACTION_CONTINUE;
+	std::string host_label;
+};
+
+struct esql_whenever_handler_t
+{
+	esql_whenever_clause_handler_t not_found;
+	esql_whenever_clause_handler_t sqlwarning;
+	esql_whenever_clause_handler_t sqlerror;
+};
 
 enum class ESQL_Command;
 
@@ -78,6 +90,23 @@ private:
 
 	int output_line;
 
+	// Source line mapping, recorded only if a map file, debug info or the map data (no_output) are requested:
+	// runs of consecutive output lines that map to the same input line or to consecutive input lines
+	// of the same file (files are identified by their id in filemap). The maps below are built from
+	// the runs when needed (build_map_data, getSrcLineMap).
+	struct SrcMapRun {
+		int out_start;
+		int in_file_id;
+		int in_start;
+		int count;
+		int in_step;	// 0: all the output lines map to in_start, 1: they map to in_start, in_start + 1, ...
+	};
+
+	bool map_enabled;
+	std::vector<SrcMapRun> src_map_runs;
+	std::string map_cur_file;
+	int map_cur_file_id;
+
 	std::map<std::string, std::string> in_to_out;
 	std::map<std::string, std::string> out_to_in;
 
@@ -88,8 +117,10 @@ private:
 	std::map<cb_exec_sql_stmt_ptr, std::tuple<int, int>> generated_blocks;
 
 	int outputESQL();
-	cb_exec_sql_stmt_ptr find_exec_sql_stmt(const std::string filename, int i);
+	void build_exec_sql_index();
+	cb_exec_sql_stmt_ptr find_exec_sql_stmt(const std::vector<cb_exec_sql_stmt_ptr>* line_index, int i);
 	cb_exec_sql_stmt_ptr find_esql_cmd(std::string cmd, int idx);
+	bool is_startup_cursor(const std::string& crsr_name);
 	std::string comment_line(const std::string &comment, const std::string &line);
 
 	void put_output_line(const std::string &line);
@@ -103,6 +134,11 @@ private:
 
 	void put_start_exec_sql(bool with_period);
 	void put_end_exec_sql(bool with_period);
+	void put_statement_flags(const ESQL_Command cmd, const cb_exec_sql_stmt_ptr stmt);
+	void put_statement_id(const cb_exec_sql_stmt_ptr stmt);
+	void add_manifest_param(const cb_exec_sql_stmt_ptr stmt, CobolVarType type, int flags);
+	void put_manifest_registration_check();
+	bool put_manifest();
 	bool put_query_defs();
 	void put_working_storage();
 	bool put_cursor_declarations();
@@ -115,11 +151,13 @@ private:
 	bool fixup_declared_vars();
 
 	bool write_map_file(const std::string &preprocd_file);
+	bool write_binary_map_file(const std::string &preprocd_file);
 	bool build_map_data();
 
-	void map_collect_files(std::map<std::string, int> &filemap);
-
-	void splitLineEntry(const std::string &k, std::string &s, int *i);
+	int get_map_file_id(const std::string &filename);
+	int find_map_file_id(const std::string &filename) const;
+	void map_add_line(int out_line, int in_file_id, int in_line);
+	void build_src_line_maps();
 
 	bool generate_consolidated_map();
 
@@ -146,6 +184,14 @@ private:
 	std::vector<std::string> ws_query_list;
 	std::vector<cb_exec_sql_stmt_ptr> startup_items;
 
+	// Built once, after parsing, by build_exec_sql_index: the ESQL block containing each line
+	// of each source file (by absolute path, indexed by line number), the blocks for each command
+	// (in parsing order), the names of the cursors declared in WORKING-STORAGE and the other cursors
+	std::map<std::string, std::vector<cb_exec_sql_stmt_ptr>> exec_sql_line_index;
+	std::map<std::string, std::vector<cb_exec_sql_stmt_ptr>> exec_sql_cmd_index;
+	std::set<std::string> startup_cursor_names;
+	std::vector<cb_exec_sql_stmt_ptr> other_cursors;
+
 	std::map<std::string, int> filemap;
 
 	std::map<std::string,  std::vector<std::string>> file_dependencies;
@@ -155,6 +201,13 @@ private:
 	bool emitted_query_defs = false;
 	bool emitted_smart_cursor_init_flags = false;
 
+	// WHENEVER clauses currently in effect
+	esql_whenever_handler_t esql_whenever_handler;
+
+	// Static statements with input parameters and their parameter types (type, flags), for the module manifest
+	std::vector<cb_exec_sql_stmt_ptr> manifest_stmts;
+	std::map<cb_exec_sql_stmt_ptr, std::vector<std::pair<CobolVarType, int>>> manifest_params;
+
 	std::shared_ptr<ESQLParserData> parser_data;
 
 	void raise_error(const std::string& m, int err_code, std::string filename = std::string(), int line = -1);
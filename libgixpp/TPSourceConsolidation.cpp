@@ -102,7 +102,11 @@ std::map<std::string, std::string> &TPSourceConsolidation::getSrcLineMap() const
 bool TPSourceConsolidation::processNextFile()
 {
 	std::string the_file = input_file_stack.top();
-	std::vector<std::string> input_lines = file_read_all_lines(the_file);
+	std::vector<std::string> input_lines;
+	if (input_file_stack.size() > 1)
+		owner->getCopyResolver()->getCopyFileLines(the_file, input_lines);
+	else
+		input_lines = file_read_all_lines(the_file);
 	std::string copy_name, copy_file;
 
 	if (!input_lines.size()) {
@@ -117,7 +117,9 @@ int gix_esql_driver::parse (TransformationStepData *input, std::shared_ptr<ESQLP
 
 	lexer.src_location_stack.push({ filename_absolute_path(input->filename()), 1 });
 
-    scan_begin ();
+    if (!scan_begin ())
+        return -1;
+
     yy::gix_esql_parser parser (this);
     parser.set_debug_level (trace_parsing);
     int res = parser.parse ();
@@ -165,7 +167,7 @@ void gix_esql_driver::warning(const std::string & m)
 	warning(loc, m);
 }
 
-void gix_esql_driver::scan_begin()
+bool gix_esql_driver::scan_begin()
 {
     lexer.set_debug( trace_scanning );
 
@@ -179,8 +181,9 @@ void gix_esql_driver::scan_begin()
     } else {
 		yy::location loc;	// FIXME
         error (loc, "Cannot open file '" + file + "'.", ERR_FILE_NOT_FOUND);
-        exit (EXIT_FAILURE);
+        return false;   // do not exit: other files may be being preprocessed in the same process
     }
+    return true;
 }
 
 void gix_esql_driver::scan_end ()
@@ -93,7 +93,7 @@ public:
     std::ifstream instream;
 
     // Handling the scanner.
-    void scan_begin ();
+    bool scan_begin ();
     void scan_end ();
     bool trace_scanning;
     
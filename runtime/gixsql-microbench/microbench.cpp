@@ -0,0 +1,662 @@
+/*
+This file is part of Gix-IDE, an IDE and platform for GnuCOBOL
+Copyright (C) 2021 Marco Ridoni
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+USA.
+*/
+
+/*
+	Microbenchmarks for the runtime paths that are executed for every host variable and every
+	statement: COBOL <-> "real" data conversion, host variable list handling, cursor/connection
+	lookups, SQLCA status setting and the parameter placeholder rewriting done by the drivers.
+
+	Results are written in JSON (default) or CSV, one entry per benchmark with the median and
+	the minimum time per operation over a number of repetitions.
+*/
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <cstdint>
+
+#include "popl.hpp"
+
+#include <stdint.h>
+#include "gixsql.h"
+#include "gixsql_internal.h"
+#include "SqlVar.h"
+#include "SqlVarList.h"
+#include "Cursor.h"
+#include "CursorManager.h"
+#include "Connection.h"
+#include "ConnectionManager.h"
+#include "IDbInterface.h"
+#include "param_fixup.h"
+#include "varlen_defs.h"
+#include "cobol_var_flags.h"
+
+#include "config.h"
+
+#define MB_DEFAULT_MIN_TIME_MS		50
+#define MB_DEFAULT_REPETITIONS		5
+#define MB_COBOL_FIELD_SIZE			8192
+
+using namespace popl;
+
+// Keeps the compiler from optimizing away the benchmarked code
+template <class T>
+static inline void do_not_optimize(T const& v)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	asm volatile("" : : "r,m"(v) : "memory");
+#else
+	static volatile const void* sink;
+	sink = &v;
+#endif
+}
+
+struct BenchmarkResult {
+	std::string name;
+	uint64_t iterations = 0;
+	double ns_per_op = 0;
+	double min_ns_per_op = 0;
+};
+
+class BenchmarkRunner
+{
+public:
+	BenchmarkRunner(const std::string& _filter, int _min_time_ms, int _repetitions) :
+		filter(_filter), min_time_ns((uint64_t)_min_time_ms * 1000000), repetitions(_repetitions) { }
+
+	// f(n) must run the benchmarked operation n times
+	void run(const std::string& name, const std::function<void(uint64_t)>& f)
+	{
+		if (!filter.empty() && name.find(filter) == std::string::npos)
+			return;
+
+		// calibrate: grow the iteration count until a single run takes at least min_time_ns
+		uint64_t n = 1;
+		uint64_t elapsed = 0;
+		while (true) {
+			elapsed = time_run(f, n);
+			if (elapsed >= min_time_ns || n >= (1ULL << 40))
+				break;
+
+			uint64_t next = elapsed > 0 ? (uint64_t)((double)n * min_time_ns * 1.2 / elapsed) : n * 100;
+			n = std::max(n * 2, std::min(next, n * 100));
+		}
+
+		std::vector<double> samples;
+		for (int i = 0; i < repetitions; i++)
+			samples.push_back((double)time_run(f, n) / n);
+
+		std::sort(samples.begin(), samples.end());
+
+		BenchmarkResult r;
+		r.name = name;
+		r.iterations = n;
+		r.ns_per_op = samples[samples.size() / 2];
+		r.min_ns_per_op = samples[0];
+		results.push_back(r);
+
+		if (progress)
+			std::cerr << name << ": " << r.ns_per_op << " ns/op" << std::endl;
+	}
+
+	const std::vector<BenchmarkResult>& getResults() { return results; }
+
+	bool progress = false;
+
+private:
+	std::string filter;
+	uint64_t min_time_ns;
+	int repetitions;
+	std::vector<BenchmarkResult> results;
+
+	static uint64_t time_run(const std::function<void(uint64_t)>& f, uint64_t n)
+	{
+		auto t0 = std::chrono::steady_clock::now();
+		f(n);
+		auto t1 = std::chrono::steady_clock::now();
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+	}
+};
+
+// Minimal driver stub: lets setStatus go through the path that reads the driver error information
+class ErrorDbInterface : public IDbInterface
+{
+public:
+	int init(const std::shared_ptr<spdlog::logger>&) override { return 0; }
+	int connect(std::shared_ptr<IDataSourceInfo>, std::shared_ptr<IConnectionOptions>) override { return 0; }
+	int reset() override { return 0; }
+	int terminate_connection() override { return 0; }
+	int exec(std::string) override { return 0; }
+	int exec_params(const std::string&, const std::vector<CobolVarType>&, const std::vector<std_binary_data>&, const std::vector<unsigned long>&, const std::vector<uint32_t>&) override { return 0; }
+	int cursor_declare(const std::shared_ptr<ICursor>&) override { return 0; }
+	int cursor_open(const std::shared_ptr<ICursor>&) override { return 0; }
+	int cursor_close(const std::shared_ptr<ICursor>&) override { return 0; }
+	int cursor_fetch_one(const std::shared_ptr<ICursor>&, int) override { return 0; }
+	bool get_resultset_value(ResultSetContextType, const IResultSetContextData&, int, int, char*, uint64_t, uint64_t*, bool*) override { return false; }
+	bool move_to_first_record(const std::string&) override { return false; }
+	uint64_t get_native_features() override { return 0; }
+	int get_num_rows(const std::shared_ptr<ICursor>&) override { return 0; }
+	int get_num_fields(const std::shared_ptr<ICursor>&) override { return 0; }
+	const char* get_error_message() override { return "ERROR:  relation \"emp\" does not exist"; }
+	int get_error_code() override { return -400; }
+	std::string get_state() override { return "42P01"; }
+	int prepare(const std::string&, const std::string&) override { return 0; }
+	int exec_prepared(const std::string&, std::vector<CobolVarType>, std::vector<std_binary_data>&, std::vector<unsigned long>, const std::vector<uint32_t>&) override { return 0; }
+	DbPropertySetResult set_property(DbProperty, std::variant<bool, int, std::string>) override { return DbPropertySetResult::Success; }
+};
+
+static const char* type_name(CobolVarType t)
+{
+	switch (t) {
+		case CobolVarType::COBOL_TYPE_UNSIGNED_NUMBER: return "UNSIGNED_NUMBER";
+		case CobolVarType::COBOL_TYPE_SIGNED_NUMBER_TS: return "SIGNED_NUMBER_TS";
+		case CobolVarType::COBOL_TYPE_SIGNED_NUMBER_TC: return "SIGNED_NUMBER_TC";
+		case CobolVarType::COBOL_TYPE_SIGNED_NUMBER_LS: return "SIGNED_NUMBER_LS";
+		case CobolVarType::COBOL_TYPE_SIGNED_NUMBER_LC: return "SIGNED_NUMBER_LC";
+		case CobolVarType::COBOL_TYPE_UNSIGNED_NUMBER_PD: return "UNSIGNED_NUMBER_PD";
+		case CobolVarType::COBOL_TYPE_SIGNED_NUMBER_PD: return "SIGNED_NUMBER_PD";
+		case CobolVarType::COBOL_TYPE_ALPHANUMERIC: return "ALPHANUMERIC";
+		case CobolVarType::COBOL_TYPE_UNSIGNED_BINARY: return "UNSIGNED_BINARY";
+		case CobolVarType::COBOL_TYPE_SIGNED_BINARY: return "SIGNED_BINARY";
+		case CobolVarType::COBOL_TYPE_JAPANESE: return "JAPANESE";
+		case CobolVarType::COBOL_TYPE_GROUP: return "GROUP";
+		case CobolVarType::COBOL_TYPE_FLOAT: return "FLOAT";
+		case CobolVarType::COBOL_TYPE_DOUBLE: return "DOUBLE";
+		case CobolVarType::COBOL_TYPE_NATIONAL: return "NATIONAL";
+		default: return "UNKNOWN";
+	}
+}
+
+static bool is_signed_type(CobolVarType t)
+{
+	return t == CobolVarType::COBOL_TYPE_SIGNED_NUMBER_TS || t == CobolVarType::COBOL_TYPE_SIGNED_NUMBER_TC ||
+		t == CobolVarType::COBOL_TYPE_SIGNED_NUMBER_LS || t == CobolVarType::COBOL_TYPE_SIGNED_NUMBER_LC ||
+		t == CobolVarType::COBOL_TYPE_SIGNED_NUMBER_PD || t == CobolVarType::COBOL_TYPE_SIGNED_BINARY;
+}
+
+static bool is_binary_type(CobolVarType t)
+{
+	return t == CobolVarType::COBOL_TYPE_UNSIGNED_BINARY || t == CobolVarType::COBOL_TYPE_SIGNED_BINARY;
+}
+
+static bool is_text_type(CobolVarType t)
+{
+	return t == CobolVarType::COBOL_TYPE_ALPHANUMERIC || t == CobolVarType::COBOL_TYPE_JAPANESE ||
+		t == CobolVarType::COBOL_TYPE_GROUP || t == CobolVarType::COBOL_TYPE_NATIONAL;
+}
+
+// A COBOL-side field with its indicator
+struct CobolField {
+	CobolVarType type;
+	int length;
+	int power;
+	uint32_t flags;
+	std::string label;
+	std::vector<uint8_t> data = std::vector<uint8_t>(MB_COBOL_FIELD_SIZE, 0);
+	int16_t ind = 0;
+};
+
+// Fills the field with a value in the storage format GnuCOBOL would use for its type
+static void fill_cobol_field(CobolField& f)
+{
+	uint8_t* d = f.data.data();
+	switch (f.type) {
+		case CobolVarType::COBOL_TYPE_UNSIGNED_NUMBER:
+		case CobolVarType::COBOL_TYPE_SIGNED_NUMBER_TC:
+			for (int i = 0; i < f.length; i++)
+				d[i] = '1' + (i % 9);
+			break;
+
+		case CobolVarType::COBOL_TYPE_SIGNED_NUMBER_LS:
+			d[0] = '-';
+			for (int i = 0; i < f.length; i++)
+				d[i + 1] = '1' + (i % 9);
+			break;
+
+		case CobolVarType::COBOL_TYPE_UNSIGNED_NUMBER_PD:
+		case CobolVarType::COBOL_TYPE_SIGNED_NUMBER_PD:
+		{
+			int nbytes = (f.length / 2) + 1;
+			for (int i = 0; i < nbytes; i++)
+				d[i] = 0x12 + (i % 8) * 0x11;
+			d[nbytes - 1] = (d[nbytes - 1] & 0xF0) | (f.type == CobolVarType::COBOL_TYPE_SIGNED_NUMBER_PD ? 0x0D : 0x0F);
+			break;
+		}
+
+		case CobolVarType::COBOL_TYPE_UNSIGNED_BINARY:
+		case CobolVarType::COBOL_TYPE_SIGNED_BINARY:
+			for (int i = 0; i < 8; i++)
+				d[i] = (uint8_t)(i + 1);
+			break;
+
+		case CobolVarType::COBOL_TYPE_JAPANESE:
+			for (int i = 0; i < f.length * 2; i++)
+				d[i] = 'a' + (i % 26);
+			break;
+
+		default:
+			if (f.flags & CBL_FIELD_FLAG_VARLEN) {
+				int actual_len = f.length - VARLEN_LENGTH_SZ;
+				*((VARLEN_LENGTH_T*)d) = (VARLEN_LENGTH_T)actual_len;
+				for (int i = 0; i < actual_len; i++)
+					d[VARLEN_LENGTH_SZ + i] = 'a' + (i % 26);
+			}
+			else {
+				// half the field is trailing blanks, so that AUTOTRIM has something to do
+				for (int i = 0; i < f.length; i++)
+					d[i] = (i < f.length / 2) ? 'a' + (i % 26) : ' ';
+			}
+			break;
+	}
+}
+
+// The value a driver would return for a column bound to the field
+static std::string db_value_for(const CobolField& f)
+{
+	if (is_text_type(f.type)) {
+		int len = (f.flags & CBL_FIELD_FLAG_VARLEN) ? f.length - VARLEN_LENGTH_SZ : f.length;
+		std::string s;
+		for (int i = 0; i < len / 2; i++)
+			s += (char)('a' + (i % 26));
+		return s;
+	}
+
+	// numeric: all the integer digits, half the decimals
+	int scale = -f.power;
+	int int_digits = std::max(1, f.length - scale);
+	std::string s = is_signed_type(f.type) ? "-" : "";
+	for (int i = 0; i < int_digits; i++)
+		s += (char)('1' + (i % 9));
+	if (scale > 0) {
+		s += '.';
+		for (int i = 0; i < (scale + 1) / 2; i++)
+			s += (char)('1' + (i % 9));
+	}
+
+	// binary fields of length <= 9 are stored in 4 bytes, keep the value in range
+	if (is_binary_type(f.type) && f.length <= 9 && s.size() > 9)
+		s = s.substr(0, 9);
+
+	return s;
+}
+
+static std::vector<CobolField> build_fields()
+{
+	std::vector<CobolField> fields;
+
+	auto add = [&fields](CobolVarType type, int length, int power, uint32_t flags, const std::string& variant) {
+		CobolField f;
+		f.type = type;
+		f.length = length;
+		f.power = power;
+		f.flags = flags;
+		f.label = std::string(type_name(type)) + "/len=" + std::to_string(length) + "/scale=" + std::to_string(-power) + variant;
+		fill_cobol_field(f);
+		fields.push_back(f);
+	};
+
+	for (int t = COBOL_TYPE_MIN; t <= COBOL_TYPE_MAX; t++) {
+		CobolVarType type = (CobolVarType)t;
+		if (strcmp(type_name(type), "UNKNOWN") == 0)
+			continue;
+
+		if (type == CobolVarType::COBOL_TYPE_ALPHANUMERIC) {
+			for (int len : { 10, 80, 4000 }) {
+				add(type, len, 0, 0, "");
+				add(type, len, 0, CBL_FIELD_FLAG_AUTOTRIM, "/autotrim");
+				add(type, len + VARLEN_LENGTH_SZ, 0, CBL_FIELD_FLAG_VARLEN, "/varlen");
+			}
+		}
+		else
+		if (is_text_type(type)) {
+			for (int len : { 10, 80 })
+				add(type, len, 0, 0, "");
+		}
+		else
+		if (type == CobolVarType::COBOL_TYPE_FLOAT) {
+			add(type, 4, 0, 0, "");
+		}
+		else
+		if (type == CobolVarType::COBOL_TYPE_DOUBLE) {
+			add(type, 8, 0, 0, "");
+		}
+		else {
+			for (int len : { 4, 9, 18 }) {
+				for (int power : { 0, -2 }) {
+					add(type, len, power, 0, "");
+				}
+			}
+		}
+	}
+
+	return fields;
+}
+
+static void bench_sqlvar(BenchmarkRunner& runner)
+{
+	std::vector<CobolField> fields = build_fields();
+
+	for (auto& f : fields) {
+		SqlVar v(f.type, f.length, f.power, f.flags, f.data.data(), &f.ind);
+		runner.run("SqlVar::createRealData/" + f.label, [&](uint64_t n) {
+			for (uint64_t i = 0; i < n; i++) {
+				v.createRealData();
+				do_not_optimize(v.getDbData());
+			}
+		});
+	}
+
+	// for the packed decimal types this is where display_to_comp3 is called
+	for (auto& f : fields) {
+		std::vector<uint8_t> out(MB_COBOL_FIELD_SIZE, 0);
+		SqlVar v(f.type, f.length, f.power, f.flags, out.data(), &f.ind);
+		std::string value = db_value_for(f);
+		runner.run("SqlVar::createCobolData/" + f.label, [&](uint64_t n) {
+			int sqlcode = 0;
+			for (uint64_t i = 0; i < n; i++) {
+				v.createCobolData((char*)value.data(), (int)value.size(), &sqlcode);
+				do_not_optimize(out[0]);
+			}
+		});
+	}
+}
+
+static void bench_sqlvarlist(BenchmarkRunner& runner)
+{
+	for (int nvars : { 1, 10, 50 }) {
+		std::vector<CobolField> fields;
+		for (int i = 0; i < nvars; i++) {
+			CobolField f;
+			f.type = (i % 2) ? CobolVarType::COBOL_TYPE_ALPHANUMERIC : CobolVarType::COBOL_TYPE_SIGNED_NUMBER_PD;
+			f.length = (i % 2) ? 30 : 9;
+			f.power = (i % 2) ? 0 : -2;
+			f.flags = 0;
+			fill_cobol_field(f);
+			fields.push_back(f);
+		}
+
+		SqlVarList l;
+		runner.run("SqlVarList::AddVar+clear/vars=" + std::to_string(nvars), [&](uint64_t n) {
+			for (uint64_t i = 0; i < n; i++) {
+				for (auto& f : fields)
+					l.AddVar(f.type, f.length, f.power, f.flags, f.data.data(), &f.ind);
+				do_not_optimize(l.size());
+				l.clear();
+			}
+		});
+	}
+}
+
+static void bench_managers(BenchmarkRunner& runner)
+{
+	for (int count : { 10, 100, 1000 }) {
+		CursorManager cm;
+		for (int i = 0; i < count; i++) {
+			std::shared_ptr<Cursor> c = cm.create();
+			c->setName("PROG1_CRSR_" + std::to_string(i));
+			cm.add(c);
+		}
+
+		std::string hit = "PROG1_CRSR_" + std::to_string(count / 2);
+		std::string miss = "PROG1_CRSR_NOT_THERE";
+
+		runner.run("CursorManager::get/cursors=" + std::to_string(count), [&](uint64_t n) {
+			for (uint64_t i = 0; i < n; i++)
+				do_not_optimize(cm.get(hit));
+		});
+
+		runner.run("CursorManager::exists/miss/cursors=" + std::to_string(count), [&](uint64_t n) {
+			for (uint64_t i = 0; i < n; i++)
+				do_not_optimize(cm.exists(miss));
+		});
+
+		cm.clear();
+	}
+
+	for (int count : { 1, 10, 100 }) {
+		ConnectionManager cm;
+
+		// one default (unnamed) connection plus named ones
+		cm.add(cm.create());
+		for (int i = 1; i < count; i++) {
+			std::shared_ptr<Connection> c = cm.create();
+			c->setName("CONN" + std::to_string(i));
+			cm.add(c);
+		}
+
+		std::string named = "CONN" + std::to_string(count / 2);
+
+		runner.run("ConnectionManager::get/default/connections=" + std::to_string(count), [&](uint64_t n) {
+			for (uint64_t i = 0; i < n; i++)
+				do_not_optimize(cm.get(""));
+		});
+
+		if (count > 1) {
+			runner.run("ConnectionManager::get/named/connections=" + std::to_string(count), [&](uint64_t n) {
+				for (uint64_t i = 0; i < n; i++)
+					do_not_optimize(cm.get(named));
+			});
+		}
+
+		runner.run("ConnectionManager::exists/connections=" + std::to_string(count), [&](uint64_t n) {
+			for (uint64_t i = 0; i < n; i++)
+				do_not_optimize(cm.exists(named));
+		});
+
+		cm.clear();
+	}
+}
+
+static void bench_set_status(BenchmarkRunner& runner)
+{
+	struct sqlca_t sqlca;
+	std::shared_ptr<IDbInterface> dbi = std::make_shared<ErrorDbInterface>();
+
+	runner.run("setStatus/no_error", [&](uint64_t n) {
+		for (uint64_t i = 0; i < n; i++) {
+			setStatus(&sqlca, nullptr, DBERR_NO_ERROR);
+			do_not_optimize(sqlca.sqlcode);
+		}
+	});
+
+	runner.run("setStatus/no_data", [&](uint64_t n) {
+		for (uint64_t i = 0; i < n; i++) {
+			setStatus(&sqlca, nullptr, DBERR_NO_DATA);
+			do_not_optimize(sqlca.sqlcode);
+		}
+	});
+
+	runner.run("setStatus/sql_error", [&](uint64_t n) {
+		for (uint64_t i = 0; i < n; i++) {
+			setStatus(&sqlca, nullptr, DBERR_SQL_ERROR);
+			do_not_optimize(sqlca.sqlcode);
+		}
+	});
+
+	runner.run("setStatus/sql_error/driver", [&](uint64_t n) {
+		for (uint64_t i = 0; i < n; i++) {
+			setStatus(&sqlca, dbi, DBERR_SQL_ERROR);
+			do_not_optimize(sqlca.sqlcode);
+		}
+	});
+}
+
+static void bench_fixup_parameters(BenchmarkRunner& runner)
+{
+	std::vector<std::pair<std::string, std::string>> queries = {
+		{ "short", "SELECT NAME, SALARY FROM EMP WHERE ID = :EMP-ID AND DEPT = :DEPT" },
+		{ "literals", "UPDATE EMP SET NOTE = 'a value with a :colon and a ? mark', NAME = ? WHERE ID = ? AND DEPT = 'X'" },
+	};
+
+	std::string long_query = "INSERT INTO T (";
+	for (int i = 1; i <= 40; i++)
+		long_query += "COL" + std::to_string(i) + (i < 40 ? ", " : ") VALUES (");
+	for (int i = 1; i <= 40; i++)
+		long_query += ":H" + std::to_string(i) + (i < 40 ? ", " : ")");
+	queries.push_back({ "40params", long_query });
+
+	// placeholder styles that each driver is expected to receive
+	std::vector<std::pair<std::string, std::string>> dollar_queries = {
+		{ "short", "SELECT NAME, SALARY FROM EMP WHERE ID = $1 AND DEPT = $2" },
+	};
+
+	for (const auto& q : queries) {
+		runner.run("pgsql_fixup_parameters/" + q.first, [&](uint64_t n) {
+			for (uint64_t i = 0; i < n; i++)
+				do_not_optimize(pgsql_fixup_parameters(q.second));
+		});
+		runner.run("mysql_fixup_parameters/" + q.first, [&](uint64_t n) {
+			for (uint64_t i = 0; i < n; i++)
+				do_not_optimize(mysql_fixup_parameters(q.second));
+		});
+		runner.run("odbc_fixup_parameters/" + q.first, [&](uint64_t n) {
+			for (uint64_t i = 0; i < n; i++)
+				do_not_optimize(odbc_fixup_parameters(q.second));
+		});
+		runner.run("odpi_fixup_parameters/" + q.first, [&](uint64_t n) {
+			for (uint64_t i = 0; i < n; i++)
+				do_not_optimize(odpi_fixup_parameters(q.second));
+		});
+	}
+
+	for (const auto& q : dollar_queries) {
+		runner.run("mysql_fixup_parameters/dollar/" + q.first, [&](uint64_t n) {
+			for (uint64_t i = 0; i < n; i++)
+				do_not_optimize(mysql_fixup_parameters(q.second));
+		});
+		runner.run("odpi_fixup_parameters/dollar/" + q.first, [&](uint64_t n) {
+			for (uint64_t i = 0; i < n; i++)
+				do_not_optimize(odpi_fixup_parameters(q.second));
+		});
+	}
+}
+
+static std::string json_escape(const std::string& s)
+{
+	std::string o;
+	for (char c : s) {
+		if (c == '"' || c == '\\')
+			o += '\\';
+		o += c;
+	}
+	return o;
+}
+
+static void write_results(std::ostream& os, const std::string& format, const std::vector<BenchmarkResult>& results)
+{
+	if (format == "csv") {
+		os << "name,iterations,ns_per_op,min_ns_per_op\n";
+		for (const auto& r : results)
+			os << "\"" << r.name << "\"," << r.iterations << "," << r.ns_per_op << "," << r.min_ns_per_op << "\n";
+		return;
+	}
+
+	os << "{\n";
+	os << "  \"version\": \"" << VERSION << "\",\n";
+	os << "  \"benchmarks\": [\n";
+	for (size_t i = 0; i < results.size(); i++) {
+		const auto& r = results[i];
+		os << "    { \"name\": \"" << json_escape(r.name) << "\", \"iterations\": " << r.iterations
+			<< ", \"ns_per_op\": " << r.ns_per_op << ", \"min_ns_per_op\": " << r.min_ns_per_op << " }"
+			<< (i < results.size() - 1 ? "," : "") << "\n";
+	}
+	os << "  ]\n";
+	os << "}\n";
+}
+
+int main(int argc, char** argv)
+{
+	std::string format = "json";
+	std::string filter;
+	std::string output_file;
+	int min_time_ms = MB_DEFAULT_MIN_TIME_MS;
+	int repetitions = MB_DEFAULT_REPETITIONS;
+
+	OptionParser options("gixsql-microbench");
+
+	auto opt_help = options.add<Switch>("h", "help", "displays help");
+	auto opt_version = options.add<Switch>("V", "version", "displays version info");
+	auto opt_format = options.add<Value<std::string>>("f", "format", "output format (json or csv)", "json", &format);
+	auto opt_filter = options.add<Value<std::string>>("F", "filter", "only run the benchmarks whose name contains this string", "", &filter);
+	auto opt_output = options.add<Value<std::string>>("o", "output", "output file (default: standard output)", "", &output_file);
+	auto opt_min_time = options.add<Value<int>>("t", "min-time", "minimum duration of a single run in milliseconds", MB_DEFAULT_MIN_TIME_MS, &min_time_ms);
+	auto opt_reps = options.add<Value<int>>("r", "repetitions", "number of runs per benchmark (the median is reported)", MB_DEFAULT_REPETITIONS, &repetitions);
+	auto opt_verbose = options.add<Switch>("v", "verbose", "print progress to standard error");
+
+	try {
+		options.parse(argc, argv);
+	}
+	catch (std::exception& ex) {
+		std::cerr << ex.what() << std::endl;
+		return 1;
+	}
+
+	if (opt_help->is_set()) {
+		std::cout << options << std::endl;
+		return 0;
+	}
+
+	if (opt_version->is_set()) {
+		std::cout << "gixsql-microbench " << VERSION << std::endl;
+		return 0;
+	}
+
+	if (format != "json" && format != "csv") {
+		std::cerr << "Invalid output format: " << format << std::endl;
+		return 1;
+	}
+
+	if (min_time_ms < 1 || repetitions < 1) {
+		std::cerr << "Invalid minimum time or number of repetitions" << std::endl;
+		return 1;
+	}
+
+	// Same default log level as the runtime: trace/debug calls in the benchmarked code are filtered out
+	spdlog::set_level(spdlog::level::err);
+
+	BenchmarkRunner runner(filter, min_time_ms, repetitions);
+	runner.progress = opt_verbose->is_set();
+
+	bench_sqlvar(runner);
+	bench_sqlvarlist(runner);
+	bench_managers(runner);
+	bench_set_status(runner);
+	bench_fixup_parameters(runner);
+
+	if (!output_file.empty()) {
+		std::ofstream ofs(output_file);
+		if (!ofs.is_open()) {
+			std::cerr << "Cannot open output file: " << output_file << std::endl;
+			return 1;
+		}
+		write_results(ofs, format, runner.getResults());
+	}
+	else {
+		write_results(std::cout, format, runner.getResults());
+	}
+
+	return 0;
+}
@@ -0,0 +1,483 @@
+/*
+This file is part of Gix-IDE, an IDE and platform for GnuCOBOL
+Copyright (C) 2021 Marco Ridoni
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+USA.
+*/
+
+#include <map>
+#include <vector>
+#include <string>
+#include <memory>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <iostream>
+
+#include "popl.hpp"
+
+#include "gixsql.h"
+#include "IDbInterface.h"
+#include "IResultSetContextData.h"
+#include "IConnectionOptions.h"
+#include "DbInterfaceFactory.h"
+#include "DataSourceInfo.h"
+#include "WorkloadTrace.h"
+
+#include "config.h"
+
+#define REPLAY_FETCH_BUFFER_SIZE	(64 * 1024)
+#define REPLAY_LABEL_MAX_LEN		60
+
+using namespace popl;
+
+// Cursor replayed from a trace: its parameters are the ones recorded when it was opened
+class ReplayCursor : public ICursor
+{
+public:
+	void setConnection(std::shared_ptr<IConnection> c) override { }
+	void setConnectionName(std::string) override { }
+	void setName(std::string n) override { name = n; }
+	void setQuery(std::string q) override { query = q; }
+	void setQuerySource(void*, int) override { }
+	void setNumParams(int) override { }
+
+	std::shared_ptr<IConnection> getConnection() override { return nullptr; }
+	std::string getConnectionName() override { return ""; }
+	std::string getName() override { return name; }
+	std::string getQuery() override { return query; }
+	void getQuerySource(void** d, int* l) override { *d = nullptr; *l = 0; }
+	int getNumParams() override { return param_values.size(); }
+	bool isWithHold() override { return with_hold; }
+	bool isOpen() override { return is_open; }
+
+	std::vector<CobolVarType> getParameterTypes() override { return param_types; }
+	std::vector<std_binary_data> getParameterValues() override { return param_values; }
+	std::vector<unsigned long> getParameterLengths() override { return param_lengths; }
+	std::vector<uint32_t> getParameterFlags() override { return param_flags; }
+
+	std::shared_ptr<IPrivateStatementData> getPrivateData() override { return private_data; }
+	void setPrivateData(std::shared_ptr<IPrivateStatementData> d) override { private_data = d; }
+	void clearPrivateData() override { private_data.reset(); }
+
+	uint64_t getRowNum() override { return rownum; }
+	void increaseRowNum() override { rownum++; }
+
+	std::string name;
+	std::string query;
+	bool with_hold = false;
+	bool is_open = false;
+	bool is_declared = false;
+	uint64_t rownum = 0;
+
+	std::vector<CobolVarType> param_types;
+	std::vector<std_binary_data> param_values;
+	std::vector<unsigned long> param_lengths;
+	std::vector<uint32_t> param_flags;
+
+private:
+	std::shared_ptr<IPrivateStatementData> private_data;
+};
+
+struct ReplayStats {
+	std::vector<uint64_t> latencies;	// ns
+	uint64_t original_time = 0;			// ns
+	uint64_t errors = 0;
+	uint64_t mismatches = 0;
+};
+
+struct ReplayOptions {
+	std::string data_source;
+	std::string username;
+	std::string password;
+	bool max_speed = false;
+	int concurrency = 1;
+	bool verbose = false;
+};
+
+static const char* get_op_name(WorkloadRecordType t)
+{
+	switch (t) {
+		case WorkloadRecordType::Connect: return "CONNECT";
+		case WorkloadRecordType::Disconnect: return "DISCONNECT";
+		case WorkloadRecordType::Exec: return "EXEC";
+		case WorkloadRecordType::Prepare: return "PREPARE";
+		case WorkloadRecordType::ExecPrepared: return "EXECUTE";
+		case WorkloadRecordType::CursorOpen: return "OPEN";
+		case WorkloadRecordType::CursorFetch: return "FETCH";
+		case WorkloadRecordType::CursorClose: return "CLOSE";
+		default: return "?";
+	}
+}
+
+// Statements are reported by id (if the program was preprocessed with -T), otherwise by name or text
+static std::string get_label(const WorkloadTraceReader& trace, const WorkloadRecord& r)
+{
+	std::string label = trace.getString(r.stmt_id);
+	if (label.empty())
+		label = trace.getString(r.name);
+	if (label.empty())
+		label = trace.getString(r.sql);
+
+	std::replace(label.begin(), label.end(), '\n', ' ');
+	if (label.size() > REPLAY_LABEL_MAX_LEN)
+		label = label.substr(0, REPLAY_LABEL_MAX_LEN - 3) + "...";
+
+	return std::string(get_op_name(r.type)) + " " + label;
+}
+
+static void get_params(const WorkloadRecord& r, std::vector<CobolVarType>& types, std::vector<std_binary_data>& values, std::vector<unsigned long>& lengths, std::vector<uint32_t>& flags)
+{
+	for (const auto& p : r.params) {
+		types.push_back(p.type);
+		values.push_back(p.data);
+		lengths.push_back(p.is_null ? DB_NULL : p.data.size());
+		flags.push_back(p.flags);
+	}
+}
+
+static bool read_row(const std::shared_ptr<IDbInterface>& dbi, ResultSetContextType ctx_type, const IResultSetContextData& ctx, int nfields, char* bfr)
+{
+	for (int i = 0; i < nfields; i++) {
+		uint64_t len = 0;
+		bool is_null = false;
+		if (!dbi->get_resultset_value(ctx_type, ctx, 0, i, bfr, REPLAY_FETCH_BUFFER_SIZE, &len, &is_null))
+			return false;
+	}
+	return true;
+}
+
+class ReplaySession
+{
+public:
+	ReplaySession(const ReplayOptions& _opts, const WorkloadTraceReader& _trace, const std::vector<const WorkloadRecord*>& _records, std::chrono::steady_clock::time_point _origin)
+		: opts(_opts), trace(_trace), records(_records), origin(_origin)
+	{
+		fetch_buffer = std::make_unique<char[]>(REPLAY_FETCH_BUFFER_SIZE);
+	}
+
+	void run()
+	{
+		for (const WorkloadRecord* r : records) {
+			if (!opts.max_speed)
+				std::this_thread::sleep_until(origin + std::chrono::nanoseconds(r->start));
+
+			if (!dbi && r->type != WorkloadRecordType::Connect && !connect(AutoCommitMode::Native))
+				return;
+
+			auto t0 = std::chrono::steady_clock::now();
+			bool is_mismatch = false;
+			int rc = execute(*r, &is_mismatch);
+			uint64_t elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0).count();
+
+			ReplayStats& s = stats[get_label(trace, *r)];
+			s.latencies.push_back(elapsed);
+			s.original_time += r->elapsed;
+
+			// End of data on FETCH is not an error, but it must happen at the same point as in the original workload
+			bool is_error = (rc != DBERR_NO_ERROR && rc != DBERR_NO_DATA);
+			if (is_error)
+				s.errors++;
+			if (is_mismatch || ((rc == DBERR_NO_ERROR) != (r->rc == DBERR_NO_ERROR)))
+				s.mismatches++;
+
+			if (is_error && opts.verbose)
+				fprintf(stderr, "%s: %s (%d)\n", get_label(trace, *r).c_str(), dbi ? dbi->get_error_message() : "", rc);
+		}
+
+		if (dbi) {
+			dbi->terminate_connection();
+			dbi.reset();
+		}
+	}
+
+	std::map<std::string, ReplayStats> stats;
+
+private:
+	const ReplayOptions& opts;
+	const WorkloadTraceReader& trace;
+	const std::vector<const WorkloadRecord*>& records;
+	std::chrono::steady_clock::time_point origin;
+
+	std::shared_ptr<IDbInterface> dbi;
+	std::map<std::string, std::shared_ptr<ReplayCursor>> cursors;
+	std::unique_ptr<char[]> fetch_buffer;
+
+	bool connect(AutoCommitMode autocommit)
+	{
+		std::shared_ptr<DataSourceInfo> ds = std::make_shared<DataSourceInfo>();
+		if (ds->init(opts.data_source, "", opts.username, opts.password) != 0) {
+			fprintf(stderr, "ERROR: invalid data source: %s\n", opts.data_source.c_str());
+			return false;
+		}
+
+		dbi = DbInterfaceFactory::getInterface(ds->getDbType(), nullptr);
+		if (!dbi) {
+			fprintf(stderr, "ERROR: cannot load the driver for %s\n", ds->getDbType().c_str());
+			return false;
+		}
+
+		std::shared_ptr<IConnectionOptions> conn_opts = std::make_shared<IConnectionOptions>();
+		conn_opts->autocommit = autocommit;
+		if (dbi->connect(ds, conn_opts) != DBERR_NO_ERROR) {
+			fprintf(stderr, "ERROR: cannot connect to %s: %s\n", opts.data_source.c_str(), dbi->get_error_message());
+			dbi.reset();
+			return false;
+		}
+		return true;
+	}
+
+	int execute(const WorkloadRecord& r, bool* is_mismatch)
+	{
+		std::vector<CobolVarType> types;
+		std::vector<std_binary_data> values;
+		std::vector<unsigned long> lengths;
+		std::vector<uint32_t> flags;
+		get_params(r, types, values, lengths, flags);
+
+		switch (r.type) {
+			case WorkloadRecordType::Connect:
+				if (dbi)
+					return DBERR_NO_ERROR;
+				return connect((r.flags == (uint32_t)AutoCommitMode::On || r.flags == (uint32_t)AutoCommitMode::Off) ? (AutoCommitMode)r.flags : AutoCommitMode::Native) ? DBERR_NO_ERROR : DBERR_CONNECTION_FAILED;
+
+			case WorkloadRecordType::Disconnect:
+			{
+				int rc = dbi->terminate_connection();
+				dbi.reset();
+				cursors.clear();
+				return rc;
+			}
+
+			case WorkloadRecordType::Exec:
+			{
+				const std::string& sql = trace.getString(r.sql);
+				dbi->set_statement_flags(r.flags);
+				int rc = types.empty() ? dbi->exec(sql) : dbi->exec_params(sql, types, values, lengths, flags);
+				dbi->set_statement_flags(0);
+				if (rc != DBERR_NO_ERROR)
+					return rc;
+
+				if (r.rows >= 0 && dbi->has(DbNativeFeature::ResultSetRowCount) && dbi->get_num_rows(nullptr) != r.rows)
+					*is_mismatch = true;
+
+				// The result of SELECT ... INTO is retrieved, as the runtime would do
+				if (r.fields > 0 && r.rows != 0) {
+					if (dbi->get_num_fields(nullptr) != r.fields)
+						*is_mismatch = true;
+					else if (dbi->move_to_first_record() && !read_row(dbi, ResultSetContextType::CurrentResultSet, CurrentResultSetContextData(), r.fields, fetch_buffer.get()))
+						return DBERR_INVALID_COLUMN_DATA;
+				}
+				return DBERR_NO_ERROR;
+			}
+
+			case WorkloadRecordType::Prepare:
+				return dbi->prepare(trace.getString(r.name), trace.getString(r.sql));
+
+			case WorkloadRecordType::ExecPrepared:
+				return dbi->exec_prepared(trace.getString(r.name), types, values, lengths, flags);
+
+			case WorkloadRecordType::CursorOpen:
+			{
+				const std::string& name = trace.getString(r.name);
+				const std::string& sql = trace.getString(r.sql);
+				std::shared_ptr<ReplayCursor>& c = cursors[name];
+				if (!c || c->query != sql) {
+					c = std::make_shared<ReplayCursor>();
+					c->name = name;
+					c->query = sql;
+				}
+
+				c->with_hold = (r.flags & WORKLOAD_FLAG_WITH_HOLD);
+				c->param_types = types;
+				c->param_values = values;
+				c->param_lengths = lengths;
+				c->param_flags = flags;
+
+				if (!c->is_declared) {
+					int rc = dbi->cursor_declare(c);
+					if (rc != DBERR_NO_ERROR)
+						return rc;
+					c->is_declared = true;
+				}
+
+				int rc = dbi->cursor_open(c);
+				c->is_open = (rc == DBERR_NO_ERROR);
+				c->rownum = 0;
+				return rc;
+			}
+
+			case WorkloadRecordType::CursorFetch:
+			{
+				auto it = cursors.find(trace.getString(r.name));
+				if (it == cursors.end() || !it->second->is_open)
+					return DBERR_CURSOR_CLOSED;
+
+				std::shared_ptr<ReplayCursor> c = it->second;
+				int rc = dbi->cursor_fetch_one(c, FETCH_NEXT_ROW);
+				if (rc == DBERR_NO_ERROR && !read_row(dbi, ResultSetContextType::Cursor, CursorContextData(c), r.fields, fetch_buffer.get()))
+					return DBERR_INVALID_COLUMN_DATA;
+				return rc;
+			}
+
+			case WorkloadRecordType::CursorClose:
+			{
+				auto it = cursors.find(trace.getString(r.name));
+				if (it == cursors.end())
+					return DBERR_NO_SUCH_CURSOR;
+
+				int rc = dbi->cursor_close(it->second);
+				it->second->is_open = false;
+				return rc;
+			}
+
+			default:
+				return DBERR_NOT_IMPL;
+		}
+	}
+};
+
+static uint64_t percentile(const std::vector<uint64_t>& sorted, double p)
+{
+	if (sorted.empty())
+		return 0;
+
+	size_t idx = (size_t)(p * (sorted.size() - 1) + 0.5);
+	return sorted.at(std::min(idx, sorted.size() - 1));
+}
+
+static void print_report(std::map<std::string, ReplayStats>& stats, uint64_t wall_time)
+{
+	uint64_t total_ops = 0, total_errors = 0, total_mismatches = 0;
+
+	printf("%-70s %8s %6s %6s %10s %10s %10s %10s %10s %10s\n", "statement", "calls", "errors", "diffs", "orig(ms)", "mean(ms)", "p50(ms)", "p90(ms)", "p99(ms)", "max(ms)");
+
+	for (auto& it : stats) {
+		ReplayStats& s = it.second;
+		std::sort(s.latencies.begin(), s.latencies.end());
+
+		uint64_t sum = 0;
+		for (uint64_t l : s.latencies)
+			sum += l;
+
+		uint64_t n = s.latencies.size();
+		printf("%-70s %8llu %6llu %6llu %10.3f %10.3f %10.3f %10.3f %10.3f %10.3f\n", it.first.c_str(), (unsigned long long)n, (unsigned long long)s.errors, (unsigned long long)s.mismatches,
+			(double)s.original_time / n / 1000000.0, (double)sum / n / 1000000.0, percentile(s.latencies, 0.5) / 1000000.0, percentile(s.latencies, 0.9) / 1000000.0,
+			percentile(s.latencies, 0.99) / 1000000.0, s.latencies.back() / 1000000.0);
+
+		total_ops += n;
+		total_errors += s.errors;
+		total_mismatches += s.mismatches;
+	}
+
+	double secs = wall_time / 1000000000.0;
+	printf("\nTotal: %llu operations, %llu errors, %llu result differences, %.3f s, %.1f ops/s\n", (unsigned long long)total_ops, (unsigned long long)total_errors,
+		(unsigned long long)total_mismatches, secs, secs > 0 ? total_ops / secs : 0.0);
+}
+
+int main(int argc, char** argv)
+{
+	char vbfr[1024];
+	sprintf(vbfr, "gixsql-replay - replays a GixSQL workload capture\nVersion: %s\n\nUsage: gixsql-replay [options] trace-file\n\nOptions", VERSION);
+
+	OptionParser options(vbfr);
+
+	auto opt_help = options.add<Switch>("h", "help", "displays help on commandline options");
+	auto opt_data_source = options.add<Value<std::string>>("D", "data-source", "data source to replay the workload against (e.g. pgsql://localhost/testdb)");
+	auto opt_username = options.add<Value<std::string>>("U", "username", "username");
+	auto opt_password = options.add<Value<std::string>>("P", "password", "password");
+	auto opt_max_speed = options.add<Switch>("m", "max-speed", "replay at maximum speed (default: original timing)");
+	auto opt_concurrency = options.add<Value<int>>("c", "concurrency", "number of copies of each captured session replayed concurrently", 1);
+	auto opt_verbose = options.add<Switch>("v", "verbose", "verbose (report errors)");
+
+	options.parse(argc, argv);
+
+	if (opt_help->is_set()) {
+		std::cout << options << std::endl;
+		return 0;
+	}
+
+	if (options.unknown_options().size() > 0 || options.non_option_args().size() != 1 || !opt_data_source->is_set() || opt_concurrency->value() < 1) {
+		std::cout << options << std::endl;
+		fprintf(stderr, "ERROR: please enter a data source and a trace file\n");
+		return 1;
+	}
+
+	ReplayOptions opts;
+	opts.data_source = opt_data_source->value();
+	opts.username = opt_username->is_set() ? opt_username->value() : "";
+	opts.password = opt_password->is_set() ? opt_password->value() : "";
+	opts.max_speed = opt_max_speed->is_set();
+	opts.concurrency = opt_concurrency->value();
+	opts.verbose = opt_verbose->is_set();
+
+	WorkloadTraceReader trace;
+	std::string trace_file = options.non_option_args().at(0);
+	if (!trace.open(trace_file)) {
+		fprintf(stderr, "ERROR: cannot read trace file %s\n", trace_file.c_str());
+		return 1;
+	}
+
+	// Each captured session (connection) is replayed on its own connection, in its own thread
+	std::vector<std::unique_ptr<WorkloadRecord>> records;
+	std::map<uint32_t, std::vector<const WorkloadRecord*>> sessions;
+	std::unique_ptr<WorkloadRecord> r = std::make_unique<WorkloadRecord>();
+	while (trace.next(*r)) {
+		sessions[r->session].push_back(r.get());
+		records.push_back(std::move(r));
+		r = std::make_unique<WorkloadRecord>();
+	}
+
+	if (records.empty()) {
+		fprintf(stderr, "ERROR: no records in trace file %s\n", trace_file.c_str());
+		return 1;
+	}
+
+	// Initializes the runtime library (logging), used by the drivers
+	GIXSQLStartSQL();
+
+	std::vector<std::unique_ptr<ReplaySession>> replay_sessions;
+	auto origin = std::chrono::steady_clock::now();
+	for (auto& it : sessions) {
+		for (int i = 0; i < opts.concurrency; i++)
+			replay_sessions.push_back(std::make_unique<ReplaySession>(opts, trace, it.second, origin));
+	}
+
+	std::vector<std::thread> threads;
+	for (auto& s : replay_sessions)
+		threads.emplace_back(&ReplaySession::run, s.get());
+
+	for (auto& t : threads)
+		t.join();
+
+	uint64_t wall_time = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - origin).count();
+
+	std::map<std::string, ReplayStats> stats;
+	for (auto& s : replay_sessions) {
+		for (auto& it : s->stats) {
+			ReplayStats& m = stats[it.first];
+			m.latencies.insert(m.latencies.end(), it.second.latencies.begin(), it.second.latencies.end());
+			m.original_time += it.second.original_time;
+			m.errors += it.second.errors;
+			m.mismatches += it.second.mismatches;
+		}
+	}
+
+	printf("Replayed %zu records from %zu session(s) x %d against %s\n\n", records.size(), sessions.size(), opts.concurrency, opts.data_source.c_str());
+	print_report(stats, wall_time);
+
+	return 0;
+}
@@ -24,13 +24,15 @@
 #include "IConnection.h"
 #include "Logger.h"
 #include "utils.h"
+#include "param_fixup.h"
 #include "varlen_defs.h"
 #include "cobol_var_flags.h"
+#include "sql_stmt_flags.h"
+#include "sql_stmt_utils.h"
 
 #define CLIENT_SIDE_CURSOR_STORAGE
 #define MYSQL_OK	0
 
-static std::string mysql_fixup_parameters(const std::string& sql);
 static std::string __get_trimmed_hostref_or_literal(void* data, int l);
 
 DbInterfaceMySQL::DbInterfaceMySQL()
@@ -42,6 +44,10 @@ DbInterfaceMySQL::DbInterfaceMySQL()
 
 DbInterfaceMySQL::~DbInterfaceMySQL()
 {
+	_updatable_crsr_stmts.clear();
+	_prepared_stmt_cache.clear();
+	_prepared_stmts.clear();
+
 	if (connaddr) {
 		mysql_close(connaddr);
 		mysql_library_end();
@@ -125,6 +131,8 @@ int DbInterfaceMySQL::connect(std::shared_ptr<IDataSourceInfo> _conn_info, std::
 	else
 		lib_logger->trace(FMT_FILE_FUNC "MYSQL::updatable cursor support is disabled", __FILE__, __func__);
 
+	_prepared_stmt_cache.setMaxMemory(opts);
+
 	connaddr = conn;
 	current_statement_data = nullptr;
 
@@ -146,6 +154,10 @@ int DbInterfaceMySQL::reset()
 int DbInterfaceMySQL::terminate_connection()
 {
 	current_statement_data.reset();
+	_updatable_crsr_stmts.clear();
+	_table_unique_keys.clear();
+	_prepared_stmt_cache.clear();
+	_prepared_stmts.clear();
 
 	if (connaddr) {
 		mysql_close(connaddr);
@@ -180,17 +192,21 @@ std::string DbInterfaceMySQL::get_state()
 int DbInterfaceMySQL::prepare(const std::string& _stmt_name, const std::string& query)
 {
 	std::string prepared_sql;
-	std::shared_ptr<MySQLStatementData> res = std::make_shared<MySQLStatementData>();
-	res->statement = mysql_stmt_init(connaddr);
-
 	std::string stmt_name = to_lower(_stmt_name);
 
 	lib_logger->trace(FMT_FILE_FUNC "MySQL::prepare ({}) - SQL: {}", __FILE__, __func__, stmt_name, query);
 
-	if (this->_prepared_stmts.find(stmt_name) != _prepared_stmts.end()) {
-		return DBERR_PREPARE_FAILED;
+	// The same text has already been prepared and the statement is not in use by another name: reuse it
+	std::shared_ptr<MySQLStatementData> res = _prepared_stmt_cache.find(query, stmt_name, _prepared_stmts);
+	if (res) {
+		lib_logger->trace(FMT_FILE_FUNC "MySQL::prepare ({}) - reusing cached statement", __FILE__, __func__, stmt_name);
+		_prepared_stmts[stmt_name] = res;
+		return DBERR_NO_ERROR;
 	}
 
+	res = std::make_shared<MySQLStatementData>();
+	res->statement = mysql_stmt_init(connaddr);
+
 	if (connection_opts->fixup_parameters) {
 		prepared_sql = mysql_fixup_parameters(query);
 		lib_logger->trace(FMT_FILE_FUNC "MySQL::fixup parameters is on", __FILE__, __func__);
@@ -214,7 +230,76 @@ int DbInterfaceMySQL::prepare(const std::string& _stmt_name, const std::string&
 
 	lib_logger->trace(FMT_FILE_FUNC "MySQL::prepare ({} - res: ({}) {}", __FILE__, __func__, stmt_name, last_rc, last_error);
 
+	// If the name was already in use, the statement it was bound to is released, unless still cached
 	_prepared_stmts[stmt_name] = res;
+	_prepared_stmt_cache.add(query, res);
+
+	return DBERR_NO_ERROR;
+}
+
+// EXPLAIN cannot be executed with placeholders outside of a prepared statement, so the parameter values
+// are inlined (as quoted literals) in the statement text, which is only used to retrieve the plan
+int DbInterfaceMySQL::explain(const std::string& query, const std::vector<CobolVarType>& paramTypes, const std::vector<std_binary_data>& paramValues, const std::vector<unsigned long>& paramLengths, const std::vector<uint32_t>& paramFlags, std::string& plan)
+{
+	if (!connaddr)
+		return DBERR_CONN_NOT_FOUND;
+
+	if (paramValues.size() != paramLengths.size() || paramValues.size() != paramFlags.size())
+		return DBERR_INTERNAL_ERR;
+
+	std::string sql = connection_opts->fixup_parameters ? mysql_fixup_parameters(query) : query;
+	std::string explain_query = "EXPLAIN FORMAT=JSON ";
+
+	int nparam = 0;
+	bool in_single_quoted_string = false;
+	bool in_double_quoted_string = false;
+	for (char c : sql) {
+		if (c == '\'' && !in_double_quoted_string)
+			in_single_quoted_string = !in_single_quoted_string;
+		else if (c == '"' && !in_single_quoted_string)
+			in_double_quoted_string = !in_double_quoted_string;
+
+		if (c != '?' || in_single_quoted_string || in_double_quoted_string || nparam >= paramValues.size()) {
+			explain_query += c;
+			continue;
+		}
+
+		unsigned long len = paramLengths.at(nparam);
+		if (len == DB_NULL) {
+			explain_query += "NULL";
+		}
+		else if (CBL_FIELD_IS_BINARY(paramFlags.at(nparam))) {
+			explain_query += "X'";
+			for (unsigned long i = 0; i < len; i++)
+				explain_query += fmt::format("{:02x}", paramValues.at(nparam).at(i));
+			explain_query += "'";
+		}
+		else {
+			std::unique_ptr<char[]> bfr = std::make_unique<char[]>(len * 2 + 1);
+			mysql_real_escape_string(connaddr, bfr.get(), (const char*)paramValues.at(nparam).data(), len);
+			explain_query += "'" + std::string(bfr.get()) + "'";
+		}
+		nparam++;
+	}
+
+	if (mysql_real_query(connaddr, explain_query.c_str(), explain_query.size())) {
+		lib_logger->warn("MySQL: cannot retrieve the execution plan: {}", mysql_error(connaddr));
+		return DBERR_SQL_ERROR;
+	}
+
+	MYSQL_RES* result = mysql_store_result(connaddr);
+	if (!result) {
+		lib_logger->warn("MySQL: cannot retrieve the execution plan: {}", mysql_error(connaddr));
+		return DBERR_SQL_ERROR;
+	}
+
+	MYSQL_ROW r = nullptr;
+	while ((r = mysql_fetch_row(result))) {
+		if (r[0])
+			plan += r[0];
+	}
+
+	mysql_free_result(result);
 
 	return DBERR_NO_ERROR;
 }
@@ -352,15 +437,14 @@ int DbInterfaceMySQL::_mysql_exec_params(std::shared_ptr<ICursor> crsr, const st
 {
 	int rc = 0;
 	bool is_delete = false;
-	std::string cursor_name, table_name, update_query;
-	std::vector<std::string> unique_key;
-	MYSQL_STMT* upd_del_statement = nullptr;
-	MYSQL_BIND *key_params;
+	std::string cursor_name, table_name;
+	std::shared_ptr<ICursor> updatable_crsr;
 	int key_params_size = 0;
-	std::unique_ptr<MYSQL_BIND[]> key_params_ptr;
 
 	lib_logger->trace(FMT_FILE_FUNC "SQL: #{}#", __FILE__, __func__, query);
 
+	invalidate_updatable_cursor_caches(query);
+
 	std::shared_ptr<MySQLStatementData> wk_rs;
 
 	if (paramTypes.size() != paramValues.size() || paramTypes.size() != paramFlags.size()) {
@@ -380,7 +464,7 @@ int DbInterfaceMySQL::_mysql_exec_params(std::shared_ptr<ICursor> crsr, const st
 
 		wk_rs = std::make_shared<MySQLStatementData>();
 
-		if (updatable_cursors_emu && is_update_or_delete_where_current_of(query, table_name, cursor_name, &is_delete)) {
+		if (updatable_cursors_emu && is_positioned_update_or_delete(query, table_name, cursor_name, &is_delete)) {
 
 			// No cursor was passed, we need to find it
 			if (cursor_name.empty() || this->_declared_cursors.find(cursor_name) == this->_declared_cursors.end() || !this->_declared_cursors[cursor_name]) {
@@ -388,25 +472,14 @@ int DbInterfaceMySQL::_mysql_exec_params(std::shared_ptr<ICursor> crsr, const st
 				return DBERR_SQL_ERROR;
 			}
 
-			std::shared_ptr<ICursor> updatable_crsr = this->_declared_cursors[cursor_name];
-
-			if (has_unique_key(table_name, updatable_crsr, unique_key)) {
-				std::string new_query;
+			updatable_crsr = this->_declared_cursors[cursor_name];
 
-				if (!prepare_updatable_cursor_query(query, updatable_crsr, unique_key, &upd_del_statement, &key_params, &key_params_size) || !upd_del_statement) {
-					spdlog::error("Cannot rewrite query for updatable cursor {}", updatable_crsr->getName());
-					return DBERR_SQL_ERROR;
-				}
-
-				// Parameters are bound later
-				key_params_ptr = std::unique_ptr<MYSQL_BIND[]>(key_params);
-
-				wk_rs->statement = upd_del_statement;
-			}
-			else {
-				spdlog::error("No unique key found on table while trying to update a cursor row (cursor: {}, table: {}", cursor_name, table_name);
+			wk_rs = get_updatable_cursor_statement(query, table_name, updatable_crsr);
+			if (!wk_rs)
 				return DBERR_SQL_ERROR;
-			}
+
+			// Key parameters are bound later
+			key_params_size = wk_rs->key_col_idxs.size();
 		}
 		else {
 			wk_rs->statement = mysql_stmt_init(connaddr);
@@ -442,12 +515,9 @@ int DbInterfaceMySQL::_mysql_exec_params(std::shared_ptr<ICursor> crsr, const st
 	}
 
 	// This will only be used if we are performing an update/delete on an updatable cursor
-	for (int i = 0; i < key_params_size; i++) {
-		MYSQL_BIND* bound_param = &bound_param_defs[nParams + i];
-
-		bound_param->buffer_type = MYSQL_TYPE_STRING;
-		bound_param->buffer = key_params_ptr[i].buffer;
-		bound_param->buffer_length = key_params[i].buffer_length;
+	if (key_params_size > 0 && !bind_updatable_cursor_keys(updatable_crsr, wk_rs, &bound_param_defs[nParams])) {
+		lib_logger->error("Could not bind key values for updatable cursor {}", updatable_crsr->getName());
+		return DBERR_SQL_ERROR;
 	}
 
 	rc = mysql_stmt_bind_param(wk_rs->statement, bound_param_defs.get());
@@ -505,7 +575,7 @@ int DbInterfaceMySQL::_mysql_exec_params(std::shared_ptr<ICursor> crsr, const st
 	}
 
 	if (!prep_stmt_data) {
-		if (is_update_or_delete_statement(query)) {
+		if (is_update_or_delete(query)) {
 			int nrows = mysql_stmt_affected_rows(wk_rs->statement);
 			if (nrows <= 0) {
 				last_rc = 100;
@@ -532,14 +602,12 @@ int DbInterfaceMySQL::_mysql_exec(std::shared_ptr<ICursor> crsr, const std::stri
 {
 	int rc = 0;
 	bool is_delete = false;
-	std::string cursor_name, table_name, update_query;
-	std::vector<std::string> unique_key;
-	MYSQL_STMT* upd_del_statement = nullptr;
-	MYSQL_BIND* key_params;
-	int key_params_size = 0;
+	std::string cursor_name, table_name;
 
 	lib_logger->trace(FMT_FILE_FUNC "SQL: #{}#", __FILE__, __func__, query);
 
+	invalidate_updatable_cursor_caches(query);
+
 	std::shared_ptr<MySQLStatementData> wk_rs;
 
 	if (!prep_stmt_data) {
@@ -551,7 +619,7 @@ int DbInterfaceMySQL::_mysql_exec(std::shared_ptr<ICursor> crsr, const std::stri
 
 		wk_rs = std::make_shared<MySQLStatementData>();
 
-		if (updatable_cursors_emu && is_update_or_delete_where_current_of(query, table_name, cursor_name, &is_delete)) {
+		if (updatable_cursors_emu && is_positioned_update_or_delete(query, table_name, cursor_name, &is_delete)) {
 
 			// No cursor was passed, we need to find it
 			if (cursor_name.empty() || this->_declared_cursors.find(cursor_name) == this->_declared_cursors.end() || !this->_declared_cursors[cursor_name]) {
@@ -561,26 +629,19 @@ int DbInterfaceMySQL::_mysql_exec(std::shared_ptr<ICursor> crsr, const std::stri
 
 			std::shared_ptr<ICursor> updatable_crsr = this->_declared_cursors[cursor_name];
 
-			if (has_unique_key(table_name, updatable_crsr, unique_key)) {
-				std::string new_query;
-
-				if (!prepare_updatable_cursor_query(query, updatable_crsr, unique_key, &upd_del_statement, &key_params, &key_params_size) || !upd_del_statement) {
-					spdlog::error("Cannot rewrite query for updatable cursor {}", updatable_crsr->getName());
-					return DBERR_SQL_ERROR;
-				}
-
-				std::unique_ptr<MYSQL_BIND[]> key_params_ptr = std::unique_ptr<MYSQL_BIND[]>(key_params);
-
-				rc = mysql_stmt_bind_param(upd_del_statement, key_params_ptr.get());
-				if (mysqlRetrieveError(rc) != MYSQL_OK) {
-					lib_logger->error("MySQL: Error while binding parameter definitions ({}): {}", last_rc, last_error);
-					return DBERR_SQL_ERROR;
-				}
+			wk_rs = get_updatable_cursor_statement(query, table_name, updatable_crsr);
+			if (!wk_rs)
+				return DBERR_SQL_ERROR;
 
-				wk_rs->statement = upd_del_statement;
+			std::unique_ptr<MYSQL_BIND[]> key_params = std::make_unique<MYSQL_BIND[]>(wk_rs->key_col_idxs.size());
+			if (!bind_updatable_cursor_keys(updatable_crsr, wk_rs, key_params.get())) {
+				lib_logger->error("Could not bind key values for updatable cursor {}", updatable_crsr->getName());
+				return DBERR_SQL_ERROR;
 			}
-			else {
-				spdlog::error("No unique key found on table while trying to update a cursor row (cursor: {}, table: {}", cursor_name, table_name);
+
+			rc = mysql_stmt_bind_param(wk_rs->statement, key_params.get());
+			if (mysqlRetrieveError(rc) != MYSQL_OK) {
+				lib_logger->error("MySQL: Error while binding parameter definitions ({}): {}", last_rc, last_error);
 				return DBERR_SQL_ERROR;
 			}
 		}
@@ -654,7 +715,7 @@ int DbInterfaceMySQL::_mysql_exec(std::shared_ptr<ICursor> crsr, const std::stri
 	}
 
 	if (!prep_stmt_data) {
-		if (is_update_or_delete_statement(query)) {
+		if (is_update_or_delete(query)) {
 			int nrows = mysql_stmt_affected_rows(wk_rs->statement);
 			if (nrows <= 0) {
 				last_rc = 100;
@@ -717,6 +778,7 @@ int DbInterfaceMySQL::cursor_close(const std::shared_ptr<ICursor>& cursor)
 	}
 
 	cursor->setPrivateData(nullptr);
+	_updatable_crsr_stmts.erase(cursor->getName());
 
 	return DBERR_NO_ERROR;
 }
@@ -727,10 +789,9 @@ int DbInterfaceMySQL::cursor_declare(const std::shared_ptr<ICursor>& cursor)
 	if (!cursor)
 		return DBERR_DECLARE_CURSOR_FAILED;
 
-	std::map<std::string, std::shared_ptr<ICursor>>::iterator it = _declared_cursors.find(cursor->getName());
-	if (it == _declared_cursors.end()) {
-		_declared_cursors[cursor->getName()] = cursor;
-	}
+	// A cursor with the same name might have been declared before, on a different query
+	_declared_cursors[cursor->getName()] = cursor;
+	_updatable_crsr_stmts.erase(cursor->getName());
 
 	return DBERR_NO_ERROR;
 }
@@ -1038,54 +1099,6 @@ void MySQLStatementData::cleanup()
 }
 
 
-static std::string mysql_fixup_parameters(const std::string& sql)
-{
-	int n = 1;
-	bool in_single_quoted_string = false;
-	bool in_double_quoted_string = false;
-	bool in_param_id = false;
-	std::string out_sql;
-
-	for (auto itc = sql.begin(); itc != sql.end(); ++itc) {
-		char c = *itc;
-
-		if (in_param_id && isalnum(c))
-			continue;
-		else {
-			in_param_id = false;
-		}
-
-		switch (c) {
-		case '"':
-			out_sql += c;
-			in_double_quoted_string = !in_double_quoted_string;
-			continue;
-
-		case '\'':
-			out_sql += c;
-			in_single_quoted_string = !in_single_quoted_string;
-			continue;
-
-		case '$':
-		case ':':
-		case '@':
-			if (!in_single_quoted_string && !in_double_quoted_string) {
-				out_sql += '?';
-				in_param_id = true;
-			}
-			else
-				out_sql += c;
-			continue;
-
-		default:
-			out_sql += c;
-
-		}
-	}
-
-	return out_sql;
-}
-
 bool DbInterfaceMySQL::is_cursor_from_prepared_statement(std::shared_ptr<ICursor> cursor)
 {
 	std::string squery = cursor->getQuery();
@@ -1162,9 +1175,6 @@ std::vector<enum_field_types> DbInterfaceMySQL::get_resultset_column_types(MYSQL
 
 bool DbInterfaceMySQL::has_unique_key(std::string table_name, std::shared_ptr<ICursor> crsr, std::vector<std::string>& unique_key)
 {
-	std::vector<std::string> key;
-	std::vector<std::string> constraints;
-
 	if (!connaddr || table_name.empty() || !crsr || !crsr->getPrivateData()) {
 		return false;
 	}
@@ -1178,63 +1188,52 @@ bool DbInterfaceMySQL::has_unique_key(std::string table_name, std::shared_ptr<IC
 	if (n != std::string::npos)
 		table_name = table_name.substr(n + 1);
 
-	int rc = mysql_query(connaddr, ("SHOW KEYS FROM `" + table_name + "`").c_str());
-	if (mysqlRetrieveError(rc) != MYSQL_OK) {
-		return false;
-	}
+	// The unique keys of a table are retrieved only once per connection
+	if (_table_unique_keys.find(table_name) == _table_unique_keys.end()) {
+		int rc = mysql_query(connaddr, ("SHOW KEYS FROM `" + table_name + "`").c_str());
+		if (mysqlRetrieveError(rc) != MYSQL_OK) {
+			return false;
+		}
 
-	MYSQL_RES* result = mysql_store_result(connaddr);
-	if (!result) {
-		return false;
-	}
+		MYSQL_RES* result = mysql_store_result(connaddr);
+		if (!result) {
+			return false;
+		}
 
-	bool key_found = false;
-	int num_fields = mysql_num_fields(result);
-	std::vector<std::string> crsr_cols = get_resultset_column_names(rs->statement);
+		// Rows are ordered by key name and by column position in the key
+		std::vector<std::vector<std::string>> keys;
+		std::string cur_key_name;
+		MYSQL_ROW r = nullptr;
+		while ((r = mysql_fetch_row(result))) {
+			bool is_unique = r[1][0] == '0';
+			if (!is_unique)
+				continue;
 
-	MYSQL_ROW r = nullptr;
-	std::string cur_key_name;
-	while (true) {
+			std::string key_name = r[2];
+			std::string column_name = r[4];
 
-		r = mysql_fetch_row(result);
-		if (!r) {
-			if (key.size() > 0 && (key_found = vector_contains_all(crsr_cols, key))) {
-				unique_key = key;
+			if (keys.empty() || key_name != cur_key_name) {
+				cur_key_name = key_name;
+				keys.push_back(std::vector<std::string>());
 			}
-			break;
+			keys.back().push_back(to_upper(column_name));
 		}
 
-		bool is_unique = r[1][0] == '0';
-		int seq_in_index = atoi(r[3]);
-		std::string column_name = r[4];
-		std::string key_name = r[2];
+		mysql_free_result(result);
 
-		if (cur_key_name.empty()) {
-			cur_key_name = key_name;
-			key.clear();
-			key.push_back(to_upper(column_name));
-			continue;
-		}
+		_table_unique_keys[table_name] = keys;
+	}
 
-		if (key_name != cur_key_name) {
-			// check and close key
-			key_found = vector_contains_all(crsr_cols, key);
-			if (key_found) {
-				unique_key = key;
-				break;
-			}
-			else {
-				key.clear();
-				cur_key_name = key_name;
-				key.push_back(to_upper(column_name));
-			}
-		}
-		else {
-			key.push_back(to_upper(column_name));
-			continue;
-		}
+	bool key_found = false;
+	std::vector<std::string> crsr_cols = get_resultset_column_names(rs->statement);
 
-	};
+	for (const auto& key : _table_unique_keys[table_name]) {
+		if (vector_contains_all(crsr_cols, key)) {
+			unique_key = key;
+			key_found = true;
+			break;
+		}
+	}
 
 	if (!key_found) {
 		lib_logger->trace("unique key not found for updatable cursor (cursor: {}, table: {})", crsr->getName(), table_name);
@@ -1243,16 +1242,11 @@ bool DbInterfaceMySQL::has_unique_key(std::string table_name, std::shared_ptr<IC
 		lib_logger->trace("unique key found for updatable cursor (cursor: {}, table: {}): {}", crsr->getName(), table_name, vector_join(unique_key, ','));
 	}
 
-	if (result)
-		mysql_free_result(result);
-
 	return key_found;
 }
 
-bool DbInterfaceMySQL::prepare_updatable_cursor_query(const std::string& qry, std::shared_ptr<ICursor> crsr, const std::vector<std::string>& unique_key, MYSQL_STMT** update_stmt, MYSQL_BIND **key_params, int *key_params_size)
+bool DbInterfaceMySQL::prepare_updatable_cursor_query(const std::string& qry, std::shared_ptr<ICursor> crsr, const std::vector<std::string>& unique_key, std::shared_ptr<MySQLStatementData>& upd_stmt_data)
 {
-	*update_stmt = nullptr;
-
 	if (!crsr || !crsr->getQuery().size())
 		return false;
 
@@ -1289,38 +1283,102 @@ bool DbInterfaceMySQL::prepare_updatable_cursor_query(const std::string& qry, st
 
 	tqry += where_clause;
 
-	MYSQL_STMT* upd_stmt = mysql_stmt_init(connaddr);
+	// we store the position of the key columns in the cursor, their values will be bound at each execution
+	std::vector<int> key_col_idxs;
+	for (int i = 0; i < unique_key.size(); i++) {
+		std::vector<std::string>::iterator itr = std::find(crsr_cols.begin(), crsr_cols.end(), unique_key.at(i));
+
+		if (itr == crsr_cols.cend()) {
+			lib_logger->error("Could not bind parameters for updatable cursor query ({})/[{}]", crsr->getName(), tqry);
+			return false;
+		}
+
+		key_col_idxs.push_back(std::distance(crsr_cols.begin(), itr));
+	}
+
+	auto upd_rs = std::make_shared<MySQLStatementData>();
+	upd_rs->statement = mysql_stmt_init(connaddr);
 
 	lib_logger->trace("Preparing updatable cursor query for {}: {}", crsr->getName(), tqry);
 
-	int rc = mysql_stmt_prepare(upd_stmt, tqry.c_str(), tqry.size());
+	int rc = mysql_stmt_prepare(upd_rs->statement, tqry.c_str(), tqry.size());
 	if (mysqlRetrieveError(rc) != MYSQL_OK) {
 		lib_logger->error("Could not prepare updatable cursor query for {}", crsr->getName());
 		return false;
 	}
 
-	// we pass parameters that need to be bound
+	upd_rs->key_col_idxs = key_col_idxs;
+	upd_stmt_data = upd_rs;
 
-	MYSQL_BIND *bound_param_defs = new MYSQL_BIND[unique_key.size()]();
-	for (int i = 0; i < unique_key.size(); i++) {
-		MYSQL_BIND* bound_param = &bound_param_defs[i];
+	return true;
+}
 
-		std::vector<std::string>::iterator itr = std::find(crsr_cols.begin(), crsr_cols.end(), unique_key.at(i));
+// Statement classification: the flags from the preprocessor are used if available, otherwise the statement text is inspected
+bool DbInterfaceMySQL::is_update_or_delete(const std::string& query)
+{
+	return SQL_STMT_HAS_FLAGS(stmt_flags) ? SQL_STMT_IS_UPDATE_OR_DELETE(stmt_flags) : is_update_or_delete_statement(query);
+}
 
-		if (itr == crsr_cols.cend()) {
-			lib_logger->error("Could not bind parameters for updatable cursor query ({})/[{}]", crsr->getName(), tqry);
+bool DbInterfaceMySQL::is_positioned_update_or_delete(const std::string& query, std::string& table_name, std::string& cursor_name, bool* is_delete)
+{
+	if (SQL_STMT_HAS_FLAGS(stmt_flags) && !SQL_STMT_IS_POSITIONED(stmt_flags))
+		return false;
+
+	return is_update_or_delete_where_current_of(query, table_name, cursor_name, is_delete);
+}
+
+std::shared_ptr<MySQLStatementData> DbInterfaceMySQL::get_updatable_cursor_statement(const std::string& qry, const std::string& table_name, std::shared_ptr<ICursor> crsr)
+{
+	// The rewritten UPDATE/DELETE is prepared only once per cursor, only the key values change from row to row
+	std::map<std::string, std::shared_ptr<MySQLStatementData>>& crsr_stmts = _updatable_crsr_stmts[crsr->getName()];
+	auto it = crsr_stmts.find(qry);
+	if (it != crsr_stmts.end())
+		return it->second;
+
+	std::vector<std::string> unique_key;
+	if (!has_unique_key(table_name, crsr, unique_key)) {
+		spdlog::error("No unique key found on table while trying to update a cursor row (cursor: {}, table: {}", crsr->getName(), table_name);
+		return nullptr;
+	}
+
+	std::shared_ptr<MySQLStatementData> upd_rs;
+	if (!prepare_updatable_cursor_query(qry, crsr, unique_key, upd_rs) || !upd_rs) {
+		spdlog::error("Cannot rewrite query for updatable cursor {}", crsr->getName());
+		return nullptr;
+	}
+
+	crsr_stmts[qry] = upd_rs;
+	return upd_rs;
+}
+
+// The rewritten UPDATE/DELETE statements depend on the cursor's select list and on the table's unique keys:
+// they are dropped when the cursor is declared again or closed, and a DDL statement invalidates everything
+void DbInterfaceMySQL::invalidate_updatable_cursor_caches(const std::string& query)
+{
+	if ((_table_unique_keys.empty() && _updatable_crsr_stmts.empty()) || !is_ddl_statement(query))
+		return;
+
+	lib_logger->trace(FMT_FILE_FUNC "DDL statement, clearing unique key and updatable cursor caches", __FILE__, __func__);
+	_table_unique_keys.clear();
+	_updatable_crsr_stmts.clear();
+}
+
+bool DbInterfaceMySQL::bind_updatable_cursor_keys(std::shared_ptr<ICursor> crsr, std::shared_ptr<MySQLStatementData> upd_stmt_data, MYSQL_BIND* key_params)
+{
+	auto rs = std::dynamic_pointer_cast<MySQLStatementData>(crsr->getPrivateData());
+	if (!rs)
+		return false;
+
+	for (int i = 0; i < upd_stmt_data->key_col_idxs.size(); i++) {
+		int col_idx = upd_stmt_data->key_col_idxs.at(i);
+		if (col_idx >= rs->data_buffers.size())
 			return false;
-		}
 
-		int col_idx = std::distance(crsr_cols.begin(), itr);
+		MYSQL_BIND* bound_param = &key_params[i];
 		bound_param->buffer_type = MYSQL_TYPE_STRING;
 		bound_param->buffer = rs->data_buffers[col_idx];
 		bound_param->buffer_length = strlen(rs->data_buffers[col_idx]);
 	}
 
-	*key_params = bound_param_defs;
-	*key_params_size = unique_key.size();
-	*update_stmt = upd_stmt;
-
 	return true;
 }
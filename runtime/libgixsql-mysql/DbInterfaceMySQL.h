@@ -42,6 +42,7 @@ extern "C" {
 #include "IDbManagerInterface.h"
 #include "IDataSourceInfo.h"
 #include "ISchemaManager.h"
+#include "PreparedStatementCache.h"
 
 struct MySQLStatementData : public IPrivateStatementData
 {
@@ -59,6 +60,9 @@ struct MySQLStatementData : public IPrivateStatementData
 
 	MYSQL_STMT* statement = nullptr;
 
+	// Updatable cursor emulation: position of the unique key columns in the cursor
+	std::vector<int> key_col_idxs;
+
 private:
 	void cleanup();
 
@@ -91,6 +95,7 @@ public:
 	virtual std::string get_state() override;
 	virtual int prepare(const std::string& stmt_name, const std::string& query) override;
 	virtual int exec_prepared(const std::string& stmt_name, std::vector<CobolVarType> paramTypes, std::vector<std_binary_data>& paramValues, std::vector<unsigned long> paramLengths, const std::vector<uint32_t>& paramFlags) override;
+	virtual int explain(const std::string& query, const std::vector<CobolVarType>& paramTypes, const std::vector<std_binary_data>& paramValues, const std::vector<unsigned long>& paramLengths, const std::vector<uint32_t>& paramFlags, std::string& plan) override;
 	virtual DbPropertySetResult set_property(DbProperty p, std::variant<bool, int, std::string> v) override;
 
 	virtual bool getSchemas(std::vector<SchemaInfo*>& res) override;
@@ -116,6 +121,7 @@ private:
 
 	std::map<std::string, std::shared_ptr<ICursor>> _declared_cursors;
 	std::map<std::string, std::shared_ptr<MySQLStatementData>> _prepared_stmts;
+	PreparedStatementCache<MySQLStatementData> _prepared_stmt_cache;
 
 	int _mysql_exec_params(std::shared_ptr<ICursor>, const std::string& query, const std::vector<CobolVarType>& paramTypes, const std::vector<std_binary_data>& paramValues, const std::vector<unsigned long>& paramLengths, const std::vector<uint32_t>& paramFlags, std::shared_ptr<MySQLStatementData> prep_stmt_data = nullptr);
 	int _mysql_exec(std::shared_ptr<ICursor>, const std::string& query, std::shared_ptr<MySQLStatementData> prep_stmt_data = nullptr);
@@ -123,10 +129,18 @@ private:
 	bool is_cursor_from_prepared_statement(std::shared_ptr<ICursor> cursor);
 	std::shared_ptr<MySQLStatementData> retrieve_prepared_statement(const std::string& prep_stmt_name);
 
+	bool is_update_or_delete(const std::string& query);
+	bool is_positioned_update_or_delete(const std::string& query, std::string& table_name, std::string& cursor_name, bool* is_delete);
+
 	// Updatable cursor emulation
 	bool updatable_cursors_emu = false;
 	bool has_unique_key(std::string table_name, std::shared_ptr<ICursor> crsr, std::vector<std::string>& unique_key);
-	bool prepare_updatable_cursor_query(const std::string& qry, std::shared_ptr<ICursor> crsr, const std::vector<std::string>& unique_key, MYSQL_STMT** update_stmt, MYSQL_BIND** key_params, int* key_params_size);
+	bool prepare_updatable_cursor_query(const std::string& qry, std::shared_ptr<ICursor> crsr, const std::vector<std::string>& unique_key, std::shared_ptr<MySQLStatementData>& upd_stmt_data);
+	std::shared_ptr<MySQLStatementData> get_updatable_cursor_statement(const std::string& qry, const std::string& table_name, std::shared_ptr<ICursor> crsr);
+	void invalidate_updatable_cursor_caches(const std::string& query);
+	bool bind_updatable_cursor_keys(std::shared_ptr<ICursor> crsr, std::shared_ptr<MySQLStatementData> upd_stmt_data, MYSQL_BIND* key_params);
+	std::map<std::string, std::vector<std::vector<std::string>>> _table_unique_keys;
+	std::map<std::string, std::map<std::string, std::shared_ptr<MySQLStatementData>>> _updatable_crsr_stmts;
 	std::vector<std::string> get_resultset_column_names(MYSQL_STMT* stmt);
 	std::vector<enum_field_types> get_resultset_column_types(MYSQL_STMT* stmt);
 };
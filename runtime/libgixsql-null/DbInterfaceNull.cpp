@@ -0,0 +1,671 @@
+/*
+This file is part of Gix-IDE, an IDE and platform for GnuCOBOL
+Copyright (C) 2021 Marco Ridoni
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+USA.
+*/
+
+#include "DbInterfaceNull.h"
+
+#include <cstring>
+#include <cctype>
+#include "IConnection.h"
+#include "Logger.h"
+#include "utils.h"
+#include "varlen_defs.h"
+
+#define NULL_MAX_INT_DIGITS		18
+
+// Statements built at runtime with literal values would make the cache grow indefinitely
+#define NULL_MAX_QUERY_SHAPES	4096
+
+// 2000-01-01, in days since 1970-01-01
+#define NULL_BASE_DATE_DAYS		10957
+#define NULL_DATE_RANGE_DAYS	(365 * 50)
+
+static std::string __get_trimmed_hostref_or_literal(void* data, int l);
+static int count_select_list_items(const std::string& query);
+static std::string format_date(int64_t days);
+
+// xorshift64: values only need to be reproducible for a given seed, not random in any strong sense
+class NullRandom
+{
+public:
+	NullRandom(uint64_t seed) : state(seed ? seed : 1) {}
+
+	uint64_t next()
+	{
+		state ^= state << 13;
+		state ^= state >> 7;
+		state ^= state << 17;
+		return state;
+	}
+
+private:
+	uint64_t state;
+};
+
+DbInterfaceNull::DbInterfaceNull()
+{}
+
+
+DbInterfaceNull::~DbInterfaceNull()
+{}
+
+int DbInterfaceNull::init(const std::shared_ptr<spdlog::logger>& _logger)
+{
+	is_connected = false;
+	current_statement_data = NULL;
+	last_rc = 0;
+
+	auto lib_sink = _logger->sinks().at(0);
+	lib_logger = std::make_shared<spdlog::logger>("libgixsql-null", lib_sink);
+	lib_logger->set_level(_logger->level());
+	lib_logger->info("libgixsql-null logger started");
+
+	return DBERR_NO_ERROR;
+}
+
+int DbInterfaceNull::connect(std::shared_ptr<IDataSourceInfo> _conn_info, std::shared_ptr<IConnectionOptions> _conn_opts)
+{
+	auto opts = _conn_info->getOptions();
+
+	opt_rows = NULL_DEFAULT_ROWS;
+	opt_select_rows = NULL_DEFAULT_SELECT_ROWS;
+	opt_affected_rows = NULL_DEFAULT_AFFECTED_ROWS;
+	uint32_t seed = 0;
+	int null_pct = 0;
+	std::string column_spec = NULL_DEFAULT_COLUMNS;
+
+	if (opts.find("rows") != opts.end())
+		opt_rows = atoi(opts["rows"].c_str());
+
+	if (opts.find("select_rows") != opts.end())
+		opt_select_rows = atoi(opts["select_rows"].c_str());
+
+	if (opts.find("affected_rows") != opts.end())
+		opt_affected_rows = atoi(opts["affected_rows"].c_str());
+
+	if (opts.find("seed") != opts.end())
+		seed = strtoul(opts["seed"].c_str(), nullptr, 10);
+
+	if (opts.find("nulls") != opts.end())
+		null_pct = atoi(opts["nulls"].c_str());
+
+	if (opts.find("columns") != opts.end())
+		column_spec = opts["columns"];
+
+	if (opt_rows < 0 || opt_select_rows < 0 || opt_affected_rows < 0 || null_pct < 0 || null_pct > 100) {
+		lib_logger->error("Null: invalid option value");
+		return DBERR_CONNECTION_FAILED;
+	}
+
+	if (!parse_columns(column_spec, seed, null_pct)) {
+		lib_logger->error("Null: invalid column specification: {}", column_spec);
+		return DBERR_CONNECTION_FAILED;
+	}
+
+	lib_logger->trace(FMT_FILE_FUNC "Null::connect: rows: {}, select_rows: {}, affected_rows: {}, columns: {}, seed: {}, nulls: {}%", __FILE__, __func__,
+		opt_rows, opt_select_rows, opt_affected_rows, column_spec, seed, null_pct);
+
+	current_statement_data.reset();
+	_query_shapes.clear();
+	nullClearError();
+	is_connected = true;
+
+	return DBERR_NO_ERROR;
+}
+
+// Format: type[:width[.scale]],... with type = int, dec, char, varchar, date (e.g. int:9,dec:11.2,char:30,date)
+bool DbInterfaceNull::parse_columns(const std::string& spec, uint32_t seed, int null_pct)
+{
+	columns.clear();
+
+	NullRandom rnd(seed);
+	NullRandom rnd_nulls(seed + 1);
+
+	for (auto item : string_split(spec, ',')) {
+		NullColumnSpec c;
+		auto parts = string_split(trim_copy(item), ':');
+		std::string type = to_lower(parts.at(0));
+		std::string width = parts.size() > 1 ? parts.at(1) : "";
+
+		if (type == "int") c.type = NullColumnType::Int;
+		else if (type == "dec") c.type = NullColumnType::Dec;
+		else if (type == "char") c.type = NullColumnType::Char;
+		else if (type == "varchar") c.type = NullColumnType::VarChar;
+		else if (type == "date") c.type = NullColumnType::Date;
+		else
+			return false;
+
+		if (!width.empty()) {
+			auto ws = string_split(width, '.');
+			c.width = atoi(ws.at(0).c_str());
+			c.scale = ws.size() > 1 ? atoi(ws.at(1).c_str()) : 0;
+		}
+		else {
+			c.width = (c.type == NullColumnType::Dec) ? 11 : 9;
+			c.scale = (c.type == NullColumnType::Dec) ? 2 : 0;
+		}
+
+		if (c.width < 1 || c.scale < 0 || c.scale >= c.width || parts.size() > 2)
+			return false;
+
+		int int_digits = std::min(c.width - c.scale, NULL_MAX_INT_DIGITS);
+		int dec_digits = std::min(c.scale, NULL_MAX_INT_DIGITS);
+		uint64_t int_mod = 1, dec_mod = 1;
+		for (int i = 0; i < int_digits; i++) int_mod *= 10;
+		for (int i = 0; i < dec_digits; i++) dec_mod *= 10;
+
+		c.values.resize(NULL_VALUE_POOL_SIZE);
+		c.nulls.resize(NULL_VALUE_POOL_SIZE);
+		for (int i = 0; i < NULL_VALUE_POOL_SIZE; i++) {
+
+			// seed = 0: sequential values (1, 2, 3...), otherwise pseudo-random values
+			uint64_t n = seed ? rnd.next() : (uint64_t)i + 1;
+			std::string v;
+
+			switch (c.type) {
+				case NullColumnType::Int:
+					v = std::to_string(n % int_mod);
+					break;
+
+				case NullColumnType::Dec:
+				{
+					std::string d = std::to_string((seed ? rnd.next() : n * 7) % dec_mod);
+					v = std::to_string(n % int_mod) + "." + std::string(dec_digits - d.size(), '0') + d;
+					break;
+				}
+
+				case NullColumnType::Char:
+				case NullColumnType::VarChar:
+					if (seed) {
+						int len = (c.type == NullColumnType::VarChar) ? (int)(1 + n % c.width) : c.width;
+						for (int j = 0; j < len; j++)
+							v += (char)('A' + rnd.next() % 26);
+					}
+					else {
+						v = "ROW" + std::to_string(n);
+						if (v.size() > (size_t)c.width)
+							v = v.substr(0, c.width);
+
+						if (c.type == NullColumnType::Char)
+							v += std::string(c.width - v.size(), ' ');
+					}
+					break;
+
+				case NullColumnType::Date:
+					v = format_date(NULL_BASE_DATE_DAYS + (int64_t)(n % NULL_DATE_RANGE_DAYS));
+					break;
+			}
+
+			c.values[i] = v;
+			c.nulls[i] = null_pct > 0 && (int)(rnd_nulls.next() % 100) < null_pct;
+		}
+
+		columns.push_back(c);
+	}
+
+	return !columns.empty();
+}
+
+int DbInterfaceNull::reset()
+{
+	int rc = terminate_connection();
+	if (rc == DBERR_NO_ERROR)
+		return DBERR_NO_ERROR;
+	else
+		return DBERR_CONN_RESET_FAILED;
+}
+
+int DbInterfaceNull::terminate_connection()
+{
+	current_statement_data.reset();
+	_prepared_stmts.clear();
+	_declared_cursors.clear();
+	_query_shapes.clear();
+	is_connected = false;
+
+	return DBERR_NO_ERROR;
+}
+
+const char* DbInterfaceNull::get_error_message()
+{
+	return (char*)last_error.c_str();
+}
+
+int DbInterfaceNull::get_error_code()
+{
+	return last_rc;
+}
+
+std::string DbInterfaceNull::get_state()
+{
+	return last_state;
+}
+
+int DbInterfaceNull::prepare(const std::string& _stmt_name, const std::string& query)
+{
+	std::string stmt_name = to_lower(_stmt_name);
+
+	lib_logger->trace(FMT_FILE_FUNC "Null::prepare ({}) - SQL: {}", __FILE__, __func__, stmt_name, query);
+
+	if (trim_copy(query).empty()) {
+		nullSetError(DBERR_EMPTY_QUERY, "42000", "Empty query");
+		return DBERR_PREPARE_FAILED;
+	}
+
+	std::shared_ptr<NullStatementData> res = std::make_shared<NullStatementData>();
+	res->shape = get_query_shape(query);
+	_prepared_stmts[stmt_name] = res;
+
+	nullClearError();
+	return DBERR_NO_ERROR;
+}
+
+int DbInterfaceNull::exec_prepared(const std::string& _stmt_name, std::vector<CobolVarType> paramTypes, std::vector<std_binary_data>& paramValues, std::vector<unsigned long> paramLengths, const std::vector<uint32_t>& paramFlags)
+{
+	std::string stmt_name = to_lower(_stmt_name);
+
+	auto it = _prepared_stmts.find(stmt_name);
+	if (it == _prepared_stmts.end()) {
+		nullSetError(DBERR_SQL_ERROR, "26000", "Invalid prepared statement name: " + stmt_name);
+		return DBERR_SQL_ERROR;
+	}
+
+	std::shared_ptr<NullStatementData> res = it->second;
+	res->nrows = res->shape.has_resultset ? opt_select_rows : (res->shape.is_dml ? opt_affected_rows : 0);
+	res->cur_row = -1;
+
+	current_statement_data = res;
+
+	nullClearError();
+	return DBERR_NO_ERROR;
+}
+
+DbPropertySetResult DbInterfaceNull::set_property(DbProperty p, std::variant<bool, int, std::string> v)
+{
+	return DbPropertySetResult::Unsupported;
+}
+
+int DbInterfaceNull::exec(std::string query)
+{
+	return _null_exec(query);
+}
+
+int DbInterfaceNull::exec_params(const std::string& query, const std::vector<CobolVarType>& paramTypes, const std::vector<std_binary_data>& paramValues, const std::vector<unsigned long>& paramLengths, const std::vector<uint32_t>& paramFlags)
+{
+	// Parameters are not used
+	return _null_exec(query);
+}
+
+int DbInterfaceNull::_null_exec(const std::string& query)
+{
+	lib_logger->trace(FMT_FILE_FUNC "SQL: #{}#", __FILE__, __func__, query);
+
+	if (query.empty()) {
+		nullSetError(DBERR_EMPTY_QUERY, "42000", "Empty query");
+		return DBERR_EMPTY_QUERY;
+	}
+
+	// The resultset is reused, unless it belongs to a prepared statement
+	if (!current_statement_data || current_statement_data.use_count() > 1)
+		current_statement_data = std::make_shared<NullStatementData>();
+
+	const NullQueryShape& shape = get_query_shape(query);
+	current_statement_data->shape = shape;
+	current_statement_data->nrows = shape.has_resultset ? opt_select_rows : (shape.is_dml ? opt_affected_rows : 0);
+	current_statement_data->cur_row = -1;
+
+	nullClearError();
+	return DBERR_NO_ERROR;
+}
+
+const NullQueryShape& DbInterfaceNull::get_query_shape(const std::string& query)
+{
+	auto it = _query_shapes.find(query);
+	if (it != _query_shapes.end())
+		return it->second;
+
+	NullQueryShape shape;
+
+	size_t p = 0;
+	while (p < query.size() && (isspace(query.at(p)) || query.at(p) == '('))
+		p++;
+
+	size_t e = p;
+	while (e < query.size() && isalpha(query.at(e)))
+		e++;
+
+	std::string verb = to_upper(query.substr(p, e - p));
+	if (verb == "SELECT" || verb == "WITH" || verb == "VALUES" || verb == "SHOW") {
+		shape.has_resultset = true;
+
+		// "SELECT *" and statements with no select list return all the columns in the specification
+		shape.nfields = count_select_list_items(query);
+		if (shape.nfields < 1)
+			shape.nfields = columns.size();
+	}
+	else {
+		shape.is_dml = (verb == "INSERT" || verb == "UPDATE" || verb == "DELETE" || verb == "MERGE");
+	}
+
+	if (_query_shapes.size() >= NULL_MAX_QUERY_SHAPES)
+		_query_shapes.clear();
+
+	return _query_shapes[query] = shape;
+}
+
+int DbInterfaceNull::cursor_close(const std::shared_ptr<ICursor>& crsr)
+{
+	// Nothing to do
+	return DBERR_NO_ERROR;
+}
+
+int DbInterfaceNull::cursor_declare(const std::shared_ptr<ICursor>& cursor)
+{
+	if (!cursor)
+		return DBERR_DECLARE_CURSOR_FAILED;
+
+	std::map<std::string, std::shared_ptr<ICursor>>::iterator it = _declared_cursors.find(cursor->getName());
+	if (it == _declared_cursors.end()) {
+		_declared_cursors[cursor->getName()] = cursor;
+	}
+
+	return DBERR_NO_ERROR;
+}
+
+int DbInterfaceNull::cursor_open(const std::shared_ptr<ICursor>& cursor)
+{
+	if (!cursor)
+		return DBERR_OPEN_CURSOR_FAILED;
+
+	std::string squery = cursor->getQuery();
+	void* src_addr = nullptr;
+	int src_len = 0;
+
+	if (squery.size() == 0) {
+		cursor->getQuerySource(&src_addr, &src_len);
+		squery = __get_trimmed_hostref_or_literal(src_addr, src_len);
+	}
+
+	if (squery.empty()) {
+		nullSetError(DBERR_EMPTY_QUERY, "42000", "Empty query");
+		return DBERR_OPEN_CURSOR_FAILED;
+	}
+
+	std::shared_ptr<NullStatementData> dp = std::dynamic_pointer_cast<NullStatementData>(cursor->getPrivateData());
+	if (!dp) {
+		dp = std::make_shared<NullStatementData>();
+		cursor->setPrivateData(dp);
+	}
+
+	if (starts_with(squery, "@")) {
+		auto it = _prepared_stmts.find(to_lower(squery.substr(1)));
+		if (it == _prepared_stmts.end()) {
+			nullSetError(DBERR_SQL_ERROR, "26000", "Invalid prepared statement name: " + squery.substr(1));
+			return DBERR_OPEN_CURSOR_FAILED;
+		}
+		dp->shape = it->second->shape;
+	}
+	else {
+		dp->shape = get_query_shape(squery);
+	}
+
+	dp->nrows = dp->shape.has_resultset ? opt_rows : 0;
+	dp->cur_row = -1;
+
+	nullClearError();
+	return DBERR_NO_ERROR;
+}
+
+int DbInterfaceNull::cursor_fetch_one(const std::shared_ptr<ICursor>& cursor, int)
+{
+	if (!cursor) {
+		lib_logger->error("Invalid cursor reference");
+		return DBERR_FETCH_ROW_FAILED;
+	}
+
+	std::shared_ptr<NullStatementData> dp = std::dynamic_pointer_cast<NullStatementData>(cursor->getPrivateData());
+	if (!dp)
+		return DBERR_FETCH_ROW_FAILED;
+
+	if (dp->cur_row + 1 >= dp->nrows) {
+		dp->cur_row = dp->nrows;
+		return DBERR_NO_DATA;
+	}
+
+	dp->cur_row++;
+	return DBERR_NO_ERROR;
+}
+
+std::shared_ptr<NullStatementData> DbInterfaceNull::get_resultset(ResultSetContextType resultset_context_type, const IResultSetContextData& context)
+{
+	switch (resultset_context_type) {
+		case ResultSetContextType::CurrentResultSet:
+			return current_statement_data;
+
+		case ResultSetContextType::PreparedStatement:
+		{
+			PreparedStatementContextData& p = (PreparedStatementContextData&)context;
+			auto it = _prepared_stmts.find(to_lower(p.prepared_statement_name));
+			return (it != _prepared_stmts.end()) ? it->second : nullptr;
+		}
+
+		case ResultSetContextType::Cursor:
+		{
+			CursorContextData& p = (CursorContextData&)context;
+			return p.cursor ? std::dynamic_pointer_cast<NullStatementData>(p.cursor->getPrivateData()) : nullptr;
+		}
+	}
+
+	return nullptr;
+}
+
+bool DbInterfaceNull::get_resultset_value(ResultSetContextType resultset_context_type, const IResultSetContextData& context, int row, int col, char* bfr, uint64_t bfrlen, uint64_t* value_len, bool* is_db_null)
+{
+	std::shared_ptr<NullStatementData> wk_rs = get_resultset(resultset_context_type, context);
+	if (!wk_rs || wk_rs->cur_row < 0 || wk_rs->cur_row >= wk_rs->nrows || col < 0 || col >= wk_rs->shape.nfields) {
+		lib_logger->error("Invalid resultset");
+		return false;
+	}
+
+	// Columns cycle through the specification, rows through the pre-generated values
+	const NullColumnSpec& c = columns.at(col % columns.size());
+	int idx = wk_rs->cur_row % NULL_VALUE_POOL_SIZE;
+
+	if (c.nulls[idx]) {
+		*is_db_null = true;
+		*value_len = 0;
+		bfr[0] = 0;
+		return true;
+	}
+
+	const std::string& v = c.values[idx];
+	if (v.size() > bfrlen) {
+		lib_logger->error("Null: ERROR: data truncated: needed {} bytes, {} allocated", v.size(), bfrlen);
+		return false;
+	}
+
+	memcpy(bfr, v.data(), v.size());
+	*value_len = v.size();
+	return true;
+}
+
+bool DbInterfaceNull::move_to_first_record(const std::string& _stmt_name)
+{
+	std::shared_ptr<NullStatementData> dp;
+	std::string stmt_name = to_lower(_stmt_name);
+
+	if (stmt_name.empty()) {
+		dp = current_statement_data;
+	}
+	else {
+		auto it = _prepared_stmts.find(stmt_name);
+		if (it != _prepared_stmts.end())
+			dp = it->second;
+	}
+
+	if (!dp) {
+		nullSetError(DBERR_MOVE_TO_FIRST_FAILED, "HY000", "Invalid statement reference");
+		return false;
+	}
+
+	if (!dp->shape.has_resultset || dp->nrows <= 0) {
+		nullSetError(DBERR_NO_DATA, "02000", "No data");
+		return false;
+	}
+
+	dp->cur_row = 0;
+	return true;
+}
+
+uint64_t DbInterfaceNull::get_native_features()
+{
+	return (uint64_t)DbNativeFeature::ResultSetRowCount;
+}
+
+int DbInterfaceNull::get_num_rows(const std::shared_ptr<ICursor>& crsr)
+{
+	std::shared_ptr<NullStatementData> dp = crsr ? std::dynamic_pointer_cast<NullStatementData>(crsr->getPrivateData()) : current_statement_data;
+	return dp ? dp->nrows : -1;
+}
+
+int DbInterfaceNull::get_num_fields(const std::shared_ptr<ICursor>& crsr)
+{
+	std::shared_ptr<NullStatementData> dp = crsr ? std::dynamic_pointer_cast<NullStatementData>(crsr->getPrivateData()) : current_statement_data;
+	return dp ? dp->shape.nfields : -1;
+}
+
+void DbInterfaceNull::nullClearError()
+{
+	last_error = "";
+	last_rc = DBERR_NO_ERROR;
+	last_state = "00000";
+}
+
+void DbInterfaceNull::nullSetError(int err_code, std::string sqlstate, std::string err_msg)
+{
+	last_error = err_msg;
+	last_rc = err_code;
+	last_state = sqlstate;
+}
+
+static std::string __get_trimmed_hostref_or_literal(void* data, int l)
+{
+	if (!data)
+		return std::string();
+
+	if (!l)
+		return std::string((char*)data);
+
+	if (l > 0) {
+		std::string s = std::string((char*)data, l);
+		return trim_copy(s);
+	}
+
+	// variable-length fields (negative length)
+	void* actual_data = (char*)data + VARLEN_LENGTH_SZ;
+	std::string t = std::string((char*)actual_data, (-l) - VARLEN_LENGTH_SZ);
+	return trim_copy(t);
+}
+
+static bool is_word_char(char c)
+{
+	return isalnum(c) || c == '_';
+}
+
+// Number of items in the (first, outermost) select list, 0 if there is none or if it is "*"
+static int count_select_list_items(const std::string& query)
+{
+	std::string q = to_upper(query);
+	int depth = 0;
+	int nitems = 0;
+	size_t list_start = std::string::npos;
+	size_t list_end = q.size();
+
+	for (size_t i = 0; i < q.size(); i++) {
+		char c = q.at(i);
+
+		if (c == '\'' || c == '"') {
+			size_t e = q.find(c, i + 1);
+			if (e == std::string::npos)
+				break;
+			i = e;
+			continue;
+		}
+
+		if (c == '(') {
+			depth++;
+			continue;
+		}
+
+		if (c == ')') {
+			depth--;
+			continue;
+		}
+
+		if (depth != 0)
+			continue;
+
+		if (isalpha(c) && (i == 0 || !is_word_char(q.at(i - 1)))) {
+			size_t e = i;
+			while (e < q.size() && is_word_char(q.at(e)))
+				e++;
+
+			std::string w = q.substr(i, e - i);
+			if (list_start == std::string::npos && w == "SELECT") {
+				list_start = e;
+				nitems = 1;
+			}
+			else if (list_start != std::string::npos && (w == "FROM" || w == "INTO")) {
+				list_end = i;
+				break;
+			}
+
+			i = e - 1;
+			continue;
+		}
+
+		if (list_start != std::string::npos && c == ',')
+			nitems++;
+	}
+
+	if (list_start == std::string::npos || trim_copy(q.substr(list_start, list_end - list_start)) == "*")
+		return 0;
+
+	return nitems;
+}
+
+static std::string format_date(int64_t days)
+{
+	// Civil date from days since 1970-01-01 (proleptic Gregorian calendar)
+	days += 719468;
+	int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+	int64_t doe = days - era * 146097;
+	int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+	int64_t y = yoe + era * 400;
+	int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+	int64_t mp = (5 * doy + 2) / 153;
+	int64_t d = doy - (153 * mp + 2) / 5 + 1;
+	int64_t m = mp < 10 ? mp + 3 : mp - 9;
+	if (m <= 2)
+		y++;
+
+	char bfr[36];	// room for three ints of any value, so that the output cannot be truncated
+	snprintf(bfr, sizeof(bfr), "%04d-%02d-%02d", (int)y, (int)m, (int)d);
+	return bfr;
+}
@@ -0,0 +1,144 @@
+#pragma once
+
+/*
+This file is part of Gix-IDE, an IDE and platform for GnuCOBOL
+Copyright (C) 2021 Marco Ridoni
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+USA.
+*/
+
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <memory>
+
+#include "ICursor.h"
+#include "IDbInterface.h"
+#include "IDbManagerInterface.h"
+#include "IDataSourceInfo.h"
+#include "ISchemaManager.h"
+
+#define NULL_DEFAULT_ROWS			10
+#define NULL_DEFAULT_SELECT_ROWS	1
+#define NULL_DEFAULT_AFFECTED_ROWS	1
+#define NULL_DEFAULT_COLUMNS		"int:9"
+
+// Number of distinct values generated for each column (rows cycle through them)
+#define NULL_VALUE_POOL_SIZE		1024
+
+enum class NullColumnType {
+	Int = 1,
+	Dec = 2,
+	Char = 3,
+	VarChar = 4,
+	Date = 5
+};
+
+struct NullColumnSpec {
+	NullColumnType type = NullColumnType::Int;
+	int width = 9;
+	int scale = 0;
+
+	// Pre-generated values: the driver only copies them when a value is requested
+	std::vector<std::string> values;
+	std::vector<bool> nulls;
+};
+
+// What the driver needs to know about a statement, derived from its text once and cached
+struct NullQueryShape {
+	bool has_resultset = false;
+	bool is_dml = false;
+	int nfields = 0;
+};
+
+struct NullStatementData : public IPrivateStatementData {
+
+	NullQueryShape shape;
+
+	// Rows in the (synthetic) resultset, or rows affected for DML
+	int nrows = 0;
+
+	// -1 = before the first row
+	int cur_row = -1;
+};
+
+/*
+	Loopback driver for benchmarks: no server is involved, queries return synthetic resultsets generated
+	from the data source options (rows, column types and widths, seed), DML statements report a configurable
+	number of affected rows. It can be used to measure the overhead of the runtime library itself.
+*/
+class DbInterfaceNull : public IDbInterface, public IDbManagerInterface
+{
+public:
+	DbInterfaceNull();
+	~DbInterfaceNull();
+
+	virtual int init(const std::shared_ptr<spdlog::logger>& _logger) override;
+	virtual int connect(std::shared_ptr<IDataSourceInfo>, std::shared_ptr<IConnectionOptions>) override;
+	virtual int reset() override;
+	virtual int terminate_connection() override;
+	virtual int exec(std::string) override;
+	virtual int exec_params(const std::string& query, const std::vector<CobolVarType>& paramTypes, const std::vector<std_binary_data>& paramValues, const std::vector<unsigned long>& paramLengths, const std::vector<uint32_t>& paramFlags) override;
+	virtual int cursor_declare(const std::shared_ptr<ICursor>& crsr) override;
+	virtual int cursor_open(const std::shared_ptr<ICursor>& crsr) override;
+	virtual int cursor_close(const std::shared_ptr<ICursor>& crsr) override;
+	virtual int cursor_fetch_one(const std::shared_ptr<ICursor>& crsr, int) override;
+	virtual bool get_resultset_value(ResultSetContextType resultset_context_type, const IResultSetContextData& context, int row, int col, char* bfr, uint64_t bfrlen, uint64_t* value_len, bool *is_db_null) override;
+	virtual bool move_to_first_record(const std::string& stmt_name = "") override;
+	virtual uint64_t get_native_features() override;
+	virtual int get_num_rows(const std::shared_ptr<ICursor>& crsr) override;
+	virtual int get_num_fields(const std::shared_ptr<ICursor>& crsr) override;
+	virtual const char* get_error_message() override;
+	virtual int get_error_code() override;
+	virtual std::string get_state() override;
+	virtual int prepare(const std::string& stmt_name, const std::string& query) override;
+	virtual int exec_prepared(const std::string& stmt_name, std::vector<CobolVarType> paramTypes, std::vector<std_binary_data>& paramValues, std::vector<unsigned long> paramLengths, const std::vector<uint32_t>& paramFlags) override;
+	virtual DbPropertySetResult set_property(DbProperty p, std::variant<bool, int, std::string> v) override;
+
+	virtual bool getSchemas(std::vector<SchemaInfo*>& res) override;
+	virtual bool getTables(std::string table, std::vector<TableInfo*>& res) override;
+	virtual bool getColumns(std::string schema, std::string table, std::vector<ColumnInfo*>& columns) override;
+	virtual bool getIndexes(std::string schema, std::string tabl, std::vector<IndexInfo*>& idxs) override;
+
+private:
+
+	bool is_connected = false;
+
+	int opt_rows = NULL_DEFAULT_ROWS;
+	int opt_select_rows = NULL_DEFAULT_SELECT_ROWS;
+	int opt_affected_rows = NULL_DEFAULT_AFFECTED_ROWS;
+	std::vector<NullColumnSpec> columns;
+
+	std::shared_ptr<NullStatementData> current_statement_data;
+
+	int last_rc = 0;
+	std::string last_error;
+	std::string last_state;
+
+	std::map<std::string, std::shared_ptr<ICursor>> _declared_cursors;
+	std::map<std::string, std::shared_ptr<NullStatementData>> _prepared_stmts;
+	std::unordered_map<std::string, NullQueryShape> _query_shapes;
+
+	void nullClearError();
+	void nullSetError(int err_code, std::string sqlstate, std::string err_msg);
+
+	int _null_exec(const std::string& query);
+
+	const NullQueryShape& get_query_shape(const std::string& query);
+	bool parse_columns(const std::string& spec, uint32_t seed, int null_pct);
+	std::shared_ptr<NullStatementData> get_resultset(ResultSetContextType resultset_context_type, const IResultSetContextData& context);
+};
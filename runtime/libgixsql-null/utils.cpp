@@ -0,0 +1,92 @@
+/*
+* This file is part of Gix-IDE, an IDE and platform for GnuCOBOL
+* Copyright (C) 2021 Marco Ridoni
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public License
+* as published by the Free Software Foundation; either version 3,
+* or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library; see the file COPYING.LIB.  If
+* not, write to the Free Software Foundation, 51 Franklin Street, Fifth Floor
+* Boston, MA 02110-1301 USA
+*/
+
+#include <algorithm>
+#include <cctype>
+
+#include "utils.h"
+
+// trim from start (in place)
+void ltrim(std::string& s)
+{
+	s.erase(s.begin(), std::find_if(s.begin(), s.end(), [](int ch) {
+		return !std::isspace(ch);
+	}));
+}
+
+// trim from end (in place)
+void rtrim(std::string& s)
+{
+	s.erase(std::find_if(s.rbegin(), s.rend(), [](int ch) {
+		return !std::isspace(ch);
+	}).base(), s.end());
+}
+
+// trim from both ends (in place)
+void trim(std::string& s)
+{
+	ltrim(s);
+	rtrim(s);
+}
+
+// trim from both ends (copying)
+std::string trim_copy(std::string s)
+{
+	trim(s);
+	return s;
+}
+
+bool starts_with(std::string s, std::string s1)
+{
+	if (s == s1)
+		return true;
+
+	if (s1.size() > s.size())
+		return false;
+
+	return s.substr(0, s1.size()) == s1;
+}
+
+std::string to_lower(const std::string s)
+{
+	std::string s1 = s;
+	std::transform(s1.begin(), s1.end(), s1.begin(), ::tolower);
+	return s1;
+}
+
+std::string to_upper(const std::string s)
+{
+	std::string s1 = s;
+	std::transform(s1.begin(), s1.end(), s1.begin(), ::toupper);
+	return s1;
+}
+
+std::vector<std::string> string_split(const std::string& s, char sep)
+{
+	std::vector<std::string> res;
+	size_t start = 0, p;
+
+	while ((p = s.find(sep, start)) != std::string::npos) {
+		res.push_back(s.substr(start, p - start));
+		start = p + 1;
+	}
+	res.push_back(s.substr(start));
+	return res;
+}
@@ -0,0 +1,37 @@
+/*
+* This file is part of Gix-IDE, an IDE and platform for GnuCOBOL
+* Copyright (C) 2021 Marco Ridoni
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public License
+* as published by the Free Software Foundation; either version 3,
+* or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library; see the file COPYING.LIB.  If
+* not, write to the Free Software Foundation, 51 Franklin Street, Fifth Floor
+* Boston, MA 02110-1301 USA
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+// trim from start (in place)
+void ltrim(std::string& s);
+// trim from end (in place)
+void rtrim(std::string& s);
+// trim from both ends (in place)
+void trim(std::string& s);
+// trim from both ends (copying)
+std::string trim_copy(std::string s);
+bool starts_with(std::string s, std::string s1);
+std::string to_lower(const std::string s);
+std::string to_upper(const std::string s);
+std::vector<std::string> string_split(const std::string& s, char sep);
@@ -23,17 +23,18 @@
 #include "IConnection.h"
 #include "Logger.h"
 #include "utils.h"
+#include "param_fixup.h"
 #include "varlen_defs.h"
 #include "cobol_var_flags.h"
 
 #include <cstring>
+#include <algorithm>
 
 
 SQLHANDLE DbInterfaceODBC::odbc_global_env_context = nullptr;
 int DbInterfaceODBC::odbc_global_env_context_usage_count = 0;
 
 static std::string __get_trimmed_hostref_or_literal(void* data, int l);
-static std::string odbc_fixup_parameters(const std::string& sql);
 
 DbInterfaceODBC::DbInterfaceODBC()
 {
@@ -145,6 +146,23 @@ int DbInterfaceODBC::connect(std::shared_ptr<IDataSourceInfo> _conn_info, std::s
 		lib_logger->debug(FMT_FILE_FUNC "DBMS name is [{}]", __FILE__, __func__, dbms_name);
 	}
 
+	auto opts = _conn_info->getOptions();
+	if (opts.find("fetch_array_size") != opts.end()) {
+		int n = atoi(opts["fetch_array_size"].c_str());
+		if (n > 0)
+			this->fetch_array_size = n;
+	}
+
+	if (opts.find("param_array_size") != opts.end()) {
+		int n = atoi(opts["param_array_size"].c_str());
+		if (n > 0)
+			this->param_array_size = n;
+	}
+
+	lib_logger->trace(FMT_FILE_FUNC "ODBC: fetch array size is {}, parameter array size is {}", __FILE__, __func__, this->fetch_array_size, this->param_array_size);
+
+	_prepared_stmt_cache.setMaxMemory(opts);
+
 	lib_logger->debug(FMT_FILE_FUNC  "ODBC: Connection registration successful", __FILE__, __func__);
 
 	odbcClearError();
@@ -175,7 +193,13 @@ int DbInterfaceODBC::terminate_connection()
 		current_statement_data.reset();
 	}
 
+	// any queued parameter set is sent before disconnecting
+	if (flush_param_batch() != DBERR_NO_ERROR) {
+		lib_logger->error("ODBC: queued parameter sets could not be executed ({}): {}", last_rc, last_error);
+	}
+
 	// same as above
+	_prepared_stmt_cache.clear();
 	_prepared_stmts.clear();
 	_declared_cursors.clear();
 
@@ -209,16 +233,21 @@ std::string DbInterfaceODBC::get_state()
 int DbInterfaceODBC::prepare(const std::string& _stmt_name, const std::string& query)
 {
 	std::string prepared_sql;
-	std::shared_ptr<ODBCStatementData> res = std::make_shared<ODBCStatementData>(conn_handle);
-
 	std::string stmt_name = to_lower(_stmt_name);
 
 	lib_logger->trace(FMT_FILE_FUNC "ODPI::prepare ({}) - SQL: {}", __FILE__, __func__, stmt_name, query);
 
-	if (this->_prepared_stmts.find(stmt_name) != _prepared_stmts.end()) {
-		return DBERR_PREPARE_FAILED;
+	// The same text has already been prepared and the statement is not in use by another name
+	// (or by the parameter sets still queued for it): reuse it
+	std::shared_ptr<ODBCStatementData> res = _prepared_stmt_cache.find(query, stmt_name, _prepared_stmts);
+	if (res && res != pending_batch) {
+		lib_logger->trace(FMT_FILE_FUNC "ODBC::prepare ({}) - reusing cached statement", __FILE__, __func__, stmt_name);
+		_prepared_stmts[stmt_name] = res;
+		return DBERR_NO_ERROR;
 	}
 
+	res = std::make_shared<ODBCStatementData>(conn_handle);
+
 	if (connection_opts->fixup_parameters) {
 		prepared_sql = odbc_fixup_parameters(query);
 		lib_logger->trace(FMT_FILE_FUNC "ODPI::fixup parameters is on", __FILE__, __func__);
@@ -240,15 +269,45 @@ int DbInterfaceODBC::prepare(const std::string& _stmt_name, const std::string& q
 
 	lib_logger->trace(FMT_FILE_FUNC "ODPI::prepare ({} - res: ({}) {}", __FILE__, __func__, stmt_name, last_rc, last_error);
 
+	// If the name was already in use, the statement it was bound to is released, unless still cached
 	_prepared_stmts[stmt_name] = res;
+	_prepared_stmt_cache.add(query, res);
 
 	return DBERR_NO_ERROR;
 }
 
+// Static statements are added to the same cache used when they are executed (see _odbc_exec_params)
+int DbInterfaceODBC::prepare_static(const std::vector<std::shared_ptr<StaticStatementInfo>>& stmts)
+{
+	int rc = DBERR_NO_ERROR;
+
+	for (const auto& s : stmts) {
+		// Cursors are not cached
+		if (s->is_cursor || _prepared_stmt_cache.find(s->query))
+			continue;
+
+		std::shared_ptr<ODBCStatementData> wk_rs = std::make_shared<ODBCStatementData>(conn_handle);
+		if (!wk_rs->statement)
+			return DBERR_PREPARE_FAILED;
+
+		int odbc_rc = SQLPrepare(wk_rs->statement, (SQLCHAR*)s->query.c_str(), SQL_NTS);
+		if (odbcRetrieveError(odbc_rc, ErrorSource::Statement, wk_rs->statement) != SQL_SUCCESS) {
+			lib_logger->warn("ODBC: cannot prepare static statement: {} ({}) - {}", last_rc, last_error, s->query);
+			rc = DBERR_PREPARE_FAILED;
+			continue;
+		}
+
+		_prepared_stmt_cache.add(s->query, wk_rs);
+	}
+
+	lib_logger->trace(FMT_FILE_FUNC "ODBC: {} statement(s) cached", __FILE__, __func__, _prepared_stmt_cache.size());
+
+	return rc;
+}
+
 int DbInterfaceODBC::exec_prepared(const std::string& _stmt_name, std::vector<CobolVarType> paramTypes, std::vector<std_binary_data>& paramValues, std::vector<unsigned long> paramLengths, const std::vector<uint32_t>& paramFlags)
 {
 	int rc = 0;
-	SQLLEN null_data = SQL_NULL_DATA;
 
 	lib_logger->trace(FMT_FILE_FUNC "statement name: {}", __FILE__, __func__, _stmt_name);
 
@@ -259,6 +318,10 @@ int DbInterfaceODBC::exec_prepared(const std::string& _stmt_name, std::vector<Co
 		return DBERR_INTERNAL_ERR;
 	}
 
+	rc = flush_param_batch();
+	if (rc != DBERR_NO_ERROR)
+		return rc;
+
 	std::string stmt_name = to_lower(_stmt_name);
 
 	if (_prepared_stmts.find(stmt_name) == _prepared_stmts.end()) {
@@ -266,60 +329,16 @@ int DbInterfaceODBC::exec_prepared(const std::string& _stmt_name, std::vector<Co
 		return DBERR_SQL_ERROR;
 	}
 
-	int nParams = (int)paramValues.size();
-
 	std::shared_ptr<ODBCStatementData> wk_rs = _prepared_stmts[stmt_name];
-	wk_rs->resizeParams(nParams);
+	wk_rs->unbindColumns();
 
-	std::vector<SQLLEN> lengths(paramLengths.size());
-
-	for (int i = 0; i < nParams; i++) {
-		int sql_type = cobol2odbctype(paramTypes[i], paramFlags[i]);
-		int c_type = CBL_FIELD_IS_BINARY(paramFlags[i]) ? SQL_C_BINARY : SQL_C_CHAR;
-
-		lengths[i] = paramLengths[i];
-		
-		if (paramLengths.at(i) != DB_NULL) {
-			rc = SQLBindParameter(
-				wk_rs->statement,
-				i + 1,
-				SQL_PARAM_INPUT,
-				c_type,
-				sql_type,
-				10,
-				0,
-				(SQLPOINTER)paramValues.at(i).data(),
-				(SQLLEN)paramLengths.at(i),
-				&lengths[i]);
-		}
-		else
-		{
-			rc = SQLBindParameter(
-				wk_rs->statement,
-				i + 1,
-				SQL_PARAM_INPUT,
-				c_type,
-				sql_type,
-				10,
-				0,
-				nullptr,
-				(SQLLEN)paramLengths.at(i),
-				&null_data);
-		}
-
-		if (odbcRetrieveError(rc, ErrorSource::Statement, wk_rs->statement) != SQL_SUCCESS) {
-			last_rc = rc;
-			lib_logger->error("ODBC: Error while binding parameter {} in prepared statement ({}): {}", i + 1, last_rc, stmt_name);
-			return DBERR_SQL_ERROR;
-		}
+	rc = bind_parameters(wk_rs, paramTypes, paramValues, paramLengths, paramFlags, 0);
+	if (rc != DBERR_NO_ERROR) {
+		lib_logger->error("ODBC: Error while binding parameters in prepared statement ({}): {}", last_rc, stmt_name);
+		return rc;
 	}
 
-	rc = SQLExecute(wk_rs->statement);
-	if (odbcRetrieveError(rc, ErrorSource::Statement, wk_rs->statement) != SQL_SUCCESS) {
-		return DBERR_SQL_ERROR;
-	}
-
-	return DBERR_NO_ERROR;
+	return execute_parameters(wk_rs, 1);
 }
 
 DbPropertySetResult DbInterfaceODBC::set_property(DbProperty p, std::variant<bool, int, std::string> v)
@@ -343,6 +362,10 @@ int DbInterfaceODBC::_odbc_exec(std::shared_ptr<ICursor> crsr, const std::string
 
 	std::shared_ptr<ODBCStatementData> wk_rs;
 
+	rc = flush_param_batch();
+	if (rc != DBERR_NO_ERROR)
+		return rc;
+
 	if (!prep_stmt_data) {
 		wk_rs = (crsr != nullptr) ? std::static_pointer_cast<ODBCStatementData>(crsr->getPrivateData()) : current_statement_data;
 
@@ -363,6 +386,7 @@ int DbInterfaceODBC::_odbc_exec(std::shared_ptr<ICursor> crsr, const std::string
 	}
 	else {
 		wk_rs = prep_stmt_data;	// Already prepared
+		wk_rs->unbindColumns();
 	}
 
 	rc = SQLExecute(wk_rs->statement);
@@ -407,7 +431,6 @@ int DbInterfaceODBC::_odbc_exec_params(std::shared_ptr<ICursor> crsr, const std:
 {
 	std::string q = query;
 	int rc = 0;
-	SQLLEN null_data = SQL_NULL_DATA;
 
 	lib_logger->trace(FMT_FILE_FUNC "SQL: #{}#", __FILE__, __func__, q);
 
@@ -420,6 +443,18 @@ int DbInterfaceODBC::_odbc_exec_params(std::shared_ptr<ICursor> crsr, const std:
 		return DBERR_INTERNAL_ERR;
 	}
 
+	// Statements that are not bound to a cursor or to a prepared statement are cached by their text,
+	// so that repeated executions only need to copy the new parameter values into the bound buffers.
+	// A cached statement currently bound to a prepared statement name is not shared.
+	bool use_cache = !crsr && !prep_stmt_data;
+	bool batchable = use_cache && param_array_size > 1 && is_batchable_statement(query);
+
+	if (pending_batch && (!batchable || query != pending_batch_query)) {
+		rc = flush_param_batch();
+		if (rc != DBERR_NO_ERROR)
+			return rc;
+	}
+
 	if (!prep_stmt_data) {
 		wk_rs = (crsr != nullptr) ? std::static_pointer_cast<ODBCStatementData>(crsr->getPrivateData()) : current_statement_data;
 
@@ -427,74 +462,70 @@ int DbInterfaceODBC::_odbc_exec_params(std::shared_ptr<ICursor> crsr, const std:
 			current_statement_data.reset();
 		}
 
-		wk_rs = std::make_shared<ODBCStatementData>(conn_handle);
-		if (!wk_rs->statement) {
-			return DBERR_SQL_ERROR;
+		wk_rs = nullptr;
+		if (pending_batch) {
+			wk_rs = pending_batch;	// same statement, more parameter sets are queued
+		}
+		else if (use_cache && (wk_rs = _prepared_stmt_cache.find(query, std::string(), _prepared_stmts))) {
+			SQLFreeStmt(wk_rs->statement, SQL_CLOSE);
+			wk_rs->unbindColumns();
 		}
 
-		rc = SQLPrepare(wk_rs->statement, (SQLCHAR*)query.c_str(), SQL_NTS);
-		if (odbcRetrieveError(rc, ErrorSource::Statement, wk_rs->statement) != SQL_SUCCESS) {
-			return DBERR_SQL_ERROR;
+		if (!wk_rs) {
+			wk_rs = std::make_shared<ODBCStatementData>(conn_handle);
+			if (!wk_rs->statement) {
+				return DBERR_SQL_ERROR;
+			}
+
+			rc = SQLPrepare(wk_rs->statement, (SQLCHAR*)query.c_str(), SQL_NTS);
+			if (odbcRetrieveError(rc, ErrorSource::Statement, wk_rs->statement) != SQL_SUCCESS) {
+				return DBERR_SQL_ERROR;
+			}
+
+			if (use_cache)
+				_prepared_stmt_cache.add(query, wk_rs);
 		}
 	}
 	else {
 		wk_rs = prep_stmt_data;	// Already prepared
+		wk_rs->unbindColumns();
 	}
 
-	int nParams = paramValues.size();
-
-	wk_rs->resizeParams(nParams);
+	if (batchable) {
+		if (wk_rs->param_capacity != param_array_size) {
+			wk_rs->param_capacity = param_array_size;
+			wk_rs->params_bound = false;
+		}
 
-	std::vector<SQLLEN> lengths(paramLengths.size());
+		rc = bind_parameters(wk_rs, paramTypes, paramValues, paramLengths, paramFlags, wk_rs->params_queued);
+		if (rc != DBERR_NO_ERROR) {
+			lib_logger->error("ODBC: Error while binding parameters in statement ({}): {} - {}", last_rc, last_error, query);
+			return rc;
+		}
 
+		wk_rs->params_queued++;
+		pending_batch = wk_rs;
+		pending_batch_query = query;
 
-	for (int i = 0; i < nParams; i++) {
-		int sql_type = cobol2odbctype(paramTypes[i], paramFlags[i]);
-		int c_type = CBL_FIELD_IS_BINARY(paramFlags[i]) ? SQL_C_BINARY : SQL_C_CHAR;
+		lib_logger->trace(FMT_FILE_FUNC "ODBC: queued parameter set #{} of {}", __FILE__, __func__, wk_rs->params_queued, wk_rs->param_capacity);
 
-		lengths[i] = paramLengths[i];
+		if (wk_rs->params_queued >= wk_rs->param_capacity)
+			return flush_param_batch();
 
-		if (paramLengths.at(i) != DB_NULL) {
-			rc = SQLBindParameter(
-				wk_rs->statement,
-				i + 1,
-				SQL_PARAM_INPUT,
-				c_type,
-				sql_type,
-				10,
-				0,
-				(SQLPOINTER)paramValues.at(i).data(),
-				(SQLLEN)paramLengths.at(i),
-				&lengths[i]);
-		}
-		else
-		{
-			
-			rc = SQLBindParameter(
-				wk_rs->statement,
-				i + 1,
-				SQL_PARAM_INPUT,
-				c_type,
-				sql_type,
-				10,
-				0,
-				nullptr,
-				0,
-				&null_data);
-		}
+		odbcClearError();
+		return DBERR_NO_ERROR;
+	}
 
-		if (odbcRetrieveError(rc, ErrorSource::Statement, wk_rs->statement) != SQL_SUCCESS) {
-			//free(pvals);
-			last_rc = rc;
-			lib_logger->error("ODBC: Error while binding parameter {} in statement ({}): {} - {}", i + 1, last_rc, last_error, query);
-			return DBERR_SQL_ERROR;
-		}
+	rc = bind_parameters(wk_rs, paramTypes, paramValues, paramLengths, paramFlags, 0);
+	if (rc != DBERR_NO_ERROR) {
+		lib_logger->error("ODBC: Error while binding parameters in statement ({}): {} - {}", last_rc, last_error, query);
+		return rc;
 	}
 
-	rc = SQLExecute(wk_rs->statement);
-	if (odbcRetrieveError(rc, ErrorSource::Statement, wk_rs->statement) != SQL_SUCCESS) {
+	rc = execute_parameters(wk_rs, 1);
+	if (rc != DBERR_NO_ERROR) {
 		lib_logger->error("ODBC: Error while executing statement ({}): {}", last_rc, last_error);
-		return DBERR_SQL_ERROR;
+		return rc;
 	}
 
 	if (!prep_stmt_data) {
@@ -524,6 +555,154 @@ int DbInterfaceODBC::_odbc_exec_params(std::shared_ptr<ICursor> crsr, const std:
 	}
 }
 
+int DbInterfaceODBC::bind_parameters(const std::shared_ptr<ODBCStatementData>& dp, const std::vector<CobolVarType>& paramTypes, const std::vector<std_binary_data>& paramValues, const std::vector<unsigned long>& paramLengths, const std::vector<uint32_t>& paramFlags, SQLULEN row)
+{
+	int nParams = (int)paramValues.size();
+
+	if (dp->params.size() != nParams) {
+		dp->resizeParams(nParams);
+		dp->params_bound = false;
+	}
+
+	for (int i = 0; i < nParams; i++) {
+		ODBCParamData& pd = dp->params[i];
+		bool is_null = (paramLengths.at(i) == DB_NULL);
+		SQLLEN len = is_null ? 0 : (SQLLEN)paramLengths.at(i);
+		SQLSMALLINT sql_type = cobol2odbctype(paramTypes[i], paramFlags[i]);
+		SQLSMALLINT c_type = CBL_FIELD_IS_BINARY(paramFlags[i]) ? SQL_C_BINARY : SQL_C_CHAR;
+
+		if (!dp->params_bound || pd.sql_type != sql_type || pd.c_type != c_type || pd.width < len) {
+
+			// Parameter sets that are already queued must be sent before the buffers can be reallocated
+			if (row > 0) {
+				lib_logger->trace(FMT_FILE_FUNC "ODBC: parameter {} changed type or size, flushing queued parameter sets", __FILE__, __func__, i + 1);
+				int rc = flush_param_batch();
+				if (rc != DBERR_NO_ERROR)
+					return rc;
+
+				return bind_parameters(dp, paramTypes, paramValues, paramLengths, paramFlags, 0);
+			}
+
+			pd.sql_type = sql_type;
+			pd.c_type = c_type;
+			pd.width = std::max(pd.width, std::max(len, (SQLLEN)1));
+			pd.data.resize(pd.width * dp->param_capacity);
+			pd.lengths.resize(dp->param_capacity);
+
+			// the column size (precision) for numeric parameters is limited by most DBMSs
+			SQLULEN col_size = (sql_type == SQL_NUMERIC) ? std::min(pd.width, (SQLLEN)38) : pd.width;
+
+			lib_logger->trace(FMT_FILE_FUNC "ODBC: binding parameter {} - SQL type: {}, C type: {}, width: {}", __FILE__, __func__, i + 1, sql_type, c_type, pd.width);
+
+			int rc = SQLBindParameter(
+				dp->statement,
+				i + 1,
+				SQL_PARAM_INPUT,
+				c_type,
+				sql_type,
+				col_size,
+				0,
+				(SQLPOINTER)pd.data.data(),
+				pd.width,
+				pd.lengths.data());
+
+			if (odbcRetrieveError(rc, ErrorSource::Statement, dp->statement) != SQL_SUCCESS) {
+				lib_logger->error("ODBC: Error while binding parameter {} ({}): {}", i + 1, last_rc, last_error);
+				dp->params_bound = false;
+				return DBERR_SQL_ERROR;
+			}
+		}
+
+		if (is_null) {
+			pd.lengths[row] = SQL_NULL_DATA;
+		}
+		else {
+			memcpy(pd.data.data() + (row * pd.width), paramValues.at(i).data(), len);
+			pd.lengths[row] = len;
+		}
+	}
+
+	dp->params_bound = true;
+	return DBERR_NO_ERROR;
+}
+
+int DbInterfaceODBC::execute_parameters(const std::shared_ptr<ODBCStatementData>& dp, SQLULEN nrows)
+{
+	int rc = 0;
+
+	if (dp->paramset_size != nrows) {
+		rc = SQLSetStmtAttr(dp->statement, SQL_ATTR_PARAMSET_SIZE, (SQLPOINTER)nrows, 0);
+		if (odbcRetrieveError(rc, ErrorSource::Statement, dp->statement) != SQL_SUCCESS)
+			return DBERR_SQL_ERROR;
+
+		if (nrows > 1) {
+			dp->param_status.resize(nrows);
+			SQLSetStmtAttr(dp->statement, SQL_ATTR_PARAM_STATUS_PTR, dp->param_status.data(), 0);
+			SQLSetStmtAttr(dp->statement, SQL_ATTR_PARAMS_PROCESSED_PTR, &dp->params_processed, 0);
+		}
+		else {
+			SQLSetStmtAttr(dp->statement, SQL_ATTR_PARAM_STATUS_PTR, nullptr, 0);
+			SQLSetStmtAttr(dp->statement, SQL_ATTR_PARAMS_PROCESSED_PTR, nullptr, 0);
+		}
+
+		dp->paramset_size = nrows;
+	}
+
+	rc = SQLExecute(dp->statement);
+	if (odbcRetrieveError(rc, ErrorSource::Statement, dp->statement) == SQL_SUCCESS)
+		return DBERR_NO_ERROR;
+
+	if (nrows > 1) {
+		// report which parameter sets have failed
+		std::string failed_rows;
+		for (SQLULEN i = 0; i < dp->params_processed && i < nrows; i++) {
+			if (dp->param_status[i] == SQL_PARAM_ERROR)
+				failed_rows += (failed_rows.empty() ? "" : ",") + std::to_string(i + 1);
+		}
+
+		if (!failed_rows.empty()) {
+			lib_logger->error("ODBC: parameter set(s) {} of {} failed: {}", failed_rows, nrows, last_error);
+			last_error = "Batch row(s) " + failed_rows + ": " + last_error;
+			return DBERR_SQL_ERROR;
+		}
+	}
+
+	if (rc == SQL_SUCCESS_WITH_INFO)
+		return DBERR_NO_ERROR;
+
+	return DBERR_SQL_ERROR;
+}
+
+int DbInterfaceODBC::flush_param_batch()
+{
+	if (!pending_batch)
+		return DBERR_NO_ERROR;
+
+	std::shared_ptr<ODBCStatementData> dp = pending_batch;
+	pending_batch.reset();
+
+	SQLULEN nrows = dp->params_queued;
+	dp->params_queued = 0;
+
+	if (nrows == 0)
+		return DBERR_NO_ERROR;
+
+	lib_logger->trace(FMT_FILE_FUNC "ODBC: executing {} queued parameter set(s)", __FILE__, __func__, nrows);
+
+	int rc = execute_parameters(dp, nrows);
+	if (rc != DBERR_NO_ERROR)
+		lib_logger->error("ODBC: Error while executing queued parameter sets ({}): {}", last_rc, last_error);
+
+	return rc;
+}
+
+bool DbInterfaceODBC::is_batchable_statement(const std::string& query)
+{
+	// Only INSERTs can be deferred: UPDATE and DELETE must report "no rows affected" on the statement itself
+	std::string q = trim_copy(query);
+	return q.size() > 7 && caseInsensitiveStringCompare(q.substr(0, 7), "insert ");
+}
+
 bool DbInterfaceODBC::is_cursor_from_prepared_statement(const std::shared_ptr<ICursor>& cursor)
 {
 	std::string squery = cursor->getQuery();
@@ -655,12 +834,21 @@ int DbInterfaceODBC::cursor_open(const std::shared_ptr<ICursor>& cursor)
 		rc = _odbc_exec(cursor, squery, prepared_stmt_data);
 	}
 
-	if (rc == SQL_SUCCESS) {
-		return DBERR_NO_ERROR;
-	}
-	else {
+	if (rc != SQL_SUCCESS) {
 		return DBERR_OPEN_CURSOR_FAILED;
 	}
+
+	// Positioned updates/deletes need the driver's cursor to be on the current row,
+	// so block cursors are only used for read-only cursors
+	if (fetch_array_size > 1 && !is_updatable_cursor(cursor)) {
+		std::shared_ptr<ODBCStatementData> dp = std::dynamic_pointer_cast<ODBCStatementData>(cursor->getPrivateData());
+		if (dp && !bind_columns(dp)) {
+			lib_logger->trace(FMT_FILE_FUNC "ODBC: block cursor not available for cursor {}, using single-row fetch", __FILE__, __func__, cursor->getName());
+			odbcClearError();
+		}
+	}
+
+	return DBERR_NO_ERROR;
 }
 
 int DbInterfaceODBC::cursor_fetch_one(const std::shared_ptr<ICursor>& cursor, int)
@@ -679,6 +867,35 @@ int DbInterfaceODBC::cursor_fetch_one(const std::shared_ptr<ICursor>& cursor, in
 	if (!dp || !dp->statement)
 		return DBERR_FETCH_ROW_FAILED;
 
+	return fetch_next_row(dp);
+}
+
+int DbInterfaceODBC::fetch_next_row(const std::shared_ptr<ODBCStatementData>& dp)
+{
+	if (dp->is_block_bound) {
+		// serve the next row from the current rowset, if any
+		while (dp->current_row + 1 < dp->rows_fetched) {
+			dp->current_row++;
+			SQLUSMALLINT row_status = dp->row_status[dp->current_row];
+			if (row_status != SQL_ROW_NOROW && row_status != SQL_ROW_DELETED && row_status != SQL_ROW_ERROR)
+				return DBERR_NO_ERROR;
+		}
+
+		dp->rows_fetched = 0;
+		dp->current_row = 0;
+
+		int rc = SQLFetch(dp->statement);
+		if (rc == SQL_NO_DATA || (SQL_SUCCEEDED(rc) && dp->rows_fetched == 0))
+			return DBERR_NO_DATA;
+
+		if (odbcRetrieveError(rc, ErrorSource::Statement, dp->statement) != SQL_SUCCESS) {
+			return DBERR_FETCH_ROW_FAILED;
+		}
+
+		lib_logger->trace(FMT_FILE_FUNC "ODBC: fetched a rowset of {} row(s)", __FILE__, __func__, dp->rows_fetched);
+		return DBERR_NO_ERROR;
+	}
+
 	int rc = SQLFetch(dp->statement);
 	if (rc == SQL_NO_DATA)
 		return DBERR_NO_DATA;
@@ -733,21 +950,35 @@ bool DbInterfaceODBC::get_resultset_value(ResultSetContextType resultset_context
 		return false;
 	}
 
-	//SQL_C_BINARY
-
-	SQLLEN reslen = 0;
-
-	bool is_binary = false;
-	if (!column_is_binary(wk_rs->statement, col + 1, &is_binary))
+	if (!wk_rs->columns_described && !describe_columns(wk_rs))
 		return false;
 
-	short target_type = is_binary ? SQL_C_BINARY : SQL_C_CHAR;
-
-	rc = SQLGetData(wk_rs->statement, col + 1, target_type, bfr, (SQLLEN) bfrlen, &reslen);
-	if (odbcRetrieveError(rc, ErrorSource::Statement, wk_rs->statement) != SQL_SUCCESS) {
+	if (col < 0 || col >= wk_rs->columns.size()) {
+		odbcSetError(DBERR_INVALID_COLUMN_DATA, "07009", "Invalid column index");
 		return false;
 	}
 
+	SQLLEN reslen = 0;
+	ODBCColumnData& cd = wk_rs->columns[col];
+
+	if (wk_rs->is_block_bound) {
+		reslen = cd.indicators[wk_rs->current_row];
+		if (reslen != SQL_NULL_DATA) {
+			if (reslen == SQL_NO_TOTAL || reslen >= (SQLLEN)bfrlen || (cd.c_type == SQL_C_BINARY && reslen > cd.width)) {
+				odbcSetError(DBERR_INVALID_COLUMN_DATA, "01004", "String data, right truncated");
+				return false;
+			}
+			memcpy(bfr, cd.data.data() + (wk_rs->current_row * cd.width), reslen);
+			bfr[reslen] = 0;
+		}
+	}
+	else {
+		rc = SQLGetData(wk_rs->statement, col + 1, cd.c_type, bfr, (SQLLEN)bfrlen, &reslen);
+		if (odbcRetrieveError(rc, ErrorSource::Statement, wk_rs->statement) != SQL_SUCCESS) {
+			return false;
+		}
+	}
+
 	if (reslen == SQL_NULL_DATA) {
 		*is_db_null = true;
 		*value_len = 0;
@@ -833,6 +1064,12 @@ int DbInterfaceODBC::get_num_fields(const std::shared_ptr<ICursor>& crsr)
 
 	if (crsr) {
 		std::shared_ptr<ODBCStatementData> p = std::dynamic_pointer_cast<ODBCStatementData>(crsr->getPrivateData());
+		if (!p)
+			return -1;
+
+		if (p->columns_described)
+			return (int)p->columns.size();
+
 		wk_rs = p->statement;
 	}
 	else {
@@ -1090,10 +1327,157 @@ ODBCStatementData::~ODBCStatementData()
 
 void ODBCStatementData::resizeParams(int n)
 {
+	params.clear();
+	params.resize(n);
 }
 
 void ODBCStatementData::resizeColumnData(int n)
 {
+	columns.clear();
+	columns.resize(n);
+}
+
+void ODBCStatementData::unbindColumns()
+{
+	if (statement && is_block_bound) {
+		SQLFreeStmt(statement, SQL_UNBIND);
+		SQLSetStmtAttr(statement, SQL_ATTR_ROW_ARRAY_SIZE, (SQLPOINTER)1, 0);
+		SQLSetStmtAttr(statement, SQL_ATTR_ROWS_FETCHED_PTR, nullptr, 0);
+		SQLSetStmtAttr(statement, SQL_ATTR_ROW_STATUS_PTR, nullptr, 0);
+	}
+
+	is_block_bound = false;
+	rowset_size = 1;
+	rows_fetched = 0;
+	current_row = 0;
+	row_status.clear();
+
+	columns_described = false;
+	columns.clear();
+}
+
+bool DbInterfaceODBC::describe_columns(const std::shared_ptr<ODBCStatementData>& dp)
+{
+	SQLSMALLINT ncols = 0;
+	int rc = SQLNumResultCols(dp->statement, &ncols);
+	if (odbcRetrieveError(rc, ErrorSource::Statement, dp->statement) != SQL_SUCCESS)
+		return false;
+
+	dp->resizeColumnData(ncols);
+
+	for (int i = 0; i < ncols; i++) {
+		ODBCColumnData& cd = dp->columns[i];
+		SQLLEN sql_type = 0;
+		SQLLEN col_size = 0;
+
+		rc = SQLColAttribute(dp->statement, i + 1, SQL_DESC_CONCISE_TYPE, nullptr, 0, nullptr, &sql_type);
+		if (odbcRetrieveError(rc, ErrorSource::Statement, dp->statement) != SQL_SUCCESS)
+			return false;
+
+		cd.sql_type = (SQLSMALLINT)sql_type;
+		bool is_binary = (sql_type == SQL_BINARY || sql_type == SQL_VARBINARY || sql_type == SQL_LONGVARBINARY);
+		cd.c_type = is_binary ? SQL_C_BINARY : SQL_C_CHAR;
+
+		// Binary data is returned as-is, everything else is converted to its character representation.
+		// Character data might be converted to a multibyte encoding by the driver, so we reserve room for it
+		rc = SQLColAttribute(dp->statement, i + 1, is_binary ? SQL_DESC_OCTET_LENGTH : SQL_DESC_DISPLAY_SIZE, nullptr, 0, nullptr, &col_size);
+		if (odbcRetrieveError(rc, ErrorSource::Statement, dp->statement) != SQL_SUCCESS)
+			return false;
+
+		bool is_char = (sql_type == SQL_CHAR || sql_type == SQL_VARCHAR || sql_type == SQL_WCHAR || sql_type == SQL_WVARCHAR);
+		if (col_size > 0 && col_size <= MAX_BOUND_COLUMN_SIZE)
+			cd.width = (is_char ? col_size * 4 : col_size) + 1;
+		else
+			cd.width = 0;	// LOBs and unknown sizes cannot be bound
+
+		lib_logger->trace(FMT_FILE_FUNC "ODBC: column {} - SQL type: {}, C type: {}, bound width: {}", __FILE__, __func__, i + 1, cd.sql_type, cd.c_type, cd.width);
+	}
+
+	dp->columns_described = true;
+	return true;
+}
+
+bool DbInterfaceODBC::bind_columns(const std::shared_ptr<ODBCStatementData>& dp)
+{
+	if (!dp->columns_described && !describe_columns(dp))
+		return false;
+
+	if (dp->columns.empty())
+		return false;
+
+	for (auto& cd : dp->columns) {
+		if (cd.width == 0 || cd.sql_type == SQL_LONGVARCHAR || cd.sql_type == SQL_WLONGVARCHAR || cd.sql_type == SQL_LONGVARBINARY)
+			return false;
+	}
+
+	SQLULEN rowset_size = fetch_array_size;
+
+	int rc = SQLSetStmtAttr(dp->statement, SQL_ATTR_ROW_BIND_TYPE, (SQLPOINTER)SQL_BIND_BY_COLUMN, 0);
+	if (odbcRetrieveError(rc, ErrorSource::Statement, dp->statement) != SQL_SUCCESS)
+		return false;
+
+	// The rowset size is set before the buffers are allocated: the driver might replace
+	// the requested value with the closest one it supports, and SQLFetch will use that one
+	rc = SQLSetStmtAttr(dp->statement, SQL_ATTR_ROW_ARRAY_SIZE, (SQLPOINTER)rowset_size, 0);
+	if (rc == SQL_SUCCESS_WITH_INFO) {
+		rc = SQLGetStmtAttr(dp->statement, SQL_ATTR_ROW_ARRAY_SIZE, &rowset_size, 0, nullptr);
+		if (!SQL_SUCCEEDED(rc) || rowset_size < 1 || rowset_size > (SQLULEN)fetch_array_size) {
+			lib_logger->warn("ODBC: the driver does not support a rowset size of {}, block cursor disabled", fetch_array_size);
+			SQLSetStmtAttr(dp->statement, SQL_ATTR_ROW_ARRAY_SIZE, (SQLPOINTER)1, 0);
+			return false;
+		}
+	}
+	else {
+		if (odbcRetrieveError(rc, ErrorSource::Statement, dp->statement) != SQL_SUCCESS)
+			return false;
+	}
+
+	for (int i = 0; i < dp->columns.size(); i++) {
+		ODBCColumnData& cd = dp->columns[i];
+		cd.data.resize(cd.width * rowset_size);
+		cd.indicators.resize(rowset_size);
+
+		rc = SQLBindCol(dp->statement, i + 1, cd.c_type, cd.data.data(), cd.width, cd.indicators.data());
+		if (odbcRetrieveError(rc, ErrorSource::Statement, dp->statement) != SQL_SUCCESS) {
+			SQLFreeStmt(dp->statement, SQL_UNBIND);
+			SQLSetStmtAttr(dp->statement, SQL_ATTR_ROW_ARRAY_SIZE, (SQLPOINTER)1, 0);
+			return false;
+		}
+	}
+
+	dp->row_status.resize(rowset_size);
+
+	SQLSetStmtAttr(dp->statement, SQL_ATTR_ROWS_FETCHED_PTR, &dp->rows_fetched, 0);
+	SQLSetStmtAttr(dp->statement, SQL_ATTR_ROW_STATUS_PTR, dp->row_status.data(), 0);
+
+	dp->rowset_size = rowset_size;
+	dp->rows_fetched = 0;
+	dp->current_row = 0;
+	dp->is_block_bound = true;
+
+	lib_logger->trace(FMT_FILE_FUNC "ODBC: block cursor enabled, rowset size: {}", __FILE__, __func__, dp->rowset_size);
+
+	return true;
+}
+
+bool DbInterfaceODBC::is_updatable_cursor(const std::shared_ptr<ICursor>& cursor)
+{
+	std::string squery = cursor->getQuery();
+	void* src_addr = nullptr;
+	int src_len = 0;
+
+	if (squery.size() == 0) {
+		cursor->getQuerySource(&src_addr, &src_len);
+		squery = __get_trimmed_hostref_or_literal(src_addr, src_len);
+	}
+
+	if (starts_with(squery, "@")) {
+		// the statement text is no longer available, play it safe
+		return true;
+	}
+
+	squery = to_upper(squery);
+	return squery.find("FOR UPDATE") != std::string::npos;
 }
 
 bool DbInterfaceODBC::column_is_binary(SQLHANDLE stmt, int col_index, bool* is_binary)
@@ -1141,49 +1525,3 @@ static std::string __get_trimmed_hostref_or_literal(void* data, int l)
 	return trim_copy(t);
 }
 
-static std::string odbc_fixup_parameters(const std::string& sql)
-{
-	int n = 1;
-	bool in_single_quoted_string = false;
-	bool in_double_quoted_string = false;
-	bool in_param_id = false;
-	std::string out_sql;
-
-	for (auto itc = sql.begin(); itc != sql.end(); ++itc) {
-		char c = *itc;
-
-		if (in_param_id && isalnum(c))
-			continue;
-		else {
-			in_param_id = false;
-		}
-
-		switch (c) {
-		case '"':
-			out_sql += c;
-			in_double_quoted_string = !in_double_quoted_string;
-			continue;
-
-		case '\'':
-			out_sql += c;
-			in_single_quoted_string = !in_single_quoted_string;
-			continue;
-
-		case '$':
-		case ':':
-			if (!in_single_quoted_string && !in_double_quoted_string) {
-				out_sql += '?';
-				in_param_id = true;
-			}
-			else
-				out_sql += c;
-			continue;
-
-		default:
-			out_sql += c;
-
-		}
-	}
-
-	return out_sql;
-}
@@ -46,6 +46,12 @@ typedef unsigned char byte;
 #include "IDataSourceInfo.h"
 #include "IConnectionOptions.h"
 #include "ISchemaManager.h"
+#include "PreparedStatementCache.h"
+
+#define FETCH_ARRAY_SIZE_DEFAULT		32
+#define MAX_BOUND_COLUMN_SIZE		32768
+
+#define PARAM_ARRAY_SIZE_DEFAULT		1
 
 struct IConnectionOptions;
 
@@ -55,6 +61,26 @@ enum class ErrorSource {
 	Statement = 3
 };
 
+struct ODBCColumnData {
+	SQLSMALLINT sql_type = 0;
+	SQLSMALLINT c_type = SQL_C_CHAR;
+	SQLLEN width = 0;
+
+	// column-wise bound buffers (one element per row in the rowset)
+	std::vector<char> data;
+	std::vector<SQLLEN> indicators;
+};
+
+struct ODBCParamData {
+	SQLSMALLINT sql_type = 0;
+	SQLSMALLINT c_type = SQL_C_CHAR;
+	SQLLEN width = 0;
+
+	// column-wise bound buffers (one element per row in the parameter set)
+	std::vector<char> data;
+	std::vector<SQLLEN> lengths;
+};
+
 struct ODBCStatementData : public IPrivateStatementData {
 
 	ODBCStatementData(SQLHANDLE conn);
@@ -62,8 +88,29 @@ struct ODBCStatementData : public IPrivateStatementData {
 
 	void resizeParams(int n);
 	void resizeColumnData(int n);
+	void unbindColumns();
 
 	SQLHANDLE statement = nullptr;
+
+	// column metadata, described once per execution
+	bool columns_described = false;
+	std::vector<ODBCColumnData> columns;
+
+	// block cursor state (SQL_ATTR_ROW_ARRAY_SIZE > 1)
+	bool is_block_bound = false;
+	SQLULEN rowset_size = 1;
+	SQLULEN rows_fetched = 0;
+	SQLULEN current_row = 0;
+	std::vector<SQLUSMALLINT> row_status;
+
+	// parameter bindings, kept across executions of the same statement
+	bool params_bound = false;
+	SQLULEN param_capacity = 1;
+	SQLULEN paramset_size = 1;
+	SQLULEN params_queued = 0;
+	SQLULEN params_processed = 0;
+	std::vector<ODBCParamData> params;
+	std::vector<SQLUSMALLINT> param_status;
 };
 
 class DbInterfaceODBC : public IDbInterface, public IDbManagerInterface
@@ -92,6 +139,7 @@ public:
 	virtual std::string get_state() override;
 	virtual int prepare(const std::string& stmt_name, const std::string& query) override;
 	virtual int exec_prepared(const std::string& stmt_name, std::vector<CobolVarType> paramTypes, std::vector<std_binary_data>& paramValues, std::vector<unsigned long> paramLengths, const std::vector<uint32_t>& paramFlags) override;
+	virtual int prepare_static(const std::vector<std::shared_ptr<StaticStatementInfo>>& stmts) override;
 	virtual DbPropertySetResult set_property(DbProperty p, std::variant<bool, int, std::string> v) override;
 
 
@@ -108,12 +156,22 @@ private:
 	SQLSMALLINT cobol2odbctype(CobolVarType t, uint32_t flags);
 	SQLSMALLINT cobol2ctype(CobolVarType t, uint32_t flags);
 	int get_data_len(SQLHANDLE hStmt, int cnum);
+	bool describe_columns(const std::shared_ptr<ODBCStatementData>& dp);
+	bool bind_columns(const std::shared_ptr<ODBCStatementData>& dp);
+	int fetch_next_row(const std::shared_ptr<ODBCStatementData>& dp);
+	int bind_parameters(const std::shared_ptr<ODBCStatementData>& dp, const std::vector<CobolVarType>& paramTypes, const std::vector<std_binary_data>& paramValues, const std::vector<unsigned long>& paramLengths, const std::vector<uint32_t>& paramFlags, SQLULEN row);
+	int execute_parameters(const std::shared_ptr<ODBCStatementData>& dp, SQLULEN nrows);
+	int flush_param_batch();
+	bool is_batchable_statement(const std::string& query);
 
 	static SQLHANDLE odbc_global_env_context;
 	static int odbc_global_env_context_usage_count;
 
 	SQLHANDLE conn_handle = nullptr;
 
+	int fetch_array_size = FETCH_ARRAY_SIZE_DEFAULT;
+	int param_array_size = PARAM_ARRAY_SIZE_DEFAULT;
+
 	std::shared_ptr<ODBCStatementData> current_statement_data;
 
 	int last_rc = 0;
@@ -122,6 +180,9 @@ private:
 
 	std::map<std::string, std::shared_ptr<ICursor>> _declared_cursors;
 	std::map<std::string, std::shared_ptr<ODBCStatementData>> _prepared_stmts;
+	PreparedStatementCache<ODBCStatementData> _prepared_stmt_cache;
+	std::shared_ptr<ODBCStatementData> pending_batch;
+	std::string pending_batch_query;
 
 	int odbcRetrieveError(int rc, ErrorSource err_src, SQLHANDLE h = 0);
 	void odbcClearError();
@@ -134,5 +195,6 @@ private:
 	bool is_cursor_from_prepared_statement(const std::shared_ptr<ICursor>& cursor);
 	std::shared_ptr<ODBCStatementData> retrieve_prepared_statement(const std::string& prep_stmt_name);
 	bool column_is_binary(SQLHANDLE stmt, int col_index, bool* is_binary);
+	bool is_updatable_cursor(const std::shared_ptr<ICursor>& cursor);
 };
 
@@ -21,19 +21,36 @@ USA.
 #include "DbInterfaceOracle.h"
 
 #include <cobol_var_flags.h>
+#include <sql_stmt_flags.h>
 #include <cstring>
 #include "IConnection.h"
 #include "Logger.h"
 #include "utils.h"
+#include "param_fixup.h"
 #include "varlen_defs.h"
 
-#define DEFAULT_CURSOR_ARRAYSIZE	100
+#define LOB_READ_CHUNK_SIZE		(1024 * 1024)
+
+// The LOB prefetch size is set through a shim that uses ODPI internals (see odpi_set_lob_prefetch_size)
+#if DPI_MAJOR_VERSION == 4 && DPI_MINOR_VERSION == 4
+#define HAVE_ODPI_LOB_PREFETCH_SHIM
+#endif
+
+#ifndef DPI_OCI_ATTR_DEFAULT_LOBPREFETCH_SIZE
+#define DPI_OCI_ATTR_DEFAULT_LOBPREFETCH_SIZE	438
+#endif
 
 dpiContext* DbInterfaceOracle::odpi_global_context = nullptr;
 int DbInterfaceOracle::odpi_global_context_usage_count = 0;
+std::map<std::string, dpiPool*> DbInterfaceOracle::odpi_session_pools;
 
 static std::string __get_trimmed_hostref_or_literal(void* data, int l);
-static std::string odpi_fixup_parameters(const std::string& sql);
+static bool get_bool_option(const std::map<std::string, std::string>& opts, const std::string& opt_name, bool default_value);
+static int get_int_option(const std::map<std::string, std::string>& opts, const std::string& opt_name, int default_value);
+#ifdef HAVE_ODPI_LOB_PREFETCH_SHIM
+static int odpi_set_lob_prefetch_size(dpiConn* conn, uint32_t size);
+#endif
+static bool is_lob_type(dpiOracleTypeNum t);
 
 DbInterfaceOracle::DbInterfaceOracle()
 {}
@@ -41,20 +58,13 @@ DbInterfaceOracle::DbInterfaceOracle()
 
 DbInterfaceOracle::~DbInterfaceOracle()
 {
-	if (connaddr) {
-		int is_healthy = 0;
-		int rc = dpiConn_getIsHealthy(connaddr, &is_healthy);
-		if (rc == DPI_SUCCESS && is_healthy) {
-			dpiConn_close(connaddr, DPI_MODE_CONN_CLOSE_DROP, nullptr, 0);
-		}
-
-		dpiConn_release(connaddr);
-	}
+	close_connection();
 
 	// TODO: use shared_ptr with deleter
 	odpi_global_context_usage_count--;
 	lib_logger->trace("dpiContext usage count is now {} ({})", odpi_global_context_usage_count, (void*)odpi_global_context);
 	if (odpi_global_context && odpi_global_context_usage_count == 0) {
+		close_session_pools();
 		dpiContext_destroy(odpi_global_context);
 		lib_logger->trace("dpiContext destroyed ({})", (void*)odpi_global_context);
 		odpi_global_context = nullptr;
@@ -122,11 +132,27 @@ int DbInterfaceOracle::connect(std::shared_ptr<IDataSourceInfo> _conn_info, std:
 		lib_logger->warn("Setting the encoding is not supported on Oracle, set NLS_LANG before trying to connect");
 	}
 
-	int rc = dpiConn_create(odpi_global_context,
-		_conn_info->getUsername().c_str(), _conn_info->getUsername().size(),
-		_conn_info->getPassword().c_str(), _conn_info->getPassword().size(),
-		conn_string.c_str(), conn_string.size(),
-		NULL, NULL, &conn);
+	auto opts = _conn_info->getOptions();
+
+	int rc = 0;
+	dpiPool* session_pool = nullptr;
+	if (get_bool_option(opts, "session_pool", false)) {
+		session_pool = get_session_pool(_conn_info, conn_string);
+		if (!session_pool) {
+			lib_logger->error("An error occurred while trying to create a session pool: ({}:{}) {}", last_rc, last_state, last_error);
+			return DBERR_CONNECTION_FAILED;
+		}
+
+		// The pool is homogeneous, so credentials are not passed again
+		rc = dpiPool_acquireConnection(session_pool, NULL, 0, NULL, 0, NULL, &conn);
+	}
+	else {
+		rc = dpiConn_create(odpi_global_context,
+			_conn_info->getUsername().c_str(), _conn_info->getUsername().size(),
+			_conn_info->getPassword().c_str(), _conn_info->getPassword().size(),
+			conn_string.c_str(), conn_string.size(),
+			NULL, NULL, &conn);
+	}
 
 	if (rc < 0) {
 		dpiRetrieveError(rc);
@@ -135,6 +161,59 @@ int DbInterfaceOracle::connect(std::shared_ptr<IDataSourceInfo> _conn_info, std:
 	}
 
 	connaddr = conn;
+	pool = session_pool;
+
+	if (pool)
+		log_pool_stats("acquire");
+
+	int stmt_cache_size = get_int_option(opts, "stmt_cache_size", DEFAULT_STMT_CACHE_SIZE);
+	if (stmt_cache_size >= 0) {
+		rc = dpiConn_setStmtCacheSize(connaddr, stmt_cache_size);
+		if (dpiRetrieveError(rc) != DPI_SUCCESS) {
+			lib_logger->error("Cannot set the statement cache size: ({}:{}) {}", last_rc, last_state, last_error);
+			close_connection();
+			return DBERR_CONNECTION_FAILED;
+		}
+		lib_logger->trace(FMT_FILE_FUNC "ODPI: statement cache size is {}", __FILE__, __func__, stmt_cache_size);
+	}
+
+	// LOB data up to this size is returned together with the locator when a row is fetched,
+	// so reading small LOBs does not require an additional round-trip for each row
+	this->lob_prefetch_size = get_int_option(opts, "lob_prefetch_size", DEFAULT_LOB_PREFETCH_SIZE);
+#ifdef HAVE_ODPI_LOB_PREFETCH_SHIM
+	if (this->lob_prefetch_size > 0) {
+		rc = odpi_set_lob_prefetch_size(connaddr, this->lob_prefetch_size);
+		if (dpiRetrieveError(rc) != DPI_SUCCESS) {
+			// Not fatal, LOBs will just be read with a separate round-trip
+			lib_logger->warn("Cannot set the LOB prefetch size: ({}:{}) {}", last_rc, last_state, last_error);
+			dpiClearError();
+		}
+		else {
+			lib_logger->trace(FMT_FILE_FUNC "ODPI: LOB prefetch size is {}", __FILE__, __func__, this->lob_prefetch_size);
+		}
+	}
+#else
+	if (this->lob_prefetch_size > 0) {
+		lib_logger->warn("LOB prefetch is not supported with this ODPI version, ignoring lob_prefetch_size");
+		this->lob_prefetch_size = 0;
+	}
+#endif
+
+	if (opts.find("fetch_array_size") != opts.end()) {
+		int n = atoi(opts["fetch_array_size"].c_str());
+		if (n > 0)
+			this->fetch_array_size = n;
+	}
+
+	if (opts.find("prefetch_rows") != opts.end()) {
+		int n = atoi(opts["prefetch_rows"].c_str());
+		if (n >= 0)
+			this->prefetch_rows = n;
+	}
+
+	lib_logger->trace(FMT_FILE_FUNC "ODPI: fetch array size is {}, prefetch rows is {}", __FILE__, __func__, this->fetch_array_size, this->prefetch_rows);
+
+	_prepared_stmt_cache.setMaxMemory(opts);
 
 	this->connection_opts = _conn_opts;
 	this->data_source_info = _conn_info;
@@ -155,15 +234,109 @@ int DbInterfaceOracle::reset()
 int DbInterfaceOracle::terminate_connection()
 {
 	lib_logger->trace(FMT_FILE_FUNC "ODPI::terminate_connection", __FILE__, __func__);
-	if (connaddr) {
-		dpiConn_close(connaddr, DPI_MODE_CONN_CLOSE_DROP, nullptr, 0);
-		dpiConn_release(connaddr);
-		connaddr = NULL;
-	}
+	close_connection();
 
 	return DBERR_NO_ERROR;
 }
 
+void DbInterfaceOracle::close_connection()
+{
+	if (!connaddr)
+		return;
+
+	// Statements must be released before the connection is closed
+	_prepared_stmt_cache.clear();
+	_prepared_stmts.clear();
+
+	int is_healthy = 0;
+	int rc = dpiConn_getIsHealthy(connaddr, &is_healthy);
+	if (rc == DPI_SUCCESS && is_healthy) {
+		// Pooled sessions are returned to the pool, unless they are no longer usable
+		dpiConn_close(connaddr, pool ? DPI_MODE_CONN_CLOSE_DEFAULT : DPI_MODE_CONN_CLOSE_DROP, nullptr, 0);
+	}
+	else {
+		if (pool)
+			dpiConn_close(connaddr, DPI_MODE_CONN_CLOSE_DROP, nullptr, 0);
+	}
+
+	dpiConn_release(connaddr);
+	connaddr = nullptr;
+
+	if (pool) {
+		log_pool_stats("release");
+		pool = nullptr;
+	}
+}
+
+dpiPool* DbInterfaceOracle::get_session_pool(std::shared_ptr<IDataSourceInfo> _conn_info, const std::string& conn_string)
+{
+	std::string pool_key = _conn_info->getUsername() + "@" + conn_string;
+	if (odpi_session_pools.find(pool_key) != odpi_session_pools.end())
+		return odpi_session_pools[pool_key];
+
+	auto opts = _conn_info->getOptions();
+
+	dpiCommonCreateParams common_params;
+	dpiPoolCreateParams pool_params;
+
+	if (dpiRetrieveError(dpiContext_initCommonCreateParams(odpi_global_context, &common_params)) < 0)
+		return nullptr;
+
+	if (dpiRetrieveError(dpiContext_initPoolCreateParams(odpi_global_context, &pool_params)) < 0)
+		return nullptr;
+
+	int stmt_cache_size = get_int_option(opts, "stmt_cache_size", DEFAULT_STMT_CACHE_SIZE);
+	if (stmt_cache_size >= 0)
+		common_params.stmtCacheSize = stmt_cache_size;
+
+	pool_params.minSessions = get_int_option(opts, "pool_min_sessions", DEFAULT_POOL_MIN_SESSIONS);
+	pool_params.maxSessions = get_int_option(opts, "pool_max_sessions", DEFAULT_POOL_MAX_SESSIONS);
+	pool_params.sessionIncrement = get_int_option(opts, "pool_session_increment", DEFAULT_POOL_SESSION_INCR);
+	pool_params.homogeneous = 1;
+	pool_params.getMode = DPI_MODE_POOL_GET_WAIT;
+
+	if (pool_params.maxSessions < pool_params.minSessions)
+		pool_params.maxSessions = pool_params.minSessions;
+
+	lib_logger->trace(FMT_FILE_FUNC "ODPI: creating session pool for {} (min: {}, max: {}, increment: {})", __FILE__, __func__,
+		pool_key, pool_params.minSessions, pool_params.maxSessions, pool_params.sessionIncrement);
+
+	dpiPool* p = nullptr;
+	int rc = dpiPool_create(odpi_global_context,
+		_conn_info->getUsername().c_str(), _conn_info->getUsername().size(),
+		_conn_info->getPassword().c_str(), _conn_info->getPassword().size(),
+		conn_string.c_str(), conn_string.size(),
+		&common_params, &pool_params, &p);
+
+	if (dpiRetrieveError(rc) < 0)
+		return nullptr;
+
+	odpi_session_pools[pool_key] = p;
+	return p;
+}
+
+void DbInterfaceOracle::log_pool_stats(const std::string& event)
+{
+	uint32_t open_count = 0, busy_count = 0;
+
+	if (!pool)
+		return;
+
+	if (dpiPool_getOpenCount(pool, &open_count) < 0 || dpiPool_getBusyCount(pool, &busy_count) < 0)
+		return;
+
+	lib_logger->debug(FMT_FILE_FUNC "ODPI: session pool stats ({}) - open: {}, busy: {}", __FILE__, __func__, event, open_count, busy_count);
+}
+
+void DbInterfaceOracle::close_session_pools()
+{
+	for (auto p : odpi_session_pools) {
+		dpiPool_close(p.second, DPI_MODE_POOL_CLOSE_FORCE);
+		dpiPool_release(p.second);
+	}
+	odpi_session_pools.clear();
+}
+
 const char* DbInterfaceOracle::get_error_message()
 {
 	return (char*)last_error.c_str();
@@ -195,16 +368,20 @@ std::string vector_join(const std::vector<std::string>& v, char sep)
 int DbInterfaceOracle::prepare(const std::string& _stmt_name, const std::string& query)
 {
 	std::string prepared_sql;
-	std::shared_ptr<OdpiStatementData> res = std::make_shared<OdpiStatementData>();
-
 	std::string stmt_name = to_lower(_stmt_name);
 
 	lib_logger->trace(FMT_FILE_FUNC "ODPI::prepare ({}) - SQL: {}", __FILE__, __func__, stmt_name, query);
 
-	if (this->_prepared_stmts.find(stmt_name) != _prepared_stmts.end()) {
-		return DBERR_PREPARE_FAILED;
+	// The same text has already been prepared and the statement is not in use by another name: reuse it
+	std::shared_ptr<OdpiStatementData> res = _prepared_stmt_cache.find(query, stmt_name, _prepared_stmts);
+	if (res) {
+		lib_logger->trace(FMT_FILE_FUNC "ODPI::prepare ({}) - reusing cached statement", __FILE__, __func__, stmt_name);
+		_prepared_stmts[stmt_name] = res;
+		return DBERR_NO_ERROR;
 	}
 
+	res = std::make_shared<OdpiStatementData>();
+
 	if (connection_opts->fixup_parameters) {
 		prepared_sql = odpi_fixup_parameters(query);
 		lib_logger->trace(FMT_FILE_FUNC "ODPI::fixup parameters is on", __FILE__, __func__);
@@ -226,7 +403,9 @@ int DbInterfaceOracle::prepare(const std::string& _stmt_name, const std::string&
 
 	lib_logger->trace(FMT_FILE_FUNC "ODPI::prepare ({} - res: ({}) {}", __FILE__, __func__, stmt_name, last_rc, last_error);
 
+	// If the name was already in use, the statement it was bound to is released, unless still cached
 	_prepared_stmts[stmt_name] = res;
+	_prepared_stmt_cache.add(query, res);
 
 	return DBERR_NO_ERROR;
 }
@@ -334,32 +513,17 @@ int DbInterfaceOracle::exec_prepared(const std::string& _stmt_name, std::vector<
 		}
 	}
 
+	rc = set_fetch_options(nullptr, wk_rs);
+	if (rc != DBERR_NO_ERROR)
+		return rc;
+
 	uint32_t nquery_cols;
 	rc = dpiStmt_execute(wk_rs->statement, DPI_MODE_EXEC_DEFAULT, &nquery_cols);
 	if (dpiRetrieveError(rc) < 0) {
 		return DBERR_SQL_ERROR;
 	}
 
-	dpiQueryInfo info;
-	wk_rs->resizeColumnData(nquery_cols);
-	for (int i = 1; i <= nquery_cols; i++) {
-
-		rc = dpiStmt_getQueryInfo(wk_rs->statement, i, &info);
-		if (dpiRetrieveError(rc) != DPI_SUCCESS) { return DBERR_SQL_ERROR; }
-
-		dpiNativeTypeNum native_type = (info.typeInfo.oracleTypeNum == DPI_ORACLE_TYPE_BLOB) ? DPI_NATIVE_TYPE_LOB : DPI_NATIVE_TYPE_BYTES;
-
-		rc = dpiStmt_getQueryInfo(wk_rs->statement, i, &info);
-		if (dpiRetrieveError(rc) != DPI_SUCCESS) { return DBERR_SQL_ERROR; }
-
-		rc = dpiConn_newVar(connaddr, info.typeInfo.oracleTypeNum, native_type, DEFAULT_CURSOR_ARRAYSIZE, info.typeInfo.clientSizeInBytes, 1, 0, NULL, &wk_rs->coldata[i - 1], &wk_rs->coldata_bfrs[i - 1]);
-		if (dpiRetrieveError(rc) != DPI_SUCCESS) { return DBERR_SQL_ERROR; }
-
-		rc = dpiStmt_define(wk_rs->statement, i, wk_rs->coldata[i - 1]);
-		if (dpiRetrieveError(rc) != DPI_SUCCESS) { return DBERR_SQL_ERROR; }
-	}
-
-	return DBERR_NO_ERROR;
+	return define_columns(wk_rs, nquery_cols);
 }
 
 DbPropertySetResult DbInterfaceOracle::set_property(DbProperty p, std::variant<bool, int, std::string> v)
@@ -398,26 +562,18 @@ int DbInterfaceOracle::_odpi_exec(std::shared_ptr<ICursor> crsr, const std::stri
 		wk_rs = prep_stmt_data;	// Already prepared
 	}
 
+	rc = set_fetch_options(crsr, wk_rs);
+	if (rc != DBERR_NO_ERROR)
+		return rc;
+
 	rc = dpiStmt_execute(wk_rs->statement, DPI_MODE_EXEC_DEFAULT, &nquery_cols);
 	if (dpiRetrieveError(rc) != DPI_SUCCESS) {
 		return DBERR_SQL_ERROR;
 	}
 
-	dpiQueryInfo info;
-	wk_rs->resizeColumnData(nquery_cols);
-	for (int i = 1; i <= nquery_cols; i++) {
-
-		rc = dpiStmt_getQueryInfo(wk_rs->statement, i, &info);
-		if (dpiRetrieveError(rc) != DPI_SUCCESS) { return DBERR_SQL_ERROR; }
-
-		dpiNativeTypeNum native_type = (info.typeInfo.oracleTypeNum == DPI_ORACLE_TYPE_BLOB) ? DPI_NATIVE_TYPE_LOB : DPI_NATIVE_TYPE_BYTES;
-
-		rc = dpiConn_newVar(connaddr, info.typeInfo.oracleTypeNum, native_type, DEFAULT_CURSOR_ARRAYSIZE, info.typeInfo.clientSizeInBytes, 1, 0, NULL, &wk_rs->coldata[i - 1], &wk_rs->coldata_bfrs[i - 1]);
-		if (dpiRetrieveError(rc) != DPI_SUCCESS) { return DBERR_SQL_ERROR; }
-
-		rc = dpiStmt_define(wk_rs->statement, i, wk_rs->coldata[i - 1]);
-		if (dpiRetrieveError(rc) != DPI_SUCCESS) { return DBERR_SQL_ERROR; }
-	}
+	rc = define_columns(wk_rs, nquery_cols);
+	if (rc != DBERR_NO_ERROR)
+		return rc;
 
 	if (!prep_stmt_data) {
 		q = trim_copy(q);
@@ -439,7 +595,8 @@ int DbInterfaceOracle::_odpi_exec(std::shared_ptr<ICursor> crsr, const std::stri
 
 		// Since Oracle automatically starts a new transaction on the first statement after a COMMIT/ROLLBACK
 		// we only need to issue a manual COMMIT after a statement has been successfully executed
-		if (connection_opts->autocommit == AutoCommitMode::On && !is_tx_termination_statement(query)) {
+		bool is_tx_end = SQL_STMT_HAS_FLAGS(stmt_flags) ? SQL_STMT_IS_TX_END(stmt_flags) : is_tx_termination_statement(query);
+		if (connection_opts->autocommit == AutoCommitMode::On && !is_tx_end) {
 
 			// the statement was not a COMMIT/ROLLBACK, so we issue a COMMIT
 			lib_logger->trace(FMT_FILE_FUNC "autocommit mode is enabled, trying to commit", __FILE__, __func__);
@@ -566,25 +723,19 @@ int DbInterfaceOracle::_odpi_exec_params(std::shared_ptr<ICursor> crsr, const st
 
 	}
 
+	rc = set_fetch_options(crsr, wk_rs);
+	if (rc != DBERR_NO_ERROR)
+		return rc;
+
 	uint32_t nquery_cols = 0;
 	rc = dpiStmt_execute(wk_rs->statement, DPI_MODE_EXEC_DEFAULT, &nquery_cols);
 	if (dpiRetrieveError(rc) != DPI_SUCCESS) {
 		return DBERR_SQL_ERROR;
 	}
 
-	dpiQueryInfo col_info;
-	for (int i = 1; i <= nquery_cols; i++) {
-
-		rc = dpiStmt_getQueryInfo(wk_rs->statement, i, &col_info);
-		if (dpiRetrieveError(rc) != DPI_SUCCESS) {
-			return DBERR_SQL_ERROR;
-		}
-
-		rc = dpiStmt_defineValue(wk_rs->statement, i, col_info.typeInfo.oracleTypeNum, DPI_NATIVE_TYPE_BYTES, col_info.typeInfo.clientSizeInBytes, 0, NULL);
-		if (dpiRetrieveError(rc) != DPI_SUCCESS) {
-			return DBERR_SQL_ERROR;
-		}
-	}
+	rc = define_columns(wk_rs, nquery_cols);
+	if (rc != DBERR_NO_ERROR)
+		return rc;
 
 	if (!prep_stmt_data) {
 		q = trim_copy(q);
@@ -612,6 +763,86 @@ int DbInterfaceOracle::_odpi_exec_params(std::shared_ptr<ICursor> crsr, const st
 	}
 }
 
+// Applies the fetch array size and the number of prefetched rows to a statement
+// before it is executed: connection-level values (from the connection string)
+// can be overridden for a single cursor (e.g. "fetch_array_size.crsr01=500")
+int DbInterfaceOracle::set_fetch_options(std::shared_ptr<ICursor> crsr, std::shared_ptr<OdpiStatementData> wk_rs)
+{
+	int array_size = get_cursor_option(crsr, "fetch_array_size", fetch_array_size);
+	int prefetch = get_cursor_option(crsr, "prefetch_rows", prefetch_rows);
+
+	if (array_size <= 0)
+		array_size = fetch_array_size;
+
+	wk_rs->fetch_array_size = array_size;
+
+	int rc = dpiStmt_setFetchArraySize(wk_rs->statement, array_size);
+	if (dpiRetrieveError(rc) != DPI_SUCCESS) {
+		lib_logger->error(FMT_FILE_FUNC "cannot set fetch array size: {} ({})", __FILE__, __func__, last_error, last_state);
+		return DBERR_SQL_ERROR;
+	}
+
+	if (prefetch >= 0) {
+		rc = dpiStmt_setPrefetchRows(wk_rs->statement, prefetch);
+		if (dpiRetrieveError(rc) != DPI_SUCCESS) {
+			lib_logger->error(FMT_FILE_FUNC "cannot set prefetch rows: {} ({})", __FILE__, __func__, last_error, last_state);
+			return DBERR_SQL_ERROR;
+		}
+	}
+
+	return DBERR_NO_ERROR;
+}
+
+// Defines the output variables for a query and caches the column metadata,
+// so that retrieving a value from the current row is a plain buffer access
+int DbInterfaceOracle::define_columns(std::shared_ptr<OdpiStatementData> wk_rs, uint32_t nquery_cols)
+{
+	int rc = 0;
+
+	wk_rs->resizeColumnData(nquery_cols);
+	for (int i = 1; i <= nquery_cols; i++) {
+
+		dpiQueryInfo& info = wk_rs->colinfo[i - 1];
+
+		rc = dpiStmt_getQueryInfo(wk_rs->statement, i, &info);
+		if (dpiRetrieveError(rc) != DPI_SUCCESS) { return DBERR_SQL_ERROR; }
+
+		dpiNativeTypeNum native_type = is_lob_type(info.typeInfo.oracleTypeNum) ? DPI_NATIVE_TYPE_LOB : DPI_NATIVE_TYPE_BYTES;
+		wk_rs->coltypes[i - 1] = native_type;
+
+		rc = dpiConn_newVar(connaddr, info.typeInfo.oracleTypeNum, native_type, wk_rs->fetch_array_size, info.typeInfo.clientSizeInBytes, 1, 0, NULL, &wk_rs->coldata[i - 1], &wk_rs->coldata_bfrs[i - 1]);
+		if (dpiRetrieveError(rc) != DPI_SUCCESS) { return DBERR_SQL_ERROR; }
+
+		rc = dpiStmt_define(wk_rs->statement, i, wk_rs->coldata[i - 1]);
+		if (dpiRetrieveError(rc) != DPI_SUCCESS) { return DBERR_SQL_ERROR; }
+	}
+
+	return DBERR_NO_ERROR;
+}
+
+int DbInterfaceOracle::get_cursor_option(const std::shared_ptr<ICursor>& crsr, const std::string& opt_name, int default_value)
+{
+	if (!crsr || !data_source_info)
+		return default_value;
+
+	// Cursor names are prefixed with the program id by the preprocessor,
+	// we accept both the full name and the one used in the source
+	std::string crsr_name = to_lower(crsr->getName());
+	std::string prefix = opt_name + ".";
+
+	for (auto o : data_source_info->getOptions()) {
+		std::string k = to_lower(o.first);
+		if (!starts_with(k, prefix) || k.size() == prefix.size())
+			continue;
+
+		std::string n = k.substr(prefix.size());
+		if (n == crsr_name || (crsr_name.size() > n.size() && crsr_name.substr(crsr_name.size() - n.size() - 1) == ("_" + n)))
+			return atoi(o.second.c_str());
+	}
+
+	return default_value;
+}
+
 bool DbInterfaceOracle::is_cursor_from_prepared_statement(const std::shared_ptr<ICursor>& cursor)
 {
 	std::string squery = cursor->getQuery();
@@ -748,6 +979,8 @@ int DbInterfaceOracle::cursor_fetch_one(const std::shared_ptr<ICursor>& cursor,
 	if (!found)
 		return DBERR_NO_DATA;
 
+	dp->current_row = bfr_row_index;
+
 	return DBERR_NO_ERROR;
 }
 
@@ -796,19 +1029,29 @@ bool DbInterfaceOracle::get_resultset_value(ResultSetContextType resultset_conte
 	}
 
 	dpiData* col_data;
-	dpiQueryInfo col_info;
 	dpiNativeTypeNum nativeTypeNum;
+	dpiOracleTypeNum oracleTypeNum;
 
-	rc = dpiStmt_getQueryInfo(wk_rs->statement, (col + 1), &col_info);
-	if (dpiRetrieveError(rc) < 0) {
-		lib_logger->error("Invalid column metadata");
-		return false;
+	if (wk_rs->coldata_bfrs && col >= 0 && col < wk_rs->coldata_count && wk_rs->coldata_bfrs[col]) {
+		// Column metadata has been cached when the columns were defined
+		col_data = &wk_rs->coldata_bfrs[col][wk_rs->current_row];
+		nativeTypeNum = wk_rs->coltypes[col];
+		oracleTypeNum = wk_rs->colinfo[col].typeInfo.oracleTypeNum;
 	}
+	else {
+		rc = dpiStmt_getQueryValue(wk_rs->statement, (col + 1), &nativeTypeNum, &col_data);
+		if (dpiRetrieveError(rc) < 0) {
+			lib_logger->error("Invalid column data");
+			return false;
+		}
 
-	rc = dpiStmt_getQueryValue(wk_rs->statement, (col + 1), &nativeTypeNum, &col_data);
-	if (dpiRetrieveError(rc) < 0) {
-		lib_logger->error("Invalid column data");
-		return false;
+		dpiQueryInfo info;
+		rc = dpiStmt_getQueryInfo(wk_rs->statement, (col + 1), &info);
+		if (dpiRetrieveError(rc) < 0) {
+			lib_logger->error("Invalid column data");
+			return false;
+		}
+		oracleTypeNum = info.typeInfo.oracleTypeNum;
 	}
 
 	if (col_data->isNull) {
@@ -835,6 +1078,7 @@ bool DbInterfaceOracle::get_resultset_value(ResultSetContextType resultset_conte
 	}
 	else
 	{
+		// The LOB length is prefetched with the locator, so this does not require a round-trip
 		uint64_t lobsize = 0;
 		dpiLob* lob = col_data->value.asLOB;
 		rc = dpiLob_getSize(lob, &lobsize);
@@ -843,18 +1087,40 @@ bool DbInterfaceOracle::get_resultset_value(ResultSetContextType resultset_conte
 			return false;
 		}
 
+		// For character LOBs the size is in characters, so this only catches the obvious cases:
+		// if the data still does not fit, dpiLob_readBytes will fail
 		if (lobsize > bfrlen) {
 			lib_logger->error("ODPI: ERROR: data truncated: needed {} bytes, {} allocated", lobsize, bfrlen);	// was just a warning
 			return false;
 		}
 
-		rc = dpiLob_readBytes(lob, 1, lobsize, bfr, &bfrlen);
-		if (dpiRetrieveError(rc) < 0) {
-			lib_logger->error("Invalid column data");
-			return false;
+		// Data is read straight into the destination field in chunks: when the LOB
+		// is not larger than the LOB prefetch size the first read is served locally
+		uint64_t offset = 1;
+		uint64_t total = 0;
+		bool is_char_lob = (oracleTypeNum == DPI_ORACLE_TYPE_CLOB || oracleTypeNum == DPI_ORACLE_TYPE_NCLOB);
+		while (offset <= lobsize && total < bfrlen) {
+			uint64_t nread = bfrlen - total;
+			uint64_t amount = lobsize - offset + 1;
+
+			// Character LOBs are read in a single call, since offsets are in characters
+			if (!is_char_lob && amount > LOB_READ_CHUNK_SIZE)
+				amount = LOB_READ_CHUNK_SIZE;
+
+			rc = dpiLob_readBytes(lob, offset, amount, bfr + total, &nread);
+			if (dpiRetrieveError(rc) < 0) {
+				lib_logger->error("Invalid column data");
+				return false;
+			}
+
+			if (nread == 0)
+				break;
+
+			total += nread;
+			offset += is_char_lob ? amount : nread;
 		}
 
-		*value_len = lobsize;
+		*value_len = total;
 	}
 
 #ifdef VERBOSE
@@ -908,6 +1174,8 @@ bool DbInterfaceOracle::move_to_first_record(const std::string& _stmt_name)
 		return false;
 	}
 
+	dp->current_row = bfr_row_index;
+
 	return true;
 }
 
@@ -940,18 +1208,26 @@ int DbInterfaceOracle::get_num_rows(const std::shared_ptr<ICursor>& crsr)
 int DbInterfaceOracle::get_num_fields(const std::shared_ptr<ICursor>& crsr)
 {
 	dpiStmt* wk_rs = nullptr;
+	std::shared_ptr<OdpiStatementData> dp;
 
 	if (crsr) {
-		std::shared_ptr<OdpiStatementData> dp = std::dynamic_pointer_cast<OdpiStatementData>(crsr->getPrivateData());;
-		wk_rs = dp->statement;
+		dp = std::dynamic_pointer_cast<OdpiStatementData>(crsr->getPrivateData());
 	}
 	else {
 		if (!current_statement_data)
 			return -1;
 
-		wk_rs = current_statement_data->statement;
+		dp = current_statement_data;
 	}
 
+	if (!dp)
+		return -1;
+
+	if (dp->coldata)
+		return dp->coldata_count;
+
+	wk_rs = dp->statement;
+
 	if (wk_rs) {
 		uint32_t col_count = -1;
 		if (dpiStmt_getNumQueryColumns(wk_rs, &col_count) >= 0)
@@ -1048,9 +1324,15 @@ void OdpiStatementData::resizeParams(int n)
 
 void OdpiStatementData::resizeColumnData(int n)
 {
+	releaseColumnData();
+
 	coldata_count = n;
 	this->coldata = new dpiVar * [n]();
 	this->coldata_bfrs = new dpiData * [n]();
+
+	colinfo.assign(n, dpiQueryInfo());
+	coltypes.assign(n, DPI_NATIVE_TYPE_BYTES);
+	current_row = 0;
 }
 
 void OdpiStatementData::cleanup()
@@ -1066,6 +1348,21 @@ void OdpiStatementData::cleanup()
 		params = nullptr;
 	}
 
+	if (params_bfrs) {
+		for (int i = 0; i < params_count; i++) {
+			params_bfrs[i] = nullptr;
+		}
+		delete[] params_bfrs;
+		params_bfrs = nullptr;
+	}
+
+	params_count = 0;
+
+	releaseColumnData();
+}
+
+void OdpiStatementData::releaseColumnData()
+{
 	if (coldata) {
 		for (int i = 0; i < coldata_count; i++) {
 			if (coldata[i]) {
@@ -1077,14 +1374,6 @@ void OdpiStatementData::cleanup()
 		coldata = nullptr;
 	}
 
-	if (params_bfrs) {
-		for (int i = 0; i < params_count; i++) {
-			params_bfrs[i] = nullptr;
-		}
-		delete[] params_bfrs;
-		params_bfrs = nullptr;
-	}
-
 	if (coldata_bfrs) {
 		for (int i = 0; i < coldata_count; i++) {
 			coldata_bfrs[i] = nullptr;
@@ -1093,7 +1382,9 @@ void OdpiStatementData::cleanup()
 		coldata_bfrs = nullptr;
 	}
 
-	params_count = 0;
+	colinfo.clear();
+	coltypes.clear();
+
 	coldata_count = 0;
 }
 
@@ -1122,43 +1413,56 @@ static std::string __get_trimmed_hostref_or_literal(void* data, int l)
 	return trim_copy(t);
 }
 
-static std::string odpi_fixup_parameters(const std::string& sql)
+static bool get_bool_option(const std::map<std::string, std::string>& opts, const std::string& opt_name, bool default_value)
 {
-	int n = 1;
-	bool in_single_quoted_string = false;
-	bool in_double_quoted_string = false;
-	std::string out_sql;
-
-	for (auto itc = sql.begin(); itc != sql.end(); ++itc) {
-		char c = *itc;
-
-		switch (c) {
-		case '"':
-			out_sql += c;
-			in_double_quoted_string = !in_double_quoted_string;
-			continue;
+	auto it = opts.find(opt_name);
+	if (it == opts.end())
+		return default_value;
 
-		case '\'':
-			out_sql += c;
-			in_single_quoted_string = !in_single_quoted_string;
-			continue;
+	std::string v = to_lower(it->second);
+	if (v == "on" || v == "1" || v == "true")
+		return true;
 
-		case '$':	// :1 is valid in Oracle, so we just change the prefix
-			out_sql += ':';
-			continue;
+	if (v == "off" || v == "0" || v == "false")
+		return false;
 
-		case '?':
-			if (!in_single_quoted_string && !in_double_quoted_string)
-				out_sql += (":" + std::to_string(n++));
-			else
-				out_sql += c;
-			continue;
+	return default_value;
+}
 
-		default:
-			out_sql += c;
+static int get_int_option(const std::map<std::string, std::string>& opts, const std::string& opt_name, int default_value)
+{
+	auto it = opts.find(opt_name);
+	if (it == opts.end() || it->second.empty())
+		return default_value;
 
-		}
-	}
+	int n = atoi(it->second.c_str());
+	return n >= 0 ? n : default_value;
+}
 
-	return out_sql;
+static bool is_lob_type(dpiOracleTypeNum t)
+{
+	return t == DPI_ORACLE_TYPE_BLOB || t == DPI_ORACLE_TYPE_CLOB || t == DPI_ORACLE_TYPE_NCLOB || t == DPI_ORACLE_TYPE_BFILE;
 }
+
+/*
+ * ODPI shim
+ *
+ * ODPI does not (yet) expose the default LOB prefetch size, so the OCI session attribute is set
+ * through ODPI's internal OCI wrapper. This is the only place where the driver uses ODPI internals
+ * (dpiImpl.h): it is only built for the vendored ODPI version it has been written against, with
+ * any other version LOBs are read without prefetch. When ODPI is refreshed, check whether it
+ * exposes this attribute (and replace this function) or update HAVE_ODPI_LOB_PREFETCH_SHIM.
+ */
+#ifdef HAVE_ODPI_LOB_PREFETCH_SHIM
+static int odpi_set_lob_prefetch_size(dpiConn* conn, uint32_t size)
+{
+	dpiError error;
+
+	if (dpiGen__startPublicFn(conn, DPI_HTYPE_CONN, __func__, &error) < 0)
+		return dpiGen__endPublicFn(conn, DPI_FAILURE, &error);
+
+	int status = dpiOci__attrSet(conn->sessionHandle, DPI_OCI_HTYPE_SESSION, &size, 0, DPI_OCI_ATTR_DEFAULT_LOBPREFETCH_SIZE, "set default LOB prefetch size", &error);
+	return dpiGen__endPublicFn(conn, status, &error);
+}
+#endif
+
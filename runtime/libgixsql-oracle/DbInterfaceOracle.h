@@ -31,6 +31,7 @@ USA.
 #include "IDbManagerInterface.h"
 #include "IDataSourceInfo.h"
 #include "ISchemaManager.h"
+#include "PreparedStatementCache.h"
 
 extern "C" {
 #include "dpi.h"
@@ -41,6 +42,15 @@ extern "C" {
 #define DECODE_BINARY_OFF		0
 #define DECODE_BINARY_DEFAULT	DECODE_BINARY_ON
 
+#define DEFAULT_CURSOR_ARRAYSIZE	100
+#define DEFAULT_PREFETCH_ROWS		-1		// use the ODPI/OCI default
+
+#define DEFAULT_POOL_MIN_SESSIONS	1
+#define DEFAULT_POOL_MAX_SESSIONS	4
+#define DEFAULT_POOL_SESSION_INCR	1
+#define DEFAULT_STMT_CACHE_SIZE		-1		// use the ODPI/OCI default
+#define DEFAULT_LOB_PREFETCH_SIZE	32768
+
 struct OdpiStatementData : public IPrivateStatementData {
 
 	OdpiStatementData();
@@ -60,8 +70,18 @@ struct OdpiStatementData : public IPrivateStatementData {
 	int params_count = 0;
 	int coldata_count = 0;
 
+	// Column metadata, retrieved once per execution when the columns are defined
+	std::vector<dpiQueryInfo> colinfo;
+	std::vector<dpiNativeTypeNum> coltypes;
+
+	uint32_t fetch_array_size = DEFAULT_CURSOR_ARRAYSIZE;
+
+	// Index of the current row in the fetch buffers (as returned by dpiStmt_fetch)
+	uint32_t current_row = 0;
+
 private:
 	void cleanup();
+	void releaseColumnData();
 };
 
 class DbInterfaceOracle : public IDbInterface, public IDbManagerInterface
@@ -100,6 +120,7 @@ public:
 
 private:
 	dpiConn *connaddr = nullptr;
+	dpiPool *pool = nullptr;	// not owned, set only if the connection was acquired from a session pool
 
 	std::shared_ptr<IDataSourceInfo> data_source_info;
 	std::shared_ptr<IConnectionOptions> connection_opts;
@@ -109,17 +130,25 @@ private:
 	static dpiContext* odpi_global_context;
 	static int odpi_global_context_usage_count;
 
+	// Session pools are shared by all the connections with the same credentials and connect string
+	static std::map<std::string, dpiPool*> odpi_session_pools;
+
 	int last_rc = 0;
 	std::string last_error;
 	std::string last_state;
 
 	std::map<std::string, std::shared_ptr<ICursor>> _declared_cursors;
 	std::map<std::string, std::shared_ptr<OdpiStatementData>> _prepared_stmts;
+	PreparedStatementCache<OdpiStatementData> _prepared_stmt_cache;
 
 	int decode_binary = DECODE_BINARY_DEFAULT;
 
 	bool is_autocommit_suspended = false;
 
+	uint32_t fetch_array_size = DEFAULT_CURSOR_ARRAYSIZE;
+	int prefetch_rows = DEFAULT_PREFETCH_ROWS;
+	int lob_prefetch_size = DEFAULT_LOB_PREFETCH_SIZE;
+
 	int dpiRetrieveError(int rc);
 	void dpiClearError(); 
 	void dpiSetError(int err_code, std::string sqlstate, std::string err_msg); 
@@ -129,6 +158,15 @@ private:
 
 	int _odpi_get_num_rows(dpiStmt *r);
 
+	int set_fetch_options(std::shared_ptr<ICursor> crsr, std::shared_ptr<OdpiStatementData> wk_rs);
+	int define_columns(std::shared_ptr<OdpiStatementData> wk_rs, uint32_t nquery_cols);
+	int get_cursor_option(const std::shared_ptr<ICursor>& crsr, const std::string& opt_name, int default_value);
+
+	dpiPool* get_session_pool(std::shared_ptr<IDataSourceInfo> conn_info, const std::string& conn_string);
+	void log_pool_stats(const std::string& event);
+	void close_connection();
+	static void close_session_pools();
+
 	std::shared_ptr<OdpiStatementData> retrieve_prepared_statement(const std::string& prep_stmt_name);
 	bool is_cursor_from_prepared_statement(const std::shared_ptr<ICursor>& cursor);
 };
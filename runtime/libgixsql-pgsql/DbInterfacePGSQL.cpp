@@ -21,19 +21,21 @@ USA.
 #include <cstring>
 #include <string>
 #include <vector>
+#include <algorithm>
 
 #include "Logger.h"
 #include "DbInterfacePGSQL.h"
 #include "IConnection.h"
 #include "utils.h"
+#include "param_fixup.h"
 #include "cobol_var_flags.h"
+#include "sql_stmt_flags.h"
 
 #define OID_BYTEA	17
 #define OID_NUMERIC 1700
 #define OID_VARCHAR 1043
 
 static std::string __get_trimmed_hostref_or_literal(void* data, int l);
-static std::string pgsql_fixup_parameters(const std::string& sql);
 static std::string pg_get_sqlstate(PGresult* r);
 
 template<typename T>
@@ -108,6 +110,10 @@ DbInterfacePGSQL::DbInterfacePGSQL()
 
 DbInterfacePGSQL::~DbInterfacePGSQL()
 {
+	_prepared_stmt_cache.clear();
+	_prepared_stmt_handles.clear();
+	_static_stmts.clear();
+
 	if (connaddr)
 		PQfinish(connaddr);
 }
@@ -222,21 +228,12 @@ int DbInterfacePGSQL::connect(std::shared_ptr<IDataSourceInfo> _conn_info, std::
 	}
 
 	// Autocommit is set to off. Since PostgreSQL is ALWAYS in autocommit mode 
-	// we will optionally start a transaction
+	// we will optionally start a transaction (with the first statement executed)
+	tx_start_pending = false;
+	deferred_cursor_closes.clear();
 	if (_conn_opts->autocommit == AutoCommitMode::Off) {
-		lib_logger->trace(FMT_FILE_FUNC "PGSQL::connect: autocommit is off, starting initial transaction", __FILE__, __func__);
-
-		PGresultPtr r(PQexec(conn, "BEGIN TRANSACTION"));
-
-		auto rc = PQresultStatus(r.get());
-		if (rc != PGRES_COMMAND_OK) {
-			last_rc = rc;
-			last_error = PQresultErrorMessage(r.get());
-			last_state = pg_get_sqlstate(r.get());
-			lib_logger->error("libpq: {}", last_error);
-			PQfinish(conn);
-			return DBERR_CONNECTION_FAILED;
-		}
+		lib_logger->trace(FMT_FILE_FUNC "PGSQL::connect: autocommit is off, initial transaction will be started with the first statement", __FILE__, __func__);
+		tx_start_pending = true;
 	}
 
 	if (opts.find("decode_binary") != opts.end()) {
@@ -265,6 +262,8 @@ int DbInterfacePGSQL::connect(std::shared_ptr<IDataSourceInfo> _conn_info, std::
 		}
 	}
 
+	_prepared_stmt_cache.setMaxMemory(opts);
+
 	connaddr = conn;
 
 	this->connection_opts = _conn_opts;
@@ -284,6 +283,15 @@ int DbInterfacePGSQL::reset()
 
 int DbInterfacePGSQL::terminate_connection()
 {
+	// The server will take care of these
+	tx_start_pending = false;
+	deferred_cursor_closes.clear();
+	_prepared_stmt_cache.clear();
+	_prepared_stmt_handles.clear();
+	_prepared_stmts.clear();
+	_static_stmts.clear();
+	deferred_deallocates.clear();
+
 	if (connaddr) {
 		PQfinish(connaddr);
 		connaddr = NULL;
@@ -301,8 +309,13 @@ int DbInterfacePGSQL::prepare(const std::string& _stmt_name, const std::string&
 
 	lib_logger->trace(FMT_FILE_FUNC "PGSQL::prepare ({}) - SQL: {}", __FILE__, __func__, stmt_name, query);
 
-	if (_prepared_stmts.find(stmt_name) != _prepared_stmts.end()) {
-		return DBERR_PREPARE_FAILED;
+	// The same text has already been prepared and the statement is not in use by another name: reuse it
+	std::shared_ptr<PGPreparedStatement> ps = _prepared_stmt_cache.find(query, stmt_name, _prepared_stmt_handles);
+	if (ps) {
+		lib_logger->trace(FMT_FILE_FUNC "PGSQL::prepare ({}) - reusing cached statement {}", __FILE__, __func__, stmt_name, ps->server_name);
+		_prepared_stmt_handles[stmt_name] = ps;
+		_prepared_stmts[stmt_name] = nullptr;
+		return DBERR_NO_ERROR;
 	}
 
 	if (connection_opts->fixup_parameters) {
@@ -314,7 +327,9 @@ int DbInterfacePGSQL::prepare(const std::string& _stmt_name, const std::string&
 		prepared_sql = query;
 	}
 
-	PGresult* res = PQprepare(connaddr, stmt_name.c_str(), prepared_sql.c_str(), 0, nullptr);
+	ps = new_prepared_statement(prepared_sql);
+
+	PGresult* res = PQprepare(connaddr, ps->server_name.c_str(), prepared_sql.c_str(), 0, nullptr);
 
 	last_rc = PQresultStatus(res);
 	last_error = PQresultErrorMessage(res);
@@ -327,11 +342,168 @@ int DbInterfacePGSQL::prepare(const std::string& _stmt_name, const std::string&
 		return DBERR_PREPARE_FAILED;
 	}
 
+	ps->is_prepared = true;
+
+	// If the name was already in use, the statement it was bound to is deallocated, unless still cached
+	_prepared_stmt_handles[stmt_name] = ps;
+	_prepared_stmt_cache.add(query, ps);
+
 	_prepared_stmts[stmt_name] = nullptr;	// for now we just track it, the actual result will be stored later
 
 	return DBERR_NO_ERROR;
 }
 
+std::shared_ptr<PGPreparedStatement> DbInterfacePGSQL::new_prepared_statement(const std::string& source)
+{
+	PGPreparedStatement* ps = new PGPreparedStatement();
+	ps->server_name = "gixsql_ps_" + std::to_string(++prepared_stmt_seq);
+	ps->source = source;
+
+	return std::shared_ptr<PGPreparedStatement>(ps, [this](PGPreparedStatement* p) {
+		if (p->is_prepared && connaddr)
+			deferred_deallocates.push_back(p->server_name);
+		delete p;
+	});
+}
+
+// Static statements are prepared with the parameter types they will be executed with, so that
+// _pgsql_exec_params can execute them by name. If supported by libpq, they are all sent in a pipeline
+int DbInterfacePGSQL::prepare_static(const std::vector<std::shared_ptr<StaticStatementInfo>>& stmts)
+{
+	std::vector<std::shared_ptr<PGPreparedStatement>> pstmts;
+
+	for (const auto& s : stmts) {
+		// Cursors are opened with DECLARE ... CURSOR FOR <query> and never use a prepared statement
+		if (s->is_cursor || _static_stmts.find(s->query) != _static_stmts.end() || s->param_types.size() != s->param_flags.size())
+			continue;
+
+		std::shared_ptr<PGPreparedStatement> ps = new_prepared_statement(s->query);
+		for (size_t i = 0; i < s->param_types.size(); i++) {
+			ps->param_types.push_back(get_pgsql_type(s->param_types.at(i), s->param_flags.at(i)));
+		}
+		pstmts.push_back(ps);
+	}
+
+	if (pstmts.empty())
+		return DBERR_NO_ERROR;
+
+	int rc = DBERR_NO_ERROR;
+	auto check_result = [this, &rc](const std::shared_ptr<PGPreparedStatement>& ps, PGresult* r) {
+		if (PQresultStatus(r) == PGRES_COMMAND_OK) {
+			ps->is_prepared = true;
+			_static_stmts[ps->source] = ps;
+		}
+		else {
+			last_rc = -(10000 + PQresultStatus(r));
+			last_error = PQresultErrorMessage(r);
+			last_state = pg_get_sqlstate(r);
+			lib_logger->warn("PGSQL: cannot prepare static statement: {} ({}) - {}", last_rc, last_error, ps->source);
+			rc = DBERR_PREPARE_FAILED;
+		}
+	};
+
+#if defined(LIBPQ_HAS_PIPELINING)
+	if (PQenterPipelineMode(connaddr)) {
+		for (const auto& ps : pstmts) {
+			PQsendPrepare(connaddr, ps->server_name.c_str(), ps->source.c_str(), ps->param_types.size(), ps->param_types.data());
+		}
+		PQpipelineSync(connaddr);
+
+		// Each statement's result is followed by a NULL, the sync point ends the pipeline
+		int n = 0;
+		while (n <= pstmts.size() && PQstatus(connaddr) == CONNECTION_OK) {
+			PGresult* r = PQgetResult(connaddr);
+			if (!r) {
+				n++;
+				continue;
+			}
+
+			if (PQresultStatus(r) == PGRES_PIPELINE_SYNC) {
+				PQclear(r);
+				break;
+			}
+
+			if (n < pstmts.size())
+				check_result(pstmts.at(n), r);
+
+			PQclear(r);
+		}
+
+		PQexitPipelineMode(connaddr);
+
+		lib_logger->trace(FMT_FILE_FUNC "PGSQL: {} static statement(s) prepared", __FILE__, __func__, _static_stmts.size());
+		return rc;
+	}
+#endif
+
+	for (const auto& ps : pstmts) {
+		PGresultPtr r(PQprepare(connaddr, ps->server_name.c_str(), ps->source.c_str(), ps->param_types.size(), ps->param_types.data()));
+		check_result(ps, r.get());
+	}
+
+	lib_logger->trace(FMT_FILE_FUNC "PGSQL: {} static statement(s) prepared", __FILE__, __func__, _static_stmts.size());
+	return rc;
+}
+
+// EXPLAIN (without ANALYZE) does not execute the statement. The plan is retrieved with the actual parameter
+// values; if a transaction is in progress, a savepoint keeps a failure from aborting it
+int DbInterfacePGSQL::explain(const std::string& query, const std::vector<CobolVarType>& paramTypes, const std::vector<std_binary_data>& paramValues, const std::vector<unsigned long>& paramLengths, const std::vector<uint32_t>& paramFlags, std::string& plan)
+{
+	if (!connaddr)
+		return DBERR_CONN_NOT_FOUND;
+
+	if (paramTypes.size() != paramValues.size() || paramTypes.size() != paramFlags.size() || paramLengths.size() != paramValues.size())
+		return DBERR_INTERNAL_ERR;
+
+	std::unique_ptr<pgsqlParamArray> param_vals = std::make_unique<pgsqlParamArray>(paramValues.size());
+	std::unique_ptr<Oid[]> param_types = std::make_unique<Oid[]>(paramTypes.size());
+	std::unique_ptr<int[]> param_lengths = std::make_unique<int[]>(paramLengths.size());
+	std::unique_ptr<int[]> param_formats = std::make_unique<int[]>(paramFlags.size());
+
+	for (int i = 0; i < paramValues.size(); i++) {
+		if (paramLengths.at(i) != DB_NULL) {
+			param_vals->assign(i, (char*)paramValues[i].data(), paramLengths[i]);
+			param_lengths[i] = paramLengths.at(i);
+		}
+		else {
+			param_vals->assign(i, nullptr, 0);
+			param_lengths[i] = 0;
+		}
+		param_types[i] = get_pgsql_type(paramTypes.at(i), paramFlags[i]);
+		param_formats[i] = CBL_FIELD_IS_BINARY(paramFlags[i]) ? 1 : 0;
+	}
+
+	bool in_tx = PQtransactionStatus(connaddr) == PQTRANS_INTRANS;
+	if (in_tx) {
+		PGresult* r = PQexec(connaddr, "SAVEPOINT gixsql_explain");
+		bool ok = PQresultStatus(r) == PGRES_COMMAND_OK;
+		PQclear(r);
+		if (!ok)
+			return DBERR_SQL_ERROR;
+	}
+
+	int rc = DBERR_NO_ERROR;
+	std::string explain_query = "EXPLAIN (FORMAT JSON) " + query;
+	PGresult* r = PQexecParams(connaddr, explain_query.c_str(), paramValues.size(), param_types.get(), param_vals->data(), param_lengths.get(), param_formats.get(), 0);
+	if (PQresultStatus(r) == PGRES_TUPLES_OK) {
+		for (int i = 0; i < PQntuples(r); i++) {
+			plan += PQgetvalue(r, i, 0);
+		}
+	}
+	else {
+		lib_logger->warn("PostgreSQL: cannot retrieve the execution plan: {}", PQresultErrorMessage(r));
+		rc = DBERR_SQL_ERROR;
+	}
+	PQclear(r);
+
+	if (in_tx) {
+		r = PQexec(connaddr, (rc == DBERR_NO_ERROR) ? "RELEASE SAVEPOINT gixsql_explain" : "ROLLBACK TO SAVEPOINT gixsql_explain; RELEASE SAVEPOINT gixsql_explain");
+		PQclear(r);
+	}
+
+	return rc;
+}
+
 int DbInterfacePGSQL::exec_prepared(const std::string& _stmt_name, std::vector<CobolVarType> paramTypes, std::vector<std_binary_data>& paramValues, std::vector<unsigned long> paramLengths, const std::vector<uint32_t>& paramFlags)
 {
 	lib_logger->trace(FMT_FILE_FUNC "statement name: {}", __FILE__, __func__, _stmt_name);
@@ -379,9 +551,14 @@ int DbInterfacePGSQL::exec_prepared(const std::string& _stmt_name, std::vector<C
 
 	int ret = DBERR_NO_ERROR;
 
+	bool start_tx = false;
+	exec_deferred_statements(std::string(), start_tx);
+	if (start_tx && start_transaction() != DBERR_NO_ERROR)
+		return DBERR_SQL_ERROR;
+
 	std::shared_ptr<PGResultSetData> wk_rs = std::make_shared<PGResultSetData>();
 
-	wk_rs->resultset = PQexecPrepared(connaddr, stmt_name.c_str(), paramValues.size(), param_vals->data(), param_lengths.get(), param_formats.get(), 0);
+	wk_rs->resultset = PQexecPrepared(connaddr, _prepared_stmt_handles[stmt_name]->server_name.c_str(), paramValues.size(), param_vals->data(), param_lengths.get(), param_formats.get(), 0);
 
 	last_rc = PQresultStatus(wk_rs->resultset);
 	last_error = PQresultErrorMessage(wk_rs->resultset);
@@ -418,34 +595,46 @@ int DbInterfacePGSQL::_pgsql_exec(const std::shared_ptr<ICursor>& crsr, const st
 		current_resultset_data.reset();
 	}
 
+	bool start_tx = false;
+	if (!exec_deferred_statements(query, start_tx)) {
+		// COMMIT/ROLLBACK with no transaction started: nothing to do
+		current_resultset_data.reset();
+		pgsqlClearError();
+		return DBERR_NO_ERROR;
+	}
+
 	wk_rs = std::make_shared<PGResultSetData>();
-	wk_rs->resultset = PQexecParams(connaddr, query.c_str(), 0, NULL, NULL, NULL, NULL, 0);
+	if (!start_tx) {
+		wk_rs->resultset = PQexecParams(connaddr, query.c_str(), 0, NULL, NULL, NULL, NULL, 0);
+	}
+	else {
+		// The new transaction is started together with this statement (simple query protocol),
+		// only the result of the last statement is returned unless an error occurs
+		lib_logger->trace(FMT_FILE_FUNC "starting deferred transaction", __FILE__, __func__);
+		wk_rs->resultset = PQexec(connaddr, ("START TRANSACTION; " + query).c_str());
+	}
 
 	last_rc = PQresultStatus(wk_rs->resultset);
 	last_error = PQresultErrorMessage(wk_rs->resultset);
 	last_state = pg_get_sqlstate(wk_rs->resultset);
 
 	// we trap COMMIT/ROLLBACK
-	if (connection_opts->autocommit == AutoCommitMode::Off && is_tx_termination_statement(query)) {
+	if (is_tx_end_statement(query)) {
 		
 		// we clean up: whether the COMMIT/ROLLBACK failed or not this is probably useless anyway
 		current_resultset_data.reset();
 
-		if (last_rc == PGRES_COMMAND_OK) {	// COMMIT/ROLLBACK succeeded, we try to start a new transaction
-			lib_logger->trace(FMT_FILE_FUNC "autocommit mode is disabled, trying to start a new transaction", __FILE__, __func__);
-			auto new_tx_rs = PQexec(connaddr, "START TRANSACTION");
-			last_rc = PQresultStatus(new_tx_rs);
-			last_error = PQresultErrorMessage(new_tx_rs);
-			last_state = pg_get_sqlstate(new_tx_rs);
-			lib_logger->trace(FMT_FILE_FUNC "transaction start result: {} ({})", __FILE__, __func__, last_error, last_state);
-			return (last_rc != PGRES_COMMAND_OK) ? DBERR_SQL_ERROR : DBERR_NO_ERROR;
+		if (last_rc == PGRES_COMMAND_OK) {	// COMMIT/ROLLBACK succeeded, a new transaction will be started with the next statement
+			lib_logger->trace(FMT_FILE_FUNC "autocommit mode is disabled, new transaction start deferred", __FILE__, __func__);
+			tx_start_pending = true;
+			return DBERR_NO_ERROR;
 		}
 
 		// if COMMIT/ROLLBACK failed, the error code/state is already set, it will be handled below
 	}
 
 	if (last_rc == PGRES_COMMAND_OK) {
-		if (is_update_or_delete_statement(query)) {
+		if (is_update_or_delete(query)) {
 			int nrows = get_num_rows(wk_rs->resultset);
 			if (nrows <= 0) {
 				last_rc = 100;
@@ -513,8 +702,30 @@ int DbInterfacePGSQL::_pgsql_exec_params(const std::shared_ptr<ICursor>& crsr, c
 		current_resultset_data.reset();
 	}
 
+	// Statements with parameters cannot be sent together with other ones,
+	// so a deferred transaction start (if any) is executed separately
+	bool start_tx = false;
+	if (!exec_deferred_statements(query, start_tx)) {
+		pgsqlClearError();
+		return DBERR_NO_ERROR;
+	}
+
+	if (start_tx && start_transaction() != DBERR_NO_ERROR)
+		return DBERR_SQL_ERROR;
+
+	// Static statements prepared in advance are executed by name, as long as the parameter types are the same
+	std::shared_ptr<PGPreparedStatement> static_stmt;
+	auto it_static = _static_stmts.find(query);
+	if (it_static != _static_stmts.end() && it_static->second->param_types.size() == paramTypes.size()
+		&& std::equal(it_static->second->param_types.begin(), it_static->second->param_types.end(), param_types.get())) {
+		static_stmt = it_static->second;
+	}
+
 	wk_rs = std::make_shared<PGResultSetData>();
-	wk_rs->resultset = PQexecParams(connaddr, query.c_str(), paramValues.size(), param_types.get(), param_vals->data(), param_lengths.get(), param_formats.get(), 0);
+	if (static_stmt)
+		wk_rs->resultset = PQexecPrepared(connaddr, static_stmt->server_name.c_str(), paramValues.size(), param_vals->data(), param_lengths.get(), param_formats.get(), 0);
+	else
+		wk_rs->resultset = PQexecParams(connaddr, query.c_str(), paramValues.size(), param_types.get(), param_vals->data(), param_lengths.get(), param_formats.get(), 0);
 	wk_rs->num_rows = get_num_rows(wk_rs->resultset);
 
 	last_rc = PQresultStatus(wk_rs->resultset);
@@ -522,26 +733,22 @@ int DbInterfacePGSQL::_pgsql_exec_params(const std::shared_ptr<ICursor>& crsr, c
 	last_state = pg_get_sqlstate(wk_rs->resultset);
 
 	// we trap COMMIT/ROLLBACK
-	if (connection_opts->autocommit == AutoCommitMode::Off && is_tx_termination_statement(query)) {
+	if (is_tx_end_statement(query)) {
 
 		// we clean up: if the COMMIT/ROLLBACK failed this is probably useless anyway
 		current_resultset_data.reset();
 
-		if (last_rc == PGRES_COMMAND_OK) {	// COMMIT/ROLLBACK succeeded, we try to start a new transaction
-			lib_logger->trace(FMT_FILE_FUNC "autocommit mode is disabled, trying to start a new transaction", __FILE__, __func__);
-			auto new_tx_rs = PQexec(connaddr, "START TRANSACTION");
-			last_rc = PQresultStatus(new_tx_rs);
-			last_error = PQresultErrorMessage(new_tx_rs);
-			last_state = pg_get_sqlstate(new_tx_rs);
-			lib_logger->trace(FMT_FILE_FUNC "transaction start result: {} ({})", __FILE__, __func__, last_error, last_state);
-			return (last_rc != PGRES_COMMAND_OK) ? DBERR_SQL_ERROR : DBERR_NO_ERROR;
+		if (last_rc == PGRES_COMMAND_OK) {	// COMMIT/ROLLBACK succeeded, a new transaction will be started with the next statement
+			lib_logger->trace(FMT_FILE_FUNC "autocommit mode is disabled, new transaction start deferred", __FILE__, __func__);
+			tx_start_pending = true;
+			return DBERR_NO_ERROR;
 		}
 
 		// if COMMIT/ROLLBACK failed, the error code/state is already set, it will be handled below
 	}
 
 	if (last_rc == PGRES_COMMAND_OK) {
-		if (is_update_or_delete_statement(query)) {
+		if (is_update_or_delete(query)) {
 			if (wk_rs->num_rows <= 0) {
 				last_rc = 100;
 				return DBERR_SQL_ERROR;
@@ -572,9 +779,11 @@ int DbInterfacePGSQL::cursor_close(const std::shared_ptr<ICursor>& cursor)
 	if (!cursor)
 		return DBERR_CLOSE_CURSOR_FAILED;
 
+	// The CLOSE statement is sent before the next statement: if that is a COMMIT/ROLLBACK
+	// (e.g. when the runtime closes all the cursors before ending a transaction)
+	// it is not needed at all, since the server closes the cursor anyway
 	if (use_native_cursors) {
-		std::string query = "CLOSE " + cursor->getName();
-		int rc = exec(query);
+		deferred_cursor_closes.push_back(std::make_tuple(cursor->getName(), cursor->isWithHold()));
 	}
 
 	if (cursor->getPrivateData()) {
@@ -584,6 +793,93 @@ int DbInterfacePGSQL::cursor_close(const std::shared_ptr<ICursor>& cursor)
 	return (rc == DBERR_NO_ERROR) ? DBERR_NO_ERROR : DBERR_CLOSE_CURSOR_FAILED;
 }
 
+// Statement classification: the flags from the preprocessor are used if available, otherwise the statement text is inspected
+bool DbInterfacePGSQL::is_tx_end_statement(const std::string& query)
+{
+	if (connection_opts->autocommit != AutoCommitMode::Off)
+		return false;
+
+	if (SQL_STMT_HAS_FLAGS(stmt_flags))
+		return SQL_STMT_IS_TX_END(stmt_flags);
+
+	return is_tx_termination_statement(query) && to_upper(query).find(" TO ") == std::string::npos;
+}
+
+bool DbInterfacePGSQL::is_update_or_delete(const std::string& query)
+{
+	return SQL_STMT_HAS_FLAGS(stmt_flags) ? SQL_STMT_IS_UPDATE_OR_DELETE(stmt_flags) : is_update_or_delete_statement(query);
+}
+
+// Executes the statements that have been deferred until the given one is executed. Each CLOSE and
+// DEALLOCATE is sent on its own and, as when it was executed immediately, its result is ignored, so it
+// cannot affect the status of the given statement. A pending transaction start is not executed here,
+// start_tx is set instead. If the return value is false the statement itself does not need to be executed
+// (a COMMIT/ROLLBACK with no active transaction)
+bool DbInterfacePGSQL::exec_deferred_statements(const std::string& query, bool& start_tx)
+{
+	bool is_tx_end = is_tx_end_statement(query);
+
+	start_tx = false;
+
+	for (auto c : deferred_cursor_closes) {
+		// cursors without WITH HOLD are closed by the server at the end of the transaction
+		if (is_tx_end && !std::get<1>(c))
+			continue;
+
+		std::string close_stmt = "CLOSE " + std::get<0>(c);
+		lib_logger->trace(FMT_FILE_FUNC "executing deferred statement: {}", __FILE__, __func__, close_stmt);
+		PGresultPtr r(PQexecParams(connaddr, close_stmt.c_str(), 0, NULL, NULL, NULL, NULL, 0));
+	}
+	deferred_cursor_closes.clear();
+
+	// not before a COMMIT/ROLLBACK: in an aborted transaction they would fail anyway
+	if (!is_tx_end) {
+		for (auto n : deferred_deallocates)
+			release_prepared_statement(n);
+		deferred_deallocates.clear();
+	}
+
+	if (tx_start_pending) {
+		// we do not start a transaction just to end it
+		if (is_tx_end)
+			return false;
+
+		tx_start_pending = false;
+		start_tx = !is_begin_transaction_statement(query);
+	}
+
+	return true;
+}
+
+int DbInterfacePGSQL::start_transaction()
+{
+	lib_logger->trace(FMT_FILE_FUNC "starting deferred transaction", __FILE__, __func__);
+
+	PGresultPtr r(PQexec(connaddr, "START TRANSACTION"));
+	auto rc = PQresultStatus(r.get());
+	if (rc != PGRES_COMMAND_OK) {
+		last_rc = -(10000 + rc);
+		last_error = PQresultErrorMessage(r.get());
+		last_state = pg_get_sqlstate(r.get());
+		lib_logger->error("ERROR ({} - {}): {}", last_rc, last_state, last_error);
+		return DBERR_SQL_ERROR;
+	}
+
+	return DBERR_NO_ERROR;
+}
+
+// Releases a server-side prepared statement evicted from the cache, the result is ignored
+void DbInterfacePGSQL::release_prepared_statement(const std::string& server_name)
+{
+	lib_logger->trace(FMT_FILE_FUNC "releasing prepared statement {}", __FILE__, __func__, server_name);
+
+#if defined(LIBPQ_HAS_CLOSE_PREPARED)
+	PGresultPtr r(PQclosePrepared(connaddr, server_name.c_str()));
+#else
+	PGresultPtr r(PQexec(connaddr, ("DEALLOCATE " + server_name).c_str()));
+#endif
+}
+
 int DbInterfacePGSQL::cursor_declare(const std::shared_ptr<ICursor>& cursor)
 {
 	if (!cursor)
@@ -951,54 +1247,6 @@ static std::string pg_get_sqlstate(PGresult* r)
 }
 
 
-static std::string pgsql_fixup_parameters(const std::string& sql)
-{
-	int n = 1;
-	bool in_single_quoted_string = false;
-	bool in_double_quoted_string = false;
-	bool in_param_id = false;
-	std::string out_sql;
-
-	for (auto itc = sql.begin(); itc != sql.end(); ++itc) {
-		char c = *itc;
-
-		if (in_param_id && isalnum(c))
-			continue;
-		else {
-			in_param_id = false;
-		}
-
-		switch (c) {
-		case '"':
-			out_sql += c;
-			in_double_quoted_string = !in_double_quoted_string;
-			continue;
-
-		case '\'':
-			out_sql += c;
-			in_single_quoted_string = !in_single_quoted_string;
-			continue;
-
-		case '?':
-		case ':':
-			if (!in_single_quoted_string && !in_double_quoted_string) {
-				out_sql += ("$" + std::to_string(n++));
-				in_param_id = true;
-			}
-			else
-				out_sql += c;
-			continue;
-
-		default:
-			out_sql += c;
-
-		}
-	}
-
-	return out_sql;
-}
-
-
 const char* DbInterfacePGSQL::get_error_message()
 {
 	if (current_resultset_data != NULL)
@@ -1038,37 +1286,16 @@ bool DbInterfacePGSQL::retrieve_prepared_statement_source(const std::string& pre
 {
 	lib_logger->trace(FMT_FILE_FUNC "Retrieving SQL source for prepared statement {}", __FILE__, __func__, prep_stmt_name);
 
-	auto pvals = std::make_unique<char*[]>(1);
-	pvals[0] = (char*)prep_stmt_name.c_str();
-
-	std::string qry = "select statement from pg_prepared_statements where lower(name) = lower($1)";
-	
-	PGresultPtr tr(PQexecParams(connaddr, qry.c_str(), 1, NULL, pvals.get(), NULL, NULL, 0));
-
-	last_rc = PQresultStatus(tr.get());
-	last_error = PQresultErrorMessage(tr.get());
-	last_state = pg_get_sqlstate(tr.get());
-
-	if (last_rc == PGRES_TUPLES_OK) {
-		if (PQntuples(tr.get()) != 1) {
-			last_rc = 42704;
-			last_error = "\"" + prep_stmt_name + "\" not found";
-			last_state = "42704";
-			lib_logger->error("Cannot retrieve prepared statement source: {}", last_error);
-			return false;
-		}
-
-		const char* res = PQgetvalue(tr.get(), 0, 0);
-		if (!res) {
-			last_rc = PQresultStatus(tr.get());
-			last_error = PQresultErrorMessage(tr.get());
-			last_state = pg_get_sqlstate(tr.get());
-			lib_logger->error("Cannot retrieve prepared statement source: {}", last_error);
-			return false;
-		}
-		src = res;
-		return true;
+	// The source is kept with the statement, so there is no need to query pg_prepared_statements
+	auto it = _prepared_stmt_handles.find(to_lower(prep_stmt_name));
+	if (it == _prepared_stmt_handles.end()) {
+		last_rc = 42704;
+		last_error = "\"" + prep_stmt_name + "\" not found";
+		last_state = "42704";
+		lib_logger->error("Cannot retrieve prepared statement source: {}", last_error);
+		return false;
 	}
 
-	return false;
+	src = it->second->source;
+	return true;
 }
\ No newline at end of file
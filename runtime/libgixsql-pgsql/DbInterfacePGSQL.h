@@ -33,6 +33,7 @@ USA.
 #include "IDbManagerInterface.h"
 #include "IDataSourceInfo.h"
 #include "ISchemaManager.h"
+#include "PreparedStatementCache.h"
 #include "cobol_var_types.h"
 
 #define DECODE_BINARY_ON		1
@@ -50,6 +51,15 @@ struct PGResultSetData : public IPrivateStatementData {
 
 // struct PGResultSetData_Deleter;
 
+// Server-side prepared statement: since it can be cached and reused under another statement name,
+// its server-side name is generated
+struct PGPreparedStatement {
+	std::string server_name;
+	std::string source;
+	std::vector<Oid> param_types;
+	bool is_prepared = false;
+};
+
 class DbInterfacePGSQL : public IDbInterface, public IDbManagerInterface
 {
 public:
@@ -76,6 +86,8 @@ public:
 	virtual std::string get_state() override;
 	virtual int prepare(const std::string& stmt_name, const std::string& query) override;
 	virtual int exec_prepared(const std::string& stmt_name, std::vector<CobolVarType> paramTypes, std::vector<std_binary_data>& paramValues, std::vector<unsigned long> paramLengths, const std::vector<uint32_t>& paramFlags) override;
+	virtual int prepare_static(const std::vector<std::shared_ptr<StaticStatementInfo>>& stmts) override;
+	virtual int explain(const std::string& query, const std::vector<CobolVarType>& paramTypes, const std::vector<std_binary_data>& paramValues, const std::vector<unsigned long>& paramLengths, const std::vector<uint32_t>& paramFlags, std::string& plan) override;
 	virtual DbPropertySetResult set_property(DbProperty p, std::variant<bool, int, std::string> v) override;
 
 	virtual bool getSchemas(std::vector<SchemaInfo*>& res) override;
@@ -113,5 +125,29 @@ private:
 	Oid get_pgsql_type(CobolVarType t, uint32_t flags);
 
 	bool use_native_cursors = true;
+
+	// Statements whose execution is deferred until the next statement is executed:
+	// the start of a new transaction after a COMMIT/ROLLBACK (autocommit off) and
+	// CLOSE statements for native cursors (cursor name, WITH HOLD)
+	bool tx_start_pending = false;
+	std::vector<std::tuple<std::string, bool>> deferred_cursor_closes;
+
+	bool exec_deferred_statements(const std::string& query, bool& start_tx);
+	int start_transaction();
+
+	// Prepared statements that are not referenced anymore are deallocated before the next statement
+	std::vector<std::string> deferred_deallocates;
+	void release_prepared_statement(const std::string& server_name);
+	std::map<std::string, std::shared_ptr<PGPreparedStatement>> _prepared_stmt_handles;
+	PreparedStatementCache<PGPreparedStatement> _prepared_stmt_cache;
+	uint64_t prepared_stmt_seq = 0;
+
+	std::shared_ptr<PGPreparedStatement> new_prepared_statement(const std::string& source);
+
+	// Static statements prepared in advance (see prepare_static), by SQL text
+	std::map<std::string, std::shared_ptr<PGPreparedStatement>> _static_stmts;
+
+	bool is_tx_end_statement(const std::string& query);
+	bool is_update_or_delete(const std::string& query);
 };
 
@@ -26,11 +26,33 @@ USA.
 #include "utils.h"
 #include "varlen_defs.h"
 #include "cobol_var_flags.h"
+#include "sql_stmt_flags.h"
+#include "sql_stmt_utils.h"
 
 #define DEFAULT_CURSOR_ARRAYSIZE	100
 
 static std::string __get_trimmed_hostref_or_literal(void* data, int l);
 static std::string sqlite_fixup_parameters(const std::string& sql);
+static bool is_valid_pragma_value(const std::string& v);
+
+// Pragmas that can be set through the connection string, in the order they are applied
+// (page_size must come first, since it only has effect before the database is populated)
+static const char* supported_pragmas[] = { "page_size", "journal_mode", "synchronous", "locking_mode", "cache_size", "mmap_size", "temp_store" };
+
+// Preset profiles: values explicitly passed in the connection string take precedence
+static const std::map<std::string, std::map<std::string, std::string>> pragma_profiles = {
+	{ "bulkload", {
+		{ "journal_mode", "WAL" },
+		{ "synchronous", "NORMAL" },
+		{ "locking_mode", "EXCLUSIVE" },
+		{ "cache_size", "-65536" },		// 64 MB
+		{ "temp_store", "MEMORY" }
+	} },
+	{ "readonly", {
+		{ "mmap_size", "268435456" },	// 256 MB
+		{ "temp_store", "MEMORY" }
+	} }
+};
 
 DbInterfaceSQLite::DbInterfaceSQLite()
 {}
@@ -65,9 +87,25 @@ int DbInterfaceSQLite::connect(std::shared_ptr<IDataSourceInfo> _conn_info, std:
 	connaddr = nullptr;
 	current_statement_data.reset();
 
-	int sqlite_rc = sqlite3_open(_conn_info->getHost().c_str(), &conn);
+	auto opts = _conn_info->getOptions();
+
+	std::string profile;
+	if (opts.find("profile") != opts.end()) {
+		profile = to_lower(opts["profile"]);
+		if (pragma_profiles.find(profile) == pragma_profiles.end()) {
+			lib_logger->error("SQLite: unknown profile: {}", profile);
+			return DBERR_CONNECTION_FAILED;
+		}
+		lib_logger->trace(FMT_FILE_FUNC "SQLite::connect: using profile {}", __FILE__, __func__, profile);
+	}
+
+	int open_flags = (profile == "readonly") ? SQLITE_OPEN_READONLY : (SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE);
+
+	int sqlite_rc = sqlite3_open_v2(_conn_info->getHost().c_str(), &conn, open_flags, nullptr);
 
 	if (sqlite_rc != SQLITE_OK || conn == NULL) {
+		if (conn)
+			sqlite3_close_v2(conn);
 		return DBERR_CONNECTION_FAILED;
 	}
 
@@ -81,19 +119,21 @@ int DbInterfaceSQLite::connect(std::shared_ptr<IDataSourceInfo> _conn_info, std:
 		}
 	}
 
-	// Autocommit is set to off. Since PostgreSQL is ALWAYS in autocommit mode 
-	// we will optionally start a transaction
+	// Some pragmas (e.g. journal_mode) cannot be changed inside a transaction,
+	// so they must be applied before the initial one is started
+	if (apply_pragmas(conn, opts, profile) != DBERR_NO_ERROR) {
+		sqlite3_close_v2(conn);
+		return DBERR_CONNECTION_FAILED;
+	}
+
+	// Autocommit is set to off. Since SQLite is ALWAYS in autocommit mode 
+	// we will optionally start a transaction (with the first statement executed)
+	tx_start_pending = false;
 	if (_conn_opts->autocommit == AutoCommitMode::Off) {
-		lib_logger->trace(FMT_FILE_FUNC "SQLite::connect: autocommit is off, starting initial transaction", __FILE__, __func__);
-		auto rc = sqlite3_exec(conn, "BEGIN TRANSACTION", 0, 0, &err_msg);
-		if (sqliteRetrieveError(rc) != SQLITE_OK) {
-			lib_logger->error("SQLite: cannot start transaction: {} ({}): {}", last_rc, last_state, last_error);
-			sqlite3_close_v2(conn);
-			return DBERR_CONNECTION_FAILED;
-		}
+		lib_logger->trace(FMT_FILE_FUNC "SQLite::connect: autocommit is off, initial transaction will be started with the first statement", __FILE__, __func__);
+		tx_start_pending = true;
 	}
 
-	auto opts = _conn_info->getOptions();
 	if (opts.find("updatable_cursors") != opts.end()) {
 		std::string opt_updatable_cursors = opts["updatable_cursors"];
 		if (!opt_updatable_cursors.empty()) {
@@ -112,6 +152,8 @@ int DbInterfaceSQLite::connect(std::shared_ptr<IDataSourceInfo> _conn_info, std:
 	else
 		lib_logger->trace(FMT_FILE_FUNC "SQLite::updatable cursor support is disabled", __FILE__, __func__);
 
+	_prepared_stmt_cache.setMaxMemory(opts);
+
 	connaddr = conn;
 	sqlite3_extended_result_codes(connaddr, 1);
 
@@ -121,6 +163,46 @@ int DbInterfaceSQLite::connect(std::shared_ptr<IDataSourceInfo> _conn_info, std:
 	return DBERR_NO_ERROR;
 }
 
+int DbInterfaceSQLite::apply_pragmas(sqlite3* conn, const std::map<std::string, std::string>& opts, const std::string& profile)
+{
+	for (auto pragma : supported_pragmas) {
+		std::string v;
+
+		auto it = opts.find(pragma);
+		if (it != opts.end()) {
+			v = it->second;
+		}
+		else {
+			if (!profile.empty()) {
+				auto& pv = pragma_profiles.at(profile);
+				if (pv.find(pragma) != pv.end())
+					v = pv.at(pragma);
+			}
+		}
+
+		if (v.empty())
+			continue;
+
+		if (!is_valid_pragma_value(v)) {
+			lib_logger->error("SQLite: invalid value for {}: {}", pragma, v);
+			return DBERR_CONNECTION_FAILED;
+		}
+
+		std::string sql = std::string("PRAGMA ") + pragma + " = " + v + ";";
+		lib_logger->trace(FMT_FILE_FUNC "SQLite::connect: {}", __FILE__, __func__, sql);
+
+		char* err_msg = 0;
+		int rc = sqlite3_exec(conn, sql.c_str(), 0, 0, &err_msg);
+		if (rc != SQLITE_OK) {
+			lib_logger->error("SQLite: cannot set {} to {}: {}", pragma, v, err_msg ? err_msg : "");
+			sqlite3_free(err_msg);
+			return DBERR_CONNECTION_FAILED;
+		}
+	}
+
+	return DBERR_NO_ERROR;
+}
+
 int DbInterfaceSQLite::reset()
 {
 	int rc = terminate_connection();
@@ -133,6 +215,14 @@ int DbInterfaceSQLite::reset()
 int DbInterfaceSQLite::terminate_connection()
 {
 	spdlog::trace("terminating connection");
+
+	// All statements must be finalized before the connection is actually closed
+	current_statement_data.reset();
+	_updatable_crsr_stmts.clear();
+	_table_unique_keys.clear();
+	_prepared_stmt_cache.clear();
+	_prepared_stmts.clear();
+
 	if (connaddr) {
 		sqlite3_close_v2(connaddr);
 		connaddr = nullptr;
@@ -173,16 +263,20 @@ std::string vector_join(const std::vector<std::string>& v, char sep)
 int DbInterfaceSQLite::prepare(const std::string& _stmt_name, const std::string& query)
 {
 	std::string prepared_sql;
-	std::shared_ptr<SQLiteStatementData> res = std::make_shared<SQLiteStatementData>();
-
 	std::string stmt_name = to_lower(_stmt_name);
 
 	lib_logger->trace(FMT_FILE_FUNC "SQLite::prepare ({}) - SQL: {}", __FILE__, __func__, stmt_name, query);
 
-	if (this->_prepared_stmts.find(stmt_name) != _prepared_stmts.end()) {
-		return DBERR_PREPARE_FAILED;
+	// The same text has already been prepared and the statement is not in use by another name: reuse it
+	std::shared_ptr<SQLiteStatementData> res = _prepared_stmt_cache.find(query, stmt_name, _prepared_stmts);
+	if (res) {
+		lib_logger->trace(FMT_FILE_FUNC "SQLite::prepare ({}) - reusing cached statement", __FILE__, __func__, stmt_name);
+		_prepared_stmts[stmt_name] = res;
+		return DBERR_NO_ERROR;
 	}
 
+	res = std::make_shared<SQLiteStatementData>();
+
 	if (connection_opts->fixup_parameters) {
 		prepared_sql = sqlite_fixup_parameters(query);
 		lib_logger->trace(FMT_FILE_FUNC "SQLite::fixup parameters is on", __FILE__, __func__);
@@ -194,7 +288,7 @@ int DbInterfaceSQLite::prepare(const std::string& _stmt_name, const std::string&
 
 	lib_logger->trace(FMT_FILE_FUNC "SQLite::prepare ({}) - SQL(P): {}", __FILE__, __func__, stmt_name, prepared_sql);
 
-	int rc = sqlite3_prepare_v2(connaddr, query.c_str(), query.size(), &res->statement, nullptr);
+	int rc = sqlite3_prepare_v3(connaddr, query.c_str(), query.size(), SQLITE_PREPARE_PERSISTENT, &res->statement, nullptr);
 	if (sqliteRetrieveError(rc) != SQLITE_OK) {
 		lib_logger->error(FMT_FILE_FUNC "SQLite::prepare ({} - res: ({}) {}", __FILE__, __func__, stmt_name, last_rc, last_error);
 		return DBERR_PREPARE_FAILED;
@@ -204,11 +298,83 @@ int DbInterfaceSQLite::prepare(const std::string& _stmt_name, const std::string&
 
 	lib_logger->trace(FMT_FILE_FUNC "SQLite::prepare ({} - res: ({}) {}", __FILE__, __func__, stmt_name, last_rc, last_error);
 
+	// If the name was already in use, the statement it was bound to is finalized, unless still cached
 	_prepared_stmts[stmt_name] = res;
+	_prepared_stmt_cache.add(query, res);
 
 	return DBERR_NO_ERROR;
 }
 
+// Static statements are added to the same cache used when they are executed (see _sqlite_exec_params)
+int DbInterfaceSQLite::prepare_static(const std::vector<std::shared_ptr<StaticStatementInfo>>& stmts)
+{
+	int rc = DBERR_NO_ERROR;
+
+	for (const auto& s : stmts) {
+		// Cursors are not cached
+		if (s->is_cursor || _prepared_stmt_cache.find(s->query))
+			continue;
+
+		std::string table_name, cursor_name;
+		bool is_delete = false;
+		if (updatable_cursors_emu && is_positioned_update_or_delete(s->query, table_name, cursor_name, &is_delete))
+			continue;
+
+		std::shared_ptr<SQLiteStatementData> wk_rs = std::make_shared<SQLiteStatementData>();
+		int sqlite_rc = sqlite3_prepare_v3(connaddr, s->query.c_str(), s->query.size(), SQLITE_PREPARE_PERSISTENT, &wk_rs->statement, nullptr);
+		if (sqliteRetrieveError(sqlite_rc) != SQLITE_OK) {
+			lib_logger->warn("SQLite: cannot prepare static statement: {} ({}) - {}", last_rc, last_error, s->query);
+			rc = DBERR_PREPARE_FAILED;
+			continue;
+		}
+
+		wk_rs->is_persistent = true;
+		_prepared_stmt_cache.add(s->query, wk_rs);
+	}
+
+	lib_logger->trace(FMT_FILE_FUNC "SQLite: {} statement(s) cached", __FILE__, __func__, _prepared_stmt_cache.size());
+
+	return rc;
+}
+
+// The query plan is retrieved without binding the parameters (unbound parameters are NULL): SQLite plans
+// the statement when it is prepared, so this does not affect the result
+int DbInterfaceSQLite::explain(const std::string& query, const std::vector<CobolVarType>& paramTypes, const std::vector<std_binary_data>& paramValues, const std::vector<unsigned long>& paramLengths, const std::vector<uint32_t>& paramFlags, std::string& plan)
+{
+	if (!connaddr)
+		return DBERR_CONN_NOT_FOUND;
+
+	std::string explain_query = "EXPLAIN QUERY PLAN " + query;
+	sqlite3_stmt* stmt = nullptr;
+	int rc = sqlite3_prepare_v2(connaddr, explain_query.c_str(), explain_query.size(), &stmt, nullptr);
+	if (rc != SQLITE_OK) {
+		lib_logger->warn("SQLite: cannot retrieve the query plan: {}", sqlite3_errmsg(connaddr));
+		sqlite3_finalize(stmt);
+		return DBERR_SQL_ERROR;
+	}
+
+	// Rows are (id, parent, notused, detail): nodes are indented according to their depth in the plan tree
+	std::map<int, int> depths;
+	while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+		int id = sqlite3_column_int(stmt, 0);
+		int parent = sqlite3_column_int(stmt, 1);
+		const char* detail = (const char*)sqlite3_column_text(stmt, 3);
+
+		int depth = (depths.find(parent) != depths.end()) ? depths[parent] + 1 : 0;
+		depths[id] = depth;
+
+		plan += std::string(depth * 2, ' ') + (detail ? detail : "") + "\n";
+	}
+
+	sqlite3_finalize(stmt);
+
+	if (rc != SQLITE_DONE) {
+		lib_logger->warn("SQLite: cannot retrieve the query plan: {}", sqlite3_errmsg(connaddr));
+		return DBERR_SQL_ERROR;
+	}
+
+	return DBERR_NO_ERROR;
+}
 
 int DbInterfaceSQLite::exec_prepared(const std::string& _stmt_name, std::vector<CobolVarType> paramTypes, std::vector<std_binary_data>& paramValues, std::vector<unsigned long> paramLengths, const std::vector<uint32_t>& paramFlags)
 {
@@ -234,33 +400,27 @@ int DbInterfaceSQLite::exec_prepared(const std::string& _stmt_name, std::vector<
 	std::shared_ptr<SQLiteStatementData> wk_rs = _prepared_stmts[stmt_name];
 	wk_rs->resizeParams(nParams);
 
+	int rc = SQLITE_OK;
+	start_pending_transaction(std::string(), rc);
+	if (sqliteRetrieveError(rc) != SQLITE_OK) {
+		lib_logger->error("SQLite: cannot start transaction: {} ({}): {}", last_rc, last_state, last_error);
+		return DBERR_SQL_ERROR;
+	}
+
 	sqlite3_reset(wk_rs->statement);
 	sqlite3_clear_bindings(wk_rs->statement);
 
+	std::vector<unsigned long> value_lengths;
 	for (int i = 0; i < nParams; i++) {
-
-		int rc = 0;
-
-		if (paramLengths.at(i) != DB_NULL) {
-			if (CBL_FIELD_IS_BINARY(paramFlags[i])) {
-				rc = sqlite3_bind_blob64(wk_rs->statement, i + 1, reinterpret_cast<const char*>(paramValues.at(i).data()), paramValues.at(i).size(), SQLITE_TRANSIENT);
-			}
-			else {
-				rc = sqlite3_bind_text(wk_rs->statement, i + 1, reinterpret_cast<const char*>(paramValues.at(i).data()), paramValues.at(i).size(), SQLITE_TRANSIENT);
-			}
-		}
-		else
-		{
-			rc = sqlite3_bind_null(wk_rs->statement, i + 1);
-		}
-
-		if (sqliteRetrieveError(rc) != SQLITE_OK)
-			return DBERR_SQL_ERROR;
+		value_lengths.push_back(paramLengths.at(i) != DB_NULL ? paramValues.at(i).size() : DB_NULL);
 	}
 
+	if (bind_parameters(wk_rs, paramValues, value_lengths, paramFlags) != DBERR_NO_ERROR)
+		return DBERR_SQL_ERROR;
+
 	int step_rc = sqlite3_step(wk_rs->statement);
 	if (step_rc != SQLITE_DONE && step_rc != SQLITE_ROW) {
-		int rc = sqliteRetrieveError(step_rc);
+		sqliteRetrieveError(step_rc);
 		return DBERR_SQL_ERROR;
 	}
 
@@ -282,15 +442,27 @@ int DbInterfaceSQLite::_sqlite_exec(const std::shared_ptr<ICursor>& crsr, const
 	int rc = 0;
 	bool is_delete = false;
 	bool is_updatable_crsr_stmt = false;
-	std::string cursor_name, table_name, update_query;
-	std::vector<std::string> unique_key;
-	std::vector<std::string> key_params;
-	sqlite3_stmt* upd_del_statement = nullptr;
+	std::string cursor_name, table_name;
+	std::shared_ptr<ICursor> updatable_crsr;
 	char* err_msg = 0;
 	uint32_t nquery_cols = 0;
 
 	lib_logger->trace(FMT_FILE_FUNC "SQL: #{}#", __FILE__, __func__, query);
 
+	invalidate_updatable_cursor_caches(query);
+
+	if (!start_pending_transaction(query, rc)) {
+		// COMMIT/ROLLBACK with no transaction started: nothing to do
+		release_current_statement();
+		sqliteClearError();
+		return DBERR_NO_ERROR;
+	}
+
+	if (sqliteRetrieveError(rc) != SQLITE_OK) {
+		lib_logger->error("SQLite: cannot start transaction: {} ({}): {}", last_rc, last_state, last_error);
+		return DBERR_SQL_ERROR;
+	}
+
 	std::shared_ptr<SQLiteStatementData> wk_rs = std::make_shared<SQLiteStatementData>();
 
 	if (!prep_stmt_data) {
@@ -298,13 +470,13 @@ int DbInterfaceSQLite::_sqlite_exec(const std::shared_ptr<ICursor>& crsr, const
 
 		if (wk_rs) {
 			if (wk_rs && wk_rs == current_statement_data) {
-				current_statement_data.reset();
+				release_current_statement();
 			}
 		}
 
 		wk_rs = std::make_shared<SQLiteStatementData>();
 
-		if (updatable_cursors_emu && is_update_or_delete_where_current_of(query, table_name, cursor_name, &is_delete)) {
+		if (updatable_cursors_emu && is_positioned_update_or_delete(query, table_name, cursor_name, &is_delete)) {
 
 			is_updatable_crsr_stmt = true;
 
@@ -314,31 +486,14 @@ int DbInterfaceSQLite::_sqlite_exec(const std::shared_ptr<ICursor>& crsr, const
 				return DBERR_SQL_ERROR;
 			}
 
-			std::shared_ptr<ICursor> updatable_crsr = this->_declared_cursors[cursor_name];
-
-			if (has_unique_key(table_name, updatable_crsr, unique_key)) {
-				std::string new_query;
-
-				if (!prepare_updatable_cursor_query(query, updatable_crsr, unique_key, &upd_del_statement, key_params) || !upd_del_statement) {
-					spdlog::error("Cannot rewrite query for updatable cursor {}", updatable_crsr->getName());
-					return DBERR_SQL_ERROR;
-				}
-
-				for (int i = 0; i < key_params.size(); i++) {
+			updatable_crsr = this->_declared_cursors[cursor_name];
 
-					int rc = sqlite3_bind_text(upd_del_statement, i + 1, key_params.at(i).c_str(), key_params.at(i).size(), SQLITE_TRANSIENT);
-					if (sqliteRetrieveError(rc) != SQLITE_OK) {
-						lib_logger->error("SQLite: Error while binding parameter definitions (# {}): {} ({}): {}", i + 1, last_rc, last_state, last_error);
-						return false;
-					}
-				}
+			wk_rs = get_updatable_cursor_statement(query, table_name, updatable_crsr);
+			if (!wk_rs)
+				return DBERR_SQL_ERROR;
 
-				wk_rs->statement = upd_del_statement;
-			}
-			else {
-				spdlog::error("No unique key found on table while trying to update a cursor row (cursor: {}, table: {}", cursor_name, table_name);
+			if (!bind_updatable_cursor_keys(updatable_crsr, wk_rs, 1))
 				return DBERR_SQL_ERROR;
-			}
 		}
 		else {
 			wk_rs = std::make_shared<SQLiteStatementData>();
@@ -357,19 +512,18 @@ int DbInterfaceSQLite::_sqlite_exec(const std::shared_ptr<ICursor>& crsr, const
 	int step_rc = sqlite3_step(wk_rs->statement);
 
 	// we trap COMMIT/ROLLBACK
-	if (connection_opts->autocommit == AutoCommitMode::Off && is_tx_termination_statement(query)) {
+	if (is_tx_end_statement(query)) {
 
 		// we clean up: if the COMMIT/ROLLBACK failed this is probably useless anyway
 		if (current_statement_data) {
-			current_statement_data = nullptr;
+			release_current_statement();
 		}
 
-		if (sqliteRetrieveError(step_rc) == SQLITE_OK) {	// COMMIT/ROLLBACK succeeded, we try to start a new transaction
-			lib_logger->trace(FMT_FILE_FUNC "autocommit mode is disabled, trying to start a new transaction", __FILE__, __func__);
-			step_rc = sqlite3_exec(connaddr, "START TRANSACTION", 0, 0, &err_msg);
-			sqliteRetrieveError(step_rc);
-			lib_logger->trace(FMT_FILE_FUNC "transaction start result: {} ({})", __FILE__, __func__, last_error, last_state);
-			return (step_rc != SQLITE_OK) ? DBERR_SQL_ERROR : DBERR_NO_ERROR;
+		if (step_rc == SQLITE_DONE) {	// COMMIT/ROLLBACK succeeded, a new transaction will be started with the next statement
+			lib_logger->trace(FMT_FILE_FUNC "autocommit mode is disabled, new transaction start deferred", __FILE__, __func__);
+			sqliteClearError();
+			tx_start_pending = true;
+			return DBERR_NO_ERROR;
 		}
 
 		// if COMMIT/ROLLBACK failed, the error code/state is already set, it will be handled below
@@ -413,14 +567,26 @@ int DbInterfaceSQLite::_sqlite_exec_params(const std::shared_ptr<ICursor>& crsr,
 	int rc = 0;
 	bool is_delete = false;
 	bool is_updatable_crsr_stmt = false;
-	std::string cursor_name, table_name, update_query;
-	std::vector<std::string> unique_key;
-	std::vector<std::string> key_params;
-	sqlite3_stmt* upd_del_statement = nullptr;
+	std::string cursor_name, table_name;
+	std::shared_ptr<ICursor> updatable_crsr;
 	char* err_msg = 0;
 	uint32_t nquery_cols = 0;
 	lib_logger->trace(FMT_FILE_FUNC "SQL: #{}#", __FILE__, __func__, query);
 
+	invalidate_updatable_cursor_caches(query);
+
+	if (!start_pending_transaction(query, rc)) {
+		// COMMIT/ROLLBACK with no transaction started: nothing to do
+		release_current_statement();
+		sqliteClearError();
+		return DBERR_NO_ERROR;
+	}
+
+	if (sqliteRetrieveError(rc) != SQLITE_OK) {
+		lib_logger->error("SQLite: cannot start transaction: {} ({}): {}", last_rc, last_state, last_error);
+		return DBERR_SQL_ERROR;
+	}
+
 	std::shared_ptr<SQLiteStatementData> wk_rs;
 
 	if (paramTypes.size() != paramValues.size() || paramTypes.size() != paramFlags.size()) {
@@ -435,13 +601,14 @@ int DbInterfaceSQLite::_sqlite_exec_params(const std::shared_ptr<ICursor>& crsr,
 
 		if (wk_rs) {
 			if (wk_rs && wk_rs == current_statement_data) {
-				current_statement_data.reset();
+				release_current_statement();
 			}
 		}
 
 		wk_rs = std::make_shared<SQLiteStatementData>();
+		std::shared_ptr<SQLiteStatementData> cached_rs;
 
-		if (updatable_cursors_emu && is_update_or_delete_where_current_of(query, table_name, cursor_name, &is_delete)) {
+		if (updatable_cursors_emu && is_positioned_update_or_delete(query, table_name, cursor_name, &is_delete)) {
 
 			is_updatable_crsr_stmt = true;
 
@@ -451,29 +618,35 @@ int DbInterfaceSQLite::_sqlite_exec_params(const std::shared_ptr<ICursor>& crsr,
 				return DBERR_SQL_ERROR;
 			}
 
-			std::shared_ptr<ICursor> updatable_crsr = this->_declared_cursors[cursor_name];
+			updatable_crsr = this->_declared_cursors[cursor_name];
 
-			if (has_unique_key(table_name, updatable_crsr, unique_key)) {
-				std::string new_query;
+			wk_rs = get_updatable_cursor_statement(query, table_name, updatable_crsr);
+			if (!wk_rs)
+				return DBERR_SQL_ERROR;
 
-				if (!prepare_updatable_cursor_query(query, updatable_crsr, unique_key, &upd_del_statement, key_params) || !upd_del_statement) {
-					spdlog::error("Cannot rewrite query for updatable cursor {}", updatable_crsr->getName());
-					return DBERR_SQL_ERROR;
+			// Key parameters are bound later
+		}
+		else if (!crsr && (cached_rs = _prepared_stmt_cache.find(query, std::string(), _prepared_stmts))) {
+			// Statements with parameters that are not part of a cursor are compiled only once
+			// for each connection: we just need to reset them before binding the new values.
+			// A statement currently bound to a prepared statement name is not shared.
+			wk_rs = cached_rs;
+			sqlite3_reset(wk_rs->statement);
+			sqlite3_clear_bindings(wk_rs->statement);
+		}
+		else {
+			wk_rs = std::make_shared<SQLiteStatementData>();
+			if (!crsr) {
+				rc = sqlite3_prepare_v3(connaddr, query.c_str(), query.size(), SQLITE_PREPARE_PERSISTENT, &wk_rs->statement, nullptr);
+				if (rc == SQLITE_OK) {
+					wk_rs->is_persistent = true;
+					_prepared_stmt_cache.add(query, wk_rs);
 				}
-
-				// Parameters are bound later
-
-				wk_rs->statement = upd_del_statement;
 			}
 			else {
-				spdlog::error("No unique key found on table while trying to update a cursor row (cursor: {}, table: {}", cursor_name, table_name);
-				return DBERR_SQL_ERROR;
+				rc = sqlite3_prepare_v2(connaddr, query.c_str(), query.size(), &wk_rs->statement, nullptr);
 			}
 		}
-		else {
-			wk_rs = std::make_shared<SQLiteStatementData>();
-			rc = sqlite3_prepare_v2(connaddr, query.c_str(), query.size(), &wk_rs->statement, nullptr);
-		}
 
 		if (sqliteRetrieveError(rc) != SQLITE_OK) {
 			spdlog::error("Prepare error: {} ({}) - {}", last_rc, last_state, last_error);
@@ -486,53 +659,28 @@ int DbInterfaceSQLite::_sqlite_exec_params(const std::shared_ptr<ICursor>& crsr,
 
 	int nParams = paramValues.size();
 
-	for (int i = 0; i < nParams; i++) {
-
-		int rc = 0;
-
-		if (paramLengths.at(i) != DB_NULL) {
-			if (CBL_FIELD_IS_BINARY(paramFlags[i])) {
-				rc = sqlite3_bind_blob64(wk_rs->statement, i + 1, reinterpret_cast<const  char*>(paramValues.at(i).data()), paramLengths.at(i), SQLITE_TRANSIENT);
-			}
-			else {
-				rc = sqlite3_bind_text(wk_rs->statement, i + 1, reinterpret_cast<const  char*>(paramValues.at(i).data()), paramLengths.at(i), SQLITE_TRANSIENT);
-			}
-		}
-		else
-		{
-			rc = sqlite3_bind_null(wk_rs->statement, i + 1);
-		}
-
-		if (sqliteRetrieveError(rc))
-			return DBERR_SQL_ERROR;
-	}
+	if (bind_parameters(wk_rs, paramValues, paramLengths, paramFlags) != DBERR_NO_ERROR)
+		return DBERR_SQL_ERROR;
 
 	// This will only be used if we are performing an update/delete on an updatable cursor
-	for (int i = 0; i < key_params.size(); i++) {
-
-		int rc = sqlite3_bind_text(wk_rs->statement, nParams + i + 1, key_params.at(i).c_str(), key_params.at(i).size(), SQLITE_TRANSIENT);
-		if (sqliteRetrieveError(rc) != SQLITE_OK) {
-			lib_logger->error("SQLite: Error while binding parameter definitions (# {}): {} ({}): {}", i + 1, last_rc, last_state, last_error);
-			return false;
-		}
-	}
+	if (is_updatable_crsr_stmt && !bind_updatable_cursor_keys(updatable_crsr, wk_rs, nParams + 1))
+		return DBERR_SQL_ERROR;
 
 	int step_rc = sqlite3_step(wk_rs->statement);
 
 	// we trap COMMIT/ROLLBACK
-	if (connection_opts->autocommit == AutoCommitMode::Off && is_tx_termination_statement(query)) {
+	if (is_tx_end_statement(query)) {
 
 		// we clean up: if the COMMIT/ROLLBACK failed this is probably useless anyway
 		if (current_statement_data) {
-			current_statement_data.reset();
+			release_current_statement();
 		}
 
-		if (sqliteRetrieveError(step_rc) == SQLITE_OK) {	// COMMIT/ROLLBACK succeeded, we try to start a new transaction
-			lib_logger->trace(FMT_FILE_FUNC "autocommit mode is disabled, trying to start a new transaction", __FILE__, __func__);
-			step_rc = sqlite3_exec(connaddr, "START TRANSACTION", 0, 0, &err_msg);
-			sqliteRetrieveError(step_rc);
-			lib_logger->trace(FMT_FILE_FUNC "transaction start result: {} ({})", __FILE__, __func__, last_error, last_state);
-			return (step_rc != SQLITE_OK) ? DBERR_SQL_ERROR : DBERR_NO_ERROR;
+		if (step_rc == SQLITE_DONE) {	// COMMIT/ROLLBACK succeeded, a new transaction will be started with the next statement
+			lib_logger->trace(FMT_FILE_FUNC "autocommit mode is disabled, new transaction start deferred", __FILE__, __func__);
+			sqliteClearError();
+			tx_start_pending = true;
+			return DBERR_NO_ERROR;
 		}
 
 		// if COMMIT/ROLLBACK failed, the error code/state is already set, it will be handled below
@@ -567,6 +715,97 @@ int DbInterfaceSQLite::_sqlite_exec_params(const std::shared_ptr<ICursor>& crsr,
 	return DBERR_NO_ERROR;
 }
 
+int DbInterfaceSQLite::bind_parameters(std::shared_ptr<SQLiteStatementData> wk_rs, const std::vector<std_binary_data>& paramValues, const std::vector<unsigned long>& paramLengths, const std::vector<uint32_t>& paramFlags)
+{
+	int nParams = paramValues.size();
+
+	// The runtime's buffers do not outlive the call, so values are copied into buffers owned
+	// by the statement (this only allocates memory when a value grows) and bound from there
+	wk_rs->param_bfrs.resize(nParams);
+
+	for (int i = 0; i < nParams; i++) {
+
+		int rc = 0;
+
+		if (paramLengths.at(i) != DB_NULL) {
+			std_binary_data& b = wk_rs->param_bfrs[i];
+			b.assign(paramValues.at(i).begin(), paramValues.at(i).end());
+
+			if (CBL_FIELD_IS_BINARY(paramFlags[i])) {
+				rc = sqlite3_bind_blob64(wk_rs->statement, i + 1, reinterpret_cast<const char*>(b.data()), paramLengths.at(i), SQLITE_STATIC);
+			}
+			else {
+				rc = sqlite3_bind_text(wk_rs->statement, i + 1, reinterpret_cast<const char*>(b.data()), paramLengths.at(i), SQLITE_STATIC);
+			}
+		}
+		else
+		{
+			rc = sqlite3_bind_null(wk_rs->statement, i + 1);
+		}
+
+		if (sqliteRetrieveError(rc) != SQLITE_OK)
+			return DBERR_SQL_ERROR;
+	}
+
+	return DBERR_NO_ERROR;
+}
+
+// Statement classification: the flags from the preprocessor are used if available, otherwise the statement text is inspected
+bool DbInterfaceSQLite::is_tx_end_statement(const std::string& query)
+{
+	if (connection_opts->autocommit != AutoCommitMode::Off)
+		return false;
+
+	if (SQL_STMT_HAS_FLAGS(stmt_flags))
+		return SQL_STMT_IS_TX_END(stmt_flags);
+
+	return is_tx_termination_statement(query) && to_upper(query).find(" TO ") == std::string::npos;
+}
+
+bool DbInterfaceSQLite::is_positioned_update_or_delete(const std::string& query, std::string& table_name, std::string& cursor_name, bool* is_delete)
+{
+	if (SQL_STMT_HAS_FLAGS(stmt_flags) && !SQL_STMT_IS_POSITIONED(stmt_flags))
+		return false;
+
+	return is_update_or_delete_where_current_of(query, table_name, cursor_name, is_delete);
+}
+
+// Starts the transaction that was deferred after the last COMMIT/ROLLBACK (or after connecting).
+// Returns false if the statement itself does not need to be executed (a COMMIT/ROLLBACK
+// with no transaction started)
+bool DbInterfaceSQLite::start_pending_transaction(const std::string& query, int& rc)
+{
+	rc = SQLITE_OK;
+
+	if (!tx_start_pending)
+		return true;
+
+	if (is_tx_end_statement(query))
+		return false;
+
+	tx_start_pending = false;
+
+	if (is_begin_transaction_statement(query))
+		return true;
+
+	lib_logger->trace(FMT_FILE_FUNC "autocommit mode is disabled, starting deferred transaction", __FILE__, __func__);
+
+	char* err_msg = 0;
+	rc = sqlite3_exec(connaddr, "BEGIN TRANSACTION", 0, 0, &err_msg);
+	sqlite3_free(err_msg);
+	return true;
+}
+
+// A cached statement is not finalized when it is no longer the current one,
+// so we reset it to release any lock it might still be holding
+void DbInterfaceSQLite::release_current_statement()
+{
+	if (current_statement_data && current_statement_data->is_persistent && current_statement_data->statement)
+		sqlite3_reset(current_statement_data->statement);
+
+	current_statement_data.reset();
+}
+
 bool DbInterfaceSQLite::is_cursor_from_prepared_statement(ICursor* cursor)
 {
 	//std::string squery = cursor->getQuery();
@@ -592,6 +831,13 @@ bool DbInterfaceSQLite::is_cursor_from_prepared_statement(ICursor* cursor)
 
 bool DbInterfaceSQLite::has_unique_key(std::string table_name, const std::shared_ptr<ICursor>& crsr, std::vector<std::string>& unique_key)
 {
+	// The unique key of a table is retrieved only once per connection
+	std::string table_id = to_upper(table_name);
+	if (_table_unique_keys.find(table_id) != _table_unique_keys.end()) {
+		unique_key = _table_unique_keys[table_id];
+		return true;
+	}
+
 	int err_idx = 1;
 	std::string q1 = "SELECT name, case when il.\"origin\" = 'pk' then 0 else 1 end a FROM pragma_index_list(?) il where \"unique\"=1 order by a";
 
@@ -643,10 +889,12 @@ bool DbInterfaceSQLite::has_unique_key(std::string table_name, const std::shared
 	rc = sqlite3_finalize(key_stmt);
 	CHECK_UNIQUE_KEY_ERR(SQLITE_OK)
 
-		return true;
+		_table_unique_keys[table_id] = unique_key;
+
+	return true;
 }
 
-bool DbInterfaceSQLite::prepare_updatable_cursor_query(const std::string& qry, const std::shared_ptr<ICursor>& crsr, const std::vector<std::string>& unique_key, sqlite3_stmt** update_stmt, std::vector<std::string>& key_params)
+bool DbInterfaceSQLite::prepare_updatable_cursor_query(const std::string& qry, const std::shared_ptr<ICursor>& crsr, const std::vector<std::string>& unique_key, std::shared_ptr<SQLiteStatementData>& upd_stmt_data)
 {
 	if (!crsr || !crsr->getQuery().size())
 		return false;
@@ -683,31 +931,91 @@ bool DbInterfaceSQLite::prepare_updatable_cursor_query(const std::string& qry, c
 
 	tqry += where_clause;
 
-	sqlite3_stmt* upd_stmt = nullptr;
+	// we store the position of the key columns in the cursor, their values will be bound at each execution
+	std::vector<int> key_col_idxs;
+	for (int i = 0; i < unique_key.size(); i++) {
+
+		std::vector<std::string>::iterator itr = std::find(crsr_cols.begin(), crsr_cols.end(), unique_key.at(i));
+		if (itr == crsr_cols.cend()) {
+			return false;
+		}
+
+		key_col_idxs.push_back(std::distance(crsr_cols.begin(), itr));
+	}
+
+	auto upd_rs = std::make_shared<SQLiteStatementData>();
 
 	lib_logger->trace("Preparing updatable cursor query for {}: {}", crsr->getName(), tqry);
 
-	int rc = sqlite3_prepare_v2(connaddr, tqry.c_str(), tqry.size(), &upd_stmt, nullptr);
+	int rc = sqlite3_prepare_v3(connaddr, tqry.c_str(), tqry.size(), SQLITE_PREPARE_PERSISTENT, &upd_rs->statement, nullptr);
 	if (sqliteRetrieveError(rc) != SQLITE_OK) {
 		lib_logger->error("Could not prepare updatable cursor query for {}", crsr->getName());
 		return false;
 	}
 
-	key_params.clear();
-	for (int i = 0; i < unique_key.size(); i++) {
+	upd_rs->is_persistent = true;
+	upd_rs->key_col_idxs = key_col_idxs;
+	upd_stmt_data = upd_rs;
 
-		std::vector<std::string>::iterator itr = std::find(crsr_cols.begin(), crsr_cols.end(), unique_key.at(i));
-		if (itr == crsr_cols.cend()) {
-			return false;
-		}
+	return true;
+}
 
-		int col_idx = std::distance(crsr_cols.begin(), itr);
+std::shared_ptr<SQLiteStatementData> DbInterfaceSQLite::get_updatable_cursor_statement(const std::string& qry, const std::string& table_name, const std::shared_ptr<ICursor>& crsr)
+{
+	// The rewritten UPDATE/DELETE is prepared only once per cursor, only the key values change from row to row
+	std::map<std::string, std::shared_ptr<SQLiteStatementData>>& crsr_stmts = _updatable_crsr_stmts[crsr->getName()];
+	auto it = crsr_stmts.find(qry);
+	if (it != crsr_stmts.end()) {
+		sqlite3_reset(it->second->statement);
+		sqlite3_clear_bindings(it->second->statement);
+		return it->second;
+	}
 
-		std::string col_data = (char*)sqlite3_column_text(rs->statement, col_idx);
-		key_params.push_back(col_data);
+	std::vector<std::string> unique_key;
+	if (!has_unique_key(table_name, crsr, unique_key)) {
+		spdlog::error("No unique key found on table while trying to update a cursor row (cursor: {}, table: {}", crsr->getName(), table_name);
+		return nullptr;
 	}
 
-	*update_stmt = upd_stmt;
+	std::shared_ptr<SQLiteStatementData> upd_rs;
+	if (!prepare_updatable_cursor_query(qry, crsr, unique_key, upd_rs) || !upd_rs) {
+		spdlog::error("Cannot rewrite query for updatable cursor {}", crsr->getName());
+		return nullptr;
+	}
+
+	crsr_stmts[qry] = upd_rs;
+	return upd_rs;
+}
+
+// The rewritten UPDATE/DELETE statements depend on the cursor's select list and on the table's unique key:
+// they are dropped when the cursor is declared again or closed, and a DDL statement invalidates everything
+void DbInterfaceSQLite::invalidate_updatable_cursor_caches(const std::string& query)
+{
+	if ((_table_unique_keys.empty() && _updatable_crsr_stmts.empty()) || !is_ddl_statement(query))
+		return;
+
+	lib_logger->trace(FMT_FILE_FUNC "DDL statement, clearing unique key and updatable cursor caches", __FILE__, __func__);
+	_table_unique_keys.clear();
+	_updatable_crsr_stmts.clear();
+}
+
+bool DbInterfaceSQLite::bind_updatable_cursor_keys(const std::shared_ptr<ICursor>& crsr, std::shared_ptr<SQLiteStatementData> upd_stmt_data, int first_param)
+{
+	auto rs = std::dynamic_pointer_cast<SQLiteStatementData>(crsr->getPrivateData());
+	if (!rs || !rs->statement)
+		return false;
+
+	for (int i = 0; i < upd_stmt_data->key_col_idxs.size(); i++) {
+		int col_idx = upd_stmt_data->key_col_idxs.at(i);
+		const char* col_data = (const char*)sqlite3_column_text(rs->statement, col_idx);
+		int col_len = sqlite3_column_bytes(rs->statement, col_idx);
+
+		int rc = sqlite3_bind_text(upd_stmt_data->statement, first_param + i, col_data ? col_data : "", col_len, SQLITE_TRANSIENT);
+		if (sqliteRetrieveError(rc) != SQLITE_OK) {
+			lib_logger->error("SQLite: Error while binding parameter definitions (# {}): {} ({}): {}", first_param + i, last_rc, last_state, last_error);
+			return false;
+		}
+	}
 
 	return true;
 }
@@ -724,7 +1032,9 @@ std::vector<std::string> DbInterfaceSQLite::get_resultset_column_names(sqlite3_s
 
 int DbInterfaceSQLite::cursor_close(const std::shared_ptr<ICursor>& crsr)
 {
-	// Nothing to do
+	if (crsr)
+		_updatable_crsr_stmts.erase(crsr->getName());
+
 	return DBERR_NO_ERROR;
 }
 
@@ -733,10 +1043,9 @@ int DbInterfaceSQLite::cursor_declare(const std::shared_ptr<ICursor>& cursor)
 	if (!cursor)
 		return DBERR_DECLARE_CURSOR_FAILED;
 
-	std::map<std::string, std::shared_ptr<ICursor>>::iterator it = _declared_cursors.find(cursor->getName());
-	if (it == _declared_cursors.end()) {
-		_declared_cursors[cursor->getName()] = cursor;
-	}
+	// A cursor with the same name might have been declared before, on a different query
+	_declared_cursors[cursor->getName()] = cursor;
+	_updatable_crsr_stmts.erase(cursor->getName());
 
 	return DBERR_NO_ERROR;
 }
@@ -1101,6 +1410,17 @@ static std::string __get_trimmed_hostref_or_literal(void* data, int l)
 	return trim_copy(t);
 }
 
+// Pragma values are inlined in the statement, so we only accept plain keywords and numbers
+static bool is_valid_pragma_value(const std::string& v)
+{
+	for (size_t i = 0; i < v.size(); i++) {
+		char c = v.at(i);
+		if (!isalnum((unsigned char)c) && !(c == '-' && i == 0))
+			return false;
+	}
+	return !v.empty();
+}
+
 static std::string sqlite_fixup_parameters(const std::string& sql)
 {
 #if 0
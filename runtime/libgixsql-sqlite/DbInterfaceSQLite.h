@@ -33,6 +33,7 @@ USA.
 #include "IDbManagerInterface.h"
 #include "IDataSourceInfo.h"
 #include "ISchemaManager.h"
+#include "PreparedStatementCache.h"
 
 
 #define DECODE_BINARY_ON		1
@@ -54,6 +55,16 @@ struct SQLiteStatementData : public IPrivateStatementData {
 
 	bool _on_first_row = false;
 
+	// Kept in the per-connection statement cache and reused across executions
+	bool is_persistent = false;
+
+	// Parameters are bound with SQLITE_STATIC from these buffers, that are
+	// reused (without reallocating, if possible) across executions
+	std::vector<std_binary_data> param_bfrs;
+
+	// Updatable cursor emulation: position of the unique key columns in the cursor
+	std::vector<int> key_col_idxs;
+
 private:
 	void cleanup();
 };
@@ -84,6 +95,8 @@ public:
 	virtual std::string get_state() override;
 	virtual int prepare(const std::string& stmt_name, const std::string& query) override;
 	virtual int exec_prepared(const std::string& stmt_name, std::vector<CobolVarType> paramTypes, std::vector<std_binary_data>& paramValues, std::vector<unsigned long> paramLengths, const std::vector<uint32_t>& paramFlags) override;
+	virtual int prepare_static(const std::vector<std::shared_ptr<StaticStatementInfo>>& stmts) override;
+	virtual int explain(const std::string& query, const std::vector<CobolVarType>& paramTypes, const std::vector<std_binary_data>& paramValues, const std::vector<unsigned long>& paramLengths, const std::vector<uint32_t>& paramFlags, std::string& plan) override;
 	virtual DbPropertySetResult set_property(DbProperty p, std::variant<bool, int, std::string> v) override;
 
 
@@ -107,6 +120,7 @@ private:
 
 	std::map<std::string, std::shared_ptr<ICursor>> _declared_cursors;
 	std::map<std::string, std::shared_ptr<SQLiteStatementData>> _prepared_stmts;
+	PreparedStatementCache<SQLiteStatementData> _prepared_stmt_cache;
 
 	int decode_binary = DECODE_BINARY_DEFAULT;
 
@@ -119,13 +133,30 @@ private:
 
 	int _sqlite_get_num_rows(sqlite3_stmt* r);
 
+	int bind_parameters(std::shared_ptr<SQLiteStatementData> wk_rs, const std::vector<std_binary_data>& paramValues, const std::vector<unsigned long>& paramLengths, const std::vector<uint32_t>& paramFlags);
+	void release_current_statement();
+
+	// Start of a new transaction after a COMMIT/ROLLBACK (autocommit off), deferred until the next statement
+	bool tx_start_pending = false;
+	bool start_pending_transaction(const std::string& query, int& rc);
+
+	bool is_tx_end_statement(const std::string& query);
+	bool is_positioned_update_or_delete(const std::string& query, std::string& table_name, std::string& cursor_name, bool* is_delete);
+
 	std::shared_ptr<SQLiteStatementData> retrieve_prepared_statement(const std::string& prep_stmt_name);
 	bool is_cursor_from_prepared_statement(ICursor* cursor);
 
+	int apply_pragmas(sqlite3* conn, const std::map<std::string, std::string>& opts, const std::string& profile);
+
 	// Updatable cursor emulation
 	bool updatable_cursors_emu = false;
 	bool has_unique_key(std::string table_name, const std::shared_ptr<ICursor>& crsr, std::vector<std::string>& unique_key);
-	bool prepare_updatable_cursor_query(const std::string& qry, const std::shared_ptr<ICursor>& crsr, const std::vector<std::string>& unique_key, sqlite3_stmt** update_stmt, std::vector<std::string>& key_params);
+	bool prepare_updatable_cursor_query(const std::string& qry, const std::shared_ptr<ICursor>& crsr, const std::vector<std::string>& unique_key, std::shared_ptr<SQLiteStatementData>& upd_stmt_data);
+	std::shared_ptr<SQLiteStatementData> get_updatable_cursor_statement(const std::string& qry, const std::string& table_name, const std::shared_ptr<ICursor>& crsr);
+	void invalidate_updatable_cursor_caches(const std::string& query);
+	bool bind_updatable_cursor_keys(const std::shared_ptr<ICursor>& crsr, std::shared_ptr<SQLiteStatementData> upd_stmt_data, int first_param);
+	std::map<std::string, std::vector<std::string>> _table_unique_keys;
+	std::map<std::string, std::map<std::string, std::shared_ptr<SQLiteStatementData>>> _updatable_crsr_stmts;
 	std::vector<std::string> get_resultset_column_names(sqlite3_stmt* stmt);
 };
 
@@ -0,0 +1,227 @@
+/*
+* This file is part of Gix-IDE, an IDE and platform for GnuCOBOL
+* Copyright (C) 2021 Marco Ridoni
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public License
+* as published by the Free Software Foundation; either version 3,
+* or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library; see the file COPYING.LIB.  If
+* not, write to the Free Software Foundation, 51 Franklin Street, Fifth Floor
+* Boston, MA 02110-1301 USA
+*/
+
+#include "AsyncLogSink.h"
+
+AsyncLogSink::AsyncLogSink(spdlog::sink_ptr _target, size_t queue_size, AsyncLogOverflowPolicy _policy, int flush_interval_ms) :
+	target(_target), queue(queue_size > 0 ? queue_size : ASYNC_LOG_DEFAULT_QUEUE_SIZE), policy(_policy),
+	flush_interval(flush_interval_ms > 0 ? flush_interval_ms : ASYNC_LOG_DEFAULT_FLUSH_INTERVAL)
+{
+	running = true;
+	stopping = false;
+	writer_idle = false;
+	written_count = 0;
+	dropped_count = 0;
+	dropped_reported = 0;
+	wake_requested = false;
+	flush_requested_seq = 0;
+	flushed_seq = 0;
+
+	writer = std::thread(&AsyncLogSink::writer_loop, this);
+}
+
+AsyncLogSink::~AsyncLogSink()
+{
+	stop();
+}
+
+void AsyncLogSink::log(const spdlog::details::log_msg& msg)
+{
+	if (!running.load(std::memory_order_acquire)) {
+		target->log(msg);
+		return;
+	}
+
+	// The message keeps the timestamp and the thread id set by the logger in this thread
+	spdlog::details::log_msg_buffer m(msg);
+	while (!queue.try_enqueue(std::move(m))) {
+		if (policy == AsyncLogOverflowPolicy::Drop) {
+			dropped_count.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+
+		if (!running.load(std::memory_order_acquire)) {
+			target->log(msg);
+			return;
+		}
+
+		// Block: let the writer thread make room
+		if (writer_idle.load())
+			wake_writer();
+		std::this_thread::yield();
+	}
+
+	// The writer thread is only woken up when the queue starts to fill up: waking it for each message would
+	// cost the caller a system call, otherwise it writes the pending messages at the next flush interval
+	if (writer_idle.load() && queue.size() >= queue.capacity() / 2)
+		wake_writer();
+}
+
+void AsyncLogSink::flush()
+{
+	if (!running.load(std::memory_order_acquire)) {
+		target->flush();
+		return;
+	}
+
+	// Wait until all the messages enqueued so far have been written and the target sink has been flushed
+	uint64_t seq = queue.enqueue_position();
+
+	std::unique_lock<std::mutex> lock(flush_mutex);
+	if (seq > flush_requested_seq)
+		flush_requested_seq = seq;
+
+	{
+		std::lock_guard<std::mutex> wlock(writer_mutex);
+		wake_requested = true;
+	}
+	writer_cv.notify_one();
+
+	flush_cv.wait(lock, [this, seq] { return flushed_seq >= seq || !running.load(); });
+}
+
+void AsyncLogSink::set_pattern(const std::string& pattern)
+{
+	target->set_pattern(pattern);
+}
+
+void AsyncLogSink::set_formatter(std::unique_ptr<spdlog::formatter> sink_formatter)
+{
+	target->set_formatter(std::move(sink_formatter));
+}
+
+void AsyncLogSink::stop()
+{
+	if (!running.exchange(false))
+		return;
+
+	// From now on new messages are written synchronously, the writer thread writes the ones still in the queue
+	stopping = true;
+	{
+		std::lock_guard<std::mutex> lock(writer_mutex);
+		wake_requested = true;
+	}
+	writer_cv.notify_one();
+
+	if (writer.joinable())
+		writer.join();
+
+	spdlog::details::log_msg_buffer m;
+	while (queue.try_dequeue(m))
+		target->log(m);
+
+	report_dropped();
+	target->flush();
+
+	// release any thread waiting in flush()
+	{
+		std::lock_guard<std::mutex> lock(flush_mutex);
+		flushed_seq = queue.enqueue_position();
+	}
+	flush_cv.notify_all();
+}
+
+void AsyncLogSink::wake_writer()
+{
+	{
+		std::lock_guard<std::mutex> lock(writer_mutex);
+		wake_requested = true;
+	}
+	writer_cv.notify_one();
+}
+
+void AsyncLogSink::report_dropped()
+{
+	uint64_t n = dropped_count.load(std::memory_order_relaxed);
+	if (n == dropped_reported)
+		return;
+
+	std::string text = fmt::format("GixSQL: log queue full, {} message(s) dropped", n - dropped_reported);
+	spdlog::details::log_msg m(spdlog::source_loc{}, "libgixsql", spdlog::level::warn, text);
+	target->log(m);
+
+	dropped_reported = n;
+}
+
+void AsyncLogSink::writer_loop()
+{
+	spdlog::details::log_msg_buffer m;
+	auto last_flush = std::chrono::steady_clock::now();
+	bool dirty = false;
+
+	while (true) {
+		int n = 0;
+		while (n < ASYNC_LOG_MAX_BATCH && queue.try_dequeue(m)) {
+			try {
+				target->log(m);
+			}
+			catch (...) {}	// a write error must not terminate the writer thread
+			n++;
+		}
+
+		if (n > 0) {
+			written_count.fetch_add(n, std::memory_order_release);
+			dirty = true;
+		}
+
+		if (dropped_count.load(std::memory_order_relaxed) != dropped_reported) {
+			report_dropped();
+			dirty = true;
+		}
+
+		bool flush_requested;
+		{
+			std::lock_guard<std::mutex> lock(flush_mutex);
+			flush_requested = flush_requested_seq > flushed_seq;
+		}
+
+		auto now = std::chrono::steady_clock::now();
+		if (dirty && (flush_requested || now - last_flush >= flush_interval)) {
+			try {
+				target->flush();
+			}
+			catch (...) {}
+			dirty = false;
+			last_flush = now;
+		}
+
+		if (flush_requested) {
+			{
+				std::lock_guard<std::mutex> lock(flush_mutex);
+				flushed_seq = written_count.load(std::memory_order_acquire);
+			}
+			flush_cv.notify_all();
+		}
+
+		if (n > 0)
+			continue;
+
+		if (stopping.load() && queue.empty())
+			break;
+
+		// Nothing to write: wait until the queue is half full, a flush is requested or the flush interval expires
+		std::unique_lock<std::mutex> lock(writer_mutex);
+		writer_idle.store(true);
+		auto timeout = dirty ? flush_interval - std::chrono::duration_cast<std::chrono::milliseconds>(now - last_flush) : flush_interval;
+		writer_cv.wait_for(lock, timeout, [this] { return wake_requested || queue.size() >= queue.capacity() / 2; });
+		wake_requested = false;
+		writer_idle.store(false);
+	}
+}
@@ -0,0 +1,207 @@
+/*
+* This file is part of Gix-IDE, an IDE and platform for GnuCOBOL
+* Copyright (C) 2021 Marco Ridoni
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public License
+* as published by the Free Software Foundation; either version 3,
+* or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library; see the file COPYING.LIB.  If
+* not, write to the Free Software Foundation, 51 Franklin Street, Fifth Floor
+* Boston, MA 02110-1301 USA
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+#include "spdlog/spdlog.h"
+#include "spdlog/sinks/sink.h"
+#include "spdlog/details/log_msg_buffer.h"
+
+#define ASYNC_LOG_DEFAULT_QUEUE_SIZE		8192
+#define ASYNC_LOG_DEFAULT_FLUSH_INTERVAL	1000
+#define ASYNC_LOG_MAX_BATCH					256
+
+enum class AsyncLogOverflowPolicy {
+	Block = 0,
+	Drop = 1
+};
+
+/*
+	Bounded multi-producer/multi-consumer queue (D. Vyukov's algorithm): each cell has a sequence
+	number that tells producers and consumers whether it is free or holds data, so enqueue and
+	dequeue only need a CAS on the respective position counter and never take a lock.
+	The capacity is rounded up to a power of 2.
+*/
+template <typename T>
+class BoundedMpmcQueue
+{
+public:
+	explicit BoundedMpmcQueue(size_t capacity)
+	{
+		size_t sz = 2;
+		while (sz < capacity)
+			sz <<= 1;
+
+		mask = sz - 1;
+		cells = std::unique_ptr<Cell[]>(new Cell[sz]);
+		for (size_t i = 0; i < sz; i++)
+			cells[i].seq.store(i, std::memory_order_relaxed);
+
+		enqueue_pos.store(0, std::memory_order_relaxed);
+		dequeue_pos.store(0, std::memory_order_relaxed);
+	}
+
+	bool try_enqueue(T&& v)
+	{
+		Cell* c;
+		size_t pos = enqueue_pos.load(std::memory_order_relaxed);
+		while (true) {
+			c = &cells[pos & mask];
+			size_t seq = c->seq.load(std::memory_order_acquire);
+			intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+			if (diff == 0) {
+				if (enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					break;
+			}
+			else
+				if (diff < 0) {
+					return false;	// full
+				}
+				else
+					pos = enqueue_pos.load(std::memory_order_relaxed);
+		}
+
+		c->data = std::move(v);
+		c->seq.store(pos + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool try_dequeue(T& v)
+	{
+		Cell* c;
+		size_t pos = dequeue_pos.load(std::memory_order_relaxed);
+		while (true) {
+			c = &cells[pos & mask];
+			size_t seq = c->seq.load(std::memory_order_acquire);
+			intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+			if (diff == 0) {
+				if (dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					break;
+			}
+			else
+				if (diff < 0) {
+					return false;	// empty
+				}
+				else
+					pos = dequeue_pos.load(std::memory_order_relaxed);
+		}
+
+		v = std::move(c->data);
+		c->seq.store(pos + mask + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool empty() const
+	{
+		return size() == 0;
+	}
+
+	// Approximate number of queued elements (exact when there are no concurrent operations)
+	size_t size() const
+	{
+		size_t d = dequeue_pos.load(std::memory_order_seq_cst);
+		size_t e = enqueue_pos.load(std::memory_order_seq_cst);
+		return e > d ? e - d : 0;
+	}
+
+	// Number of enqueue operations started so far (the position of the next enqueue)
+	size_t enqueue_position() const { return enqueue_pos.load(std::memory_order_acquire); }
+
+	size_t capacity() const { return mask + 1; }
+
+private:
+	struct Cell {
+		std::atomic<size_t> seq;
+		T data;
+	};
+
+	std::unique_ptr<Cell[]> cells;
+	size_t mask;
+
+	// on separate cache lines, to avoid false sharing between producers and the consumer
+	alignas(64) std::atomic<size_t> enqueue_pos;
+	alignas(64) std::atomic<size_t> dequeue_pos;
+};
+
+/*
+	Asynchronous sink, enabled by setting GIXSQL_LOG_ASYNC: messages are copied (with the timestamp
+	and thread id taken by the logger in the calling thread) to a bounded lock-free queue and written
+	to the target sink by a background thread, in batches. When the queue is full the caller either
+	waits for the writer thread or the message is dropped and counted, depending on the overflow policy.
+	The writer thread wakes up when the queue is half full or at a fixed interval, after which the
+	target sink is flushed, and when flush() is called.
+
+	Since the drivers attach their loggers to the first sink of the runtime library logger, they
+	use this sink too.
+*/
+class AsyncLogSink : public spdlog::sinks::sink
+{
+public:
+	AsyncLogSink(spdlog::sink_ptr target, size_t queue_size, AsyncLogOverflowPolicy policy, int flush_interval_ms);
+	~AsyncLogSink();
+
+	void log(const spdlog::details::log_msg& msg) override;
+	void flush() override;
+	void set_pattern(const std::string& pattern) override;
+	void set_formatter(std::unique_ptr<spdlog::formatter> sink_formatter) override;
+
+	// Writes all the pending messages and stops the writer thread: after this, messages are written synchronously
+	void stop();
+
+	uint64_t dropped() const { return dropped_count.load(std::memory_order_relaxed); }
+
+private:
+	void writer_loop();
+	void wake_writer();
+	void report_dropped();
+
+	spdlog::sink_ptr target;
+	BoundedMpmcQueue<spdlog::details::log_msg_buffer> queue;
+	AsyncLogOverflowPolicy policy;
+	std::chrono::milliseconds flush_interval;
+
+	std::thread writer;
+	std::atomic<bool> running;
+	std::atomic<bool> stopping;
+	std::atomic<bool> writer_idle;
+
+	std::atomic<uint64_t> written_count;
+	std::atomic<uint64_t> dropped_count;
+	uint64_t dropped_reported;
+
+	std::mutex writer_mutex;
+	std::condition_variable writer_cv;
+	bool wake_requested;
+
+	// flush() requests
+	std::mutex flush_mutex;
+	std::condition_variable flush_cv;
+	uint64_t flush_requested_seq;
+	uint64_t flushed_seq;
+};
@@ -93,3 +93,49 @@ std::shared_ptr<IDbInterface> Connection::getDbInterface()
 {
 	return dbi;
 }
+
+bool Connection::hasReplicas()
+{
+	return !replicas.empty();
+}
+
+std::vector<std::shared_ptr<Connection>> Connection::getReplicas()
+{
+	return replicas;
+}
+
+std::shared_ptr<Connection> Connection::nextReplica()
+{
+	if (replicas.empty())
+		return nullptr;
+
+	if (next_replica >= replicas.size())
+		next_replica = 0;
+
+	return replicas[next_replica++];
+}
+
+std::shared_ptr<Connection> Connection::getPrimary()
+{
+	return primary.lock();
+}
+
+bool Connection::isPinnedToPrimary()
+{
+	return pinned_to_primary;
+}
+
+void Connection::setPinnedToPrimary(bool b)
+{
+	pinned_to_primary = b;
+}
+
+bool Connection::isReadYourWrites()
+{
+	return read_your_writes;
+}
+
+void Connection::setReadYourWrites(bool b)
+{
+	read_your_writes = b;
+}
@@ -67,6 +67,17 @@ public:
 	std::shared_ptr<IConnectionOptions> getConnectionOptions() const override;
 	void setConnectionOptions(std::shared_ptr<IConnectionOptions>) override;
 
+	// Read/write split: read-only replicas of this connection (see the "read_replicas" option)
+	bool hasReplicas();
+	std::vector<std::shared_ptr<Connection>> getReplicas();
+	std::shared_ptr<Connection> nextReplica();
+	std::shared_ptr<Connection> getPrimary();
+
+	bool isPinnedToPrimary();
+	void setPinnedToPrimary(bool);
+	bool isReadYourWrites();
+	void setReadYourWrites(bool);
+
 private:
 
 	int id;
@@ -75,5 +86,13 @@ private:
 	bool is_opened = false;
 	std::shared_ptr<IConnectionOptions> options;
 	std::shared_ptr<IDbInterface> dbi;
+
+	std::vector<std::shared_ptr<Connection>> replicas;
+	size_t next_replica = 0;
+	std::weak_ptr<Connection> primary;
+
+	// Set after a write in a transaction (or after any write with read-your-writes enabled), reset on COMMIT/ROLLBACK
+	bool pinned_to_primary = false;
+	bool read_your_writes = false;
 };
 
@@ -99,6 +99,19 @@ void ConnectionManager::remove(std::shared_ptr<Connection> conn)
 		default_connection.reset();
 }
 
+// Replicas are not registered by name: they share the id of their primary connection
+// (so that cursor handling by connection id also applies to them) and are only reached through it
+void ConnectionManager::addReplica(std::shared_ptr<Connection> conn, std::shared_ptr<Connection> replica)
+{
+	if (conn == NULL || replica == NULL)
+		return;
+
+	replica->id = conn->id;
+	replica->name = conn->name + "#R" + std::to_string(conn->replicas.size() + 1);
+	replica->primary = conn;
+	conn->replicas.push_back(replica);
+}
+
 bool ConnectionManager::exists(const std::string& cname)
 {
 	return _connection_name_map.find(cname) != _connection_name_map.end();
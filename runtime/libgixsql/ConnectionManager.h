@@ -38,6 +38,7 @@ public:
 	std::shared_ptr<Connection> get(const std::string& name = "");
 	int add(std::shared_ptr<Connection> conn);
 	void remove(std::shared_ptr<Connection> conn);
+	void addReplica(std::shared_ptr<Connection> conn, std::shared_ptr<Connection> replica);
 	bool exists(const std::string& cname);
 	std::vector<std::shared_ptr<Connection>> list();
 	void clear();
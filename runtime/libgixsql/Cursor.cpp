@@ -115,6 +115,7 @@ bool Cursor::isWithHold()
 void Cursor::setOpened(bool b)
 {
 	is_opened = b;
+	clearFetchPlan();
 }
 
 void Cursor::setParameters(SqlVarList& l)
@@ -145,6 +146,16 @@ void Cursor::setWithHold(bool f)
 	is_with_hold = f;
 }
 
+void Cursor::setReadOnly(bool f)
+{
+	is_read_only = f;
+}
+
+bool Cursor::isReadOnly()
+{
+	return is_read_only;
+}
+
 uint64_t Cursor::getRowNum()
 {
 	return rownum;
@@ -245,3 +256,51 @@ std::string Cursor::getConnectionNameFromReference()
 	return trim_copy(s);
 }
 
+bool Cursor::hasFetchPlan(SqlVarList& res_vars)
+{
+	if (!has_fetch_plan || res_vars.size() != fetch_plan_vars.size())
+		return false;
+
+	for (int i = 0; i < res_vars.size(); i++) {
+		SqlVar* v = res_vars.at(i);
+		const FetchPlanVar& pv = fetch_plan_vars[i];
+		if (v->getAddr() != pv.addr || v->getIndAddr() != pv.ind_addr || v->getType() != pv.type ||
+			v->getLength() != pv.length || v->getPower() != pv.power || v->getFlags() != pv.flags)
+			return false;
+	}
+	return true;
+}
+
+void Cursor::buildFetchPlan(SqlVarList& res_vars)
+{
+	fetch_plan_vars.clear();
+	for (int i = 0; i < res_vars.size(); i++) {
+		SqlVar* v = res_vars.at(i);
+		fetch_plan_vars.push_back({ v->getType(), v->getLength(), v->getPower(), v->getFlags(), v->getAddr(), v->getIndAddr() });
+	}
+
+	// The buffer is only reallocated when it needs to grow
+	uint64_t bsize = res_vars.getMaxLength() + VARLEN_LENGTH_SZ + 1;
+	if (bsize > fetch_buffer_size) {
+		fetch_buffer = std::make_unique<char[]>(bsize);
+		fetch_buffer_size = bsize;
+	}
+
+	has_fetch_plan = true;
+}
+
+void Cursor::clearFetchPlan()
+{
+	has_fetch_plan = false;
+	fetch_plan_vars.clear();
+}
+
+char* Cursor::getFetchBuffer()
+{
+	return fetch_buffer.get();
+}
+
+uint64_t Cursor::getFetchBufferSize()
+{
+	return fetch_buffer_size;
+}
@@ -68,6 +68,8 @@ public:
 	SqlVarList& getParameters();
 	void createRealDataforParameters();
 	void setWithHold(bool);
+	void setReadOnly(bool);
+	bool isReadOnly();
 
 	uint64_t getRowNum() override;
 	void increaseRowNum() override;
@@ -75,6 +77,14 @@ public:
 	void setConnectionReference(void *d, int l);
 	std::string getConnectionNameFromReference();
 
+	// Fetch plan: built on the first FETCH after the cursor is opened, it is reused
+	// by the following ones as long as they use the same result variables
+	bool hasFetchPlan(SqlVarList& res_vars);
+	void buildFetchPlan(SqlVarList& res_vars);
+	void clearFetchPlan();
+	char* getFetchBuffer();
+	uint64_t getFetchBufferSize();
+
 private:
 
 	std::shared_ptr<IConnection> connection;
@@ -86,6 +96,7 @@ private:
 	int nParams = 0;
 	bool is_opened = false;
 	bool is_with_hold = false;
+	bool is_read_only = false;
 	int tuples = 0;
 
 	SqlVarList parameter_list; // parameter list
@@ -96,5 +107,19 @@ private:
 
 	void *connref_data = nullptr;
 	int connref_datalen = 0;
+
+	struct FetchPlanVar {
+		CobolVarType type;
+		unsigned long length;
+		int power;
+		uint32_t flags;
+		void* addr;
+		void* ind_addr;
+	};
+
+	bool has_fetch_plan = false;
+	std::vector<FetchPlanVar> fetch_plan_vars;
+	std::unique_ptr<char[]> fetch_buffer;
+	uint64_t fetch_buffer_size = 0;
 };
 
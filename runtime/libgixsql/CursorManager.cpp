@@ -106,8 +106,11 @@ void CursorManager::closeConnectionCursors(int connId, bool clear_held_cursors)
 
 	for (it = _cur_to_close.begin(); it != _cur_to_close.end(); it++) {
 		std::shared_ptr<Cursor> c = (*it);
-		if (c && c->getConnection() && c->getConnection()->getDbInterface())
+		// cursors that were never opened (or are already closed) have nothing to release on the server
+		if (c && c->isOpen() && c->getConnection() && c->getConnection()->getDbInterface()) {
 			c->getConnection()->getDbInterface()->cursor_close(c);
+			c->setOpened(false);
+		}
 	}
 }
 
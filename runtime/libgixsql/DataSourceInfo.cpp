@@ -96,7 +96,7 @@ int DataSourceInfo::init(const std::string& data_source, const std::string& dbna
 		return 0;
 	}
 
-	std::string connstring_rx_text_full = R"(^(?:((?:gixsql|mysql|pgsql|odbc|oracle|sqlite)\:))(\/\/(?:(([^:]+)##GIXSQL_USRPWD_SEP##([^:]+)@)?)[A-Za-z0-9\-_\.]+)(:[0-9]+)?(\/[A-Za-z0-9\-_]+)?\ *)";
+	std::string connstring_rx_text_full = R"(^(?:((?:gixsql|mysql|pgsql|odbc|oracle|sqlite|null)\:))(\/\/(?:(([^:]+)##GIXSQL_USRPWD_SEP##([^:]+)@)?)[A-Za-z0-9\-_\.]+)(:[0-9]+)?(\/[A-Za-z0-9\-_]+)?\ *)";
 	std::string connstring_rx_text_dflt_drvr = R"(^((?:(([^:]+)##GIXSQL_USRPWD_SEP##([^:]+)@)?)[A-Za-z0-9\-_\.]+)(:[0-9]+)?(\/[A-Za-z0-9\-_]+)?\ *)";
 	std::string connstring_rx_text_ocesql = R"(^((?:(([^:]+)@)?)([A-Za-z0-9\-_\.]+))(:[0-9]+)?\ *)";
 	std::string connstring_rx_text;
@@ -467,7 +467,8 @@ bool DataSourceInfo::is_sqlite(const std::string& ds, bool *uses_default_driver)
 		!starts_with(ds, "pgsql://") &&
 		!starts_with(ds, "mysql://") &&
 		!starts_with(ds, "odbc://") &&
-		!starts_with(ds, "oracle://")
+		!starts_with(ds, "oracle://") &&
+		!starts_with(ds, "null://")
 	) {
 		*uses_default_driver = true;
 		return true;
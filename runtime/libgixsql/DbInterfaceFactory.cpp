@@ -74,6 +74,9 @@ std::shared_ptr<IDbInterface> DbInterfaceFactory::getInterface(int type, const s
 		case DB_SQLITE:
 			return load_dblib("sqlite");
 
+		case DB_NULL_DRIVER:
+			return load_dblib("null");
+
 		default:
 			return NULL;
 	}
@@ -96,6 +99,9 @@ std::shared_ptr<IDbInterface> DbInterfaceFactory::getInterface(std::string t, co
 		if (t == "sqlite")
 			return load_dblib("sqlite");
 
+		if (t == "null")
+			return load_dblib("null");
+
 		return NULL;
 }
 
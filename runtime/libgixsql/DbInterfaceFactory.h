@@ -27,6 +27,7 @@
 #define DB_MSSQL			5	// Currently unused
 #define DB_DB2  			6	// Currently unused (uses ODBC)
 #define DB_SQLITE  			7
+#define DB_NULL_DRIVER		8	// Benchmark driver (no database)
 #define DB_SET_RUNTIME		-1
 
 #include "Logger.h"
@@ -119,6 +119,14 @@ enum class DbPropertySetResult {
 	Unsupported = 2
 };
 
+// Static statement listed in a module manifest (registered with GIXSQLRegisterStatement)
+struct StaticStatementInfo {
+	std::string query;
+	bool is_cursor = false;
+	std::vector<CobolVarType> param_types;
+	std::vector<uint32_t> param_flags;
+};
+
 class IDbInterface
 {
 	friend class DbInterfaceFactory;
@@ -159,9 +167,30 @@ public:
 		return get_native_features() & ((uint64_t)f);
 	}
 
+	// Prepares the static statements registered by the modules on a new connection, so that they are already
+	// known to the server when first executed. Drivers that would not benefit from it just ignore them
+	virtual int prepare_static(const std::vector<std::shared_ptr<StaticStatementInfo>>& stmts)
+	{
+		return DBERR_NO_ERROR;
+	}
+
+	// Retrieves the execution plan of a statement (used by the slow statement log), without affecting the
+	// state of the connection (current resultset, last error). Drivers that cannot do it return DBERR_NOT_IMPL
+	virtual int explain(const std::string& query, const std::vector<CobolVarType>& paramTypes, const std::vector<std_binary_data>& paramValues, const std::vector<unsigned long>& paramLengths, const std::vector<uint32_t>& paramFlags, std::string& plan)
+	{
+		return DBERR_NOT_IMPL;
+	}
+
+	// Classification flags (see sql_stmt_flags.h) of the statement about to be executed, if it was provided by the preprocessor
+	void set_statement_flags(uint32_t f)
+	{
+		stmt_flags = f;
+	}
+
 protected:
 
 	std::shared_ptr<spdlog::logger> lib_logger;
+	uint32_t stmt_flags = 0;
 
 private:
 	void *native_lib_ptr = nullptr;	
@@ -30,5 +30,6 @@
 #define DEFAULT_GIXSQL_LOG_FILE		"gixsql.log"
 #define DEFAULT_GIXSQL_LOG_LEVEL	spdlog::level::err
 #define DEFAULT_GIXSQL_LOG_TRUNC	false
+#define DEFAULT_GIXSQL_LOG_MAX_FILES	3
 
 extern std::shared_ptr<spdlog::logger> gixsql_logger;
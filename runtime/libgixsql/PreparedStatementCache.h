@@ -0,0 +1,154 @@
+/*
+* This file is part of Gix-IDE, an IDE and platform for GnuCOBOL
+* Copyright (C) 2021 Marco Ridoni
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public License
+* as published by the Free Software Foundation; either version 3,
+* or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library; see the file COPYING.LIB.  If
+* not, write to the Free Software Foundation, 51 Franklin Street, Fifth Floor
+* Boston, MA 02110-1301 USA
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <list>
+#include <map>
+#include <unordered_map>
+#include <memory>
+
+#define DEFAULT_PREPARED_STMT_CACHE_MEMORY	(1024 * 1024)
+
+// Rough estimate of the memory used by a driver statement, besides its SQL text
+#define PREPARED_STMT_CACHE_ENTRY_OVERHEAD	1024
+
+/*
+	Per-connection cache of prepared statements, keyed by their SQL text: it allows a driver to reuse
+	a statement when the same text is prepared again, instead of having the server parse and plan it
+	once more (e.g. a PREPARE executed in a loop, or a name alternately prepared from different texts).
+	Some drivers also keep here the statements executed directly (static SQL), looking them up with an
+	empty name so that a statement bound to a prepared statement name is never shared with them.
+	Statements are reference-counted: when an entry is evicted (least recently used first, once the
+	estimated memory used exceeds the configured limit) only the reference held by the cache is released,
+	the statement is actually freed when it is not bound to any name anymore.
+*/
+template <class T>
+class PreparedStatementCache
+{
+public:
+	// A limit of 0 disables the cache
+	void setMaxMemory(uint64_t n)
+	{
+		max_memory = n;
+		evict();
+	}
+
+	// Reads the memory limit from the connection options, if set
+	void setMaxMemory(std::map<std::string, std::string>& opts)
+	{
+		if (opts.find("prepared_stmt_cache_memory") != opts.end()) {
+			std::string v = opts["prepared_stmt_cache_memory"];
+			if (!v.empty() && v.find_first_not_of("0123456789") == std::string::npos)
+				setMaxMemory(std::strtoull(v.c_str(), nullptr, 10));
+		}
+	}
+
+	std::shared_ptr<T> find(const std::string& sql)
+	{
+		auto it = entries.find(sql);
+		if (it == entries.end())
+			return nullptr;
+
+		lru.splice(lru.begin(), lru, it->second.lru_pos);
+		return it->second.stmt;
+	}
+
+	// Returns the statement cached for the given text, unless it is currently bound to a name other than
+	// stmt_name: different names never share a statement, since each of them can have a cursor open on it
+	std::shared_ptr<T> find(const std::string& sql, const std::string& stmt_name, const std::map<std::string, std::shared_ptr<T>>& bound_stmts)
+	{
+		std::shared_ptr<T> stmt = find(sql);
+		if (!stmt)
+			return nullptr;
+
+		for (const auto& b : bound_stmts) {
+			if (b.second == stmt && b.first != stmt_name)
+				return nullptr;
+		}
+
+		return stmt;
+	}
+
+	void add(const std::string& sql, const std::shared_ptr<T>& stmt)
+	{
+		if (!max_memory || !stmt)
+			return;
+
+		auto it = entries.find(sql);
+		if (it != entries.end()) {
+			it->second.stmt = stmt;
+			lru.splice(lru.begin(), lru, it->second.lru_pos);
+			return;
+		}
+
+		lru.push_front(sql);
+		entries[sql] = { stmt, lru.begin() };
+		memory_used += entry_size(sql);
+
+		evict();
+	}
+
+	void clear()
+	{
+		entries.clear();
+		lru.clear();
+		memory_used = 0;
+	}
+
+	size_t size() const
+	{
+		return entries.size();
+	}
+
+	uint64_t memoryUsed() const
+	{
+		return memory_used;
+	}
+
+private:
+	struct Entry {
+		std::shared_ptr<T> stmt;
+		std::list<std::string>::iterator lru_pos;
+	};
+
+	std::unordered_map<std::string, Entry> entries;
+	std::list<std::string> lru;
+	uint64_t memory_used = 0;
+	uint64_t max_memory = DEFAULT_PREPARED_STMT_CACHE_MEMORY;
+
+	static uint64_t entry_size(const std::string& sql)
+	{
+		return (sql.size() * 2) + PREPARED_STMT_CACHE_ENTRY_OVERHEAD;	// the text is stored in both the map and the LRU list
+	}
+
+	void evict()
+	{
+		while (memory_used > max_memory && !lru.empty()) {
+			const std::string& sql = lru.back();
+			memory_used -= entry_size(sql);
+			entries.erase(sql);
+			lru.pop_back();
+		}
+	}
+};
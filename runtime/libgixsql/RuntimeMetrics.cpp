@@ -0,0 +1,532 @@
+/*
+* This file is part of Gix-IDE, an IDE and platform for GnuCOBOL
+* Copyright (C) 2021 Marco Ridoni
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public License
+* as published by the Free Software Foundation; either version 3,
+* or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library; see the file COPYING.LIB.  If
+* not, write to the Free Software Foundation, 51 Franklin Street, Fifth Floor
+* Boston, MA 02110-1301 USA
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <csignal>
+#include <chrono>
+#include <map>
+#include <tuple>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#if (defined(_WIN32) || defined(_WIN64)) && !defined(__MINGW32__)
+#include <process.h>
+#include <intrin.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+#include "RuntimeMetrics.h"
+#include "Logger.h"
+#include "utils.h"
+
+bool RuntimeMetrics::is_enabled = false;
+bool RuntimeMetrics::is_timing = false;
+std::string RuntimeMetrics::metrics_file;
+int RuntimeMetrics::metrics_format = METRICS_FORMAT_JSON;
+
+static volatile sig_atomic_t dump_requested = 0;
+
+// Counters are only written by the thread that owns them, so a relaxed load/store is enough
+// (no locked instructions) and the dump can read them at any time
+struct MetricsCounter {
+	std::atomic<uint64_t> v{ 0 };
+
+	void add(uint64_t n) { v.store(v.load(std::memory_order_relaxed) + n, std::memory_order_relaxed); }
+	uint64_t get() const { return v.load(std::memory_order_relaxed); }
+};
+
+static int log2_floor(uint64_t v)
+{
+#if defined(_MSC_VER)
+	unsigned long r;
+	_BitScanReverse64(&r, v);
+	return (int)r;
+#else
+	return 63 - __builtin_clzll(v);
+#endif
+}
+
+static int histogram_bucket(uint64_t v)
+{
+	const uint64_t sub_count = (uint64_t)1 << METRICS_HISTOGRAM_SUB_BITS;
+	if (v < sub_count)
+		return (int)v;
+
+	int m = log2_floor(v);
+	if (m > METRICS_HISTOGRAM_MAX_MAGNITUDE)
+		return METRICS_HISTOGRAM_BUCKETS - 1;
+
+	int sub = (int)((v >> (m - METRICS_HISTOGRAM_SUB_BITS)) & (sub_count - 1));
+	return ((m - METRICS_HISTOGRAM_SUB_BITS + 1) << METRICS_HISTOGRAM_SUB_BITS) + sub;
+}
+
+// Upper bound of the values that fall in a bucket
+static uint64_t histogram_bucket_value(int b)
+{
+	const int sub_count = 1 << METRICS_HISTOGRAM_SUB_BITS;
+	if (b < sub_count)
+		return b;
+
+	int m = (b >> METRICS_HISTOGRAM_SUB_BITS) + METRICS_HISTOGRAM_SUB_BITS - 1;
+	uint64_t sub = b & (sub_count - 1);
+	return ((sub_count + sub + 1) << (m - METRICS_HISTOGRAM_SUB_BITS)) - 1;
+}
+
+struct MetricsHistogram {
+	MetricsCounter buckets[METRICS_HISTOGRAM_BUCKETS];
+	MetricsCounter sum;
+	MetricsCounter max;
+
+	void record(uint64_t v)
+	{
+		buckets[histogram_bucket(v)].add(1);
+		sum.add(v);
+		if (v > max.get())
+			max.v.store(v, std::memory_order_relaxed);
+	}
+};
+
+struct StatementMetrics {
+	std::string op;
+	std::string stmt_id;
+	std::string sql;
+	std::string connection;
+	std::string driver;
+
+	MetricsCounter calls;
+	MetricsCounter errors;
+	MetricsCounter rows_fetched;
+	MetricsCounter rows_affected;
+	MetricsCounter bytes_in;
+	MetricsCounter bytes_out;
+	MetricsHistogram driver_time;
+	MetricsHistogram conversion_time;
+};
+
+struct MetricsShard {
+	std::mutex mtx;	// only taken when a new entry is added and when dumping
+	std::unordered_map<std::string, std::unique_ptr<StatementMetrics>> entries;
+};
+
+// Snapshot used when dumping: shards are merged by statement, connection and driver
+struct MetricsAggregate {
+	std::string sql;
+	uint64_t calls = 0;
+	uint64_t errors = 0;
+	uint64_t rows_fetched = 0;
+	uint64_t rows_affected = 0;
+	uint64_t bytes_in = 0;
+	uint64_t bytes_out = 0;
+	std::vector<uint64_t> driver_time = std::vector<uint64_t>(METRICS_HISTOGRAM_BUCKETS + 2);		// buckets, sum, max
+	std::vector<uint64_t> conversion_time = std::vector<uint64_t>(METRICS_HISTOGRAM_BUCKETS + 2);
+
+	void merge(const StatementMetrics& m)
+	{
+		if (sql.empty())
+			sql = m.sql;
+
+		calls += m.calls.get();
+		errors += m.errors.get();
+		rows_fetched += m.rows_fetched.get();
+		rows_affected += m.rows_affected.get();
+		bytes_in += m.bytes_in.get();
+		bytes_out += m.bytes_out.get();
+		merge_histogram(driver_time, m.driver_time);
+		merge_histogram(conversion_time, m.conversion_time);
+	}
+
+	void merge(const MetricsAggregate& a)
+	{
+		calls += a.calls;
+		errors += a.errors;
+		rows_fetched += a.rows_fetched;
+		rows_affected += a.rows_affected;
+		bytes_in += a.bytes_in;
+		bytes_out += a.bytes_out;
+		for (int i = 0; i < METRICS_HISTOGRAM_BUCKETS + 1; i++) {
+			driver_time[i] += a.driver_time[i];
+			conversion_time[i] += a.conversion_time[i];
+		}
+		driver_time[METRICS_HISTOGRAM_BUCKETS + 1] = std::max(driver_time[METRICS_HISTOGRAM_BUCKETS + 1], a.driver_time[METRICS_HISTOGRAM_BUCKETS + 1]);
+		conversion_time[METRICS_HISTOGRAM_BUCKETS + 1] = std::max(conversion_time[METRICS_HISTOGRAM_BUCKETS + 1], a.conversion_time[METRICS_HISTOGRAM_BUCKETS + 1]);
+	}
+
+	static void merge_histogram(std::vector<uint64_t>& h, const MetricsHistogram& mh)
+	{
+		for (int i = 0; i < METRICS_HISTOGRAM_BUCKETS; i++)
+			h[i] += mh.buckets[i].get();
+		h[METRICS_HISTOGRAM_BUCKETS] += mh.sum.get();
+		h[METRICS_HISTOGRAM_BUCKETS + 1] = std::max(h[METRICS_HISTOGRAM_BUCKETS + 1], mh.max.get());
+	}
+};
+
+// statement: op, statement id, connection, driver
+using StatementKey = std::tuple<std::string, std::string, std::string, std::string>;
+
+static std::mutex& shards_mutex()
+{
+	static std::mutex m;
+	return m;
+}
+
+static std::vector<std::shared_ptr<MetricsShard>>& shards()
+{
+	static std::vector<std::shared_ptr<MetricsShard>> v;
+	return v;
+}
+
+static MetricsShard* get_shard()
+{
+	thread_local std::shared_ptr<MetricsShard> shard;
+	if (!shard) {
+		shard = std::make_shared<MetricsShard>();
+		std::lock_guard<std::mutex> lock(shards_mutex());
+		shards().push_back(shard);
+	}
+	return shard.get();
+}
+
+static thread_local MetricsSample current_sample;
+static thread_local int current_depth = 0;
+
+static void on_dump_signal(int)
+{
+	dump_requested = 1;
+}
+
+static void dump_at_exit()
+{
+	RuntimeMetrics::dump();
+}
+
+void RuntimeMetrics::init()
+{
+	char* f = getenv("GIXSQL_METRICS_FILE");
+	if (!f || !strlen(f))
+		return;
+
+	metrics_file = f;
+	if (metrics_file.find("$$") != std::string::npos)
+		metrics_file = string_replace(metrics_file, "$$", std::to_string(getpid()));
+
+	char* format = getenv("GIXSQL_METRICS_FORMAT");
+	if (format && to_lower(format) == "prometheus")
+		metrics_format = METRICS_FORMAT_PROMETHEUS;
+
+	// The dump is not performed in the signal handler, but by the next GIXSQL call
+#if !defined(_WIN32) && !defined(_WIN64)
+	char* sig = getenv("GIXSQL_METRICS_SIGNAL");
+	if (sig) {
+		std::string s = to_upper(sig);
+		int signo = (s == "USR1" || s == "SIGUSR1") ? SIGUSR1 : (s == "USR2" || s == "SIGUSR2") ? SIGUSR2 : atoi(sig);
+		if (signo > 0)
+			signal(signo, on_dump_signal);
+	}
+#endif
+
+	// The shard registry must be constructed before the exit handler is registered,
+	// otherwise it would be destroyed before the final dump runs
+	shards_mutex();
+	shards();
+
+	std::atexit(dump_at_exit);
+
+	is_enabled = true;
+	is_timing = true;
+	spdlog::info("GixSQL: runtime metrics enabled, file: {}", metrics_file);
+}
+
+uint64_t RuntimeMetrics::now()
+{
+	if (!is_timing)
+		return 0;
+
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void RuntimeMetrics::begin(const char* op)
+{
+	if (current_depth++ > 0)
+		return;
+
+	current_sample.op = op;
+	current_sample.stmt_id.clear();
+	current_sample.sql.clear();
+	current_sample.connection.clear();
+	current_sample.driver.clear();
+	current_sample.driver_time = 0;
+	current_sample.conversion_time = 0;
+	current_sample.rows_fetched = 0;
+	current_sample.rows_affected = 0;
+	current_sample.bytes_in = 0;
+	current_sample.bytes_out = 0;
+	current_sample.start = now();
+}
+
+void RuntimeMetrics::end(bool is_error)
+{
+	if (current_depth == 0 || --current_depth > 0)
+		return;
+
+	// Calls that did not reach a statement (e.g. invalid arguments) are not recorded
+	if (current_sample.stmt_id.empty())
+		return;
+
+	MetricsShard* shard = get_shard();
+	std::string key = current_sample.op + '\x1f' + current_sample.stmt_id + '\x1f' + current_sample.connection;
+
+	auto it = shard->entries.find(key);
+	if (it == shard->entries.end()) {
+		std::unique_ptr<StatementMetrics> m = std::make_unique<StatementMetrics>();
+		m->op = current_sample.op;
+		m->stmt_id = current_sample.stmt_id;
+		m->sql = current_sample.sql;
+		m->connection = current_sample.connection;
+		m->driver = current_sample.driver;
+
+		std::lock_guard<std::mutex> lock(shard->mtx);
+		it = shard->entries.emplace(key, std::move(m)).first;
+	}
+
+	StatementMetrics* m = it->second.get();
+	m->calls.add(1);
+	if (is_error)
+		m->errors.add(1);
+	m->rows_fetched.add(current_sample.rows_fetched);
+	m->rows_affected.add(current_sample.rows_affected);
+	m->bytes_in.add(current_sample.bytes_in);
+	m->bytes_out.add(current_sample.bytes_out);
+	m->driver_time.record(current_sample.driver_time);
+	m->conversion_time.record(current_sample.conversion_time);
+
+	if (dump_requested) {
+		dump_requested = 0;
+		dump();
+	}
+}
+
+void RuntimeMetrics::setStatement(const std::string& stmt_id, const std::string& sql)
+{
+	if (current_depth == 0)
+		return;
+
+	if (!stmt_id.empty()) {
+		current_sample.stmt_id = stmt_id;
+	}
+	else {
+		// Statements without an id (dynamic SQL, or no ids emitted by the preprocessor) are identified by their text
+		char bfr[24];
+		snprintf(bfr, sizeof(bfr), "sql:%016llx", (unsigned long long)std::hash<std::string>{}(sql));
+		current_sample.stmt_id = bfr;
+	}
+	current_sample.sql = sql;
+}
+
+void RuntimeMetrics::setConnection(const std::string& connection, const std::string& driver)
+{
+	if (current_depth == 0)
+		return;
+
+	current_sample.connection = connection;
+	current_sample.driver = driver;
+}
+
+void RuntimeMetrics::addDriverTime(uint64_t since)
+{
+	if (current_depth > 0)
+		current_sample.driver_time += now() - since;
+}
+
+void RuntimeMetrics::addConversionTime(uint64_t since)
+{
+	if (current_depth > 0)
+		current_sample.conversion_time += now() - since;
+}
+
+void RuntimeMetrics::addRowsFetched(uint64_t n)
+{
+	if (current_depth > 0)
+		current_sample.rows_fetched += n;
+}
+
+void RuntimeMetrics::addRowsAffected(uint64_t n)
+{
+	if (current_depth > 0)
+		current_sample.rows_affected += n;
+}
+
+void RuntimeMetrics::addBytesIn(uint64_t n)
+{
+	if (current_depth > 0)
+		current_sample.bytes_in += n;
+}
+
+void RuntimeMetrics::addBytesOut(uint64_t n)
+{
+	if (current_depth > 0)
+		current_sample.bytes_out += n;
+}
+
+static uint64_t histogram_percentile(const std::vector<uint64_t>& h, double p)
+{
+	uint64_t count = 0;
+	for (int i = 0; i < METRICS_HISTOGRAM_BUCKETS; i++)
+		count += h[i];
+
+	if (count == 0)
+		return 0;
+
+	uint64_t target = (uint64_t)(p * count);
+	if (target < 1)
+		target = 1;
+
+	uint64_t n = 0;
+	for (int i = 0; i < METRICS_HISTOGRAM_BUCKETS; i++) {
+		n += h[i];
+		if (n >= target)
+			return std::min(histogram_bucket_value(i), h[METRICS_HISTOGRAM_BUCKETS + 1]);
+	}
+	return h[METRICS_HISTOGRAM_BUCKETS + 1];
+}
+
+static std::string prom_escape(const std::string& s)
+{
+	std::string res;
+	for (char c : s) {
+		if (c == '"' || c == '\\')
+			res += '\\';
+		if (c == '\n')
+			res += "\\n";
+		else
+			res += c;
+	}
+	return res;
+}
+
+static const double metrics_quantiles[] = { 0.5, 0.9, 0.99, 0.999 };
+
+static std::string json_histogram(const std::vector<uint64_t>& h)
+{
+	return fmt::format("{{ \"sum\": {}, \"max\": {}, \"p50\": {}, \"p90\": {}, \"p99\": {}, \"p999\": {} }}",
+		h[METRICS_HISTOGRAM_BUCKETS], h[METRICS_HISTOGRAM_BUCKETS + 1],
+		histogram_percentile(h, 0.5), histogram_percentile(h, 0.9), histogram_percentile(h, 0.99), histogram_percentile(h, 0.999));
+}
+
+static std::string json_aggregate(const std::string& labels, const MetricsAggregate& a)
+{
+	return fmt::format("{{ {}, \"calls\": {}, \"errors\": {}, \"rows_fetched\": {}, \"rows_affected\": {}, \"bytes_in\": {}, \"bytes_out\": {}, \"driver_time_ns\": {}, \"conversion_time_ns\": {} }}",
+		labels, a.calls, a.errors, a.rows_fetched, a.rows_affected, a.bytes_in, a.bytes_out, json_histogram(a.driver_time), json_histogram(a.conversion_time));
+}
+
+static void prom_aggregate(FILE* f, const std::string& prefix, const std::string& labels, const MetricsAggregate& a)
+{
+	fprintf(f, "%s_calls_total{%s} %llu\n", prefix.c_str(), labels.c_str(), (unsigned long long)a.calls);
+	fprintf(f, "%s_errors_total{%s} %llu\n", prefix.c_str(), labels.c_str(), (unsigned long long)a.errors);
+	fprintf(f, "%s_rows_fetched_total{%s} %llu\n", prefix.c_str(), labels.c_str(), (unsigned long long)a.rows_fetched);
+	fprintf(f, "%s_rows_affected_total{%s} %llu\n", prefix.c_str(), labels.c_str(), (unsigned long long)a.rows_affected);
+	fprintf(f, "%s_bytes_in_total{%s} %llu\n", prefix.c_str(), labels.c_str(), (unsigned long long)a.bytes_in);
+	fprintf(f, "%s_bytes_out_total{%s} %llu\n", prefix.c_str(), labels.c_str(), (unsigned long long)a.bytes_out);
+
+	for (auto h : { std::make_pair("driver", &a.driver_time), std::make_pair("conversion", &a.conversion_time) }) {
+		for (double q : metrics_quantiles)
+			fprintf(f, "%s_%s_seconds{%s,quantile=\"%g\"} %.9f\n", prefix.c_str(), h.first, labels.c_str(), q, histogram_percentile(*h.second, q) / 1e9);
+		fprintf(f, "%s_%s_seconds_sum{%s} %.9f\n", prefix.c_str(), h.first, labels.c_str(), (*h.second)[METRICS_HISTOGRAM_BUCKETS] / 1e9);
+		fprintf(f, "%s_%s_seconds_count{%s} %llu\n", prefix.c_str(), h.first, labels.c_str(), (unsigned long long)a.calls);
+	}
+}
+
+bool RuntimeMetrics::dump()
+{
+	if (!is_enabled)
+		return false;
+
+	std::map<StatementKey, MetricsAggregate> stmts;
+	std::map<std::tuple<std::string, std::string>, MetricsAggregate> conns;
+	std::map<std::string, MetricsAggregate> drivers;
+
+	{
+		std::lock_guard<std::mutex> lock(shards_mutex());
+		for (auto shard : shards()) {
+			std::lock_guard<std::mutex> shard_lock(shard->mtx);
+			for (auto& e : shard->entries) {
+				const StatementMetrics& m = *e.second;
+				stmts[std::make_tuple(m.op, m.stmt_id, m.connection, m.driver)].merge(m);
+			}
+		}
+	}
+
+	for (auto& s : stmts) {
+		conns[std::make_tuple(std::get<2>(s.first), std::get<3>(s.first))].merge(s.second);
+		drivers[std::get<3>(s.first)].merge(s.second);
+	}
+
+	FILE* f = fopen(metrics_file.c_str(), "w");
+	if (!f) {
+		spdlog::error("Cannot write runtime metrics to {}", metrics_file);
+		return false;
+	}
+
+	if (metrics_format == METRICS_FORMAT_PROMETHEUS) {
+		for (auto& s : stmts) {
+			std::string labels = fmt::format("op=\"{}\",statement=\"{}\",connection=\"{}\",driver=\"{}\"",
+				std::get<0>(s.first), prom_escape(std::get<1>(s.first)), prom_escape(std::get<2>(s.first)), std::get<3>(s.first));
+			prom_aggregate(f, "gixsql_statement", labels, s.second);
+		}
+		for (auto& c : conns) {
+			std::string labels = fmt::format("connection=\"{}\",driver=\"{}\"", prom_escape(std::get<0>(c.first)), std::get<1>(c.first));
+			prom_aggregate(f, "gixsql_connection", labels, c.second);
+		}
+		for (auto& d : drivers) {
+			prom_aggregate(f, "gixsql_driver", fmt::format("driver=\"{}\"", d.first), d.second);
+		}
+	}
+	else {
+		fprintf(f, "{\n  \"pid\": %d,\n  \"statements\": [\n", (int)getpid());
+		int n = 0;
+		for (auto& s : stmts) {
+			std::string labels = fmt::format("\"op\": \"{}\", \"statement\": \"{}\", \"connection\": \"{}\", \"driver\": \"{}\", \"sql\": \"{}\"",
+				std::get<0>(s.first), json_escape(std::get<1>(s.first)), json_escape(std::get<2>(s.first)), std::get<3>(s.first), json_escape(s.second.sql));
+			fprintf(f, "%s    %s", n++ ? ",\n" : "", json_aggregate(labels, s.second).c_str());
+		}
+		fprintf(f, "\n  ],\n  \"connections\": [\n");
+		n = 0;
+		for (auto& c : conns) {
+			std::string labels = fmt::format("\"connection\": \"{}\", \"driver\": \"{}\"", json_escape(std::get<0>(c.first)), std::get<1>(c.first));
+			fprintf(f, "%s    %s", n++ ? ",\n" : "", json_aggregate(labels, c.second).c_str());
+		}
+		fprintf(f, "\n  ],\n  \"drivers\": [\n");
+		n = 0;
+		for (auto& d : drivers) {
+			std::string labels = fmt::format("\"driver\": \"{}\"", d.first);
+			fprintf(f, "%s    %s", n++ ? ",\n" : "", json_aggregate(labels, d.second).c_str());
+		}
+		fprintf(f, "\n  ]\n}\n");
+	}
+
+	fclose(f);
+	return true;
+}
@@ -0,0 +1,108 @@
+/*
+* This file is part of Gix-IDE, an IDE and platform for GnuCOBOL
+* Copyright (C) 2021 Marco Ridoni
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public License
+* as published by the Free Software Foundation; either version 3,
+* or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library; see the file COPYING.LIB.  If
+* not, write to the Free Software Foundation, 51 Franklin Street, Fifth Floor
+* Boston, MA 02110-1301 USA
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <atomic>
+
+// Latency histograms: log-linear buckets (2^METRICS_HISTOGRAM_SUB_BITS buckets for each power of 2),
+// values are in nanoseconds and clamped to 2^METRICS_HISTOGRAM_MAX_MAGNITUDE
+#define METRICS_HISTOGRAM_SUB_BITS		3
+#define METRICS_HISTOGRAM_MAX_MAGNITUDE	47
+#define METRICS_HISTOGRAM_BUCKETS		((METRICS_HISTOGRAM_MAX_MAGNITUDE - METRICS_HISTOGRAM_SUB_BITS + 2) << METRICS_HISTOGRAM_SUB_BITS)
+
+#define METRICS_FORMAT_JSON			1
+#define METRICS_FORMAT_PROMETHEUS	2
+
+// Data collected during a single GIXSQL call
+struct MetricsSample {
+	std::string op;
+	std::string stmt_id;
+	std::string sql;
+	std::string connection;
+	std::string driver;
+
+	uint64_t start = 0;
+	uint64_t driver_time = 0;
+	uint64_t conversion_time = 0;
+	uint64_t rows_fetched = 0;
+	uint64_t rows_affected = 0;
+	uint64_t bytes_in = 0;
+	uint64_t bytes_out = 0;
+};
+
+/*
+	Runtime metrics, enabled by setting GIXSQL_METRICS_FILE: call counts, latency histograms (time spent in
+	the driver and in data conversion), rows and bytes transferred for each statement, connection and driver.
+	Metrics are collected in per-thread shards (counters have a single writer, so no locks are taken on the
+	hot path) and are dumped to the metrics file, as JSON or Prometheus text, at exit or on request (signal).
+*/
+class RuntimeMetrics
+{
+public:
+	static void init();
+	static bool dump();
+
+	static inline bool enabled() { return is_enabled; }
+
+	// Returns 0 unless timing is needed (by the metrics, or by other components that enable it)
+	static uint64_t now();
+	static inline void enableTiming() { is_timing = true; }
+
+	// The current GIXSQL call (one per thread)
+	static void begin(const char* op);
+	static void end(bool is_error);
+	static void setStatement(const std::string& stmt_id, const std::string& sql);
+	static void setConnection(const std::string& connection, const std::string& driver);
+	static void addDriverTime(uint64_t since);
+	static void addConversionTime(uint64_t since);
+	static void addRowsFetched(uint64_t n);
+	static void addRowsAffected(uint64_t n);
+	static void addBytesIn(uint64_t n);
+	static void addBytesOut(uint64_t n);
+
+private:
+	static bool is_enabled;
+	static bool is_timing;
+	static std::string metrics_file;
+	static int metrics_format;
+};
+
+// Records the current GIXSQL call when it goes out of scope
+class MetricsCallScope
+{
+public:
+	MetricsCallScope(const char* op, const int* sqlcode) : sqlcode(sqlcode)
+	{
+		if (RuntimeMetrics::enabled())
+			RuntimeMetrics::begin(op);
+	}
+
+	~MetricsCallScope()
+	{
+		if (RuntimeMetrics::enabled())
+			RuntimeMetrics::end(sqlcode && *sqlcode < 0);
+	}
+
+private:
+	const int* sqlcode;
+};
@@ -0,0 +1,126 @@
+/*
+* This file is part of Gix-IDE, an IDE and platform for GnuCOBOL
+* Copyright (C) 2021 Marco Ridoni
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public License
+* as published by the Free Software Foundation; either version 3,
+* or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library; see the file COPYING.LIB.  If
+* not, write to the Free Software Foundation, 51 Franklin Street, Fifth Floor
+* Boston, MA 02110-1301 USA
+*/
+
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <chrono>
+#include <mutex>
+
+#if (defined(_WIN32) || defined(_WIN64)) && !defined(__MINGW32__)
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+#include "SlowStatementLog.h"
+#include "RuntimeMetrics.h"
+#include "Logger.h"
+#include "utils.h"
+
+bool SlowStatementLog::is_enabled = false;
+uint64_t SlowStatementLog::threshold_ns = (uint64_t)SLOW_LOG_THRESHOLD_DEFAULT * 1000000;
+bool SlowStatementLog::explain_enabled = false;
+bool SlowStatementLog::mask_params = false;
+std::string SlowStatementLog::log_file;
+
+static std::mutex slow_log_mutex;
+
+static bool is_option_on(const char* v)
+{
+	if (!v)
+		return false;
+
+	std::string s = to_lower(v);
+	return s == "on" || s == "1" || s == "true";
+}
+
+void SlowStatementLog::init()
+{
+	char* f = getenv("GIXSQL_SLOW_LOG_FILE");
+	if (!f || !strlen(f))
+		return;
+
+	log_file = f;
+	if (log_file.find("$$") != std::string::npos)
+		log_file = string_replace(log_file, "$$", std::to_string(getpid()));
+
+	char* t = getenv("GIXSQL_SLOW_LOG_THRESHOLD");
+	if (t && strlen(t)) {
+		int ms = atoi(t);
+		if (ms >= 0)
+			threshold_ns = (uint64_t)ms * 1000000;
+	}
+
+	explain_enabled = is_option_on(getenv("GIXSQL_SLOW_LOG_EXPLAIN"));
+	mask_params = is_option_on(getenv("GIXSQL_SLOW_LOG_MASK_PARAMS"));
+
+	RuntimeMetrics::enableTiming();
+
+	is_enabled = true;
+	spdlog::info("GixSQL: slow statement log enabled, file: {}, threshold: {} ms", log_file, threshold_ns / 1000000);
+}
+
+void SlowStatementLog::write(const SlowStatementEntry& e)
+{
+	auto ts = std::chrono::system_clock::now();
+	time_t tt = std::chrono::system_clock::to_time_t(ts);
+	int ms = (int)(std::chrono::duration_cast<std::chrono::milliseconds>(ts.time_since_epoch()).count() % 1000);
+
+	struct tm tm_buf;
+#if defined(_WIN32) || defined(_WIN64)
+	localtime_s(&tm_buf, &tt);
+#else
+	localtime_r(&tt, &tm_buf);
+#endif
+	char time_bfr[32];
+	strftime(time_bfr, sizeof(time_bfr), "%Y-%m-%dT%H:%M:%S", &tm_buf);
+
+	std::string params;
+	for (size_t i = 0; i < e.params.size(); i++) {
+		if (i > 0)
+			params += ", ";
+		params += "\"" + json_escape(e.params.at(i)) + "\"";
+	}
+
+	std::string ln = fmt::format("{{\"time\": \"{}.{:03d}\", \"pid\": {}, \"elapsed_ms\": {:.3f}, \"op\": \"{}\", \"stmt_id\": \"{}\", \"source\": \"{}\", "
+		"\"connection\": \"{}\", \"driver\": \"{}\", \"sql\": \"{}\", \"params\": [{}], \"rows\": {}, \"rc\": {}",
+		time_bfr, ms, (int)getpid(), (double)e.elapsed / 1000000.0, e.op, json_escape(e.stmt_id), json_escape(e.source),
+		json_escape(e.connection), e.driver, json_escape(e.sql), params, e.rows, e.rc);
+
+	if (!e.plan.empty())
+		ln += ", \"plan\": \"" + json_escape(e.plan) + "\"";
+
+	ln += "}\n";
+
+	// Slow statements are expected to be rare: the file is opened for each entry, so that it can be rotated
+	std::lock_guard<std::mutex> lock(slow_log_mutex);
+	FILE* f = fopen(log_file.c_str(), "a");
+	if (!f) {
+		spdlog::error("GixSQL: cannot write to slow statement log file {}", log_file);
+		return;
+	}
+
+	fwrite(ln.c_str(), 1, ln.size(), f);
+	fclose(f);
+}
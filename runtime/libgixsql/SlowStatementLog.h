@@ -0,0 +1,70 @@
+/*
+* This file is part of Gix-IDE, an IDE and platform for GnuCOBOL
+* Copyright (C) 2021 Marco Ridoni
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public License
+* as published by the Free Software Foundation; either version 3,
+* or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library; see the file COPYING.LIB.  If
+* not, write to the Free Software Foundation, 51 Franklin Street, Fifth Floor
+* Boston, MA 02110-1301 USA
+*/
+
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#define SLOW_LOG_THRESHOLD_DEFAULT	1000	// ms
+
+// A statement whose execution time exceeded the threshold
+struct SlowStatementEntry {
+	std::string op;
+	std::string stmt_id;
+	std::string source;
+	std::string connection;
+	std::string driver;
+	std::string sql;
+	std::vector<std::string> params;
+
+	uint64_t elapsed = 0;	// ns
+	int64_t rows = -1;		// -1: not available
+	int rc = 0;
+	std::string plan;
+};
+
+/*
+	Slow statement log, enabled by setting GIXSQL_SLOW_LOG_FILE: each statement whose execution in the
+	driver takes longer than GIXSQL_SLOW_LOG_THRESHOLD milliseconds is written to the log (one JSON object
+	per line), with its text, parameters (optionally masked), rows, source location and execution plan
+	(if GIXSQL_SLOW_LOG_EXPLAIN is enabled and the driver supports it).
+*/
+class SlowStatementLog
+{
+public:
+	static void init();
+
+	static inline bool enabled() { return is_enabled; }
+	static inline uint64_t threshold() { return threshold_ns; }
+	static inline bool explainEnabled() { return explain_enabled; }
+	static inline bool maskParams() { return mask_params; }
+
+	static void write(const SlowStatementEntry& e);
+
+private:
+	static bool is_enabled;
+	static uint64_t threshold_ns;
+	static bool explain_enabled;
+	static bool mask_params;
+	static std::string log_file;
+};
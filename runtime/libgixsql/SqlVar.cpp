@@ -780,6 +780,11 @@ unsigned long SqlVar::getDisplayLength()
 	return db_data_len;
 }
 
+int SqlVar::getPower()
+{
+	return power;
+}
+
 uint32_t SqlVar::getFlags()
 {
 	return flags;
@@ -948,8 +953,9 @@ void SqlVar::allocate_realdata_buffer()
 		}
 
 		case CobolVarType::COBOL_TYPE_JAPANESE:
-			length = length * 2;
-			/* no break */
+			db_data_buffer_len = length * 2;	// length is in characters (2 bytes each), createRealData/createCobolData double it
+			break;
+
 		case CobolVarType::COBOL_TYPE_ALPHANUMERIC:
 			db_data_buffer_len = length;	// we always allocate the maximum size, to handle variable length types (the length field includes the extra 2 bytes)
 			break;
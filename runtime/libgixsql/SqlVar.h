@@ -47,6 +47,7 @@ public:
 	CobolVarType getType();
 	unsigned long getLength();
 	unsigned long getDisplayLength();
+	int getPower();
 	uint32_t getFlags();
 
 	bool isVarLen();
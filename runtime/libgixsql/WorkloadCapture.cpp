@@ -0,0 +1,168 @@
+/*
+* This file is part of Gix-IDE, an IDE and platform for GnuCOBOL
+* Copyright (C) 2021 Marco Ridoni
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public License
+* as published by the Free Software Foundation; either version 3,
+* or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library; see the file COPYING.LIB.  If
+* not, write to the Free Software Foundation, 51 Franklin Street, Fifth Floor
+* Boston, MA 02110-1301 USA
+*/
+
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+
+#if (defined(_WIN32) || defined(_WIN64)) && !defined(__MINGW32__)
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+#include "WorkloadCapture.h"
+#include "RuntimeMetrics.h"
+#include "Logger.h"
+#include "utils.h"
+
+#define CAPTURE_BUFFER_SIZE		(1024 * 1024)
+
+bool WorkloadCapture::is_enabled = false;
+std::string WorkloadCapture::capture_file;
+
+static std::mutex capture_mutex;
+static FILE* capture_fp = nullptr;
+static uint64_t capture_start = 0;
+static std::unordered_map<std::string, uint32_t> capture_strings;
+static std::atomic<uint32_t> capture_thread_seq(0);
+static thread_local uint32_t capture_thread_id = 0;
+
+static void close_at_exit()
+{
+	WorkloadCapture::close();
+}
+
+void WorkloadCapture::init()
+{
+	char* f = getenv("GIXSQL_CAPTURE_FILE");
+	if (!f || !strlen(f))
+		return;
+
+	capture_file = f;
+	if (capture_file.find("$$") != std::string::npos)
+		capture_file = string_replace(capture_file, "$$", std::to_string(getpid()));
+
+	capture_fp = fopen(capture_file.c_str(), "wb");
+	if (!capture_fp) {
+		spdlog::error("GixSQL: cannot create workload capture file {}", capture_file);
+		return;
+	}
+	setvbuf(capture_fp, nullptr, _IOFBF, CAPTURE_BUFFER_SIZE);
+
+	std::string hdr = WORKLOAD_TRACE_MAGIC;
+	workload_put_varint(hdr, WORKLOAD_TRACE_VERSION);
+	fwrite(hdr.data(), 1, hdr.size(), capture_fp);
+
+	RuntimeMetrics::enableTiming();
+	capture_start = RuntimeMetrics::now();
+	std::atexit(close_at_exit);
+
+	is_enabled = true;
+	spdlog::info("GixSQL: workload capture enabled, file: {}", capture_file);
+}
+
+void WorkloadCapture::close()
+{
+	std::lock_guard<std::mutex> lock(capture_mutex);
+	is_enabled = false;
+	if (capture_fp) {
+		fclose(capture_fp);
+		capture_fp = nullptr;
+	}
+}
+
+// Must be called with the lock held: strings are written the first time they are seen
+static uint32_t get_string_index(std::string& out, const std::string& s)
+{
+	if (s.empty())
+		return 0;
+
+	auto it = capture_strings.find(s);
+	if (it != capture_strings.end())
+		return it->second;
+
+	uint32_t idx = capture_strings.size() + 1;
+	capture_strings[s] = idx;
+
+	out += (char)WorkloadRecordType::String;
+	workload_put_varint(out, idx);
+	workload_put_bytes(out, s.data(), s.size());
+	return idx;
+}
+
+void WorkloadCapture::record(WorkloadRecordType type, uint32_t session, uint64_t t0, int rc, const std::string& sql, const std::string& name, const std::string& stmt_id, uint32_t flags, int64_t rows, int32_t fields,
+	const std::vector<CobolVarType>& param_types, const std::vector<std_binary_data>& param_values, const std::vector<unsigned long>& param_lengths, const std::vector<uint32_t>& param_flags)
+{
+	uint64_t t1 = RuntimeMetrics::now();
+
+	if (capture_thread_id == 0)
+		capture_thread_id = ++capture_thread_seq;
+
+	// The record is encoded outside of the lock, only the string references need it
+	std::string head;
+	head += (char)type;
+	workload_put_varint(head, session);
+	workload_put_varint(head, capture_thread_id);
+	workload_put_varint(head, t0 > capture_start ? t0 - capture_start : 0);
+	workload_put_varint(head, t1 > t0 ? t1 - t0 : 0);
+	workload_put_svarint(head, rc);
+
+	std::string tail;
+	workload_put_varint(tail, flags);
+	workload_put_svarint(tail, rows);
+	workload_put_svarint(tail, fields);
+	workload_put_varint(tail, param_values.size());
+
+	for (size_t i = 0; i < param_values.size(); i++) {
+		workload_put_varint(tail, (uint64_t)param_types.at(i));
+		workload_put_varint(tail, param_flags.at(i));
+		if (param_lengths.at(i) == DB_NULL) {
+			workload_put_svarint(tail, -1);
+		}
+		else {
+			workload_put_svarint(tail, param_lengths.at(i));
+			tail.append((const char*)param_values.at(i).data(), param_lengths.at(i));
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(capture_mutex);
+	if (!capture_fp)
+		return;
+
+	std::string strs;
+	uint32_t sql_idx = get_string_index(strs, sql);
+	uint32_t name_idx = get_string_index(strs, name);
+	uint32_t stmt_id_idx = get_string_index(strs, stmt_id);
+
+	workload_put_varint(head, sql_idx);
+	workload_put_varint(head, name_idx);
+	workload_put_varint(head, stmt_id_idx);
+
+	if (!strs.empty())
+		fwrite(strs.data(), 1, strs.size(), capture_fp);
+	fwrite(head.data(), 1, head.size(), capture_fp);
+	fwrite(tail.data(), 1, tail.size(), capture_fp);
+}
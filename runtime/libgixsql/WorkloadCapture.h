@@ -0,0 +1,52 @@
+/*
+* This file is part of Gix-IDE, an IDE and platform for GnuCOBOL
+* Copyright (C) 2021 Marco Ridoni
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public License
+* as published by the Free Software Foundation; either version 3,
+* or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library; see the file COPYING.LIB.  If
+* not, write to the Free Software Foundation, 51 Franklin Street, Fifth Floor
+* Boston, MA 02110-1301 USA
+*/
+
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "WorkloadTrace.h"
+
+using std_binary_data = std::vector<unsigned char>;
+
+/*
+	Workload capture, enabled by setting GIXSQL_CAPTURE_FILE: every statement executed through the
+	database drivers is recorded (with its parameters, timing and result shape) in a binary trace
+	(see WorkloadTrace.h) that can be replayed against any driver with gixsql-replay.
+*/
+class WorkloadCapture
+{
+public:
+	static void init();
+	static void close();
+
+	static inline bool enabled() { return is_enabled; }
+
+	// t0 is the start of the driver call (RuntimeMetrics::now())
+	static void record(WorkloadRecordType type, uint32_t session, uint64_t t0, int rc, const std::string& sql, const std::string& name, const std::string& stmt_id, uint32_t flags = 0, int64_t rows = -1, int32_t fields = 0,
+		const std::vector<CobolVarType>& param_types = {}, const std::vector<std_binary_data>& param_values = {}, const std::vector<unsigned long>& param_lengths = {}, const std::vector<uint32_t>& param_flags = {});
+
+private:
+	static bool is_enabled;
+	static std::string capture_file;
+};
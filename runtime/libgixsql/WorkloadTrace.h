@@ -0,0 +1,234 @@
+/*
+* This file is part of Gix-IDE, an IDE and platform for GnuCOBOL
+* Copyright (C) 2021 Marco Ridoni
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public License
+* as published by the Free Software Foundation; either version 3,
+* or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library; see the file COPYING.LIB.  If
+* not, write to the Free Software Foundation, 51 Franklin Street, Fifth Floor
+* Boston, MA 02110-1301 USA
+*/
+
+
+#pragma once
+
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "cobol_var_types.h"
+
+/*
+	Workload trace format (written by WorkloadCapture, read by gixsql-replay)
+
+	The file starts with WORKLOAD_TRACE_MAGIC and the format version (varint), followed by a sequence
+	of records. All integers are varints (LEB128, signed values are zigzag-encoded), strings (SQL text,
+	cursor/statement/connection names, statement ids) are written once, in a WorkloadRecordType::String
+	record, and then referenced by index (0 = none). Records:
+
+		type, session, thread, start, elapsed, rc, sql, name, stmt_id, flags, rows, fields,
+		nparams, { param type, param flags, param length (-1: NULL), param data }
+
+	start is the time (ns) since the capture was started, elapsed the time (ns) spent in the driver.
+*/
+
+#define WORKLOAD_TRACE_MAGIC		"GIXSQLWT"
+#define WORKLOAD_TRACE_MAGIC_LEN	8
+#define WORKLOAD_TRACE_VERSION		1
+
+enum class WorkloadRecordType : uint8_t {
+	String = 1,
+	Connect = 2,		// name: connection name, sql: DB type, flags: autocommit mode
+	Disconnect = 3,
+	Exec = 4,			// sql, params, rows (affected or in resultset), fields (resultset columns)
+	Prepare = 5,		// name: statement name, sql
+	ExecPrepared = 6,	// name: statement name, params
+	CursorOpen = 7,		// name: cursor name, sql, params, flags: WORKLOAD_FLAG_WITH_HOLD
+	CursorFetch = 8,	// name: cursor name, fields
+	CursorClose = 9		// name: cursor name
+};
+
+#define WORKLOAD_FLAG_WITH_HOLD		1
+
+struct WorkloadParam {
+	CobolVarType type = CobolVarType::UNKNOWN;
+	uint32_t flags = 0;
+	bool is_null = false;
+	std::vector<unsigned char> data;
+};
+
+struct WorkloadRecord {
+	WorkloadRecordType type = WorkloadRecordType::String;
+	uint32_t session = 0;
+	uint32_t thread = 0;
+	uint64_t start = 0;
+	uint64_t elapsed = 0;
+	int32_t rc = 0;
+	uint32_t sql = 0;
+	uint32_t name = 0;
+	uint32_t stmt_id = 0;
+	uint32_t flags = 0;
+	int64_t rows = -1;
+	int32_t fields = 0;
+	std::vector<WorkloadParam> params;
+};
+
+// Varint encoding helpers, shared by the writer and the reader
+
+inline void workload_put_varint(std::string& out, uint64_t v)
+{
+	while (v >= 0x80) {
+		out += (char)((v & 0x7f) | 0x80);
+		v >>= 7;
+	}
+	out += (char)v;
+}
+
+inline void workload_put_svarint(std::string& out, int64_t v)
+{
+	workload_put_varint(out, ((uint64_t)v << 1) ^ (uint64_t)(v >> 63));
+}
+
+inline void workload_put_bytes(std::string& out, const void* data, uint64_t len)
+{
+	workload_put_varint(out, len);
+	out.append((const char*)data, len);
+}
+
+// Reads a workload trace sequentially. String records are resolved internally and not returned
+class WorkloadTraceReader
+{
+public:
+	~WorkloadTraceReader()
+	{
+		if (f)
+			fclose(f);
+	}
+
+	bool open(const std::string& filename)
+	{
+		f = fopen(filename.c_str(), "rb");
+		if (!f)
+			return false;
+
+		char magic[WORKLOAD_TRACE_MAGIC_LEN];
+		uint64_t version = 0;
+		if (fread(magic, 1, WORKLOAD_TRACE_MAGIC_LEN, f) != WORKLOAD_TRACE_MAGIC_LEN || memcmp(magic, WORKLOAD_TRACE_MAGIC, WORKLOAD_TRACE_MAGIC_LEN) != 0
+			|| !get_varint(version) || version != WORKLOAD_TRACE_VERSION) {
+			fclose(f);
+			f = nullptr;
+			return false;
+		}
+
+		strings.clear();
+		strings.push_back("");
+		return true;
+	}
+
+	// Returns false at the end of the trace (or if the trace is truncated)
+	bool next(WorkloadRecord& r)
+	{
+		while (f) {
+			int t = fgetc(f);
+			if (t == EOF)
+				return false;
+
+			if ((WorkloadRecordType)t == WorkloadRecordType::String) {
+				uint64_t idx, len;
+				if (!get_varint(idx) || !get_varint(len))
+					return false;
+
+				std::string s(len, '\0');
+				if (len && fread(&s[0], 1, len, f) != len)
+					return false;
+
+				if (idx >= strings.size())
+					strings.resize(idx + 1);
+				strings[idx] = s;
+				continue;
+			}
+
+			uint64_t session, thread, start, elapsed, sql, name, stmt_id, flags, nparams;
+			int64_t rc, rows, fields;
+			if (!get_varint(session) || !get_varint(thread) || !get_varint(start) || !get_varint(elapsed) || !get_svarint(rc)
+				|| !get_varint(sql) || !get_varint(name) || !get_varint(stmt_id) || !get_varint(flags)
+				|| !get_svarint(rows) || !get_svarint(fields) || !get_varint(nparams))
+				return false;
+
+			r.type = (WorkloadRecordType)t;
+			r.session = (uint32_t)session;
+			r.thread = (uint32_t)thread;
+			r.start = start;
+			r.elapsed = elapsed;
+			r.rc = (int32_t)rc;
+			r.sql = (uint32_t)sql;
+			r.name = (uint32_t)name;
+			r.stmt_id = (uint32_t)stmt_id;
+			r.flags = (uint32_t)flags;
+			r.rows = rows;
+			r.fields = (int32_t)fields;
+			r.params.resize(nparams);
+
+			for (auto& p : r.params) {
+				uint64_t ptype, pflags;
+				int64_t plen;
+				if (!get_varint(ptype) || !get_varint(pflags) || !get_svarint(plen))
+					return false;
+
+				p.type = (CobolVarType)ptype;
+				p.flags = (uint32_t)pflags;
+				p.is_null = plen < 0;
+				p.data.resize(plen > 0 ? plen : 0);
+				if (plen > 0 && fread(p.data.data(), 1, plen, f) != (size_t)plen)
+					return false;
+			}
+			return true;
+		}
+		return false;
+	}
+
+	const std::string& getString(uint32_t idx) const
+	{
+		return idx < strings.size() ? strings[idx] : strings[0];
+	}
+
+private:
+	FILE* f = nullptr;
+	std::vector<std::string> strings;
+
+	bool get_varint(uint64_t& v)
+	{
+		v = 0;
+		for (int shift = 0; shift < 64; shift += 7) {
+			int c = fgetc(f);
+			if (c == EOF)
+				return false;
+
+			v |= (uint64_t)(c & 0x7f) << shift;
+			if (!(c & 0x80))
+				return true;
+		}
+		return false;
+	}
+
+	bool get_svarint(int64_t& v)
+	{
+		uint64_t u;
+		if (!get_varint(u))
+			return false;
+
+		v = (int64_t)(u >> 1) ^ -(int64_t)(u & 1);
+		return true;
+	}
+};
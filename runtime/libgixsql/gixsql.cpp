@@ -24,8 +24,11 @@
 #include <cstdbool>
 #include <vector>
 #include <map>
+#include <set>
 #include <string>
 #include <cstring>
+#include <cstdint>
+#include <cerrno>
 #include <memory>
 
 #if (defined(_WIN32) || defined(_WIN64)) && !defined(__MINGW32__)
@@ -36,6 +39,8 @@
 #include <math.h>
 
 #include "cobol_var_types.h"
+#include "cobol_var_flags.h"
+#include "sql_stmt_flags.h"
 #include "Connection.h"
 #include "ConnectionManager.h"
 #include "Cursor.h"
@@ -44,6 +49,9 @@
 #include "DataSourceInfo.h"
 #include "SqlVar.h"
 #include "SqlVarList.h"
+#include "RuntimeMetrics.h"
+#include "SlowStatementLog.h"
+#include "WorkloadCapture.h"
 
 #include "IDbInterface.h"
 #include "IConnection.h"
@@ -51,10 +59,13 @@
 #include "Logger.h"
 #include "utils.h"
 #include "gixsql.h"
+#include "gixsql_internal.h"
 #include "platform.h"
 #include "Logger.h"
 
 #include "spdlog/sinks/null_sink.h"
+#include "spdlog/sinks/rotating_file_sink.h"
+#include "AsyncLogSink.h"
 
 #include "cobol_var_types.h"
 
@@ -65,6 +76,9 @@
 
 #define CHECK_LIB_INIT() if (!__lib_initialized) lib_initialize();
 
+// The number of rows of a slow statement is retrieved from the driver
+#define SLOW_LOG_ROWS_FROM_DRIVER	-2
+
 struct query_info {
 	char* pname;  // default
 	char* query;
@@ -74,12 +88,15 @@ struct query_info {
 static ConnectionManager connection_manager;
 static CursorManager cursor_manager;
 static bool __lib_initialized = false;
+static std::shared_ptr<AsyncLogSink> gixsql_async_sink;
 
 static void sqlca_initialize(struct sqlca_t*);
-static int setStatus(struct sqlca_t* st, std::shared_ptr<IDbInterface> dbi, int err);
 static AutoCommitMode get_autocommit(const std::shared_ptr<DataSourceInfo>& ds);
 static bool get_fixup_params(const std::shared_ptr<DataSourceInfo>&);
+static bool get_eager_prepare(const std::shared_ptr<DataSourceInfo>&);
 static std::string get_client_encoding(const std::shared_ptr<DataSourceInfo>&);
+static bool get_read_your_writes(const std::shared_ptr<DataSourceInfo>&);
+static std::vector<std::string> get_read_replicas(const std::shared_ptr<DataSourceInfo>&);
 static void init_sql_var_list(void);
 static bool is_signed_numeric(CobolVarType t);
 
@@ -87,12 +104,38 @@ static bool is_signed_numeric(CobolVarType t);
 SqlVarList _current_sql_var_list;
 SqlVarList _res_sql_var_list;
 
+/* statement classification, set by the preprocessor (if enabled) for static SQL */
+static uint32_t _current_stmt_flags = SQL_STMT_FLAG_NONE;
+
+/* statement id (module:query id) and source location (file:line), set by the preprocessor (if enabled) for static SQL */
+static std::string _current_stmt_id;
+static std::string _current_stmt_source;
+
+/* static statements from the module manifests (if enabled in the preprocessor), prepared when connecting */
+static std::vector<std::shared_ptr<StaticStatementInfo>> _static_stmts;
+static std::set<std::string> _static_stmt_queries;
+static std::vector<CobolVarType> _static_stmt_param_types;
+static std::vector<uint32_t> _static_stmt_param_flags;
+
 static int _gixsqlExec(const std::shared_ptr<IConnection>& conn, struct sqlca_t* st, char* _query);
 static int _gixsqlExecParams(const std::shared_ptr<IConnection>& conn, struct sqlca_t* st, char* _query, unsigned int nParams);
 static int _gixsqlCursorDeclare(struct sqlca_t* st, std::shared_ptr<IConnection> conn, std::string connection_name, std::string cursor_name, int with_hold, void* d_query, int query_tl, int nParams);
 static int _gixsqlExecPrepared(sqlca_t* st, void* d_connection_id, int connection_id_tl, char* stmt_name, int nParams, std::shared_ptr<IDbInterface>& _dbi);
 static int _gixsqlConnectReset(struct sqlca_t* st, const std::string& connection_id);
 
+static void connect_replicas(const std::shared_ptr<Connection>& conn, const std::shared_ptr<DataSourceInfo>& ds);
+static std::shared_ptr<IConnection> get_read_connection(const std::shared_ptr<IConnection>& conn);
+static void update_read_write_state(const std::shared_ptr<IConnection>& conn, const std::string& query, bool is_tx_end);
+static bool is_read_only_query(const std::string& query);
+static bool strip_read_only_clause(std::string& query);
+static void init_read_only_cursor(const std::shared_ptr<Cursor>& c, const std::shared_ptr<IConnection>& conn);
+
+static void metrics_set_connection(const std::shared_ptr<IConnection>& conn);
+static void capture_exec(const std::shared_ptr<IConnection>& conn, uint64_t t0, int rc, const std::string& query,
+	const std::vector<CobolVarType>& param_types = {}, const std::vector<std_binary_data>& param_values = {}, const std::vector<unsigned long>& param_lengths = {}, const std::vector<uint32_t>& param_flags = {});
+static void slow_log_check(const char* op, uint64_t t0, int rc, const std::shared_ptr<IConnection>& conn, const std::string& query, int64_t rows,
+	const std::vector<CobolVarType>& param_types = {}, const std::vector<std_binary_data>& param_values = {}, const std::vector<unsigned long>& param_lengths = {}, const std::vector<uint32_t>& param_flags = {});
+
 static std::string get_hostref_or_literal(void* data, int connection_id_tl);
 
 static bool lib_initialize();
@@ -172,6 +215,7 @@ GIXSQLConnect(struct sqlca_t* st, void* d_data_source, int data_source_tl, void*
 	spdlog::trace(FMT_FILE_FUNC "Fix up parameters : {}", __FILE__, __func__, opts->fixup_parameters);
 	spdlog::trace(FMT_FILE_FUNC "Client encoding   : {}", __FILE__, __func__, opts->client_encoding);
 
+	uint64_t t0 = RuntimeMetrics::now();
 	rc = dbi->connect(data_source, opts);
 	if (rc != DBERR_NO_ERROR) {
 		setStatus(st, dbi, DBERR_CONNECTION_FAILED);
@@ -185,14 +229,254 @@ GIXSQLConnect(struct sqlca_t* st, void* d_data_source, int data_source_tl, void*
 	c->setConnectionInfo(data_source);
 	c->setDbInterface(dbi);
 	c->setOpened(true);
+	c->setReadYourWrites(get_read_your_writes(data_source));
 	connection_manager.add(c);
 
+	if (WorkloadCapture::enabled())
+		WorkloadCapture::record(WorkloadRecordType::Connect, c->getId(), t0, rc, dbtype, c->getName(), "", (uint32_t)opts->autocommit);
+
 	spdlog::debug(FMT_FILE_FUNC "connection success. connection id# = {}, connection id = [{}]", __FILE__, __func__, c->getId(), connection_id);
 
+	if (_static_stmts.size() > 0 && get_eager_prepare(data_source)) {
+		spdlog::trace(FMT_FILE_FUNC "preparing {} static statement(s)", __FILE__, __func__, _static_stmts.size());
+
+		// Not fatal: the statements will just be prepared when they are executed
+		if (dbi->prepare_static(_static_stmts) != DBERR_NO_ERROR)
+			spdlog::warn("Some static statements could not be prepared in advance: {}", dbi->get_error_message());
+	}
+
+	connect_replicas(c, data_source);
+
 	setStatus(st, NULL, DBERR_NO_ERROR);
 	return RESULT_SUCCESS;
 }
 
+// Connects the read-only replicas listed in the "read_replicas" option: replicas that cannot
+// be connected are only logged, queries will be executed on the primary connection instead
+static void connect_replicas(const std::shared_ptr<Connection>& conn, const std::shared_ptr<DataSourceInfo>& ds)
+{
+	for (auto replica_var : get_read_replicas(ds)) {
+		char* v = getenv(replica_var.c_str());
+		if (!v || !strlen(v)) {
+			spdlog::warn("Read replica data source variable {} is not set, ignoring", replica_var);
+			continue;
+		}
+
+		// Replicas defined without credentials use the ones of the primary connection
+		std::shared_ptr<DataSourceInfo> replica_ds = std::make_shared<DataSourceInfo>();
+		int rc = replica_ds->init(v, "", "", "");
+		if (rc == 0 && replica_ds->getUsername().empty() && !ds->getUsername().empty()) {
+			replica_ds = std::make_shared<DataSourceInfo>();
+			rc = replica_ds->init(v, "", ds->getUsername(), ds->getPassword());
+		}
+
+		if (rc != 0) {
+			spdlog::warn("Cannot initialize read replica connection parameters, data source is [{}]", v);
+			continue;
+		}
+
+		std::shared_ptr<IDbInterface> replica_dbi = DbInterfaceFactory::getInterface(replica_ds->getDbType(), gixsql_logger);
+		if (!replica_dbi) {
+			spdlog::warn("Cannot initialize driver library for read replica, DB type is [{}]", replica_ds->getDbType());
+			continue;
+		}
+
+		// Replicas only execute queries: unless set otherwise they run in autocommit mode, so that they do not keep a transaction open
+		std::shared_ptr<IConnectionOptions> opts = std::make_shared<IConnectionOptions>();
+		opts->autocommit = replica_ds->getOptions().count("autocommit") ? get_autocommit(replica_ds) : AutoCommitMode::On;
+		opts->fixup_parameters = get_fixup_params(replica_ds);
+		opts->client_encoding = get_client_encoding(replica_ds);
+
+		if (replica_dbi->connect(replica_ds, opts) != DBERR_NO_ERROR) {
+			spdlog::warn("Cannot connect to read replica {}: {}", replica_ds->getName(), replica_dbi->get_error_message());
+			continue;
+		}
+
+		std::shared_ptr<Connection> r = connection_manager.create();
+		r->setConnectionOptions(opts);
+		r->setConnectionInfo(replica_ds);
+		r->setDbInterface(replica_dbi);
+		r->setOpened(true);
+		connection_manager.addReplica(conn, r);
+
+		spdlog::debug(FMT_FILE_FUNC "read replica connected: {} ({})", __FILE__, __func__, r->getName(), replica_ds->getName());
+
+		if (_static_stmts.size() > 0 && get_eager_prepare(replica_ds)) {
+			if (replica_dbi->prepare_static(_static_stmts) != DBERR_NO_ERROR)
+				spdlog::warn("Some static statements could not be prepared in advance: {}", replica_dbi->get_error_message());
+		}
+	}
+}
+
+// Returns the connection that should execute a read-only query: a replica of the primary
+// connection (round-robin), unless there are none or the primary one is in a write transaction
+static std::shared_ptr<IConnection> get_read_connection(const std::shared_ptr<IConnection>& conn)
+{
+	std::shared_ptr<Connection> c = std::static_pointer_cast<Connection>(conn);
+	if (c->getPrimary())
+		c = c->getPrimary();
+
+	if (!c->hasReplicas() || c->isPinnedToPrimary())
+		return c;
+
+	return c->nextReplica();
+}
+
+// After a write, reads are pinned to the primary connection until the transaction ends
+// (in autocommit mode only if read-your-writes is enabled)
+static void update_read_write_state(const std::shared_ptr<IConnection>& conn, const std::string& query, bool is_tx_end)
+{
+	std::shared_ptr<Connection> c = std::static_pointer_cast<Connection>(conn);
+	if (!c->hasReplicas())
+		return;
+
+	if (is_tx_end) {
+		c->setPinnedToPrimary(false);
+		return;
+	}
+
+	if (c->isPinnedToPrimary() || is_read_only_query(query))
+		return;
+
+	if (c->isReadYourWrites() || c->getConnectionOptions()->autocommit == AutoCommitMode::Off) {
+		spdlog::trace(FMT_FILE_FUNC "connection {}: reads pinned to primary until the end of the transaction", __FILE__, __func__, c->getName());
+		c->setPinnedToPrimary(true);
+	}
+}
+
+static void metrics_set_connection(const std::shared_ptr<IConnection>& conn)
+{
+	if (!RuntimeMetrics::enabled() || !conn)
+		return;
+
+	std::shared_ptr<Connection> c = std::static_pointer_cast<Connection>(conn);
+	RuntimeMetrics::setConnection(c->getName(), c->getConnectionInfo() ? c->getConnectionInfo()->getDbType() : "");
+}
+
+// EXPLAIN is only supported for DML statements (and not for positioned UPDATE/DELETE)
+static bool is_explainable_query(const std::string& query)
+{
+	std::string q = to_upper(trim_copy(query));
+	if (q.find("WHERE CURRENT OF") != std::string::npos)
+		return false;
+
+	return starts_with(q, "SELECT ") || starts_with(q, "INSERT ") || starts_with(q, "UPDATE ") || starts_with(q, "DELETE ") || starts_with(q, "WITH ");
+}
+
+// Writes the statement to the slow statement log if its execution in the driver (started at t0) took longer than
+// the threshold. The number of rows can be retrieved from the driver (if supported) for non-cursor statements
+static void slow_log_check(const char* op, uint64_t t0, int rc, const std::shared_ptr<IConnection>& conn, const std::string& query, int64_t rows,
+	const std::vector<CobolVarType>& param_types, const std::vector<std_binary_data>& param_values, const std::vector<unsigned long>& param_lengths, const std::vector<uint32_t>& param_flags)
+{
+	uint64_t elapsed = RuntimeMetrics::now() - t0;
+	if (elapsed < SlowStatementLog::threshold() || !conn)
+		return;
+
+	std::shared_ptr<Connection> c = std::static_pointer_cast<Connection>(conn);
+	std::shared_ptr<IDbInterface> dbi = c->getDbInterface();
+
+	SlowStatementEntry e;
+	e.op = op;
+	e.stmt_id = _current_stmt_id;
+	e.source = _current_stmt_source;
+	e.connection = c->getName();
+	e.driver = c->getConnectionInfo() ? c->getConnectionInfo()->getDbType() : "";
+	e.sql = query;
+	e.elapsed = elapsed;
+	e.rc = rc;
+
+	if (rows == SLOW_LOG_ROWS_FROM_DRIVER)
+		rows = (rc == DBERR_NO_ERROR && dbi && dbi->has(DbNativeFeature::ResultSetRowCount)) ? dbi->get_num_rows(nullptr) : -1;
+	e.rows = rows;
+
+	for (size_t i = 0; i < param_values.size(); i++) {
+		if (SlowStatementLog::maskParams()) {
+			e.params.push_back("***");
+		}
+		else if (param_lengths.at(i) == DB_NULL) {
+			e.params.push_back("NULL");
+		}
+		else if (CBL_FIELD_IS_BINARY(param_flags.at(i))) {
+			std::string hex;
+			for (unsigned long j = 0; j < param_lengths.at(i); j++)
+				hex += fmt::format("{:02x}", param_values.at(i).at(j));
+			e.params.push_back("X'" + hex + "'");
+		}
+		else {
+			e.params.push_back(std::string((const char*)param_values.at(i).data(), param_lengths.at(i)));
+		}
+	}
+
+	// The plan is only retrieved for statements that succeeded, so that the driver's error state is preserved
+	if (SlowStatementLog::explainEnabled() && rc == DBERR_NO_ERROR && dbi && is_explainable_query(query)) {
+		if (dbi->explain(query, param_types, param_values, param_lengths, param_flags, e.plan) != DBERR_NO_ERROR)
+			e.plan.clear();
+	}
+
+	SlowStatementLog::write(e);
+}
+
+// Records a statement in the workload capture, with the shape of its result (row and column count)
+static void capture_exec(const std::shared_ptr<IConnection>& conn, uint64_t t0, int rc, const std::string& query,
+	const std::vector<CobolVarType>& param_types, const std::vector<std_binary_data>& param_values, const std::vector<unsigned long>& param_lengths, const std::vector<uint32_t>& param_flags)
+{
+	std::shared_ptr<IDbInterface> dbi = conn->getDbInterface();
+
+	int64_t rows = -1;
+	int32_t fields = 0;
+	if (rc == DBERR_NO_ERROR) {
+		if (dbi->has(DbNativeFeature::ResultSetRowCount))
+			rows = dbi->get_num_rows(nullptr);
+
+		if (is_read_only_query(query))
+			fields = dbi->get_num_fields(nullptr);
+	}
+
+	WorkloadCapture::record(WorkloadRecordType::Exec, conn->getId(), t0, rc, query, "", _current_stmt_id, _current_stmt_flags, rows, fields, param_types, param_values, param_lengths, param_flags);
+}
+
+static bool is_read_only_query(const std::string& query)
+{
+	std::string q = to_upper(trim_copy(query));
+	if (q.find(" FOR UPDATE") != std::string::npos)
+		return false;
+
+	if (SQL_STMT_HAS_FLAGS(_current_stmt_flags))
+		return (_current_stmt_flags & SQL_STMT_FLAG_SELECT);
+
+	return starts_with(q, "SELECT ");
+}
+
+static bool strip_read_only_clause(std::string& query)
+{
+	std::string q = to_upper(rtrim_copy(query));
+	for (std::string clause : { " FOR READ ONLY", " FOR FETCH ONLY" }) {
+		if (ends_with(q, clause)) {
+			query = rtrim_copy(query.substr(0, q.size() - clause.size()));
+			return true;
+		}
+	}
+	return false;
+}
+
+// On connections with read replicas, "FOR READ ONLY" (or "FOR FETCH ONLY") at the end of a cursor query
+// is interpreted by the runtime (the cursor is opened on a replica) and removed from the query, since
+// not all DBMSs support it. On other connections the query is sent to the DBMS as it is.
+static void init_read_only_cursor(const std::shared_ptr<Cursor>& c, const std::shared_ptr<IConnection>& conn)
+{
+	if (!conn || c->getQuery().empty())
+		return;
+
+	if (std::static_pointer_cast<Connection>(conn)->getReplicas().empty())
+		return;
+
+	std::string query = c->getQuery();
+	if (strip_read_only_clause(query)) {
+		c->setReadOnly(true);
+		c->setQuery(query);
+	}
+}
+
 int _gixsqlConnectReset(struct sqlca_t* st, const std::string& connection_id)
 {
 	std::shared_ptr<Connection> conn = connection_manager.get(connection_id);
@@ -206,6 +490,14 @@ int _gixsqlConnectReset(struct sqlca_t* st, const std::string& connection_id)
 	std::shared_ptr<IDbInterface> dbi = conn->getDbInterface();
 	int rc = dbi->reset();
 	FAIL_ON_ERROR(rc, st, dbi, DBERR_CONN_RESET_FAILED)
+
+	for (std::shared_ptr<Connection> r : conn->getReplicas()) {
+		if (r->getDbInterface() && r->getDbInterface()->reset() != DBERR_NO_ERROR)
+			spdlog::warn("Cannot reset read replica connection {}", r->getName());
+		r->setDbInterface(nullptr);
+		r->setOpened(false);
+	}
+
 	int dbi_uc = dbi.use_count();
 	int cc = conn.use_count();
 	conn->setDbInterface(nullptr);
@@ -248,6 +540,8 @@ GIXSQLExec(struct sqlca_t* st, void* d_connection_id, int connection_id_tl, char
 {
 	CHECK_LIB_INIT();
 
+	MetricsCallScope metrics_scope("exec", &st->sqlcode);
+
 	spdlog::trace(FMT_FILE_FUNC "GIXSQLExec start", __FILE__, __func__);
 	spdlog::trace(FMT_FILE_FUNC "GIXSQLExec SQL: {}", __FILE__, __func__, _query);
 
@@ -275,6 +569,8 @@ GIXSQLExecImmediate(struct sqlca_t* st, void* d_connection_id, int connection_id
 {
 	CHECK_LIB_INIT();
 
+	MetricsCallScope metrics_scope("exec", &st->sqlcode);
+
 	spdlog::trace(FMT_FILE_FUNC "GIXSQLExecImmediate start", __FILE__, __func__);
 
 	std::string connection_id = get_hostref_or_literal(d_connection_id, connection_id_tl);
@@ -308,13 +604,33 @@ static int _gixsqlExec(const std::shared_ptr<IConnection>& conn, struct sqlca_t*
 	int rc = 0;
 	std::shared_ptr<IDbInterface> dbi = conn->getDbInterface();
 
-	if (is_commit_or_rollback_statement(query)) {
+	bool is_tx_end = SQL_STMT_HAS_FLAGS(_current_stmt_flags) ? SQL_STMT_IS_TX_END(_current_stmt_flags) : is_commit_or_rollback_statement(query);
+	if (is_tx_end) {
 		cursor_manager.closeConnectionCursors(conn->getId(), false);
 	}
 
+	update_read_write_state(conn, query, is_tx_end);
+
+	RuntimeMetrics::setStatement(_current_stmt_id, query);
+	metrics_set_connection(conn);
+	uint64_t t0 = RuntimeMetrics::now();
+
+	dbi->set_statement_flags(_current_stmt_flags);
 	rc = dbi->exec(query);
+	dbi->set_statement_flags(SQL_STMT_FLAG_NONE);
+	RuntimeMetrics::addDriverTime(t0);
+	if (SlowStatementLog::enabled())
+		slow_log_check("exec", t0, rc, conn, query, SLOW_LOG_ROWS_FROM_DRIVER);
+	if (WorkloadCapture::enabled())
+		capture_exec(conn, t0, rc, query);
 	FAIL_ON_ERROR(rc, st, dbi, DBERR_SQL_ERROR)
 
+	if (RuntimeMetrics::enabled() && dbi->has(DbNativeFeature::ResultSetRowCount) && !is_tx_end && !is_read_only_query(query)) {
+		int nrows = dbi->get_num_rows(nullptr);
+		if (nrows > 0)
+			RuntimeMetrics::addRowsAffected(nrows);
+	}
+
 
 	setStatus(st, NULL, DBERR_NO_ERROR);
 	return RESULT_SUCCESS;
@@ -325,6 +641,8 @@ GIXSQLExecParams(struct sqlca_t* st, void* d_connection_id, int connection_id_tl
 {
 	CHECK_LIB_INIT();
 
+	MetricsCallScope metrics_scope("exec", &st->sqlcode);
+
 	spdlog::trace(FMT_FILE_FUNC "GIXSQLExecParams - SQL: {}", __FILE__, __func__, _query);
 
 	std::string connection_id = get_hostref_or_literal(d_connection_id, connection_id_tl);
@@ -364,6 +682,8 @@ static int _gixsqlExecParams(const std::shared_ptr<IConnection>& conn, struct sq
 	std::vector<uint32_t> param_flags;
 	std::vector<SqlVar*>::iterator it;
 
+	uint64_t t0 = RuntimeMetrics::now();
+
 	// set parameters
 	for (it = _current_sql_var_list.begin(); it != _current_sql_var_list.end(); it++) {
 		SqlVar* v = *it;
@@ -371,8 +691,12 @@ static int _gixsqlExecParams(const std::shared_ptr<IConnection>& conn, struct sq
 		param_values.push_back(v->getDbData());
 		param_lengths.push_back(!v->isDbNull() ? v->getDisplayLength() : DB_NULL);
 		param_flags.push_back(v->getFlags());
+		if (!v->isDbNull())
+			RuntimeMetrics::addBytesOut(v->getDisplayLength());
 	}
 
+	RuntimeMetrics::addConversionTime(t0);
+
 	std::string query = _query;
 	int rc = 0;
 	std::shared_ptr<IDbInterface> dbi = conn->getDbInterface();
@@ -380,13 +704,33 @@ static int _gixsqlExecParams(const std::shared_ptr<IConnection>& conn, struct sq
 		FAIL_ON_ERROR(1, st, dbi, DBERR_SQL_ERROR);
 	}
 
-	if (is_commit_or_rollback_statement(query)) {
+	bool is_tx_end = SQL_STMT_HAS_FLAGS(_current_stmt_flags) ? SQL_STMT_IS_TX_END(_current_stmt_flags) : is_commit_or_rollback_statement(query);
+	if (is_tx_end) {
 		cursor_manager.closeConnectionCursors(conn->getId(), false);
 	}
 
+	update_read_write_state(conn, query, is_tx_end);
+
+	RuntimeMetrics::setStatement(_current_stmt_id, query);
+	metrics_set_connection(conn);
+	t0 = RuntimeMetrics::now();
+
+	dbi->set_statement_flags(_current_stmt_flags);
 	rc = dbi->exec_params(query, param_types, param_values, param_lengths, param_flags);
+	dbi->set_statement_flags(SQL_STMT_FLAG_NONE);
+	RuntimeMetrics::addDriverTime(t0);
+	if (SlowStatementLog::enabled())
+		slow_log_check("exec", t0, rc, conn, query, SLOW_LOG_ROWS_FROM_DRIVER, param_types, param_values, param_lengths, param_flags);
+	if (WorkloadCapture::enabled())
+		capture_exec(conn, t0, rc, query, param_types, param_values, param_lengths, param_flags);
 	FAIL_ON_ERROR(rc, st, dbi, DBERR_SQL_ERROR)
 
+	if (RuntimeMetrics::enabled() && dbi->has(DbNativeFeature::ResultSetRowCount) && !is_tx_end && !is_read_only_query(query)) {
+		int nrows = dbi->get_num_rows(nullptr);
+		if (nrows > 0)
+			RuntimeMetrics::addRowsAffected(nrows);
+	}
+
 	setStatus(st, NULL, DBERR_NO_ERROR);
 	return RESULT_SUCCESS;
 }
@@ -429,20 +773,37 @@ int _gixsqlExecPrepared(sqlca_t* st, void* d_connection_id, int connection_id_tl
 	std::vector<uint32_t> param_flags;
 	std::vector<SqlVar*>::iterator it;
 
+	uint64_t t0 = RuntimeMetrics::now();
+
 	// set parameters
 	for (it = _current_sql_var_list.begin(); it != _current_sql_var_list.end(); it++) {
 		param_values.push_back((*it)->getDbData());
 		param_types.push_back((*it)->getType());
 		param_lengths.push_back((*it)->getDisplayLength());
 		param_flags.push_back((*it)->getFlags());
+		RuntimeMetrics::addBytesOut((*it)->getDisplayLength());
 	}
 
+	RuntimeMetrics::addConversionTime(t0);
+
 	int rc = 0;
 	std::shared_ptr<IDbInterface> dbi = conn->getDbInterface();
 	if (!dbi)
 		FAIL_ON_ERROR(1, st, dbi, DBERR_SQL_ERROR)
 
+	// Prepared statements are always executed on the primary connection and treated as writes
+	update_read_write_state(conn, "", false);
+
+	RuntimeMetrics::setStatement(std::string("prepared:") + stmt_name, "");
+	metrics_set_connection(conn);
+	t0 = RuntimeMetrics::now();
+
 	rc = dbi->exec_prepared(stmt_name, param_types, param_values, param_lengths, param_flags);
+	RuntimeMetrics::addDriverTime(t0);
+	if (SlowStatementLog::enabled())
+		slow_log_check("exec_prepared", t0, rc, conn, std::string("EXECUTE ") + stmt_name, SLOW_LOG_ROWS_FROM_DRIVER, param_types, param_values, param_lengths, param_flags);
+	if (WorkloadCapture::enabled())
+		WorkloadCapture::record(WorkloadRecordType::ExecPrepared, conn->getId(), t0, rc, "", stmt_name, _current_stmt_id, 0, -1, 0, param_types, param_values, param_lengths, param_flags);
 	FAIL_ON_ERROR(rc, st, dbi, DBERR_SQL_ERROR)
 
 	setStatus(st, NULL, DBERR_NO_ERROR);
@@ -455,6 +816,8 @@ LIBGIXSQL_API int GIXSQLExecPrepared(sqlca_t* st, void* d_connection_id, int con
 {
 	CHECK_LIB_INIT();
 
+	MetricsCallScope metrics_scope("exec_prepared", &st->sqlcode);
+
 	std::shared_ptr<IDbInterface> dbi;	// not used but we need it for the call to the worker function
 	spdlog::trace(FMT_FILE_FUNC "GIXSQLExecPrepared start", __FILE__, __func__);
 	return _gixsqlExecPrepared(st, d_connection_id, connection_id_tl, stmt_name, nParams, dbi);
@@ -464,6 +827,8 @@ LIBGIXSQL_API int GIXSQLExecPreparedInto(sqlca_t* st, void* d_connection_id, int
 {
 	CHECK_LIB_INIT();
 
+	MetricsCallScope metrics_scope("exec_prepared", &st->sqlcode);
+
 	std::shared_ptr<IDbInterface> dbi;
 	spdlog::trace(FMT_FILE_FUNC "GIXSQLExecPreparedInto start", __FILE__, __func__);
 
@@ -508,6 +873,7 @@ LIBGIXSQL_API int GIXSQLExecPreparedInto(sqlca_t* st, void* d_connection_id, int
 	int sqlcode = 0;
 	bool has_invalid_column_data = false;
 	uint64_t bsize = _res_sql_var_list.getMaxLength() + VARLEN_LENGTH_SZ + 1;
+	uint64_t t0 = RuntimeMetrics::now();
 
 	std::unique_ptr<char[]> buffer = std::make_unique<char[]>(bsize);
 	for (int i = 0; i < _res_sql_var_list.size(); i++) {
@@ -527,9 +893,14 @@ LIBGIXSQL_API int GIXSQLExecPreparedInto(sqlca_t* st, void* d_connection_id, int
 			continue;
 		}
 
+		RuntimeMetrics::addBytesIn(datalen);
+
 		spdlog::trace(FMT_FILE_FUNC "result parameter {} - addr: {}", __FILE__, __func__, i + 1, (void*)v->getAddr());
 	}
 
+	RuntimeMetrics::addConversionTime(t0);
+	RuntimeMetrics::addRowsFetched(1);
+
 	if (sqlcode != 0) {
 		return RESULT_FAILED;
 	}
@@ -648,8 +1019,11 @@ static int  _gixsqlCursorDeclare(struct sqlca_t* st, std::shared_ptr<IConnection
 	c->setConnectionName(connection_name);
 	c->setName(std::string(cursor_name));
 
-	if (!query_tl)
-		c->setQuery(get_hostref_or_literal(d_query, query_tl));
+	if (!query_tl) {
+		std::string query = get_hostref_or_literal(d_query, query_tl);
+		c->setQuery(query);
+		init_read_only_cursor(c, conn);
+	}
 	else
 		c->setQuerySource(d_query, query_tl);
 
@@ -682,6 +1056,8 @@ GIXSQLCursorOpen(struct sqlca_t* st, char* cname)
 
 	int rc = 0;
 
+	MetricsCallScope metrics_scope("open", &st->sqlcode);
+
 	spdlog::trace(FMT_FILE_FUNC "GIXSQLCursorOpen start for cursor [{}]", __FILE__, __func__, cname);
 
 	sqlca_initialize(st);
@@ -727,6 +1103,8 @@ GIXSQLCursorOpen(struct sqlca_t* st, char* cname)
 		}
 
 		if (cursor->getConnection()) {
+			init_read_only_cursor(cursor, cursor->getConnection());
+
 			std::shared_ptr<IDbInterface> cdbi = cursor->getConnection()->getDbInterface();
 			if (!cdbi || cdbi->cursor_declare(cursor)) {
 				spdlog::error("Invalid cursor data: {}", cname);
@@ -752,7 +1130,35 @@ GIXSQLCursorOpen(struct sqlca_t* st, char* cname)
 		FAIL_ON_ERROR(rc, st, dbi, DBERR_CLOSE_CURSOR_FAILED)
 	}
 
+	// Read-only cursors are opened on a read replica, if available
+	if (cursor->isReadOnly()) {
+		std::shared_ptr<IConnection> rconn = get_read_connection(c);
+		if (rconn != c) {
+			std::shared_ptr<IDbInterface> rdbi = rconn->getDbInterface();
+			cursor->clearPrivateData();
+			cursor->setConnection(rconn);
+			if (!rdbi || rdbi->cursor_declare(cursor)) {
+				spdlog::error("Invalid cursor data: {}", cname);
+				setStatus(st, NULL, DBERR_DECLARE_CURSOR_FAILED);
+				return RESULT_FAILED;
+			}
+			spdlog::trace(FMT_FILE_FUNC "cursor {} routed to connection {}", __FILE__, __func__, cname, std::static_pointer_cast<Connection>(rconn)->getName());
+			c = rconn;
+			dbi = rdbi;
+		}
+	}
+
+	RuntimeMetrics::setStatement(std::string("cursor:") + cname, cursor->getQuery());
+	metrics_set_connection(c);
+	uint64_t t0 = RuntimeMetrics::now();
+
 	rc = dbi->cursor_open(cursor);
+	RuntimeMetrics::addDriverTime(t0);
+	if (SlowStatementLog::enabled())
+		slow_log_check("open", t0, rc, c, cursor->getQuery(), -1, cursor->getParameterTypes(), cursor->getParameterValues(), cursor->getParameterLengths(), cursor->getParameterFlags());
+	if (WorkloadCapture::enabled())
+		WorkloadCapture::record(WorkloadRecordType::CursorOpen, c->getId(), t0, rc, cursor->getQuery(), cname, _current_stmt_id, cursor->isWithHold() ? WORKLOAD_FLAG_WITH_HOLD : 0, -1, 0,
+			cursor->getParameterTypes(), cursor->getParameterValues(), cursor->getParameterLengths(), cursor->getParameterFlags());
 	cursor->setOpened(rc == DBERR_NO_ERROR);
 	FAIL_ON_ERROR(rc, st, dbi, DBERR_OPEN_CURSOR_FAILED)
 	
@@ -764,6 +1170,8 @@ LIBGIXSQL_API int GIXSQLCursorFetchOne(struct sqlca_t* st, char* cname)
 {
 	CHECK_LIB_INIT();
 
+	MetricsCallScope metrics_scope("fetch", &st->sqlcode);
+
 	spdlog::trace(FMT_FILE_FUNC "GIXSQLCursorFetchOne start", __FILE__, __func__);
 
 	sqlca_initialize(st);
@@ -789,48 +1197,69 @@ LIBGIXSQL_API int GIXSQLCursorFetchOne(struct sqlca_t* st, char* cname)
 		return RESULT_FAILED;
 	}
 
+	RuntimeMetrics::setStatement(std::string("cursor:") + cname, cursor->getQuery());
+	metrics_set_connection(cursor->getConnection());
+	uint64_t t0 = RuntimeMetrics::now();
+
 	std::shared_ptr<IDbInterface> dbi = cursor->getConnection()->getDbInterface();
 	int rc = dbi->cursor_fetch_one(cursor, FETCH_NEXT_ROW);
+	RuntimeMetrics::addDriverTime(t0);
+	if (SlowStatementLog::enabled())
+		slow_log_check("fetch", t0, rc, cursor->getConnection(), cursor->getQuery(), (rc == DBERR_NO_ERROR) ? 1 : 0, cursor->getParameterTypes(), cursor->getParameterValues(), cursor->getParameterLengths(), cursor->getParameterFlags());
+	if (WorkloadCapture::enabled())
+		WorkloadCapture::record(WorkloadRecordType::CursorFetch, cursor->getConnection()->getId(), t0, rc, "", cname, _current_stmt_id, 0, (rc == DBERR_NO_ERROR) ? 1 : 0, _res_sql_var_list.size());
 	if (rc == DBERR_NO_DATA) {
 		setStatus(st, dbi, DBERR_NO_DATA);
 		return DBERR_FETCH_ROW_FAILED;
 	}
 	FAIL_ON_ERROR(rc, st, dbi, DBERR_FETCH_ROW_FAILED)
 
-	int nResParams = _res_sql_var_list.size();
-	int nfields = dbi->get_num_fields(cursor);
-	if (nfields != nResParams) {
-		spdlog::error("ResParams({}) and fields({}) are different", nResParams, nfields);
-		setStatus(st, dbi, DBERR_FIELD_COUNT_MISMATCH);
-		return RESULT_FAILED;
+	// The field count check and the buffer allocation are only performed on the first FETCH
+	// after the cursor has been opened, or when the result variables change
+	if (!cursor->hasFetchPlan(_res_sql_var_list)) {
+		int nResParams = _res_sql_var_list.size();
+		int nfields = dbi->get_num_fields(cursor);
+		if (nfields != nResParams) {
+			spdlog::error("ResParams({}) and fields({}) are different", nResParams, nfields);
+			setStatus(st, dbi, DBERR_FIELD_COUNT_MISMATCH);
+			return RESULT_FAILED;
+		}
+		cursor->buildFetchPlan(_res_sql_var_list);
+		spdlog::trace(FMT_FILE_FUNC "fetch plan built for cursor {} ({} fields)", __FILE__, __func__, cname, nfields);
 	}
 
-	uint64_t bsize = _res_sql_var_list.getMaxLength() + VARLEN_LENGTH_SZ + 1;
-	std::unique_ptr<char[]> buffer = std::make_unique<char[]>(bsize);
+	char* buffer = cursor->getFetchBuffer();
+	uint64_t bsize = cursor->getFetchBufferSize();
+	t0 = RuntimeMetrics::now();
 	std::vector<SqlVar*>::iterator it;
 	int i = 0;
 	uint64_t datalen = 0;
 	int sqlcode = 0;
 	for (it = _res_sql_var_list.begin(); it != _res_sql_var_list.end(); it++) {
 		bool is_null = false;
-		if (!dbi->get_resultset_value(ResultSetContextType::Cursor, CursorContextData(cursor), 0, i++, buffer.get(), bsize, &datalen, &is_null)) {
+		if (!dbi->get_resultset_value(ResultSetContextType::Cursor, CursorContextData(cursor), 0, i++, buffer, bsize, &datalen, &is_null)) {
 			setStatus(st, dbi, DBERR_INVALID_COLUMN_DATA);
 			sqlcode = DBERR_INVALID_COLUMN_DATA;
 			continue;
 		}
 
 		int sql_code_local = DBERR_NO_ERROR;
-		(*it)->createCobolData(buffer.get(), datalen, &sql_code_local);
+		(*it)->createCobolData(buffer, datalen, &sql_code_local);
 		if (sql_code_local) {
 			setStatus(st, dbi, sql_code_local);
 			sqlcode = sql_code_local;
 			continue;
 		}
 
+		RuntimeMetrics::addBytesIn(datalen);
+
 		spdlog::trace(FMT_FILE_FUNC "result parameter {} - addr: {}", __FILE__, __func__, i + 1, (*it)->getAddr());
 
 	}
 
+	RuntimeMetrics::addConversionTime(t0);
+	RuntimeMetrics::addRowsFetched(1);
+
 	if (sqlcode != 0) {
 		return RESULT_FAILED;
 	}
@@ -845,6 +1274,8 @@ GIXSQLCursorClose(struct sqlca_t* st, char* cname)
 {
 	CHECK_LIB_INIT();
 
+	MetricsCallScope metrics_scope("close", &st->sqlcode);
+
 	spdlog::trace(FMT_FILE_FUNC "GIXSQLCursorClose start", __FILE__, __func__);
 
 	sqlca_initialize(st);
@@ -869,8 +1300,15 @@ GIXSQLCursorClose(struct sqlca_t* st, char* cname)
 		return RESULT_SUCCESS;
 	}
 
+	RuntimeMetrics::setStatement(std::string("cursor:") + cname, cursor->getQuery());
+	metrics_set_connection(conn);
+	uint64_t t0 = RuntimeMetrics::now();
+
 	std::shared_ptr<IDbInterface> dbi = cursor->getConnection()->getDbInterface();
 	int rc = dbi->cursor_close(cursor);
+	RuntimeMetrics::addDriverTime(t0);
+	if (WorkloadCapture::enabled())
+		WorkloadCapture::record(WorkloadRecordType::CursorClose, cursor->getConnection()->getId(), t0, rc, "", cname, _current_stmt_id);
 
 	// when closing a cursor we always mark its logical state as closed, 
 	// even if an error occurred
@@ -909,7 +1347,12 @@ LIBGIXSQL_API int GIXSQLPrepareStatement(sqlca_t* st, void* d_connection_id, int
 
 	std::shared_ptr<IDbInterface> dbi = conn->getDbInterface();
 
-	if (dbi->prepare(stmt_name, statement_src)) {
+	uint64_t t0 = RuntimeMetrics::now();
+	int rc = dbi->prepare(stmt_name, statement_src);
+	if (WorkloadCapture::enabled())
+		WorkloadCapture::record(WorkloadRecordType::Prepare, conn->getId(), t0, rc, statement_src, stmt_name, _current_stmt_id);
+
+	if (rc) {
 		spdlog::error("Cannot prepare statement (2)");
 		setStatus(st, dbi, DBERR_SQL_ERROR);
 		return RESULT_FAILED;
@@ -923,6 +1366,8 @@ GIXSQLExecSelectIntoOne(struct sqlca_t* st, void* d_connection_id, int connectio
 {
 	CHECK_LIB_INIT();
 
+	MetricsCallScope metrics_scope("select_into", &st->sqlcode);
+
 	spdlog::trace(FMT_FILE_FUNC "GIXSQLExecSelectIntoOne start", __FILE__, __func__);
 	spdlog::trace(FMT_FILE_FUNC "SQL: #{}#", __FILE__, __func__, _query);
 
@@ -941,14 +1386,19 @@ GIXSQLExecSelectIntoOne(struct sqlca_t* st, void* d_connection_id, int connectio
 		return RESULT_FAILED;
 	}
 
-	std::shared_ptr<IDbInterface> dbi = conn->getDbInterface();
+	// Queries are executed on a read replica, if available
+	std::shared_ptr<IConnection> qconn = conn;
+	if (conn->hasReplicas() && is_read_only_query(_query))
+		qconn = get_read_connection(conn);
+
+	std::shared_ptr<IDbInterface> dbi = qconn->getDbInterface();
 
 	if (nParams > 0) {
-		if (_gixsqlExecParams(conn, st, _query, nParams) != RESULT_SUCCESS)
+		if (_gixsqlExecParams(qconn, st, _query, nParams) != RESULT_SUCCESS)
 			return RESULT_FAILED;
 	}
 	else {
-		if (_gixsqlExec(conn, st, _query) != RESULT_SUCCESS)
+		if (_gixsqlExec(qconn, st, _query) != RESULT_SUCCESS)
 			return RESULT_FAILED;
 	}
 
@@ -989,6 +1439,8 @@ GIXSQLExecSelectIntoOne(struct sqlca_t* st, void* d_connection_id, int connectio
 	int sqlcode = 0;
 	bool has_invalid_column_data = false;
 	uint64_t bsize = _res_sql_var_list.getMaxLength() + VARLEN_LENGTH_SZ + 1;
+	uint64_t t0 = RuntimeMetrics::now();
+
 	std::unique_ptr<char[]> buffer = std::make_unique<char[]>(bsize);
 	for (int i = 0; i < _res_sql_var_list.size(); i++) {
 		SqlVar* v = _res_sql_var_list.at(i);
@@ -1009,9 +1461,14 @@ GIXSQLExecSelectIntoOne(struct sqlca_t* st, void* d_connection_id, int connectio
 			continue;
 		}
 
+		RuntimeMetrics::addBytesIn(datalen);
+
 		spdlog::trace(FMT_FILE_FUNC "result parameter {} - addr: {}", __FILE__, __func__, i + 1, (void*)v->getAddr());
 	}
 
+	RuntimeMetrics::addConversionTime(t0);
+	RuntimeMetrics::addRowsFetched(1);
+
 	if (sqlcode != 0) {
 		return RESULT_FAILED;
 	}
@@ -1037,9 +1494,19 @@ GIXSQLDisconnect(struct sqlca_t* st, void* d_connection_id, int connection_id_tl
 	cursor_manager.clearConnectionCursors(conn->getId(), true);
 
 	std::shared_ptr<IDbInterface> dbi = conn->getDbInterface();
+	uint64_t t0 = RuntimeMetrics::now();
 	int rc = dbi->terminate_connection();
 	conn->setOpened(false);
 
+	if (WorkloadCapture::enabled())
+		WorkloadCapture::record(WorkloadRecordType::Disconnect, conn->getId(), t0, rc, "", conn->getName(), "");
+
+	for (std::shared_ptr<Connection> r : conn->getReplicas()) {
+		if (r->getDbInterface())
+			r->getDbInterface()->terminate_connection();
+		r->setOpened(false);
+	}
+
 	FAIL_ON_ERROR(rc, st, dbi, DBERR_DISCONNECT_FAILED)
 
 	setStatus(st, NULL, DBERR_NO_ERROR);
@@ -1053,6 +1520,9 @@ GIXSQLStartSQL(void)
 
 	spdlog::trace(FMT_FILE_FUNC "#begin SQL fragment", __FILE__, __func__);
 	init_sql_var_list();
+	_current_stmt_flags = SQL_STMT_FLAG_NONE;
+	_current_stmt_id.clear();
+	_current_stmt_source.clear();
 	spdlog::trace(FMT_FILE_FUNC "#end SQL fragment", __FILE__, __func__);
 	return 0;
 }
@@ -1123,6 +1593,65 @@ LIBGIXSQL_API int GIXSQLEndSQL(void)
 
 	_current_sql_var_list.clear();
 	_res_sql_var_list.clear();
+	_current_stmt_flags = SQL_STMT_FLAG_NONE;
+	_current_stmt_id.clear();
+	_current_stmt_source.clear();
+
+	return RESULT_SUCCESS;
+}
+
+LIBGIXSQL_API int GIXSQLSetStatementFlags(uint32_t flags)
+{
+	CHECK_LIB_INIT();
+
+	_current_stmt_flags = flags;
+
+	return RESULT_SUCCESS;
+}
+
+LIBGIXSQL_API int GIXSQLSetStatementId(char* stmt_id, char* src_file, int src_line)
+{
+	CHECK_LIB_INIT();
+
+	_current_stmt_id = stmt_id ? stmt_id : "";
+	_current_stmt_source = (src_file && src_line > 0) ? fmt::format("{}:{}", src_file, src_line) : "";
+
+	return RESULT_SUCCESS;
+}
+
+LIBGIXSQL_API int GIXSQLRegisterStatementParam(int type, uint32_t flags)
+{
+	CHECK_LIB_INIT();
+
+	if (type < COBOL_TYPE_MIN || type > COBOL_TYPE_MAX) {
+		spdlog::error("invalid argument 'type': {}", type);
+		return RESULT_FAILED;
+	}
+
+	_static_stmt_param_types.push_back(static_cast<CobolVarType>(type));
+	_static_stmt_param_flags.push_back(flags);
+
+	return RESULT_SUCCESS;
+}
+
+// The parameters of the statement are the ones registered (with GIXSQLRegisterStatementParam) since the previous one
+LIBGIXSQL_API int GIXSQLRegisterStatement(char* query, int is_cursor)
+{
+	CHECK_LIB_INIT();
+
+	std::shared_ptr<StaticStatementInfo> s = std::make_shared<StaticStatementInfo>();
+	s->query = query ? query : "";
+	s->is_cursor = is_cursor != 0;
+	s->param_types.swap(_static_stmt_param_types);
+	s->param_flags.swap(_static_stmt_param_flags);
+
+	if (s->query.empty() || _static_stmt_queries.find(s->query) != _static_stmt_queries.end())
+		return RESULT_SUCCESS;
+
+	spdlog::trace(FMT_FILE_FUNC "registered static statement ({} parameter(s)): {}", __FILE__, __func__, s->param_types.size(), s->query);
+
+	_static_stmt_queries.insert(s->query);
+	_static_stmts.push_back(s);
 
 	return RESULT_SUCCESS;
 }
@@ -1144,7 +1673,7 @@ static void set_sqlerrm(struct sqlca_t* st, const char* m)
 	st->sqlerrm.sqlerrml = strlen(st->sqlerrm.sqlerrmc);
 }
 
-static int setStatus(struct sqlca_t* st, std::shared_ptr<IDbInterface> dbi, int err)
+int setStatus(struct sqlca_t* st, std::shared_ptr<IDbInterface> dbi, int err)
 {
 	sqlca_initialize(st);
 
@@ -1371,6 +1900,23 @@ static AutoCommitMode get_autocommit(const std::shared_ptr<DataSourceInfo>& ds)
 }
 
 
+static bool get_eager_prepare(const std::shared_ptr<DataSourceInfo>& ds)
+{
+	std::map<std::string, std::string> options = ds->getOptions();
+	if (options.find("eager_prepare") != options.end()) {
+		std::string o = to_lower(options["eager_prepare"]);
+		return o == "on" || o == "1" || o == "true";
+	}
+
+	char* v = getenv("GIXSQL_EAGER_PREPARE");
+	if (v) {
+		if (strcmp(v, "1") == 0 || strcasecmp(v, "ON") == 0)
+			return true;
+	}
+
+	return false;
+}
+
 static bool get_fixup_params(const std::shared_ptr<DataSourceInfo>& ds)
 {
 	std::map<std::string, std::string> options = ds->getOptions();
@@ -1407,6 +1953,47 @@ static std::string get_client_encoding(const std::shared_ptr<DataSourceInfo>& ds
 	return GIXSQL_CLIENT_ENCODING_DEFAULT;
 }
 
+static bool get_read_your_writes(const std::shared_ptr<DataSourceInfo>& ds)
+{
+	std::map<std::string, std::string> options = ds->getOptions();
+	if (options.find("read_your_writes") != options.end()) {
+		std::string o = to_lower(options["read_your_writes"]);
+		return o == "on" || o == "1" || o == "true";
+	}
+
+	char* v = getenv("GIXSQL_READ_YOUR_WRITES");
+	if (v) {
+		if (strcmp(v, "1") == 0 || strcasecmp(v, "ON") == 0)
+			return true;
+	}
+
+	return false;
+}
+
+// The "read_replicas" option lists (comma-separated) the environment variables that contain
+// the data sources of the read replicas, since data sources cannot be nested in an option value
+static std::vector<std::string> get_read_replicas(const std::shared_ptr<DataSourceInfo>& ds)
+{
+	std::string v;
+	std::map<std::string, std::string> options = ds->getOptions();
+	if (options.find("read_replicas") != options.end()) {
+		v = options["read_replicas"];
+	}
+	else {
+		char* e = getenv("GIXSQL_READ_REPLICAS");
+		if (e)
+			v = e;
+	}
+
+	std::vector<std::string> res;
+	for (auto r : string_split(v, ",")) {
+		trim(r);
+		if (!r.empty())
+			res.push_back(r);
+	}
+	return res;
+}
+
 std::string get_hostref_or_literal(void* data, int l)
 {
 	if (!data)
@@ -1496,6 +2083,110 @@ bool get_log_truncation_flag() {
 			return DEFAULT_GIXSQL_LOG_TRUNC;
 }
 
+static bool get_log_async()
+{
+	char* c = getenv("GIXSQL_LOG_ASYNC");
+	if (!c)
+		return false;
+
+	std::string s = to_lower(c);
+	return s == "on" || s == "1";
+}
+
+static size_t get_log_queue_size()
+{
+	char* c = getenv("GIXSQL_LOG_QUEUE_SIZE");
+	if (c) {
+		int n = atoi(c);
+		if (n > 0)
+			return n;
+	}
+	return ASYNC_LOG_DEFAULT_QUEUE_SIZE;
+}
+
+static AsyncLogOverflowPolicy get_log_overflow_policy()
+{
+	char* c = getenv("GIXSQL_LOG_OVERFLOW");
+	if (c && to_lower(c) == "drop")
+		return AsyncLogOverflowPolicy::Drop;
+
+	return AsyncLogOverflowPolicy::Block;
+}
+
+static int get_log_flush_interval()
+{
+	char* c = getenv("GIXSQL_LOG_FLUSH_INTERVAL");
+	if (c) {
+		int n = atoi(c);
+		if (n > 0)
+			return n;
+	}
+	return ASYNC_LOG_DEFAULT_FLUSH_INTERVAL;
+}
+
+// Size in bytes, with an optional K/M/G suffix (0 = no rotation). Returns false (and
+// leaves max_size set to 0) if the value is not valid or too large
+static bool get_log_max_size(uint64_t* max_size)
+{
+	*max_size = 0;
+
+	char* c = getenv("GIXSQL_LOG_MAX_SIZE");
+	if (!c || !*c)
+		return true;
+
+	if (!isdigit((unsigned char)*c))
+		return false;
+
+	char* end = nullptr;
+	errno = 0;
+	uint64_t n = strtoull(c, &end, 10);
+	if (errno == ERANGE)
+		return false;
+
+	uint64_t multiplier = 1;
+	switch (toupper((unsigned char)*end)) {
+		case 0:
+			break;
+		case 'K':
+			multiplier = 1024;
+			break;
+		case 'M':
+			multiplier = 1024 * 1024;
+			break;
+		case 'G':
+			multiplier = 1024 * 1024 * 1024;
+			break;
+		default:
+			return false;
+	}
+
+	if (multiplier > 1 && *(end + 1))
+		return false;
+
+	if (n > UINT64_MAX / multiplier)
+		return false;
+
+	*max_size = n * multiplier;
+	return true;
+}
+
+static size_t get_log_max_files()
+{
+	char* c = getenv("GIXSQL_LOG_MAX_FILES");
+	if (c) {
+		int n = atoi(c);
+		if (n >= 0)
+			return n;
+	}
+	return DEFAULT_GIXSQL_LOG_MAX_FILES;
+}
+
+static void log_shutdown()
+{
+	if (gixsql_async_sink)
+		gixsql_async_sink->stop();
+}
+
 void setup_no_rec_code()
 {
 	char* c = getenv("GIXSQL_NOREC_CODE");
@@ -1524,6 +2215,7 @@ static bool lib_initialize()
 	int pid = getpid();
 
 	spdlog::sink_ptr gixsql_std_sink;
+	bool log_max_size_valid = true;
 
 	bool truncate_log = get_log_truncation_flag();
 	spdlog::level::level_enum level = get_log_level();
@@ -1536,7 +2228,17 @@ static bool lib_initialize()
 			filename = string_replace(filename, "$$", std::to_string(pid));
 		}
 
-		gixsql_std_sink = std::make_shared<spdlog::sinks::basic_file_sink_mt>(filename, truncate_log);
+		uint64_t max_size = 0;
+		log_max_size_valid = get_log_max_size(&max_size);
+		if (max_size > 0)
+			gixsql_std_sink = std::make_shared<spdlog::sinks::rotating_file_sink_mt>(filename, max_size, get_log_max_files(), truncate_log);
+		else
+			gixsql_std_sink = std::make_shared<spdlog::sinks::basic_file_sink_mt>(filename, truncate_log);
+
+		if (get_log_async()) {
+			gixsql_async_sink = std::make_shared<AsyncLogSink>(gixsql_std_sink, get_log_queue_size(), get_log_overflow_policy(), get_log_flush_interval());
+			gixsql_std_sink = gixsql_async_sink;
+		}
 	}
 
 	//gixsql_logger = std::make_shared<spdlog::logger>("libgixsql", gixsql_std_sink);
@@ -1555,9 +2257,23 @@ static bool lib_initialize()
 	spdlog::set_level(level);
 	spdlog::info("GixSQL logger started (PID: {})", pid);
 
+	if (!log_max_size_valid)
+		spdlog::warn("GixSQL: invalid value for GIXSQL_LOG_MAX_SIZE ({}), log rotation disabled", getenv("GIXSQL_LOG_MAX_SIZE"));
+
+	if (gixsql_async_sink) {
+		// The pending messages must be written before the logger and the sinks are destroyed
+		std::atexit(log_shutdown);
+		spdlog::info("GixSQL: asynchronous logging enabled, queue size: {}, on overflow: {}", get_log_queue_size(),
+			get_log_overflow_policy() == AsyncLogOverflowPolicy::Drop ? "drop" : "block");
+	}
+
 	// customize default values
 	setup_no_rec_code();
 
+	SlowStatementLog::init();
+	WorkloadCapture::init();
+	RuntimeMetrics::init();
+
 	__lib_initialized = true;
 
 	return true;
@@ -152,6 +152,10 @@ extern "C" {
 	LIBGIXSQL_API int GIXSQLSetSQLParams(int type, int length, int scale, uint32_t flags, void* addr, void* ind_addr);
 	LIBGIXSQL_API int GIXSQLSetResultParams(int type, int length, int scale, uint32_t flags, void* var_addr, void* ind_addr);
 	LIBGIXSQL_API int GIXSQLEndSQL(void);
+	LIBGIXSQL_API int GIXSQLSetStatementFlags(uint32_t flags);
+	LIBGIXSQL_API int GIXSQLSetStatementId(char* stmt_id, char* src_file, int src_line);
+	LIBGIXSQL_API int GIXSQLRegisterStatementParam(int type, uint32_t flags);
+	LIBGIXSQL_API int GIXSQLRegisterStatement(char* query, int is_cursor);
 
 }
 
@@ -0,0 +1,34 @@
+/*
+* This file is part of Gix-IDE, an IDE and platform for GnuCOBOL
+* Copyright (C) 2021 Marco Ridoni
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public License
+* as published by the Free Software Foundation; either version 3,
+* or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library; see the file COPYING.LIB.  If
+* not, write to the Free Software Foundation, 51 Franklin Street, Fifth Floor
+* Boston, MA 02110-1301 USA
+*/
+
+#pragma once
+
+#include <memory>
+
+#include "sqlca.h"
+#include "IDbInterface.h"
+
+/*
+	Runtime functions that are not part of the library's public interface (see gixsql.h)
+	but are used by other components built with it, e.g. the microbenchmarks.
+*/
+
+// Sets the SQLCA according to the given error code and to the last error reported by the driver
+int setStatus(struct sqlca_t* st, std::shared_ptr<IDbInterface> dbi, int err);
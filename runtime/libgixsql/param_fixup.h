@@ -0,0 +1,217 @@
+/*
+* This file is part of Gix-IDE, an IDE and platform for GnuCOBOL
+* Copyright (C) 2021 Marco Ridoni
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public License
+* as published by the Free Software Foundation; either version 3,
+* or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library; see the file COPYING.LIB.  If
+* not, write to the Free Software Foundation, 51 Franklin Street, Fifth Floor
+* Boston, MA 02110-1301 USA
+*/
+
+#pragma once
+
+#include <string>
+#include <cctype>
+
+/*
+	Parameter placeholder fixup (enabled with GIXSQL_FIXUP_PARAMS or the fixup_params connection option):
+	the placeholders in the SQL text are converted to the style expected by each DBMS client library.
+	These are shared with the microbenchmarks, so they are defined here instead of in each driver.
+*/
+
+// PostgreSQL: ?, :name -> $1, $2...
+inline std::string pgsql_fixup_parameters(const std::string& sql)
+{
+	int n = 1;
+	bool in_single_quoted_string = false;
+	bool in_double_quoted_string = false;
+	bool in_param_id = false;
+	std::string out_sql;
+
+	for (auto itc = sql.begin(); itc != sql.end(); ++itc) {
+		char c = *itc;
+
+		if (in_param_id && isalnum(c))
+			continue;
+		else {
+			in_param_id = false;
+		}
+
+		switch (c) {
+		case '"':
+			out_sql += c;
+			in_double_quoted_string = !in_double_quoted_string;
+			continue;
+
+		case '\'':
+			out_sql += c;
+			in_single_quoted_string = !in_single_quoted_string;
+			continue;
+
+		case '?':
+		case ':':
+			if (!in_single_quoted_string && !in_double_quoted_string) {
+				out_sql += ("$" + std::to_string(n++));
+				in_param_id = true;
+			}
+			else
+				out_sql += c;
+			continue;
+
+		default:
+			out_sql += c;
+
+		}
+	}
+
+	return out_sql;
+}
+
+// MySQL: $1, :name, @name -> ?
+inline std::string mysql_fixup_parameters(const std::string& sql)
+{
+	int n = 1;
+	bool in_single_quoted_string = false;
+	bool in_double_quoted_string = false;
+	bool in_param_id = false;
+	std::string out_sql;
+
+	for (auto itc = sql.begin(); itc != sql.end(); ++itc) {
+		char c = *itc;
+
+		if (in_param_id && isalnum(c))
+			continue;
+		else {
+			in_param_id = false;
+		}
+
+		switch (c) {
+		case '"':
+			out_sql += c;
+			in_double_quoted_string = !in_double_quoted_string;
+			continue;
+
+		case '\'':
+			out_sql += c;
+			in_single_quoted_string = !in_single_quoted_string;
+			continue;
+
+		case '$':
+		case ':':
+		case '@':
+			if (!in_single_quoted_string && !in_double_quoted_string) {
+				out_sql += '?';
+				in_param_id = true;
+			}
+			else
+				out_sql += c;
+			continue;
+
+		default:
+			out_sql += c;
+
+		}
+	}
+
+	return out_sql;
+}
+
+// ODBC: $1, :name -> ?
+inline std::string odbc_fixup_parameters(const std::string& sql)
+{
+	int n = 1;
+	bool in_single_quoted_string = false;
+	bool in_double_quoted_string = false;
+	bool in_param_id = false;
+	std::string out_sql;
+
+	for (auto itc = sql.begin(); itc != sql.end(); ++itc) {
+		char c = *itc;
+
+		if (in_param_id && isalnum(c))
+			continue;
+		else {
+			in_param_id = false;
+		}
+
+		switch (c) {
+		case '"':
+			out_sql += c;
+			in_double_quoted_string = !in_double_quoted_string;
+			continue;
+
+		case '\'':
+			out_sql += c;
+			in_single_quoted_string = !in_single_quoted_string;
+			continue;
+
+		case '$':
+		case ':':
+			if (!in_single_quoted_string && !in_double_quoted_string) {
+				out_sql += '?';
+				in_param_id = true;
+			}
+			else
+				out_sql += c;
+			continue;
+
+		default:
+			out_sql += c;
+
+		}
+	}
+
+	return out_sql;
+}
+
+// Oracle: $1 -> :1, ? -> :1, :2...
+inline std::string odpi_fixup_parameters(const std::string& sql)
+{
+	int n = 1;
+	bool in_single_quoted_string = false;
+	bool in_double_quoted_string = false;
+	std::string out_sql;
+
+	for (auto itc = sql.begin(); itc != sql.end(); ++itc) {
+		char c = *itc;
+
+		switch (c) {
+		case '"':
+			out_sql += c;
+			in_double_quoted_string = !in_double_quoted_string;
+			continue;
+
+		case '\'':
+			out_sql += c;
+			in_single_quoted_string = !in_single_quoted_string;
+			continue;
+
+		case '$':	// :1 is valid in Oracle, so we just change the prefix
+			out_sql += ':';
+			continue;
+
+		case '?':
+			if (!in_single_quoted_string && !in_double_quoted_string)
+				out_sql += (":" + std::to_string(n++));
+			else
+				out_sql += c;
+			continue;
+
+		default:
+			out_sql += c;
+
+		}
+	}
+
+	return out_sql;
+}
@@ -305,4 +305,24 @@ std::string to_upper(const std::string& s)
 	std::string s1 = s;
 	std::transform(s1.begin(), s1.end(), s1.begin(), ::toupper);
 	return s1;
-}
\ No newline at end of file
+}
+
+std::string json_escape(const std::string& s)
+{
+	std::string res;
+	for (char c : s) {
+		switch (c) {
+			case '"': res += "\\\""; break;
+			case '\\': res += "\\\\"; break;
+			case '\n': res += "\\n"; break;
+			case '\r': res += "\\r"; break;
+			case '\t': res += "\\t"; break;
+			default:
+				if ((unsigned char)c < 0x20)
+					res += fmt::format("\\u{:04x}", (int)c);
+				else
+					res += c;
+		}
+	}
+	return res;
+}
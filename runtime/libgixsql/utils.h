@@ -71,4 +71,6 @@ bool caseInsensitiveStringCompare(const std::string& str1, const std::string& st
 std::string to_lower(const std::string& s);
 std::string to_upper(const std::string& s);
 
+std::string json_escape(const std::string& s);
+
 #endif